@@ -9,13 +9,80 @@
 namespace Splash
 {
 
+namespace
+{
+/**
+ * Get the leaf at the given location inside an object branch
+ * \param objectBranch Object branch
+ * \param group Branch holding the leaf, i.e. "attributes" or "links"
+ * \param name Leaf name
+ * \return Return the leaf, or nullptr
+ */
+Tree::Leaf* getObjectLeaf(Tree::Branch* objectBranch, const std::string& group, const std::string& name)
+{
+    auto groupBranch = objectBranch->getBranch(group);
+    return groupBranch ? groupBranch->getLeaf(name) : nullptr;
+}
+} // namespace
+
+/*************/
+const ControllerObject::ObjectSnapshot& ControllerObject::getObjectSnapshot(const Tree::RootHandle& tree) const
+{
+    // Branch list versions are unique across all branches: if the list of root objects did not change,
+    // their branches are still alive, and a new objects branch can not have the same version as a previous one
+    auto treeBranch = tree->getBranchAt("/");
+    bool upToDate = treeBranch == _objectSnapshot.treeBranch && treeBranch->getBranchListVersion() == _objectSnapshot.treeVersion;
+    for (auto it = _objectSnapshot.roots.cbegin(); upToDate && it != _objectSnapshot.roots.cend(); ++it)
+        upToDate = it->root->getBranch("objects") == it->objects && (!it->objects || it->objects->getBranchListVersion() == it->version);
+
+    if (upToDate)
+        return _objectSnapshot;
+
+    _objectSnapshot = ObjectSnapshot();
+    _objectSnapshot.treeBranch = treeBranch;
+    _objectSnapshot.treeVersion = treeBranch->getBranchListVersion();
+
+    Tree::Branch* worldObjectsBranch = nullptr;
+    for (const auto& rootName : treeBranch->getBranchList())
+    {
+        auto rootBranch = treeBranch->getBranch(rootName);
+        auto objectsBranch = rootBranch->getBranch("objects");
+        _objectSnapshot.roots.push_back({rootBranch, objectsBranch, objectsBranch ? objectsBranch->getBranchListVersion() : 0});
+        if (!objectsBranch)
+            continue;
+
+        const bool isWorld = rootName == "world";
+        if (isWorld)
+            worldObjectsBranch = objectsBranch;
+
+        for (const auto& objectName : objectsBranch->getBranchList())
+        {
+            auto [objectIt, inserted] = _objectSnapshot.objects.try_emplace(objectName);
+            if (inserted)
+                _objectSnapshot.names.push_back(objectName);
+
+            auto& object = objectIt->second;
+            auto objectBranch = objectsBranch->getBranch(objectName);
+            object.branches.push_back(objectBranch);
+            if (!isWorld)
+                object.typeBranch = objectBranch;
+        }
+    }
+
+    // The World holds the remote types, which have precedence
+    if (worldObjectsBranch)
+        for (const auto& objectName : worldObjectsBranch->getBranchList())
+            _objectSnapshot.objects[objectName].typeBranch = worldObjectsBranch->getBranch(objectName);
+
+    return _objectSnapshot;
+}
+
 /*************/
 bool ControllerObject::checkObjectExists(const std::string& name) const
 {
-    const auto objects = getObjectList();
-    if (std::find(objects.cbegin(), objects.cend(), name) != objects.cend())
-        return true;
-    return false;
+    const auto tree = _root->getTree();
+    const auto& snapshot = getObjectSnapshot(tree);
+    return snapshot.objects.find(name) != snapshot.objects.end();
 }
 
 /*************/
@@ -23,19 +90,21 @@ std::vector<std::string> ControllerObject::getGeneratedAttributes(const std::str
 {
     std::vector<std::string> generatedAttributes;
     const auto tree = _root->getTree();
+    const auto& snapshot = getObjectSnapshot(tree);
+
+    const auto objectIt = snapshot.objects.find(objName);
+    if (objectIt == snapshot.objects.end())
+        return {};
 
-    for (const auto& rootName : tree->getBranchList())
+    for (auto objectBranch : objectIt->second.branches)
     {
-        const auto objectPath = "/" + rootName + "/objects/" + objName;
-        if (!tree->hasBranchAt(objectPath))
+        auto docBranch = objectBranch->getBranch("documentation");
+        if (!docBranch)
             continue;
-        const auto docPath = objectPath + "/documentation";
-        const auto attrList = tree->getBranchListAt(docPath);
-        for (const auto& attrName : attrList)
+        for (const auto& attrName : docBranch->getBranchList())
         {
-            Value value;
-            tree->getValueForLeafAt(docPath + "/" + attrName + "/generated", value);
-            if (value.as<bool>())
+            auto generatedLeaf = getObjectLeaf(docBranch, attrName, "generated");
+            if (generatedLeaf && generatedLeaf->get().as<bool>())
                 generatedAttributes.push_back(attrName);
         }
     }
@@ -75,14 +144,18 @@ std::vector<std::shared_ptr<GraphObject>> ControllerObject::getObjectsPtr(const
 std::string ControllerObject::getObjectAlias(const std::string& name) const
 {
     const auto tree = _root->getTree();
+    const auto& snapshot = getObjectSnapshot(tree);
+
+    const auto objectIt = snapshot.objects.find(name);
+    if (objectIt == snapshot.objects.end())
+        return {};
 
-    for (const auto& rootName : tree->getBranchList())
+    for (auto objectBranch : objectIt->second.branches)
     {
-        const auto path = "/" + rootName + "/objects/" + name + "/attributes/alias";
-        if (!tree->hasLeafAt(path))
+        auto aliasLeaf = getObjectLeaf(objectBranch, "attributes", "alias");
+        if (!aliasLeaf)
             continue;
-        Value value;
-        tree->getValueForLeafAt(path, value);
+        const auto value = aliasLeaf->get();
         return value.size() == 0 ? name : value[0].as<std::string>();
     }
 
@@ -94,21 +167,13 @@ std::unordered_map<std::string, std::string> ControllerObject::getObjectAliases(
 {
     auto aliases = std::unordered_map<std::string, std::string>();
     const auto tree = _root->getTree();
+    const auto& snapshot = getObjectSnapshot(tree);
 
-    for (const auto& rootName : tree->getBranchList())
+    for (const auto& [objectName, object] : snapshot.objects)
     {
-        const auto objectPath = "/" + rootName + "/objects";
-        const auto objectList = tree->getBranchListAt(objectPath);
-
-        for (const auto& objectName : objectList)
-        {
-            if (aliases.find(objectName) == aliases.end())
-            {
-                Value value;
-                tree->getValueForLeafAt(objectPath + "/" + objectName + "/attributes/alias", value);
-                aliases[objectName] = value.size() == 0 ? objectName : value[0].as<std::string>();
-            }
-        }
+        auto aliasLeaf = getObjectLeaf(object.branches.front(), "attributes", "alias");
+        const auto value = aliasLeaf ? aliasLeaf->get() : Value();
+        aliases[objectName] = value.size() == 0 ? objectName : value[0].as<std::string>();
     }
 
     return aliases;
@@ -117,37 +182,29 @@ std::unordered_map<std::string, std::string> ControllerObject::getObjectAliases(
 /*************/
 std::vector<std::string> ControllerObject::getObjectList() const
 {
-    auto names = std::vector<std::string>();
     const auto tree = _root->getTree();
-
-    for (const auto& rootName : tree->getBranchList())
-    {
-        const auto objectPath = "/" + rootName + "/objects";
-        const auto objectList = tree->getBranchListAt(objectPath);
-
-        for (const auto& objectName : objectList)
-            if (std::find(names.begin(), names.end(), objectName) == names.end())
-                names.push_back(objectName);
-    }
-
-    return names;
+    return getObjectSnapshot(tree).names;
 }
 
 /*************/
 Values ControllerObject::getObjectAttributeDescription(const std::string& name, const std::string& attr) const
 {
     const auto tree = _root->getTree();
-    for (const auto& rootName : tree->getBranchList())
+    const auto& snapshot = getObjectSnapshot(tree);
+
+    const auto objectIt = snapshot.objects.find(name);
+    if (objectIt == snapshot.objects.end())
+        return {};
+
+    for (auto objectBranch : objectIt->second.branches)
     {
-        const auto objectPath = "/" + rootName + "/objects/" + name;
-        if (!tree->hasBranchAt(objectPath))
+        auto docBranch = objectBranch->getBranch("documentation");
+        if (!docBranch)
             continue;
-        const auto docPath = objectPath + "/documentation/" + attr + "/description";
-        if (!tree->hasLeafAt(docPath))
+        auto descriptionLeaf = getObjectLeaf(docBranch, attr, "description");
+        if (!descriptionLeaf)
             continue;
-        Value value;
-        tree->getValueForLeafAt(docPath, value);
-        return value.as<Values>();
+        return descriptionLeaf->get().as<Values>();
     }
 
     return {};
@@ -157,14 +214,18 @@ Values ControllerObject::getObjectAttributeDescription(const std::string& name,
 Values ControllerObject::getObjectAttribute(const std::string& name, const std::string& attr) const
 {
     const auto tree = _root->getTree();
-    for (const auto& rootName : tree->getBranchList())
+    const auto& snapshot = getObjectSnapshot(tree);
+
+    const auto objectIt = snapshot.objects.find(name);
+    if (objectIt == snapshot.objects.end())
+        return {};
+
+    for (auto objectBranch : objectIt->second.branches)
     {
-        Value value;
-        const auto attrPath = "/" + rootName + "/objects/" + name + "/attributes/" + attr;
-        if (!tree->hasLeafAt(attrPath))
+        auto attributeLeaf = getObjectLeaf(objectBranch, "attributes", attr);
+        if (!attributeLeaf)
             continue;
-        tree->getValueForLeafAt(attrPath, value);
-        return value.as<Values>();
+        return attributeLeaf->get().as<Values>();
     }
 
     return {};
@@ -175,20 +236,19 @@ std::unordered_map<std::string, Values> ControllerObject::getObjectAttributes(co
 {
     auto attributes = std::unordered_map<std::string, Values>();
     const auto tree = _root->getTree();
+    const auto& snapshot = getObjectSnapshot(tree);
+
+    const auto objectIt = snapshot.objects.find(name);
+    if (objectIt == snapshot.objects.end())
+        return {};
 
-    for (const auto& rootName : tree->getBranchList())
+    for (auto objectBranch : objectIt->second.branches)
     {
-        const auto objectPath = "/" + rootName + "/objects/" + name;
-        if (!tree->hasBranchAt(objectPath))
+        auto attributesBranch = objectBranch->getBranch("attributes");
+        if (!attributesBranch)
             continue;
-        const auto attrPath = objectPath + "/attributes";
-        const auto attrList = tree->getLeafListAt(attrPath);
-        for (const auto& attrName : attrList)
-        {
-            Value value;
-            tree->getValueForLeafAt(attrPath + "/" + attrName, value);
-            attributes[attrName] = value.as<Values>();
-        }
+        for (const auto& attrName : attributesBranch->getLeafList())
+            attributes[attrName] = attributesBranch->getLeaf(attrName)->get().as<Values>();
     }
 
     return attributes;
@@ -199,26 +259,20 @@ std::unordered_map<std::string, std::vector<std::string>> ControllerObject::getO
 {
     auto links = std::unordered_map<std::string, std::vector<std::string>>();
     const auto tree = _root->getTree();
+    const auto& snapshot = getObjectSnapshot(tree);
 
-    for (const auto& rootName : tree->getBranchList())
+    for (const auto& [objectName, object] : snapshot.objects)
     {
-        const auto objectPath = "/" + rootName + "/objects";
-        const auto objectList = tree->getBranchListAt(objectPath);
-
-        for (const auto& objectName : objectList)
+        auto& childList = links[objectName];
+        for (auto objectBranch : object.branches)
         {
-            const auto linksIt = links.find(objectName);
-            if (linksIt == links.end())
-                links.emplace(make_pair(objectName, std::vector<std::string>()));
-
-            const auto childrenPath = objectPath + "/" + objectName + "/links/children";
+            auto childsLeaf = getObjectLeaf(objectBranch, "links", "children");
+            if (!childsLeaf)
+                continue;
 
-            Value value;
-            tree->getValueForLeafAt(childrenPath, value);
-            const auto children = value.as<Values>();
-            for (const auto& child : children)
+            const auto childs = childsLeaf->get().as<Values>();
+            for (const auto& child : childs)
             {
-                auto& childList = links[objectName];
                 const auto childName = child.as<std::string>();
                 if (std::find(childList.begin(), childList.end(), childName) == childList.end())
                     childList.push_back(childName);
@@ -234,26 +288,20 @@ std::unordered_map<std::string, std::vector<std::string>> ControllerObject::getO
 {
     auto links = std::unordered_map<std::string, std::vector<std::string>>();
     const auto tree = _root->getTree();
+    const auto& snapshot = getObjectSnapshot(tree);
 
-    for (const auto& rootName : tree->getBranchList())
+    for (const auto& [objectName, object] : snapshot.objects)
     {
-        const auto objectPath = "/" + rootName + "/objects";
-        const auto objectList = tree->getBranchListAt(objectPath);
-
-        for (const auto& objectName : objectList)
+        auto& parentList = links[objectName];
+        for (auto objectBranch : object.branches)
         {
-            const auto linksIt = links.find(objectName);
-            if (linksIt == links.end())
-                links.emplace(make_pair(objectName, std::vector<std::string>()));
-
-            const auto parentsPath = objectPath + "/" + objectName + "/links/parents";
+            auto parentsLeaf = getObjectLeaf(objectBranch, "links", "parents");
+            if (!parentsLeaf)
+                continue;
 
-            Value value;
-            tree->getValueForLeafAt(parentsPath, value);
-            const auto parents = value.as<Values>();
+            const auto parents = parentsLeaf->get().as<Values>();
             for (const auto& parent : parents)
             {
-                auto& parentList = links[objectName];
                 const auto parentName = parent.as<std::string>();
                 if (std::find(parentList.begin(), parentList.end(), parentName) == parentList.end())
                     parentList.push_back(parentName);
@@ -290,33 +338,19 @@ std::map<std::string, std::string> ControllerObject::getObjectTypes() const
 {
     auto types = std::map<std::string, std::string>();
     const auto tree = _root->getTree();
+    const auto& snapshot = getObjectSnapshot(tree);
 
-    const auto feedListFunc = [&](const std::string& branch) {
-        const auto objectPath = "/" + branch + "/objects";
-        const auto objectList = tree->getBranchListAt(objectPath);
-        for (const auto& objectName : objectList)
-        {
-            const auto typePath = objectPath + "/" + objectName + "/type";
-            assert(tree->hasLeafAt(typePath));
-            Value value;
-            tree->getValueForLeafAt(typePath, value);
-            assert(value.getType() == Value::string);
-            const auto type = value[0].as<std::string>();
-            types[objectName] = type;
-        }
-    };
-
-    // Loop over all Scenes
-    for (const auto& rootName : tree->getBranchList())
+    for (const auto& [objectName, object] : snapshot.objects)
     {
-        if (rootName == "world")
+        auto typeLeaf = object.typeBranch->getLeaf("type");
+        assert(typeLeaf);
+        if (!typeLeaf)
             continue;
-        feedListFunc(rootName);
+        const auto value = typeLeaf->get();
+        assert(value.getType() == Value::string);
+        types[objectName] = value[0].as<std::string>();
     }
 
-    // Loop over the World to get the remote types
-    feedListFunc("world");
-
     return types;
 }
 
@@ -324,28 +358,31 @@ std::map<std::string, std::string> ControllerObject::getObjectTypes() const
 std::vector<std::string> ControllerObject::getObjectsOfType(const std::string& type) const
 {
     std::vector<std::string> objectList;
-
     const auto tree = _root->getTree();
-    for (const auto& rootName : tree->getBranchList())
+    const auto& snapshot = getObjectSnapshot(tree);
+
+    if (type.empty())
+    {
+        objectList = snapshot.names;
+    }
+    else
     {
-        const auto objectsPath = "/" + rootName + "/objects";
-        for (const auto& objectName : tree->getBranchListAt(objectsPath))
+        for (const auto& [objectName, object] : snapshot.objects)
         {
-            if (type.empty())
-                objectList.push_back(objectName);
-
-            const auto typePath = objectsPath + "/" + objectName + "/type";
-            assert(tree->hasLeafAt(typePath));
-            Value typeValue;
-            tree->getValueForLeafAt(typePath, typeValue);
-            if (typeValue[0].as<std::string>() == type)
-                objectList.push_back(objectName);
+            for (auto objectBranch : object.branches)
+            {
+                auto typeLeaf = objectBranch->getLeaf("type");
+                assert(typeLeaf);
+                if (typeLeaf && typeLeaf->get()[0].as<std::string>() == type)
+                {
+                    objectList.push_back(objectName);
+                    break;
+                }
+            }
         }
     }
 
     std::sort(objectList.begin(), objectList.end());
-    objectList.erase(std::unique(objectList.begin(), objectList.end()), objectList.end());
-
     return objectList;
 }
 
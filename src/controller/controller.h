@@ -27,6 +27,7 @@
 
 #include <chrono>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "./core/constants.h"
@@ -34,6 +35,7 @@
 #include "./core/attribute.h"
 #include "./core/graph_object.h"
 #include "./core/scene.h"
+#include "./core/tree.h"
 #include "./userinput/userinput.h"
 
 namespace Splash
@@ -255,6 +257,43 @@ class ControllerObject : public GraphObject
      * Register new functors to modify attributes
      */
     void registerAttributes() { GraphObject::registerAttributes(); }
+
+  private:
+    /**
+     * Snapshot of the objects held in the tree, to answer queries without walking
+     * every root branch and building paths on each call. It is only rebuilt when objects
+     * are added, removed or renamed, values being read directly from the tree leaves.
+     * As it holds pointers to branches, it must only be used while the tree is locked.
+     */
+    struct ObjectSnapshot
+    {
+        struct Object
+        {
+            std::vector<Tree::Branch*> branches{}; //!< Object branch in each root holding it, in the tree order
+            Tree::Branch* typeBranch{nullptr};     //!< Branch the type is read from, the World having precedence
+        };
+
+        struct RootObjects
+        {
+            Tree::Branch* root{nullptr};    //!< Branch of a root object
+            Tree::Branch* objects{nullptr}; //!< Branch holding its objects, if any
+            uint64_t version{0};            //!< Version of the object list
+        };
+
+        Tree::Branch* treeBranch{nullptr}; //!< Main branch of the tree
+        uint64_t treeVersion{0};           //!< Version of the root object list
+        std::vector<RootObjects> roots{};
+        std::vector<std::string> names{};
+        std::unordered_map<std::string, Object> objects{};
+    };
+    mutable ObjectSnapshot _objectSnapshot{};
+
+    /**
+     * Get the object snapshot, rebuilding it if the objects changed in the tree
+     * \param tree Handle over the tree, which must be kept as long as the snapshot is used
+     * \return Return the snapshot
+     */
+    const ObjectSnapshot& getObjectSnapshot(const Tree::RootHandle& tree) const;
 };
 
 /*************/
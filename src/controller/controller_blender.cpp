@@ -1,9 +1,14 @@
 #include "./controller/controller_blender.h"
 
+#include <algorithm>
+#include <array>
+
 #include "./core/scene.h"
 #include "./graphics/camera.h"
 #include "./graphics/geometry.h"
 #include "./graphics/object.h"
+#include "./utils/log.h"
+#include "./utils/timer.h"
 
 namespace chrono = std::chrono;
 
@@ -64,61 +69,153 @@ void Blender::update()
                 return camera;
             });
 
+            // Objects can be linked to multiple cameras, we only keep them once
+            std::unordered_set<std::string> objectNames;
             objectList = getObjLinkedToCameras();
-            std::transform(objectList.cbegin(), objectList.cend(), std::back_inserter(objects), [](auto objectPtr) {
+            for (const auto& objectPtr : objectList)
+            {
                 auto object = std::dynamic_pointer_cast<Object>(objectPtr);
                 assert(object != nullptr);
-                return object;
-            });
+                if (objectNames.insert(object->getName()).second)
+                    objects.push_back(object);
+            }
 
             // If depth-aware depth computation is deactivated, also
             // deactivate vertex depth computation to prevent wasting
             // processing power
             setObjectsOfType("object", "computeFarthestVisibleVertexDistance", {_depthAwareBlending});
 
-            if (!cameras.empty())
+            if (cameras.empty())
+                return;
+
+            // When blending continuously, only the objects affected by a change since the last
+            // computation are updated. Otherwise everything is computed from scratch.
+            const bool incrementalUpdate = _continuousBlending && !_cameraStates.empty() && _depthAwareBlending == _depthAwareBlendingComputed;
+            const auto affectedObjects = incrementalUpdate ? getAffectedObjects(cameras, objects) : objectNames;
+
+            // Only the cameras seeing an affected object have to take part in the computation
+            std::vector<std::shared_ptr<Camera>> affectedCameras;
+            for (const auto& camera : cameras)
+            {
+                const auto linkedObjects = camera->getLinkedObjects();
+                if (std::any_of(linkedObjects.cbegin(), linkedObjects.cend(), [&](const auto& object) { return affectedObjects.contains(object->getName()); }))
+                    affectedCameras.push_back(camera);
+            }
+
+            // Store the current state of cameras and objects, to compare them with the next computation
+            _depthAwareBlendingComputed = _depthAwareBlending;
+            std::unordered_map<std::string, CameraState> cameraStates;
+            for (const auto& camera : cameras)
             {
-                for (auto& object : objects)
+                auto& cameraState = cameraStates[camera->getName()];
+                cameraState.viewMatrix = camera->computeViewMatrix();
+                cameraState.projectionMatrix = camera->computeProjectionMatrix();
+                cameraState.blendWidth = camera->getBlendWidth();
+                cameraState.blendPrecision = camera->getBlendPrecision();
+                for (const auto& object : camera->getLinkedObjects())
+                    cameraState.objects.push_back(object->getName());
+
+                // Keep the farthest vertex distances of objects which will not be updated
+                if (const auto previousState = _cameraStates.find(camera->getName()); previousState != _cameraStates.end())
+                    for (const auto& [objectName, distance] : previousState->second.farthestVisibleVertexDistances)
+                        if (!affectedObjects.contains(objectName))
+                            cameraState.farthestVisibleVertexDistances[objectName] = distance;
+            }
+            _cameraStates = std::move(cameraStates);
+
+            _objectStates.clear();
+            for (const auto& object : objects)
+            {
+                auto& objectState = _objectStates[object->getName()];
+                objectState.modelMatrix = object->getModelMatrix();
+                const auto geometry = object->getGeometry();
+                objectState.geometryTimestamp = geometry ? geometry->getTimestamp() : 0;
+                if (geometry)
+                    objectState.boundingBox = geometry->getBoundingBox();
+            }
+
+            if (affectedObjects.empty())
+            {
+                setObjectAttribute(_name, "blendingUpdated", {});
+                return;
+            }
+
+            const auto blendingStart = Timer::getTime();
+
+            for (auto& object : objects)
+                if (affectedObjects.contains(object->getName()))
                     object->resetTessellation();
 
-                // Tessellate
-                for (auto& camera : cameras)
-                {
-                    camera->computeVertexVisibility();
-                    camera->blendingTessellateForCurrentCamera();
-                }
+            // Tessellate
+            // This has to be done camera after camera, as each tessellation modifies
+            // the geometry which is then used for the visibility of the next camera
+            Timer::get() << "blending_tessellation";
+            for (auto& camera : affectedCameras)
+            {
+                camera->renderVertexVisibility();
+                camera->transferVertexVisibility(affectedObjects);
+                camera->blendingTessellateForCurrentCamera(affectedObjects);
+            }
+            Timer::get() >> "blending_tessellation";
 
-                for (auto& object : objects)
+            for (auto& object : objects)
+                if (affectedObjects.contains(object->getName()))
                     object->resetBlendingAttribute();
 
-                // Compute each camera contribution
-                float maxVertexDistance = 0.f;
-                for (auto& camera : cameras)
-                {
-                    camera->computeVertexVisibility();
-                    camera->computeBlendingContribution();
-                    maxVertexDistance = std::max(maxVertexDistance, camera->getFarthestVisibleVertexDistance());
-                }
+            // The geometry does not change anymore, so the visibility of all cameras can be
+            // rendered in a row. Each camera keeps its result in its own output texture.
+            Timer::get() << "blending_visibility";
+            for (auto& camera : affectedCameras)
+                camera->renderVertexVisibility();
+            Timer::get() >> "blending_visibility";
 
-                // Set the farthest visible vertex distance into all objects,
-                // so it can be used when rendering the blending
-                for (auto& object : objects)
-                    object->setAttribute("farthestVisibleVertexDistance", {maxVertexDistance});
-            }
-            else
+            // Compute each camera contribution
+            Timer::get() << "blending_contribution";
+            for (auto& camera : affectedCameras)
             {
-                return;
+                camera->transferVertexVisibility(affectedObjects);
+                camera->computeBlendingContribution(affectedObjects);
+
+                auto& distances = _cameraStates[camera->getName()].farthestVisibleVertexDistances;
+                for (const auto& object : camera->getLinkedObjects())
+                    if (affectedObjects.contains(object->getName()))
+                        distances[object->getName()] = object->getFarthestVisibleVertexDistance();
             }
+            Timer::get() >> "blending_contribution";
+
+            float maxVertexDistance = 0.f;
+            for (const auto& [cameraName, cameraState] : _cameraStates)
+                for (const auto& [objectName, distance] : cameraState.farthestVisibleVertexDistances)
+                    maxVertexDistance = std::max(maxVertexDistance, distance);
+
+            // Set the farthest visible vertex distance into all objects,
+            // so it can be used when rendering the blending
+            for (auto& object : objects)
+                object->setAttribute("farthestVisibleVertexDistance", {maxVertexDistance});
+
+            Log::get() << (_continuousBlending ? Log::DEBUGGING : Log::MESSAGE) << "Blender::" << __FUNCTION__ << " - Blending computed for " << affectedObjects.size()
+                       << " objects and " << affectedCameras.size() << " cameras in " << (Timer::getTime() - blendingStart) / 1000
+                       << "ms (tessellation: " << Timer::get().getDuration("blending_tessellation") / 1000 << "ms, visibility: " << Timer::get().getDuration("blending_visibility") / 1000
+                       << "ms, contribution: " << Timer::get().getDuration("blending_contribution") / 1000 << "ms)" << Log::endl;
 
             for (auto& object : objects)
                 object->setAttribute("activateVertexBlending", {true});
 
-            // If there are some other scenes, send them the blending
+            // If there are some other scenes, send them the updated geometries
+            std::unordered_set<std::string> affectedGeometries;
+            for (const auto& object : objects)
+                if (const auto geometry = object->getGeometry(); geometry && affectedObjects.contains(object->getName()))
+                    affectedGeometries.insert(geometry->getName());
+
             auto geometries = getObjectsPtr(getObjectsOfType("geometry"));
             for (auto& geometry : geometries)
             {
-                auto serializedGeometry = std::dynamic_pointer_cast<Geometry>(geometry)->serialize();
-                sendBuffer(std::move(serializedGeometry));
+                if (!affectedGeometries.contains(geometry->getName()))
+                    continue;
+                // Affected geometries are always sent: a scene may have reset its copy since the last
+                // blending, in which case content identical to what we sent before is still needed
+                auto bufferObject = std::dynamic_pointer_cast<Geometry>(geometry);
+                sendBuffer(bufferObject->serialize());
             }
 
             setObjectAttribute(_name, "blendingUpdated", {});
@@ -153,6 +250,9 @@ void Blender::update()
         auto cameras = getObjectsPtr(getObjectsOfType("camera"));
         auto objects = getObjLinkedToCameras();
 
+        _cameraStates.clear();
+        _objectStates.clear();
+
         if (isMaster && cameras.size() != 0)
         {
             for (auto& it : objects)
@@ -168,6 +268,145 @@ void Blender::update()
     }
 }
 
+/*************/
+std::unordered_set<std::string> Blender::getAffectedObjects(const std::vector<std::shared_ptr<Camera>>& cameras, const std::vector<std::shared_ptr<Object>>& objects) const
+{
+    std::unordered_set<std::string> affectedObjects;
+
+    // Conservative test of a bounding box against a frustum: the box is considered
+    // outside only if all its corners are outside of the same clipping plane
+    const auto isBoxInFrustum = [](const glm::dmat4& mvp, const std::pair<glm::vec3, glm::vec3>& box) -> bool {
+        std::array<glm::dvec4, 8> corners;
+        for (uint32_t i = 0; i < corners.size(); ++i)
+            corners[i] = mvp * glm::dvec4(i & 1 ? box.second.x : box.first.x, i & 2 ? box.second.y : box.first.y, i & 4 ? box.second.z : box.first.z, 1.0);
+
+        for (uint32_t axis = 0; axis < 3; ++axis)
+        {
+            if (std::all_of(corners.cbegin(), corners.cend(), [&](const auto& c) { return c[axis] < -c.w; }))
+                return false;
+            if (std::all_of(corners.cbegin(), corners.cend(), [&](const auto& c) { return c[axis] > c.w; }))
+                return false;
+        }
+        return true;
+    };
+
+    // Bounds of the changed objects, before and after the change, in world space
+    struct ChangedBounds
+    {
+        glm::dmat4 modelMatrix{1.0};
+        std::pair<glm::vec3, glm::vec3> boundingBox{};
+    };
+    std::vector<ChangedBounds> changedBounds;
+
+    for (const auto& object : objects)
+    {
+        const auto& objectName = object->getName();
+        const auto objectState = _objectStates.find(objectName);
+        const auto geometry = object->getGeometry();
+        const auto geometryTimestamp = geometry ? geometry->getTimestamp() : 0;
+        if (objectState != _objectStates.end() && objectState->second.modelMatrix == object->getModelMatrix() && objectState->second.geometryTimestamp == geometryTimestamp)
+            continue;
+
+        affectedObjects.insert(objectName);
+        if (objectState != _objectStates.end() && objectState->second.boundingBox)
+            changedBounds.push_back({objectState->second.modelMatrix, *objectState->second.boundingBox});
+        if (geometry)
+            changedBounds.push_back({object->getModelMatrix(), geometry->getBoundingBox()});
+    }
+
+    // An object which changed may occlude, or stop occluding, other objects seen by the same
+    // cameras: the objects linked to any camera seeing its old or new bounds are affected
+    for (const auto& camera : cameras)
+    {
+        const auto viewProjectionMatrix = camera->computeProjectionMatrix() * camera->computeViewMatrix();
+        const auto cameraState = _cameraStates.find(camera->getName());
+        const auto seesBounds = [&](const ChangedBounds& bounds) {
+            if (isBoxInFrustum(viewProjectionMatrix * bounds.modelMatrix, bounds.boundingBox))
+                return true;
+            if (cameraState == _cameraStates.end())
+                return false;
+            const auto& previous = cameraState->second;
+            return isBoxInFrustum(previous.projectionMatrix * previous.viewMatrix * bounds.modelMatrix, bounds.boundingBox);
+        };
+
+        if (std::none_of(changedBounds.cbegin(), changedBounds.cend(), seesBounds))
+            continue;
+
+        for (const auto& object : camera->getLinkedObjects())
+            affectedObjects.insert(object->getName());
+        if (cameraState != _cameraStates.end())
+            for (const auto& objectName : cameraState->second.objects)
+                affectedObjects.insert(objectName);
+    }
+
+    std::unordered_set<std::string> currentCameras;
+    for (const auto& camera : cameras)
+    {
+        currentCameras.insert(camera->getName());
+        const auto linkedObjects = camera->getLinkedObjects();
+        const auto cameraState = _cameraStates.find(camera->getName());
+
+        // New cameras affect all the objects they are linked to
+        if (cameraState == _cameraStates.end())
+        {
+            for (const auto& object : linkedObjects)
+                affectedObjects.insert(object->getName());
+            continue;
+        }
+
+        const auto& previous = cameraState->second;
+        const auto viewMatrix = camera->computeViewMatrix();
+        const auto projectionMatrix = camera->computeProjectionMatrix();
+        const bool frustumChanged = previous.viewMatrix != viewMatrix || previous.projectionMatrix != projectionMatrix || previous.blendWidth != camera->getBlendWidth()
+                                    || previous.blendPrecision != camera->getBlendPrecision();
+
+        // Objects newly linked or unlinked are affected
+        std::unordered_set<std::string> linkedNames;
+        for (const auto& object : linkedObjects)
+        {
+            linkedNames.insert(object->getName());
+            if (std::find(previous.objects.cbegin(), previous.objects.cend(), object->getName()) == previous.objects.cend())
+                affectedObjects.insert(object->getName());
+        }
+        for (const auto& objectName : previous.objects)
+            if (!linkedNames.contains(objectName))
+                affectedObjects.insert(objectName);
+
+        if (!frustumChanged)
+            continue;
+
+        // Objects seen by either the previous or the current frustum are affected
+        for (const auto& object : linkedObjects)
+        {
+            if (affectedObjects.contains(object->getName()))
+                continue;
+
+            const auto geometry = object->getGeometry();
+            if (!geometry)
+                continue;
+
+            const auto boundingBox = geometry->getBoundingBox();
+            const auto modelMatrix = object->getModelMatrix();
+            if (isBoxInFrustum(projectionMatrix * viewMatrix * modelMatrix, boundingBox) || isBoxInFrustum(previous.projectionMatrix * previous.viewMatrix * modelMatrix, boundingBox))
+                affectedObjects.insert(object->getName());
+        }
+    }
+
+    // Objects seen by a camera which has been removed are affected
+    for (const auto& [cameraName, cameraState] : _cameraStates)
+        if (!currentCameras.contains(cameraName))
+            for (const auto& objectName : cameraState.objects)
+                affectedObjects.insert(objectName);
+
+    // Only keep objects which are still linked to a camera
+    std::unordered_set<std::string> objectNames;
+    for (const auto& object : objects)
+        objectNames.insert(object->getName());
+    std::erase_if(affectedObjects, [&](const auto& name) { return !objectNames.contains(name); });
+
+    return affectedObjects;
+}
+
 /*************/
 void Blender::registerAttributes()
 {
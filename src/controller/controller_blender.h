@@ -25,13 +25,23 @@
 #ifndef SPLASH_CONTROLLER_BLENDER_H
 #define SPLASH_CONTROLLER_BLENDER_H
 
+#include <optional>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
 
 #include "./controller.h"
 
 namespace Splash
 {
 
+class Camera;
+class Object;
+
 class Blender final : public ControllerObject
 {
   public:
@@ -58,11 +68,43 @@ class Blender final : public ControllerObject
     bool _continuousBlending{false};   //!< If true, render does not reset _computeBlending
     bool _blendingComputed{false};     //!< True if the blending has been computed
 
+    // Parameters used for the last blending computation, to detect which part of it needs to be updated
+    struct CameraState
+    {
+        glm::dmat4 viewMatrix{1.0};
+        glm::dmat4 projectionMatrix{1.0};
+        float blendWidth{0.f};
+        float blendPrecision{0.f};
+        std::vector<std::string> objects{};
+        std::unordered_map<std::string, float> farthestVisibleVertexDistances{}; //!< Per object farthest visible vertex distance
+    };
+
+    struct ObjectState
+    {
+        glm::dmat4 modelMatrix{1.0};
+        int64_t geometryTimestamp{0};
+        std::optional<std::pair<glm::vec3, glm::vec3>> boundingBox{}; //!< Bounding box of the geometry, in model space
+    };
+
+    std::unordered_map<std::string, CameraState> _cameraStates{};
+    std::unordered_map<std::string, ObjectState> _objectStates{};
+    bool _depthAwareBlendingComputed{false}; //!< Value of _depthAwareBlending for the last computation
+
     // Vertex blending variables
     std::mutex _vertexBlendingMutex;
     std::condition_variable _vertexBlendingCondition;
     std::atomic_bool _vertexBlendingReceptionStatus{false};
 
+    /**
+     * Get the objects whose blending is affected by changes since the last computation
+     * An object is affected if it moved, if its mesh changed, if its links to the cameras changed,
+     * or if the frustum of a camera seeing it changed and overlaps it (before or after the change)
+     * \param cameras Cameras to compute the blending for
+     * \param objects Objects linked to the cameras
+     * \return Return the names of the affected objects
+     */
+    std::unordered_set<std::string> getAffectedObjects(const std::vector<std::shared_ptr<Camera>>& cameras, const std::vector<std::shared_ptr<Object>>& objects) const;
+
     /**
      * Register new functors to modify attributes
      */
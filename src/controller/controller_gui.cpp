@@ -24,6 +24,7 @@
 #include "./graphics/texture.h"
 #include "./graphics/texture_image.h"
 #include "./graphics/window.h"
+#include "./utils/latency.h"
 #include "./utils/log.h"
 #include "./utils/osutils.h"
 #include "./utils/timer.h"
@@ -1576,6 +1577,28 @@ void Gui::initImWidgets()
             stream << "        Swapping: " << std::setprecision(4) << stats[branchName + "_swap"] << " ms\n";
         }
 
+        // And the latencies from the sources to each stage, as measured by each process
+        stream << "Latencies (p50 / p95 / p99):\n";
+        for (const auto& branchName : tree->getBranchList())
+        {
+            const auto latenciesPath = "/" + branchName + "/latencies";
+            if (!tree->hasBranchAt(latenciesPath))
+                continue;
+
+            for (const auto& source : tree->getBranchListAt(latenciesPath))
+            {
+                stream << "- " << source << " (" << branchName << "):\n";
+                for (const auto& stage : {LatencyTracker::STAGE_SERIALIZE, LatencyTracker::STAGE_SEND, LatencyTracker::STAGE_DESERIALIZE, LatencyTracker::STAGE_UPLOAD, LatencyTracker::STAGE_DISPLAY})
+                {
+                    Value value;
+                    if (!tree->getValueForLeafAt(latenciesPath + "/" + source + "/" + stage, value) || value.size() < 3)
+                        continue;
+                    stream << "    " << stage << ": " << std::setprecision(4) << value[0].as<float>() << " / " << value[1].as<float>() << " / " << value[2].as<float>()
+                           << " ms\n";
+                }
+            }
+        }
+
         return stream.str();
     });
     _guiBottomWidgets.push_back(std::dynamic_pointer_cast<GuiWidget>(timingBox));
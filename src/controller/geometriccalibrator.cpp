@@ -1,6 +1,7 @@
 #include "./controller/geometriccalibrator.h"
 
 #include <algorithm>
+#include <mutex>
 #include <thread>
 
 #include <calimiro/calimiro.h>
@@ -206,10 +207,11 @@ std::optional<GeometricCalibrator::Calibration> GeometricCalibrator::calibration
 {
     // Begin calibration
     calimiro::Workspace workspace;
-    calimiro::Structured_Light structuredLight(&_logger, _structuredLightScale);
 
     Image imageObject(_root);
     _finalizeCalibration = false;
+    _measuredCaptureDelay.reset();
+    const auto calibrationStart = Timer::getTime();
     size_t positionIndex = 0;
     while (!_finalizeCalibration)
     {
@@ -220,6 +222,7 @@ std::optional<GeometricCalibrator::Calibration> GeometricCalibrator::calibration
         }
         _nextPosition = false;
         setObjectAttribute("gui", "hide", {true});
+        const auto positionStart = Timer::getTime();
 
         // If an error happens while capturing this position, this flag will be set to true
         bool abortCurrentPosition = false;
@@ -231,15 +234,24 @@ std::optional<GeometricCalibrator::Calibration> GeometricCalibrator::calibration
             setObjectAttribute(filterName, "texLayout", {0, 0, 0, 0});
         }
 
+        const std::string directory = workspace.getWorkPath() + "/pos_" + std::to_string(positionIndex);
+        std::filesystem::create_directory(directory);
+
         // For each position, capture the patterns for all cameras
-        std::vector<cv::Mat2i> decodedProjectors;
+        // Captured frames are converted while the next pattern is displayed, and the patterns
+        // of a camera are decoded while the patterns of the next one are captured
+        std::mutex workspaceMutex;
+        std::vector<std::future<std::optional<cv::Mat2i>>> decodedProjectors;
         for (size_t cameraIndex = 0; cameraIndex < state.cameraList.size(); ++cameraIndex)
         {
             const auto& cameraName = state.cameraList[cameraIndex];
             const auto cameraSize = getObjectAttribute(cameraName, "size");
             const auto camWidth = cameraSize[0].as<int>();
             const auto camHeight = cameraSize[1].as<int>();
-            auto patterns = structuredLight.create(camWidth, camHeight);
+
+            // Each camera gets its own decoder, as decoding happens in the background
+            auto structuredLight = std::make_shared<calimiro::Structured_Light>(&_logger, _structuredLightScale);
+            auto patterns = structuredLight->create(camWidth, camHeight);
 
             // Convert patterns to RGB
             for (auto& pattern : patterns)
@@ -282,7 +294,16 @@ std::optional<GeometricCalibrator::Calibration> GeometricCalibrator::calibration
             layout[targetLayoutIndex] = 2; // This index will display the third texture, named _worldImageName
             setObjectAttribute(targetFilterName, "texLayout", layout);
 
-            std::vector<cv::Mat1b> capturedPatterns{};
+            // The delay between display and capture is measured once, with the first camera seen by the grabber
+            if (!_measuredCaptureDelay)
+            {
+                _measuredCaptureDelay = measureCaptureDelay(imageObject, targetWindowName, camWidth, camHeight);
+                if (_measuredCaptureDelay)
+                    Log::get() << Log::MESSAGE << "GeometricCalibrator::" << __FUNCTION__ << " - Measured capture delay: " << _measuredCaptureDelay->count() << "ms" << Log::endl;
+            }
+            const auto captureDelay = _measuredCaptureDelay.value_or(_captureDelay);
+
+            std::vector<std::future<std::optional<cv::Mat1b>>> capturedPatterns{};
             for (size_t patternIndex = 0; patternIndex < patterns.size(); ++patternIndex)
             {
                 const auto& pattern = patterns[patternIndex];
@@ -290,76 +311,30 @@ std::optional<GeometricCalibrator::Calibration> GeometricCalibrator::calibration
                 const auto channels = pattern.channels();
                 ImageBufferSpec spec(camWidth, camHeight, channels, 8 * channels, ImageBufferSpec::Type::UINT8, "RGB");
                 spec.videoFrame = false;
-                ImageBuffer imageBuffer(spec, pattern.data);
-
-                imageObject.set(imageBuffer);
-                imageObject.update(); // We have to force the update, as Image is double-buffered
-                auto serializedImage = imageObject.serialize();
-
-                // Send the buffer, and make sure it has been received and displayed
-                sendBuffer(std::move(serializedImage));
-                for (int64_t updatedTimestamp = 0; updatedTimestamp != imageObject.getTimestamp();
-                     updatedTimestamp = getObjectAttribute(targetWindowName, "timestamp")[0].as<int64_t>())
-                    std::this_thread::sleep_for(15ms);
+                displayImage(imageObject, ImageBuffer(spec, pattern.data), targetWindowName);
 
                 // Wait for a few more frames to be drawn, to account for double buffering,
                 // and exposure time of the input grabber
-                std::this_thread::sleep_for(_captureDelay);
-
-                const auto updateTime = Timer::getTime();
-                // Some grabber need to be asked to capture a frame
-                setObjectAttribute(_grabber->getName(), "capture", {true});
-                while (updateTime > _grabber->getTimestamp())
-                {
-                    _grabber->update();
-                    std::this_thread::sleep_for(100ms);
-                }
-                imageBuffer = _grabber->get();
+                std::this_thread::sleep_for(captureDelay);
 
+                auto imageBuffer = grabFrame();
                 if (imageBuffer.empty())
                     return {};
 
-                spec = imageBuffer.getSpec();
-                cv::Mat capturedImage;
-
-                if (spec.format.find("RGB") != std::string::npos)
-                {
-                    assert(spec.channels == 4 || spec.channels == 3); // All Image classes should output RGB or RGBA (when uncompressed)
-                    capturedImage = cv::Mat(spec.height, spec.width, spec.channels == 4 ? CV_8UC4 : CV_8UC3, imageBuffer.data());
-                    cv::cvtColor(capturedImage, capturedImage, cv::COLOR_RGB2GRAY);
-                }
-                else if (spec.format.find("BGR") != std::string::npos)
-                {
-                    assert(spec.channels == 4 || spec.channels == 3);
-                    const auto bgraImage = cv::Mat(spec.height, spec.width, spec.channels == 4 ? CV_8UC4 : CV_8UC3, imageBuffer.data());
-                    cv::cvtColor(bgraImage, capturedImage, cv::COLOR_BGR2GRAY);
-                }
-                else if (spec.format == "YUYV")
-                {
-                    assert(spec.channels == 3 && spec.bpp == 16);
-                    auto yuvImage = cv::Mat(spec.height, spec.width, CV_8UC2, imageBuffer.data());
-                    cv::cvtColor(yuvImage, capturedImage, cv::COLOR_YUV2RGB_YUYV);
-                }
-                else
-                {
-                    Log::get() << Log::WARNING << "GeometricCalibrator::" << __FUNCTION__ << " - Format " << spec.format << " is not supported" << Log::endl;
-                    return {};
-                }
-
-                cv::Mat1b grayscale(spec.height, spec.width);
-                int fromTo[] = {0, 0};
-                cv::mixChannels(&capturedImage, 1, &grayscale, 1, fromTo, 1);
-                capturedPatterns.push_back(grayscale);
-
-                std::string directory = workspace.getWorkPath() + "/pos_" + std::to_string(positionIndex);
-                std::filesystem::create_directory(directory);
-                cv::imwrite(directory + "/prj" + std::to_string(cameraIndex) + "_pattern" + std::to_string(patternIndex) + ".jpg", capturedImage);
-
 #ifdef DEBUG
                 std::string patternImageFilePath = directory + "/prj" + std::to_string(cameraIndex) + "_pattern" + std::to_string(patternIndex) + ".png";
                 if (!imageObject.write(patternImageFilePath))
                     Log::get() << Log::WARNING << "GeometricCalibrator::" << __FUNCTION__ << " - Could not write image to " << patternImageFilePath << Log::endl;
 #endif
+
+                const auto captureFilePath = directory + "/prj" + std::to_string(cameraIndex) + "_pattern" + std::to_string(patternIndex) + ".jpg";
+                capturedPatterns.push_back(std::async(std::launch::async, [imageBuffer = std::move(imageBuffer), captureFilePath]() mutable -> std::optional<cv::Mat1b> {
+                    cv::Mat capturedImage;
+                    auto grayscale = convertToGrayscale(imageBuffer, capturedImage);
+                    if (grayscale)
+                        cv::imwrite(captureFilePath, capturedImage);
+                    return grayscale;
+                }));
             }
 
             layout[targetLayoutIndex] = 0; // This index will display the first texture, _worldBlackImage
@@ -368,20 +343,34 @@ std::optional<GeometricCalibrator::Calibration> GeometricCalibrator::calibration
             if (abortCurrentPosition)
                 break;
 
-            auto decoded = structuredLight.decode(camWidth, camHeight, capturedPatterns);
-            auto shadowMask = structuredLight.getShadowMask();
-            auto decodedCoords = structuredLight.getDecodedCoordinates(camWidth, camHeight);
+            decodedProjectors.push_back(std::async(std::launch::async,
+                [&, structuredLight, capturedPatterns = std::move(capturedPatterns), cameraIndex, camWidth, camHeight]() mutable -> std::optional<cv::Mat2i> {
+                    std::vector<cv::Mat1b> grayscalePatterns{};
+                    for (auto& capturedPattern : capturedPatterns)
+                    {
+                        auto grayscale = capturedPattern.get();
+                        if (!grayscale)
+                            return {};
+                        grayscalePatterns.push_back(grayscale.value());
+                    }
+
+                    auto decoded = structuredLight->decode(camWidth, camHeight, grayscalePatterns);
+                    auto shadowMask = structuredLight->getShadowMask();
+                    auto decodedCoords = structuredLight->getDecodedCoordinates(camWidth, camHeight);
 
-            if (!decoded || !shadowMask || !decodedCoords)
-                return {};
+                    if (!decoded || !shadowMask || !decodedCoords)
+                        return {};
 
-            calimiro::Workspace::ImageList imagesToSave(
-                {{"decoded_images/pos_" + std::to_string(positionIndex) + "_proj" + std::to_string(cameraIndex) + "_shadow_mask.jpg", shadowMask.value()},
-                    {"decoded_images/pos_" + std::to_string(positionIndex) + "_proj" + std::to_string(cameraIndex) + "_x.jpg", decodedCoords.value().first},
-                    {"decoded_images/pos_" + std::to_string(positionIndex) + "_proj" + std::to_string(cameraIndex) + "_y.jpg", decodedCoords.value().second}});
-            if (!workspace.saveImagesFromList(imagesToSave))
-                return {};
-            decodedProjectors.push_back(decoded.value());
+                    calimiro::Workspace::ImageList imagesToSave(
+                        {{"decoded_images/pos_" + std::to_string(positionIndex) + "_proj" + std::to_string(cameraIndex) + "_shadow_mask.jpg", shadowMask.value()},
+                            {"decoded_images/pos_" + std::to_string(positionIndex) + "_proj" + std::to_string(cameraIndex) + "_x.jpg", decodedCoords.value().first},
+                            {"decoded_images/pos_" + std::to_string(positionIndex) + "_proj" + std::to_string(cameraIndex) + "_y.jpg", decodedCoords.value().second}});
+
+                    std::lock_guard<std::mutex> lockWorkspace(workspaceMutex);
+                    if (!workspace.saveImagesFromList(imagesToSave))
+                        return {};
+                    return decoded.value();
+                }));
         }
 
         // Set all cameras to display a pattern
@@ -391,14 +380,32 @@ std::optional<GeometricCalibrator::Calibration> GeometricCalibrator::calibration
             setObjectAttribute(filterName, "texLayout", {1, 1, 1, 1});
         }
 
+        // Wait for the decoding to finish. All futures are waited for before leaving,
+        // as they reference the workspace
+        std::vector<cv::Mat2i> decodedMatrices;
+        bool decodingFailed = false;
+        for (auto& decodedProjector : decodedProjectors)
+        {
+            auto decoded = decodedProjector.get();
+            if (decoded)
+                decodedMatrices.push_back(decoded.value());
+            else
+                decodingFailed = true;
+        }
+        if (decodingFailed)
+            return {};
+
         if (abortCurrentPosition)
             continue;
 
-        auto mergedProjectors = workspace.combineDecodedProjectors(decodedProjectors);
+        auto mergedProjectors = workspace.combineDecodedProjectors(decodedMatrices);
         if (!mergedProjectors)
             return {};
         workspace.exportMatrixToYaml(mergedProjectors.value(), "decoded_matrix/pos_" + std::to_string(positionIndex));
 
+        Log::get() << Log::MESSAGE << "GeometricCalibrator::" << __FUNCTION__ << " - Position " << positionIndex << " captured in "
+                   << (Timer::getTime() - positionStart) / 1000 << "ms" << Log::endl;
+
         ++positionIndex;
         setObjectAttribute("gui", "show", {});
     }
@@ -507,9 +514,125 @@ std::optional<GeometricCalibrator::Calibration> GeometricCalibrator::calibration
         calibration.params.push_back(params);
     }
 
+    Log::get() << Log::MESSAGE << "GeometricCalibrator::" << __FUNCTION__ << " - Calibration computed, total calibration time: " << (Timer::getTime() - calibrationStart) / 1000000
+               << "s" << Log::endl;
+
     return {calibration};
 }
 
+/*************/
+void GeometricCalibrator::displayImage(Image& imageObject, const ImageBuffer& imageBuffer, const std::string& windowName)
+{
+    imageObject.set(imageBuffer);
+    imageObject.update(); // We have to force the update, as Image is double-buffered
+    auto serializedImage = imageObject.serialize();
+
+    // Send the buffer, and make sure it has been received and displayed
+    sendBuffer(std::move(serializedImage));
+    for (int64_t updatedTimestamp = 0; updatedTimestamp != imageObject.getTimestamp(); updatedTimestamp = getObjectAttribute(windowName, "timestamp")[0].as<int64_t>())
+        std::this_thread::sleep_for(5ms);
+}
+
+/*************/
+ImageBuffer GeometricCalibrator::grabFrame()
+{
+    const auto updateTime = Timer::getTime();
+    // Some grabber need to be asked to capture a frame
+    setObjectAttribute(_grabber->getName(), "capture", {true});
+    while (updateTime > _grabber->getTimestamp())
+    {
+        _grabber->update();
+        std::this_thread::sleep_for(5ms);
+    }
+    return _grabber->get();
+}
+
+/*************/
+std::optional<std::chrono::milliseconds> GeometricCalibrator::measureCaptureDelay(Image& imageObject, const std::string& windowName, int width, int height)
+{
+    ImageBufferSpec spec(width, height, 3, 24, ImageBufferSpec::Type::UINT8, "RGB");
+    spec.videoFrame = false;
+    ImageBuffer testImage(spec);
+
+    // Grab a reference frame while displaying black, leaving the grabber the configured delay to settle
+    testImage.zero();
+    displayImage(imageObject, testImage, windowName);
+    std::this_thread::sleep_for(_captureDelay);
+    auto referenceBuffer = grabFrame();
+    cv::Mat referenceImage;
+    const auto reference = convertToGrayscale(referenceBuffer, referenceImage);
+    if (!reference)
+        return std::nullopt;
+
+    // Then display white, and grab frames until the change shows up
+    std::fill(testImage.data(), testImage.data() + spec.rawSize(), 255);
+    displayImage(imageObject, testImage, windowName);
+    const auto displayTime = Timer::getTime();
+
+    // The delay is only worth measuring if it is shorter than the configured one
+    const auto maxDelay = duration_cast<microseconds>(_captureDelay).count();
+    while (true)
+    {
+        const auto captureTime = Timer::getTime();
+        if (captureTime - displayTime > maxDelay)
+            return std::nullopt;
+
+        auto frameBuffer = grabFrame();
+        cv::Mat frameImage;
+        const auto frame = convertToGrayscale(frameBuffer, frameImage);
+        if (!frame || frame->size() != reference->size())
+            return std::nullopt;
+
+        // Consider the pattern visible once a small portion of the frame got much brighter
+        cv::Mat1b difference;
+        cv::subtract(frame.value(), reference.value(), difference);
+        const auto changedPixels = cv::countNonZero(difference > 64);
+        if (static_cast<size_t>(changedPixels) > difference.total() / 200)
+        {
+            // Keep a margin, to account for exposure variations between frames
+            const auto delay = duration_cast<milliseconds>(microseconds(captureTime - displayTime));
+            return delay + delay / 4;
+        }
+    }
+}
+
+/*************/
+std::optional<cv::Mat1b> GeometricCalibrator::convertToGrayscale(ImageBuffer& imageBuffer, cv::Mat& capturedImage)
+{
+    if (imageBuffer.empty())
+        return std::nullopt;
+
+    const auto spec = imageBuffer.getSpec();
+    if (spec.format.find("RGB") != std::string::npos)
+    {
+        assert(spec.channels == 4 || spec.channels == 3); // All Image classes should output RGB or RGBA (when uncompressed)
+        capturedImage = cv::Mat(spec.height, spec.width, spec.channels == 4 ? CV_8UC4 : CV_8UC3, imageBuffer.data());
+        cv::cvtColor(capturedImage, capturedImage, cv::COLOR_RGB2GRAY);
+    }
+    else if (spec.format.find("BGR") != std::string::npos)
+    {
+        assert(spec.channels == 4 || spec.channels == 3);
+        const auto bgraImage = cv::Mat(spec.height, spec.width, spec.channels == 4 ? CV_8UC4 : CV_8UC3, imageBuffer.data());
+        cv::cvtColor(bgraImage, capturedImage, cv::COLOR_BGR2GRAY);
+    }
+    else if (spec.format == "YUYV")
+    {
+        assert(spec.channels == 3 && spec.bpp == 16);
+        auto yuvImage = cv::Mat(spec.height, spec.width, CV_8UC2, imageBuffer.data());
+        cv::cvtColor(yuvImage, capturedImage, cv::COLOR_YUV2RGB_YUYV);
+    }
+    else
+    {
+        Log::get() << Log::WARNING << "GeometricCalibrator::" << __FUNCTION__ << " - Format " << spec.format << " is not supported" << Log::endl;
+        return std::nullopt;
+    }
+
+    cv::Mat1b grayscale(spec.height, spec.width);
+    int fromTo[] = {0, 0};
+    cv::mixChannels(&capturedImage, 1, &grayscale, 1, fromTo, 1);
+    return grayscale;
+}
+
 /*************/
 void GeometricCalibrator::applyCalibration(const GeometricCalibrator::ConfigurationState& state, const Calibration& calibration)
 {
@@ -635,7 +758,9 @@ void GeometricCalibrator::registerAttributes()
         },
         [&]() -> Values { return {_captureDelay.count()}; },
         {'i'});
-    setAttributeDescription("captureDelay", "Delay between the display of the next pattern and grabbing it through the camera");
+    setAttributeDescription("captureDelay",
+        "Maximum delay between the display of the next pattern and grabbing it through the camera. The actual delay is measured at the beginning of the calibration, "
+        "this value being used if the measure fails");
 
     addAttribute(
         "patternScale",
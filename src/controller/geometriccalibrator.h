@@ -33,6 +33,7 @@
 #include <optional>
 
 #include <calimiro/texture_coordinates/texCoordUtils.h>
+#include <opencv2/core.hpp>
 
 #include "./controller/controller.h"
 #include "./core/constants.h"
@@ -143,6 +144,7 @@ class GeometricCalibrator final : public ControllerObject
     CameraModel _cameraModel{CameraModel::Pinhole};
     float _structuredLightScale{1.0 / 16.0};
     std::chrono::milliseconds _captureDelay{std::chrono::milliseconds(250)};
+    std::optional<std::chrono::milliseconds> _measuredCaptureDelay{}; //!< Display to capture latency, measured once per calibration
 
     std::shared_ptr<Image> _grabber{nullptr};
     std::future<bool> _calibrationFuture{};
@@ -153,6 +155,38 @@ class GeometricCalibrator final : public ControllerObject
      */
     std::optional<Calibration> calibrationFunc(const ConfigurationState& state);
 
+    /**
+     * Send the given image to be displayed, and wait for the given window to show it
+     * \param imageObject Image used to send the buffer
+     * \param imageBuffer Image buffer to display
+     * \param windowName Window displaying the image
+     */
+    void displayImage(Image& imageObject, const ImageBuffer& imageBuffer, const std::string& windowName);
+
+    /**
+     * Ask the grabber for a new frame, and wait for it
+     * \return Return the captured frame, empty if the grabber failed
+     */
+    ImageBuffer grabFrame();
+
+    /**
+     * Measure the delay between an image being displayed and it being visible in the grabbed frames
+     * \param imageObject Image used to send the test images
+     * \param windowName Window displaying the test images
+     * \param width Test image width
+     * \param height Test image height
+     * \return Return the measured delay, or std::nullopt if no change could be detected in the grabbed frames
+     */
+    std::optional<std::chrono::milliseconds> measureCaptureDelay(Image& imageObject, const std::string& windowName, int width, int height);
+
+    /**
+     * Convert a frame from the grabber to grayscale
+     * \param imageBuffer Captured frame
+     * \param capturedImage Set to the captured frame converted to an OpenCV matrix
+     * \return Return the grayscale image, or std::nullopt if the frame format is not supported
+     */
+    static std::optional<cv::Mat1b> convertToGrayscale(ImageBuffer& imageBuffer, cv::Mat& capturedImage);
+
     /**
      * Save the configuration state at the beginning of the calibration
      * \return Return the configuration state
@@ -1,6 +1,9 @@
 #include "./core/buffer_object.h"
 
+#include <utility>
+
 #include "./core/root_object.h"
+#include "./utils/hash.h"
 
 namespace Splash
 {
@@ -15,11 +18,18 @@ void BufferObject::setNotUpdated()
 /*************/
 bool BufferObject::deserialize()
 {
-    if (!_newSerializedObject)
-        return false;
+    SerializedObject obj;
+    {
+        std::lock_guard<std::mutex> lock(_serializedObjectMutex);
+        if (!_newSerializedObject)
+            return false;
+        obj = std::move(_serializedObject);
+        _newSerializedObject = false;
+    }
 
-    bool returnValue = deserialize(std::move(_serializedObject));
-    _newSerializedObject = false;
+    const bool returnValue = deserialize(std::move(obj));
+    if (!returnValue)
+        ++_droppedBuffers;
 
     return returnValue;
 }
@@ -28,27 +38,113 @@ bool BufferObject::deserialize()
 bool BufferObject::setSerializedObject(SerializedObject&& obj)
 {
     if (obj.size() == 0)
+    {
+        ++_droppedBuffers;
         return false;
+    }
 
-    // If a buffer is already being deserialized, this test will fail
-    // and the value will still be true. Otherwise it will succeed, and
-    // the value will be set to true.
-    if (!_serializedObjectWaiting.exchange(true))
+    // The latest object wins: one still waiting for deserialization is replaced
     {
+        std::lock_guard<std::mutex> lock(_serializedObjectMutex);
+        if (_newSerializedObject)
+            ++_coalescedBuffers;
         _serializedObject = std::move(obj);
         _newSerializedObject = true;
+    }
+
+    // Only one deserialization task is scheduled at a time, it processes
+    // the mailbox until it is empty
+    if (_deserializationScheduled.exchange(true))
+        return true;
+
+    auto weakObject = weak_from_this();
+    if (!_root || weakObject.expired())
+    {
+        processSerializedObjects();
+        return true;
+    }
+
+    // If the pool discards the task without running it, the flag is reset so that
+    // the next serialized object schedules a new task
+    using WeakObject = decltype(weakObject);
+    auto pendingObject = std::shared_ptr<WeakObject>(new WeakObject(weakObject), [](WeakObject* pending) {
+        if (auto object = std::static_pointer_cast<BufferObject>(pending->lock()))
+            object->_deserializationScheduled = false;
+        delete pending;
+    });
+
+    _root->getDeserializationPool().enqueue([pendingObject]() {
+        if (auto object = std::static_pointer_cast<BufferObject>(std::exchange(*pendingObject, {}).lock()))
+            object->processSerializedObjects();
+    });
 
-        // Deserialize it right away, in a separate thread
-        _deserializeFuture = std::async(std::launch::async, [this]() {
+    return true;
+}
+
+/*************/
+void BufferObject::processSerializedObjects()
+{
+    while (true)
+    {
+        {
             std::lock_guard<Spinlock> updateLock(_updateMutex);
             deserialize();
-            _serializedObjectWaiting = false;
-        });
+        }
+
+        // The flag is reset while holding the mailbox lock, so that an object set
+        // concurrently is either seen here or schedules a new task
+        std::lock_guard<std::mutex> lock(_serializedObjectMutex);
+        if (!_newSerializedObject)
+        {
+            _deserializationScheduled = false;
+            return;
+        }
+    }
+}
 
+/*************/
+bool BufferObject::isTransportDue() const
+{
+    if (_transportPolicy != TransportPolicy::rate_limited)
+        return true;
+    return Timer::getTime() - _lastTransportTime >= static_cast<int64_t>(1e6f / _transportMaxRate.load());
+}
+
+/*************/
+bool BufferObject::hasNewContent(const SerializedObject& obj)
+{
+    const auto now = Timer::getTime();
+    const bool forced = _forceTransport.exchange(false);
+
+    if (now - _contentCheckTime >= _streamedUpdatePeriod)
+        _contentChanges = 0;
+    _contentCheckTime = now;
+
+    // Streamed objects change at every update, hashing them would only cost time
+    if (_contentChanges >= _streamedChangeCount)
+    {
+        _contentHash.reset();
         return true;
     }
 
-    return false;
+    const auto hash = getContentHash(obj);
+    if (_contentHash == hash && !forced)
+    {
+        ++_skippedTransports;
+        _skippedTransportBytes += obj.size();
+        return false;
+    }
+
+    if (_contentHash && _contentHash != hash)
+        ++_contentChanges;
+    _contentHash = hash;
+    return true;
+}
+
+/*************/
+uint64_t BufferObject::getContentHash(const SerializedObject& obj) const
+{
+    return Hash::xxh64(std::span<const uint8_t>(obj.data(), obj.size()));
 }
 
 /*************/
@@ -68,6 +164,65 @@ void BufferObject::updateTimestamp(int64_t timestamp)
 void BufferObject::registerAttributes()
 {
     GraphObject::registerAttributes();
+
+    addAttribute("coalescedBuffers", [&]() -> Values { return {static_cast<int64_t>(_coalescedBuffers.load())}; });
+    setAttributeDescription("coalescedBuffers", "Number of received buffers replaced by a newer one before being deserialized");
+
+    addAttribute("droppedBuffers", [&]() -> Values { return {static_cast<int64_t>(_droppedBuffers.load())}; });
+    setAttributeDescription("droppedBuffers", "Number of received buffers which were empty or failed to deserialize");
+
+    addAttribute("skippedTransports", [&]() -> Values { return {static_cast<int64_t>(_skippedTransports.load())}; });
+    setAttributeDescription("skippedTransports", "Number of updates which were not sent to other processes, as their content did not change");
+
+    addAttribute("skippedTransportBytes", [&]() -> Values { return {static_cast<int64_t>(_skippedTransportBytes.load())}; });
+    setAttributeDescription("skippedTransportBytes", "Number of bytes which were not sent to other processes, as the content did not change");
+
+    addAttribute(
+        "transportPolicy",
+        [&](const Values& args) {
+            const auto policy = args[0].as<std::string>();
+            if (policy == "latest")
+                _transportPolicy = TransportPolicy::latest;
+            else if (policy == "reliable")
+                _transportPolicy = TransportPolicy::reliable;
+            else if (policy == "rate_limited")
+                _transportPolicy = TransportPolicy::rate_limited;
+            else
+            {
+                Log::get() << Log::WARNING << "BufferObject::" << __FUNCTION__ << " - Unknown transport policy: " << policy << Log::endl;
+                return false;
+            }
+            return true;
+        },
+        [&]() -> Values {
+            switch (_transportPolicy)
+            {
+            default:
+            case TransportPolicy::latest:
+                return {"latest"};
+            case TransportPolicy::reliable:
+                return {"reliable"};
+            case TransportPolicy::rate_limited:
+                return {"rate_limited"};
+            }
+        },
+        {'s'});
+    setAttributeDescription("transportPolicy",
+        "How updates are sent to other processes: latest (real-time, only the latest buffer matters), reliable (every update, on a background lane) or rate_limited (background "
+        "lane, at most transportMaxRate updates per second)");
+
+    addAttribute(
+        "transportMaxRate",
+        [&](const Values& args) {
+            const auto rate = args[0].as<float>();
+            if (rate <= 0.f)
+                return false;
+            _transportMaxRate = rate;
+            return true;
+        },
+        [&]() -> Values { return {_transportMaxRate.load()}; },
+        {'r'});
+    setAttributeDescription("transportMaxRate", "Maximum number of updates sent per second when the transport policy is rate_limited");
 }
 
 } // namespace Splash
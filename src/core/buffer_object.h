@@ -31,12 +31,15 @@
 #include <json/json.h>
 #include <list>
 #include <map>
+#include <mutex>
+#include <optional>
 #include <shared_mutex>
 #include <unordered_map>
 
 #include "./core/graph_object.h"
 #include "./core/serialized_object.h"
 #include "./core/spinlock.h"
+#include "./network/channel.h"
 
 namespace Splash
 {
@@ -72,6 +75,14 @@ class BufferObject : public GraphObject
 
     friend BufferObjectLockRead;
 
+  public:
+    enum class TransportPolicy : uint8_t
+    {
+        latest,      //!< Only the latest buffer matters, sent as soon as possible
+        reliable,    //!< Every update is sent, without delaying real-time buffers
+        rate_limited //!< Updates are sent at most at the maximum transport rate
+    };
+
   public:
     /**
      * Constructor
@@ -92,9 +103,13 @@ class BufferObject : public GraphObject
     BufferObjectLockRead getReadLock() { return BufferObjectLockRead(this); }
 
     /**
-     * Set the object as dirty to force update
+     * Set the object as dirty to force update, and to force its transport even if its content did not change
      */
-    void setDirty() { updateTimestamp(); }
+    void setDirty()
+    {
+        _forceTransport = true;
+        updateTimestamp();
+    }
 
     /**
      * Check whether the object has been updated
@@ -158,10 +173,9 @@ class BufferObject : public GraphObject
 
     /**
      * Set the next serialized object to deserialize to buffer. Deserialization is
-     * done asynchronously, in a separate thread if the system allows for it. Use
-     * hasSerializedObjectWaiting to check whether a deserialization is waiting
-     * If another object is currently being set for deserialization, the call
-     * to this method will do nothing and return false.
+     * done asynchronously, by the worker pool of the root object if any. Use
+     * hasSerializedObjectWaiting to check whether a deserialization is waiting.
+     * If an object is already waiting for deserialization, it is replaced by this one.
      * \param obj Serialized object
      * \return Return true if the object has been set for deserialization, false otherwise
      */
@@ -169,9 +183,74 @@ class BufferObject : public GraphObject
 
     /**
      * Check whether a serialized object is waiting for deserialization
-     * \return Return true if a serialized object is waiting
+     * \return Return true if a serialized object is waiting or being deserialized
+     */
+    bool hasSerializedObjectWaiting() const { return _deserializationScheduled; };
+
+    /**
+     * Get the number of serialized objects replaced by a newer one before being deserialized
+     * \return Return the coalesced buffer count
+     */
+    uint64_t getCoalescedBufferCount() const { return _coalescedBuffers; }
+
+    /**
+     * Get the number of serialized objects which were empty or failed to deserialize
+     * \return Return the dropped buffer count
+     */
+    uint64_t getDroppedBufferCount() const { return _droppedBuffers; }
+
+    /**
+     * Get the transport policy used to send this object to other processes
+     * \return Return the transport policy
+     */
+    TransportPolicy getTransportPolicy() const { return _transportPolicy; }
+
+    /**
+     * Get the priority of the channel lane this object should be sent through
+     * \return Return the buffer priority
+     */
+    ChannelOutput::BufferPriority getTransportPriority() const
+    {
+        return _transportPolicy == TransportPolicy::latest ? ChannelOutput::BufferPriority::realtime : ChannelOutput::BufferPriority::background;
+    }
+
+    /**
+     * Check whether the object can be sent, according to its transport policy
+     * \return Return true if an update of the object can be sent now
+     */
+    bool isTransportDue() const;
+
+    /**
+     * Mark the object as just sent, for rate limiting
+     * \param priority Priority the object is sent with
+     * \return Return the priority of the previous transport. If it differs, buffers sent through the previous lane have to be flushed first.
+     */
+    ChannelOutput::BufferPriority setTransported(ChannelOutput::BufferPriority priority)
+    {
+        _lastTransportTime = Timer::getTime();
+        return _lastTransportPriority.exchange(priority);
+    }
+
+    /**
+     * Check whether a serialized version of the object holds new content, compared to the previous one
+     * checked, in which case it has to be transported. Objects updated with new content at a high rate,
+     * like videos, are considered as new without computing their hash.
+     * \param obj Serialized object
+     * \return Return true if the content is new, or if the object was set dirty
+     */
+    bool hasNewContent(const SerializedObject& obj);
+
+    /**
+     * Get the number of transports skipped as the content did not change
+     * \return Return the skipped transport count
+     */
+    uint64_t getSkippedTransportCount() const { return _skippedTransports; }
+
+    /**
+     * Get the number of bytes which were not transported as the content did not change
+     * \return Return the skipped byte count
      */
-    bool hasSerializedObjectWaiting() const { return _newSerializedObject; };
+    uint64_t getSkippedTransportBytes() const { return _skippedTransportBytes; }
 
   protected:
     /**
@@ -187,14 +266,47 @@ class BufferObject : public GraphObject
      */
     mutable std::shared_mutex _readMutex;
 
-    std::atomic_bool _serializedObjectWaiting{false}; //!< True if a serialized object has been set and waits for processing
-    std::future<void> _deserializeFuture{};           //!< Holds the deserialization thread
     mutable Spinlock _timestampMutex;
     int64_t _timestamp{0};                  //!< Timestamp
     std::atomic_bool _updatedBuffer{false}; //!< True if the BufferObject has been updated
 
-    SerializedObject _serializedObject;           //!< Internal buffer object
-    std::atomic_bool _newSerializedObject{false}; //!< Set to true during serialized object processing
+    // Mailbox holding the latest serialized object, waiting for deserialization
+    std::mutex _serializedObjectMutex{};
+    SerializedObject _serializedObject;                //!< Internal buffer object
+    std::atomic_bool _newSerializedObject{false};      //!< True if a serialized object is waiting in the mailbox
+    std::atomic_bool _deserializationScheduled{false}; //!< True while a deserialization task is scheduled or running
+    std::atomic<uint64_t> _coalescedBuffers{0};        //!< Serialized objects replaced before being deserialized
+    std::atomic<uint64_t> _droppedBuffers{0};          //!< Serialized objects which were empty or failed to deserialize
+
+    // Set from the attributes while the World loop reads them, hence atomic
+    std::atomic<TransportPolicy> _transportPolicy{TransportPolicy::latest}; //!< How updates of this object are sent to other processes
+    std::atomic<float> _transportMaxRate{1.f};                              //!< Maximum transport rate for rate limited objects, in Hz
+    std::atomic<int64_t> _lastTransportTime{0};                             //!< Last time the object was sent, in us
+    std::atomic<ChannelOutput::BufferPriority> _lastTransportPriority{ChannelOutput::BufferPriority::realtime}; //!< Priority of the last transport
+
+    // Objects which got new content this many times in a row, each less than the period apart, are considered streamed
+    static constexpr uint32_t _streamedChangeCount{4};
+    static constexpr int64_t _streamedUpdatePeriod{1'000'000};
+
+    std::atomic_bool _forceTransport{false};       //!< Set by setDirty, to transport the object even if its content did not change
+    std::optional<uint64_t> _contentHash{};        //!< Hash of the last checked content, if it was computed
+    uint32_t _contentChanges{0};                   //!< Number of consecutive changes of content, each less than the streamed update period apart
+    int64_t _contentCheckTime{0};                  //!< Last time the content was checked, in us
+    std::atomic<uint64_t> _skippedTransports{0};     //!< Transports skipped as the content did not change
+    std::atomic<uint64_t> _skippedTransportBytes{0}; //!< Bytes not transported as the content did not change
+
+    /**
+     * Compute the hash of the content of a serialized version of the object. Derived classes
+     * serializing data changing at each update (as a timestamp) should leave it out of the hash.
+     * \param obj Serialized object
+     * \return Return the hash
+     */
+    virtual uint64_t getContentHash(const SerializedObject& obj) const;
+
+    /**
+     * Deserialize the objects set in the mailbox, until it is empty
+     */
+    void processSerializedObjects();
 
     /**
      * Updates the timestamp of the object. Also, set the update flag to true.
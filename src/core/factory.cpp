@@ -17,6 +17,7 @@
 #include "./graphics/window.h"
 #include "./image/image.h"
 #include "./image/image_ffmpeg.h"
+#include "./image/image_file_sequence.h"
 #include "./image/image_list.h"
 #include "./image/image_ndi.h"
 #include "./image/queue.h"
@@ -263,6 +264,20 @@ void Factory::registerObjects()
         "Static images read from a directory.",
         true);
 
+    _objectBook["image_file_sequence"] = Page(
+        [&](RootObject* root) {
+            std::shared_ptr<GraphObject> object;
+            if (!_scene)
+                object = std::dynamic_pointer_cast<GraphObject>(std::make_shared<Image_FileSequence>(root));
+            else
+                object = std::dynamic_pointer_cast<GraphObject>(std::make_shared<Image>(root));
+            return object;
+        },
+        GraphObject::Category::IMAGE,
+        "image sequence",
+        "Image object playing a sequence of numbered image files, decoded ahead of time.",
+        true);
+
 #if HAVE_LINUX
     _objectBook["image_v4l2"] = Page(
         [&](RootObject* root) {
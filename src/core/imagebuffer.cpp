@@ -97,6 +97,15 @@ ImageBuffer::ImageBuffer(const ImageBufferSpec& spec, uint8_t* data, bool map)
     }
 }
 
+/*************/
+ImageBuffer::ImageBuffer(const std::shared_ptr<const ImageBuffer>& buffer)
+{
+    assert(buffer);
+    _spec = buffer->getSpec();
+    _mappedBuffer = const_cast<uint8_t*>(buffer->data());
+    _sharedBuffer = buffer;
+}
+
 /*************/
 void ImageBuffer::zero()
 {
@@ -171,6 +171,13 @@ class ImageBuffer
      */
     ImageBuffer(const ImageBufferSpec& spec, uint8_t* data = nullptr, bool map = false);
 
+    /**
+     * Constructor, sharing the data of another buffer instead of copying it
+     * The shared buffer is kept alive as long as this one, and its data must not be modified
+     * \param buffer Buffer to share
+     */
+    explicit ImageBuffer(const std::shared_ptr<const ImageBuffer>& buffer);
+
     /**
      * Destructor
      */
@@ -246,6 +253,7 @@ class ImageBuffer
     ImageBufferSpec _spec{};
     ResizableArray<uint8_t> _buffer;
     uint8_t* _mappedBuffer{nullptr};
+    std::shared_ptr<const ImageBuffer> _sharedBuffer{nullptr}; //!< Buffer holding the mapped data, if shared
 };
 
 } // namespace Splash
@@ -7,6 +7,7 @@
 #include "./core/serialize/serialize_uuid.h"
 #include "./core/serialize/serialize_value.h"
 #include "./core/serializer.h"
+#include "./utils/latency.h"
 
 namespace chrono = std::chrono;
 
@@ -87,7 +88,10 @@ void RootObject::disposeObject(const std::string& name)
         std::lock_guard<std::recursive_mutex> registerLock(_objectsMutex);
         auto objectIt = _objects.find(name);
         if (objectIt != _objects.end() && objectIt->second.use_count() == 1)
+        {
             _objects.erase(objectIt);
+            _link->releaseBuffers(name);
+        }
     });
 }
 
@@ -154,7 +158,7 @@ std::shared_ptr<GraphObject> RootObject::getObject(const std::string& name)
 }
 
 /*************/
-bool RootObject::set(const std::string& name, const std::string& attrib, const Values& args, bool async)
+bool RootObject::set(const std::string& name, const std::string& attrib, Values args, bool async)
 {
     if (name == _name || name == Constants::ALL_PEERS)
         return setAttribute(attrib, args) != BaseObject::SetAttrStatus::failure;
@@ -165,7 +169,7 @@ bool RootObject::set(const std::string& name, const std::string& attrib, const V
 
     if (async)
     {
-        addTask([=, this]() {
+        addTask([=, this, args = std::move(args)]() {
             auto object = getObject(name);
             if (object)
                 object->setAttribute(attrib, args);
@@ -241,12 +245,11 @@ bool RootObject::handleSerializedObject(const std::string& name, SerializedObjec
 {
     if (name == "_tree")
     {
-        const auto data = obj.grabData();
-        auto dataIt = data.cbegin();
-        // We deserialize the buffer name, but we don't need to keep it
-        Serial::detail::deserializer<std::string>(dataIt);
+        auto dataIt = static_cast<const uint8_t*>(obj.data());
+        // We skip the buffer name, we don't need to keep it
+        Serial::detail::deserializer<std::string_view>(dataIt);
         auto seeds = Serial::detail::deserializer<std::list<Tree::Seed>>(dataIt);
-        _tree.addSeedsToQueue(seeds);
+        _tree.addSeedsToQueue(std::move(seeds));
 
         return true;
     }
@@ -286,6 +289,39 @@ void RootObject::updateTreeFromObjects()
         _tree.setValueForLeafAt(path, Values({Value(static_cast<int>(d.second))}));
     }
 
+    // Update duration statistics, as min, average, max, p95 and p99 in us
+    for (const auto& [name, stats] : Timer::get().getStatistics())
+    {
+        const auto path = "/" + _name + "/durationStats/" + name;
+        if (!_tree.hasLeafAt(path))
+            if (!_tree.createLeafAt(path))
+                continue;
+        _tree.setValueForLeafAt(path,
+            Values({static_cast<int64_t>(stats.min),
+                static_cast<int64_t>(stats.average),
+                static_cast<int64_t>(stats.max),
+                static_cast<int64_t>(stats.p95),
+                static_cast<int64_t>(stats.p99)}));
+    }
+
+    // Update latencies, as the p50, p95 and p99 percentiles in ms, and the measurement count
+    for (const auto& [source, stages] : LatencyTracker::get().getPercentiles())
+    {
+        const auto sourcePath = "/" + _name + "/latencies/" + source;
+        if (!_tree.hasBranchAt(sourcePath))
+            if (!_tree.createBranchAt(sourcePath))
+                continue;
+
+        for (const auto& [stage, percentiles] : stages)
+        {
+            const auto path = sourcePath + "/" + stage;
+            if (!_tree.hasLeafAt(path))
+                if (!_tree.createLeafAt(path))
+                    continue;
+            _tree.setValueForLeafAt(path, Values({percentiles.p50, percentiles.p95, percentiles.p99, static_cast<int64_t>(percentiles.count)}));
+        }
+    }
+
     // Update the Root object attributes
     {
         const auto attributePath = std::string("/" + _name + "/attributes/");
@@ -378,11 +414,22 @@ void RootObject::registerAttributes()
 {
     addAttribute("answerMessage",
         [&](const Values& args) {
-            if (args.size() == 0 || args[0].as<std::string>() != _answerExpected)
+            // Answers end with the id of the request they answer to
+            if (args.size() < 2)
                 return false;
-            std::unique_lock<std::mutex> conditionLock(_conditionMutex);
-            _lastAnswerReceived = args;
-            _answerCondition.notify_one();
+            auto answer = args;
+            const auto requestId = answer.back().as<int64_t>();
+            answer.pop_back();
+
+            std::lock_guard<std::mutex> lock(_requestsMutex);
+            const auto requestIt = _pendingRequests.find(requestId);
+            if (requestIt == _pendingRequests.end() || answer[0].as<std::string>() != requestIt->second.attribute)
+                return false;
+
+            auto& request = requestIt->second;
+            LatencyTracker::get().recordLatency("rpc_" + request.target, request.attribute, Timer::getTime() - request.sendTime);
+            request.answer.set_value(answer);
+            _pendingRequests.erase(requestIt);
             return true;
         },
         {});
@@ -395,6 +442,8 @@ void RootObject::initializeTree()
     _tree.createBranchAt("/world/attributes");
     _tree.createBranchAt("/world/commands");
     _tree.createBranchAt("/world/durations");
+    _tree.createBranchAt("/world/durationStats");
+    _tree.createBranchAt("/world/latencies");
     _tree.createBranchAt("/world/logs");
     _tree.createBranchAt("/world/objects");
 
@@ -624,29 +673,55 @@ Json::Value RootObject::getRootConfigurationAsJson(const std::string& rootName)
 }
 
 /*************/
-Values RootObject::sendMessageWithAnswer(const std::string& name, const std::string& attribute, const Values& message, const unsigned long long timeout)
+std::future<Values> RootObject::sendRequest(const std::string& name, const std::string& attribute, const Values& message, const unsigned long long timeout)
 {
     assert(_link);
     assert(_link->isReady());
 
-    std::lock_guard<std::mutex> lock(_answerMutex);
-    _answerExpected = attribute;
-
-    std::unique_lock<std::mutex> conditionLock(_conditionMutex);
-    _link->sendMessage(name, attribute, message);
+    const auto requestId = _nextRequestId++;
+    const auto deadline = chrono::steady_clock::now() + chrono::microseconds(timeout);
 
-    auto cvStatus = std::cv_status::no_timeout;
-    if (timeout == 0ull)
-        _answerCondition.wait(conditionLock);
-    else
-        cvStatus = _answerCondition.wait_for(conditionLock, chrono::microseconds(timeout));
-
-    _answerExpected = "";
+    std::future<Values> answer;
+    {
+        std::lock_guard<std::mutex> lock(_requestsMutex);
+        auto& request = _pendingRequests[requestId];
+        request.target = name;
+        request.attribute = attribute;
+        request.sendTime = Timer::getTime();
+        answer = request.answer.get_future();
+    }
 
-    if (std::cv_status::no_timeout == cvStatus)
-        return _lastAnswerReceived;
-    else
+    auto requestMessage = message;
+    requestMessage.push_back(requestId);
+    _link->sendMessage(name, attribute, requestMessage);
+    // The caller is likely to wait for the answer, so the request is not kept in a batch
+    _link->flushMessages();
+
+    // The timeout is handled when the answer is retrieved, from the caller thread
+    return std::async(std::launch::deferred, [this, requestId, timeout, deadline, answer = std::move(answer)]() mutable -> Values {
+        if (timeout == 0ull || answer.wait_until(deadline) == std::future_status::ready)
+            return answer.get();
+
+        std::lock_guard<std::mutex> lock(_requestsMutex);
+        const auto requestIt = _pendingRequests.find(requestId);
+        if (requestIt == _pendingRequests.end())
+            return answer.get(); // Answered in the meantime
+
+        Log::get() << Log::WARNING << "RootObject::" << __FUNCTION__ << " - Timeout while waiting for an answer to " << requestIt->second.attribute << " from "
+                   << requestIt->second.target << Log::endl;
+        _pendingRequests.erase(requestIt);
         return {};
+    });
+}
+
+/*************/
+void RootObject::answerRequest(const std::string& name, const Values& requestArgs, Values answer)
+{
+    if (requestArgs.empty())
+        return;
+    answer.push_back(requestArgs.back());
+    sendMessage(name, "answerMessage", answer);
+    _link->flushMessages();
 }
 
 } // namespace Splash
@@ -25,12 +25,15 @@
 #ifndef SPLASH_ROOT_OBJECT_H
 #define SPLASH_ROOT_OBJECT_H
 
+#include <algorithm>
 #include <atomic>
 #include <condition_variable>
+#include <future>
 #include <json/json.h>
 #include <list>
 #include <map>
 #include <string>
+#include <thread>
 #include <unordered_map>
 
 #include "./config.h"
@@ -41,6 +44,7 @@
 #include "./core/tree.h"
 #include "./network/link.h"
 #include "./utils/dense_map.h"
+#include "./utils/worker_pool.h"
 
 namespace Splash
 {
@@ -200,18 +204,18 @@ class RootObject : public BaseObject
      * Set the attribute of the named object with the given args
      * \param name Object name
      * \param attrib Attribute name
-     * \param args Value to set the attribute to
+     * \param args Value to set the attribute to, moved to the asynchronous task if any
      * \param async Set to true for the attribute to be set asynchronously
      * \return Return true if all went well
      */
-    bool set(const std::string& name, const std::string& attrib, const Values& args, bool async = true);
+    bool set(const std::string& name, const std::string& attrib, Values args, bool async = true);
 
     /**
      * Set an object from its serialized form. If non existant, it is handled
      * by the handleSerializedObject method.
      * Note that if the object exists, this method calls itself
      * BufferObject::setFromSerializedObject, and that the deserialization is
-     * handled asynchronously. Use BufferObject::hasSerializedObjectWaiting to
+     * handled asynchronously by the deserialization pool. Use BufferObject::hasSerializedObjectWaiting to
      * check whether a deserialization is waiting.
      * \param name Object name
      * \param obj Serialized object
@@ -239,6 +243,12 @@ class RootObject : public BaseObject
      */
     void signalBufferObjectUpdated();
 
+    /**
+     * Get the worker pool in charge of deserializing the BufferObjects
+     * \return Return the deserialization pool
+     */
+    Utils::WorkerPool& getDeserializationPool() { return _deserializationPool; }
+
   protected:
     Context _context{};
 
@@ -248,11 +258,17 @@ class RootObject : public BaseObject
 
     std::unique_ptr<Factory> _factory{}; //!< Object factory
 
-    Values _lastAnswerReceived{}; //!< Holds the last answer received through the link
-    std::condition_variable _answerCondition{};
-    std::mutex _conditionMutex{};
-    std::mutex _answerMutex{};
-    std::string _answerExpected{""};
+    // Requests sent with sendRequest, waiting for their answer
+    struct PendingRequest
+    {
+        std::string target{};
+        std::string attribute{};
+        int64_t sendTime{0};
+        std::promise<Values> answer{};
+    };
+    std::mutex _requestsMutex{};
+    std::atomic<int64_t> _nextRequestId{1};
+    std::unordered_map<int64_t, PendingRequest> _pendingRequests{};
 
     // Condition variable for signaling a BufferObject update
     std::condition_variable _bufferObjectUpdatedCondition{};
@@ -263,6 +279,10 @@ class RootObject : public BaseObject
     std::atomic_bool _objectsCurrentlyUpdated{false};               //!< Prevents modification of objects from multiple places at the same time
     DenseMap<std::string, std::shared_ptr<GraphObject>> _objects{}; //!< Map of all the objects
 
+    static constexpr size_t _maxDeserializationThreads{4};
+    Utils::WorkerPool _deserializationPool{
+        std::clamp<size_t>(std::thread::hardware_concurrency() / 4, 1, _maxDeserializationThreads)}; //!< Persistent threads deserializing the BufferObjects
+
     std::unique_ptr<Link> _link{}; //!< Link object for communicatin between World and Scene
 
     /**
@@ -339,12 +359,33 @@ class RootObject : public BaseObject
      * \param name Root object name
      * \param attribute Attribute name
      * \param message Message
+     * \param coalesce If true, replaces any message to the same object and attribute not sent yet, see Link::sendMessage
      */
-    void sendMessage(const std::string& name, const std::string& attribute, const Values& message = {})
+    void sendMessage(const std::string& name, const std::string& attribute, const Values& message = {}, bool coalesce = false)
     {
-        _link->sendMessage(name, attribute, message);
+        _link->sendMessage(name, attribute, message, coalesce);
     }
 
+    /**
+     * Send a request to another root object, without waiting for the answer. Any number of requests can be
+     * in flight at the same time, answers being matched to their request by an id appended to the message.
+     * The receiving attribute has to send it back using answerRequest.
+     * \param name Root object name
+     * \param attribute Attribute name
+     * \param message Message
+     * \param timeout Timeout in microseconds, starting when the request is sent. If 0, wait indefinitely
+     * \return Return a future holding the answer received, or an empty Values if the timeout is reached
+     */
+    std::future<Values> sendRequest(const std::string& name, const std::string& attribute, const Values& message = {}, const unsigned long long timeout = 0ull);
+
+    /**
+     * Answer a request sent with sendRequest
+     * \param name Root object which sent the request
+     * \param requestArgs Arguments received with the request, ending with the request id
+     * \param answer Answer, starting with the requested attribute name
+     */
+    void answerRequest(const std::string& name, const Values& requestArgs, Values answer);
+
     /**
      * Send a message to another root object, and wait for an answer. Can specify a timeout for the answer, in microseconds.
      * \param name Root object name
@@ -353,7 +394,10 @@ class RootObject : public BaseObject
      * \param timeout Timeout in microseconds
      * \return Return the answer received (or an empty Values)
      */
-    Values sendMessageWithAnswer(const std::string& name, const std::string& attribute, const Values& message = {}, const unsigned long long timeout = 0ull);
+    Values sendMessageWithAnswer(const std::string& name, const std::string& attribute, const Values& message = {}, const unsigned long long timeout = 0ull)
+    {
+        return sendRequest(name, attribute, message, timeout).get();
+    }
 };
 
 } // namespace Splash
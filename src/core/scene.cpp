@@ -27,10 +27,12 @@
 #include "./userinput/userinput_joystick.h"
 #include "./userinput/userinput_keyboard.h"
 #include "./userinput/userinput_mouse.h"
+#include "./utils/latency.h"
 #include "./utils/log.h"
 #include "./utils/osutils.h"
 #include "./utils/scope_guard.h"
 #include "./utils/timer.h"
+#include "./utils/trace_recorder.h"
 
 #if HAVE_GPHOTO and HAVE_OPENCV
 #include "./controller/colorcalibrator.h"
@@ -61,6 +63,8 @@ std::vector<std::string> Scene::_ghostableTypes{"camera", "warp"};
 Scene::Scene(Context context)
     : RootObject(context)
 {
+    _creationDate = Timer::getTime();
+
     _type = "scene";
 #ifdef DEBUG
     Log::get() << Log::DEBUGGING << "Scene::Scene - Scene created successfully" << Log::endl;
@@ -108,6 +112,7 @@ Scene::~Scene()
             for (auto& obj : _objects)
                 obj.second.reset();
             _objects.clear();
+            _textureReadbackQueue.reset();
 
             mainRenderingContext->releaseContext();
         }
@@ -360,6 +365,16 @@ void Scene::render()
         }
     }
 
+    {
+        ZoneScopedN("Readback");
+
+        // Collect the texture readbacks from previous frames and issue the ones
+        // requested during this one, before the swap flushes the command stream
+        Timer::get() << "readback";
+        _textureReadbackQueue->process(_maxTextureReadbacksPerFrame);
+        Timer::get() >> "readback";
+    }
+
     {
         ZoneScopedN("Swap");
 
@@ -369,6 +384,9 @@ void Scene::render()
             if (obj.second->getType() == "window")
                 std::dynamic_pointer_cast<Window>(obj.second)->swapBuffers();
         Timer::get() >> "swap";
+
+        // Frames uploaded during this loop are now displayed
+        LatencyTracker::get().setDisplayed();
     }
 
     TracyGpuCollect;
@@ -398,6 +416,9 @@ void Scene::run()
     TracyGpuContext;
     DebugGraphicsScope;
 
+    // Messages sent during a loop are sent together at its end
+    _link->setMessageBatching(true);
+
     while (_isRunning)
     {
         FrameMarkStart("Scene");
@@ -436,6 +457,12 @@ void Scene::run()
                 Timer::get() >> "rendering";
             }
 
+            if (!_firstFrameRendered)
+            {
+                _firstFrameRendered = true;
+                logStartupTimeline();
+            }
+
             {
                 ZoneScopedN("Update inputs");
                 Timer::get() << "inputsUpdate";
@@ -458,6 +485,8 @@ void Scene::run()
             Timer::get() >> "tree_propagate";
         }
 
+        _link->flushMessages();
+
         // If no sync message was received from the World for more than 10 seconds, exit
         const int64_t syncTimeout = 10; // in seconds
         if (_lastSyncMessageDate != 0 && (Timer::getTime() - _lastSyncMessageDate) > 10 * 1e6)
@@ -468,6 +497,7 @@ void Scene::run()
 
         FrameMarkEnd("Scene");
     }
+    _link->setMessageBatching(false);
     mainRenderingContext->releaseContext();
 
     signalBufferObjectUpdated();
@@ -582,9 +612,27 @@ void Scene::init(const std::string& name)
         return;
 
     _objectLibrary = std::make_unique<ObjectLibrary>(this);
+    _textureReadbackQueue = std::make_unique<TextureReadbackQueue>(_renderer.get());
 
     _isInitialized = true;
     _renderer->init(name);
+    _contextCreationDate = Timer::getTime();
+}
+
+/*************/
+void Scene::logStartupTimeline()
+{
+    const auto toMilliseconds = [this](int64_t date) { return std::to_string((date - _creationDate) / 1000); };
+
+    // Shaders are compiled lazily, so their compilation is spread until the first frame
+    std::string shaderCompilation{""};
+    const auto statistics = Timer::get().getStatistics();
+    if (const auto shaderIt = statistics.find("shader_compile"); shaderIt != statistics.end())
+        shaderCompilation = ", including about " + std::to_string(shaderIt->second.average * shaderIt->second.count / 1000) + "ms compiling " +
+                            std::to_string(shaderIt->second.count) + " shader stages";
+
+    Log::get() << Log::MESSAGE << "Scene::" << __FUNCTION__ << " - Scene " << _name << " startup: rendering context after " << toMilliseconds(_contextCreationDate)
+               << "ms, started after " << toMilliseconds(_startDate) << "ms, first frame after " << toMilliseconds(Timer::getTime()) << "ms" << shaderCompilation << Log::endl;
 }
 
 /*************/
@@ -628,7 +676,7 @@ void Scene::registerAttributes()
 
     addAttribute("checkSceneRunning",
         [&](const Values&) {
-            sendMessageToWorld("sceneLaunched", {});
+            sendMessageToWorld("sceneLaunched", {_name});
             return true;
         },
         {});
@@ -720,6 +768,16 @@ void Scene::registerAttributes()
         {'b'});
     setAttributeDescription("logToFile", "If true, the process holding the Scene will try to write log to file");
 
+    addAttribute("recordTrace",
+        [&](const Values& args) {
+            const auto seconds = args[0].as<float>();
+            if (seconds <= 0.f)
+                return false;
+            return TraceRecorder::get().record(seconds, args[1].as<std::string>(), _name);
+        },
+        {'r', 's'});
+    setAttributeDescription("recordTrace", "Record the Timer and OpenGL profiling scopes for the given duration in seconds, and write them to the given file suffixed with the Scene name");
+
     addAttribute("ping",
         [&](const Values&) {
             signalBufferObjectUpdated();
@@ -730,8 +788,8 @@ void Scene::registerAttributes()
     setAttributeDescription("ping", "Ping the World");
 
     addAttribute("sync",
-        [&](const Values&) {
-            addTask([this]() { sendMessageToWorld("answerMessage", {"sync", _name}); });
+        [&](const Values& args) {
+            addTask([=, this]() { answerRequest("world", args, {"sync", _name}); });
             return true;
         },
         {});
@@ -763,9 +821,11 @@ void Scene::registerAttributes()
     setAttributeDescription("setMaster", "Set this Scene as master, can give the configuration file path as a parameter");
 
     addAttribute("start",
-        [&](const Values&) {
+        [&](const Values& args) {
+            int64_t notStarted = 0;
+            _startDate.compare_exchange_strong(notStarted, Timer::getTime());
             _started = true;
-            sendMessageToWorld("answerMessage", {"start", _name});
+            answerRequest("world", args, {"start", _name});
             return true;
         },
         {});
@@ -885,6 +945,15 @@ void Scene::registerAttributes()
         {});
 #endif
 
+    addAttribute("maxTextureReadbacksPerFrame",
+        [&](const Values& args) {
+            _maxTextureReadbacksPerFrame = std::max(1, args[0].as<int>());
+            return true;
+        },
+        [&]() -> Values { return {_maxTextureReadbacksPerFrame}; },
+        {'i'});
+    setAttributeDescription("maxTextureReadbacksPerFrame", "Maximum number of textures read back to the CPU each frame, for objects syncing their output to the 'buffer' attribute");
+
     addAttribute("runInBackground",
         [&](const Values& args) {
             _runInBackground = args[0].as<bool>();
@@ -928,6 +997,8 @@ void Scene::initializeTree()
     _tree.createBranchAt("/" + _name + "/attributes");
     _tree.createBranchAt("/" + _name + "/commands");
     _tree.createBranchAt("/" + _name + "/durations");
+    _tree.createBranchAt("/" + _name + "/durationStats");
+    _tree.createBranchAt("/" + _name + "/latencies");
     _tree.createBranchAt("/" + _name + "/logs");
     _tree.createBranchAt("/" + _name + "/objects");
 }
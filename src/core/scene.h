@@ -40,6 +40,7 @@
 #include "./core/spinlock.h"
 #include "./graphics/object_library.h"
 #include "./graphics/rendering_context.h"
+#include "./graphics/texture_readback_queue.h"
 
 namespace Splash
 {
@@ -96,6 +97,12 @@ class Scene : public RootObject
      */
     ObjectLibrary* getObjectLibrary() { return _objectLibrary.get(); }
 
+    /**
+     * Get the queue for asynchronous texture readbacks, shared by all objects of this Scene
+     * \return Return a pointer to the readback queue
+     */
+    TextureReadbackQueue* getTextureReadbackQueue() { return _textureReadbackQueue.get(); }
+
     /**
      * Get a raw pointer to the Scene graphic renderer
      * \return Return a raw pointer to the renderer
@@ -223,6 +230,7 @@ class Scene : public RootObject
 
   private:
     std::unique_ptr<ObjectLibrary> _objectLibrary{nullptr};     //!< Library of 3D objects used by multiple GraphObjects
+    std::unique_ptr<TextureReadbackQueue> _textureReadbackQueue{nullptr}; //!< Asynchronous texture readbacks, processed once per frame
     static inline std::unique_ptr<gfx::Renderer> _renderer{nullptr}; // Must be static due to usage inside static functions in Scene.
     gfx::Renderer::RendererMsgCallbackData _rendererMsgCallbackData;
 
@@ -233,10 +241,17 @@ class Scene : public RootObject
     bool _isInitialized{false};
     bool _status{false};                        //!< Set to true if an error occured during rendering
     int _swapInterval{1};                       //!< Global value for the swap interval, default for all windows
+    int _maxTextureReadbacksPerFrame{4};        //!< Maximum number of texture readbacks issued each frame
     unsigned long long _targetFrameDuration{0}; //!< Duration in microseconds of a frame at the refresh rate of the primary monitor
     std::atomic_bool _doUploadTextures{false};  //!< True if the render loop should upload the textures
     int64_t _lastSyncMessageDate{0};            //!< Time in µs a sync message was sent from World
 
+    // Startup timeline, in µs
+    int64_t _creationDate{0};           //!< Date at which the Scene was created
+    int64_t _contextCreationDate{0};    //!< Date at which the rendering context was created
+    std::atomic<int64_t> _startDate{0}; //!< Date at which the Scene was asked to start
+    bool _firstFrameRendered{false};    //!< Set to true once the first frame has been rendered
+
     static std::vector<std::string> _ghostableTypes;
 
     /**
@@ -257,6 +272,11 @@ class Scene : public RootObject
      */
     void init(const std::string& name);
 
+    /**
+     * Log the startup timeline of this Scene, from its creation to its first frame
+     */
+    void logStartupTimeline();
+
     /**
      *  Computes and store the duration of a frame at the refresh rate of the primary monitor
      * \return The duration of a frame at the refresh rate of the primary monitor in microseconds
@@ -66,7 +66,8 @@ struct serializeHelper<T, typename std::enable_if<std::is_same<ImageBuffer, T>::
 template <class T>
 struct deserializeHelper<T, typename std::enable_if<std::is_same<ImageBuffer, T>::value>::type>
 {
-    static T apply(std::vector<uint8_t>::const_iterator& it)
+    template <class Iterator>
+    static T apply(Iterator& it)
     {
         const auto name = deserializer<std::string>(it);
         const auto specString = deserializer<std::string>(it);
@@ -57,7 +57,8 @@ struct serializeHelper<T, typename std::enable_if<std::is_same<glm::vec2, T>::va
 template <class T>
 struct deserializeHelper<T, typename std::enable_if<std::is_same<glm::vec2, T>::value>::type>
 {
-    static T apply(std::vector<uint8_t>::const_iterator& it)
+    template <class Iterator>
+    static T apply(Iterator& it)
     {
         T vector;
         auto data = reinterpret_cast<uint8_t*>(&vector);
@@ -90,7 +91,8 @@ struct serializeHelper<T, typename std::enable_if<std::is_same<glm::vec4, T>::va
 template <class T>
 struct deserializeHelper<T, typename std::enable_if<std::is_same<glm::vec4, T>::value>::type>
 {
-    static T apply(std::vector<uint8_t>::const_iterator& it)
+    template <class Iterator>
+    static T apply(Iterator& it)
     {
         T vector;
         auto data = reinterpret_cast<uint8_t*>(&vector);
@@ -132,7 +134,8 @@ struct serializeHelper<T, typename std::enable_if<std::is_base_of<Mesh::MeshCont
 template <class T>
 struct deserializeHelper<T, typename std::enable_if<std::is_base_of<Mesh::MeshContainer, T>::value>::type>
 {
-    static T apply(std::vector<uint8_t>::const_iterator& it)
+    template <class Iterator>
+    static T apply(Iterator& it)
     {
         Mesh::MeshContainer meshContainer;
         meshContainer.name = deserializer<std::string>(it);
@@ -60,7 +60,8 @@ struct serializeHelper<T, typename std::enable_if<std::is_same<T, UUID>::value>:
 template <class T>
 struct deserializeHelper<T, typename std::enable_if<std::is_same<T, UUID>::value>::type>
 {
-    static T apply(std::vector<uint8_t>::const_iterator& it)
+    template <class Iterator>
+    static T apply(Iterator& it)
     {
         constexpr size_t size = sizeof(T);
         UUID obj(false);
@@ -54,7 +54,8 @@ struct serializeHelper<T, typename std::enable_if<std::is_same<T, Value::Buffer>
 template <class T>
 struct deserializeHelper<T, typename std::enable_if<std::is_same<T, Value::Buffer>::value>::type>
 {
-    static T apply(std::vector<uint8_t>::const_iterator& it)
+    template <class Iterator>
+    static T apply(Iterator& it)
     {
         auto size = deserializer<uint32_t>(it);
         T obj(static_cast<size_t>(size));
@@ -118,7 +119,8 @@ struct serializeHelper<T, typename std::enable_if<std::is_same<T, Value>::value>
 template <class T>
 struct deserializeHelper<T, typename std::enable_if<std::is_same<T, Value>::value>::type>
 {
-    static Value apply(std::vector<uint8_t>::const_iterator& it)
+    template <class Iterator>
+    static Value apply(Iterator& it)
     {
         T obj;
         Value::Type type;
@@ -25,6 +25,9 @@
 #ifndef SPLASH_SERIALIZED_OBJECT_H
 #define SPLASH_SERIALIZED_OBJECT_H
 
+#include <memory>
+#include <span>
+
 #include "./utils/resizable_array.h"
 
 namespace Splash
@@ -63,6 +66,18 @@ struct SerializedObject
     {
     }
 
+    /**
+     * Constructor from a view over memory owned by someone else, kept alive by the holder
+     * as long as the view is used. The data is only copied if it has to be modified.
+     * \param view View over the data
+     * \param holder Holder of the memory, released along with the view
+     */
+    SerializedObject(std::span<const uint8_t> view, std::shared_ptr<const void> holder)
+        : _view(view)
+        , _viewHolder(std::move(holder))
+    {
+    }
+
     /**
      * Prevent copy constructor and operator
      * Allow for move constructor and operator
@@ -76,29 +91,57 @@ struct SerializedObject
      * Get the pointer to the data
      * \return Return a pointer to the data
      */
-    inline uint8_t* data() { return _data.data(); }
-    inline const uint8_t* data() const { return _data.data(); }
+    inline uint8_t* data()
+    {
+        ownData();
+        return _data.data();
+    }
+    inline const uint8_t* data() const { return _viewHolder ? _view.data() : _data.data(); }
 
     /**
      * Get ownership over the inner buffer. Use with caution, as it invalidates the SerializedObject
      * \return Return the inner buffer as a rvalue
      */
-    inline ResizableArray<uint8_t>&& grabData() { return std::move(_data); }
+    inline ResizableArray<uint8_t>&& grabData()
+    {
+        ownData();
+        return std::move(_data);
+    }
 
     /**
      * Get the size of the data
      * \return Return the size
      */
-    inline std::size_t size() const { return _data.size(); }
+    inline std::size_t size() const { return _viewHolder ? _view.size() : _data.size(); }
 
     /**
      * Modify the size of the data
      * \param s New size
      */
-    inline void resize(size_t s) { _data.resize(s); }
+    inline void resize(size_t s)
+    {
+        ownData();
+        _data.resize(s);
+    }
 
     //! Inner buffer
     ResizableArray<uint8_t> _data{};
+
+  private:
+    std::span<const uint8_t> _view{};           //!< View over data owned by someone else
+    std::shared_ptr<const void> _viewHolder{}; //!< Holder of the viewed data, set as long as the view is used
+
+    /**
+     * Copy the viewed data to the inner buffer, if it is a view, and release the view
+     */
+    inline void ownData()
+    {
+        if (!_viewHolder)
+            return;
+        _data = ResizableArray<uint8_t>(_view.data(), _view.data() + _view.size());
+        _view = {};
+        _viewHolder.reset();
+    }
 };
 
 } // namespace Splash
@@ -22,6 +22,10 @@
  * The serializer and deserializer methods
  * This has been inspired a lot by https://github.com/motonacciu/meta-serialization
  * For the sake of supporting multiple platforms, size_t is converted to uint32_t
+ *
+ * Deserialization works on any contiguous view over the serialized data. A std::string_view
+ * can be deserialized in place of a std::string, in which case it points into the
+ * serialized data and is only valid as long as that data is.
  */
 
 #ifndef SPLASH_SERIALIZER_H
@@ -29,8 +33,11 @@
 
 #include <chrono>
 #include <iterator>
+#include <memory>
 #include <numeric>
+#include <span>
 #include <string>
+#include <string_view>
 #include <tuple>
 #include <type_traits>
 #include <utility>
@@ -110,6 +117,12 @@ struct getSizeHelper<T, typename std::enable_if<std::is_same<T, std::string>::va
     static uint32_t value(const T& obj) { return sizeof(uint32_t) + obj.size() * sizeof(typename T::value_type); }
 };
 
+template <class T>
+struct getSizeHelper<T, typename std::enable_if<std::is_same<T, std::string_view>::value>::type>
+{
+    static uint32_t value(const T& obj) { return sizeof(uint32_t) + obj.size() * sizeof(typename T::value_type); }
+};
+
 template <class T>
 struct getSizeHelper<T, typename std::enable_if<is_specialisation_of<std::chrono::time_point, T>::value>::type>
 {
@@ -117,7 +130,7 @@ struct getSizeHelper<T, typename std::enable_if<is_specialisation_of<std::chrono
 };
 
 template <class T>
-struct getSizeHelper<T, typename std::enable_if<isIterable<T>::value && !std::is_same<T, std::string>::value>::type>
+struct getSizeHelper<T, typename std::enable_if<isIterable<T>::value && !std::is_same<T, std::string>::value && !std::is_same<T, std::string_view>::value>::type>
 {
     static uint32_t value(const T& obj)
     {
@@ -185,7 +198,7 @@ struct serializeHelper<T, typename std::enable_if<std::is_arithmetic<T>::value |
 };
 
 template <class T>
-struct serializeHelper<T, typename std::enable_if<std::is_same<std::string, T>::value>::type>
+struct serializeHelper<T, typename std::enable_if<std::is_same<std::string, T>::value || std::is_same<std::string_view, T>::value>::type>
 {
     static void apply(const T& obj, std::vector<uint8_t>::iterator& it)
     {
@@ -211,7 +224,7 @@ struct serializeHelper<T, typename std::enable_if<is_specialisation_of<std::chro
 };
 
 template <class T>
-struct serializeHelper<T, typename std::enable_if<isIterable<T>::value && !std::is_same<std::string, T>::value>::type>
+struct serializeHelper<T, typename std::enable_if<isIterable<T>::value && !std::is_same<std::string, T>::value && !std::is_same<std::string_view, T>::value>::type>
 {
     static void apply(const T& obj, std::vector<uint8_t>::iterator& it)
     {
@@ -277,13 +290,14 @@ namespace detail
 template <class T, class Enable = void>
 struct deserializeHelper;
 
-template <class T>
-T deserializer(std::vector<uint8_t>::const_iterator& it);
+template <class T, class Iterator>
+T deserializer(Iterator& it);
 
 template <class T>
 struct deserializeHelper<T, typename std::enable_if<std::is_arithmetic<T>::value || std::is_enum<T>::value>::type>
 {
-    static T apply(std::vector<uint8_t>::const_iterator& it)
+    template <class Iterator>
+    static T apply(Iterator& it)
     {
         T obj;
         std::copy(it, it + sizeof(T), reinterpret_cast<uint8_t*>(&obj));
@@ -295,7 +309,8 @@ struct deserializeHelper<T, typename std::enable_if<std::is_arithmetic<T>::value
 template <class T>
 struct deserializeHelper<T, typename std::enable_if<std::is_same<T, std::string>::value>::type>
 {
-    static T apply(std::vector<uint8_t>::const_iterator& it)
+    template <class Iterator>
+    static T apply(Iterator& it)
     {
         const auto size = deserializer<uint32_t>(it);
         auto obj = T(static_cast<size_t>(size), ' ');
@@ -306,10 +321,24 @@ struct deserializeHelper<T, typename std::enable_if<std::is_same<T, std::string>
     }
 };
 
+template <class T>
+struct deserializeHelper<T, typename std::enable_if<std::is_same<T, std::string_view>::value>::type>
+{
+    template <class Iterator>
+    static T apply(Iterator& it)
+    {
+        const auto size = deserializer<uint32_t>(it);
+        auto obj = T(reinterpret_cast<const typename T::value_type*>(std::to_address(it)), static_cast<size_t>(size));
+        it += size * sizeof(typename T::value_type);
+        return obj;
+    }
+};
+
 template <class T>
 struct deserializeHelper<T, typename std::enable_if<is_specialisation_of<std::chrono::time_point, T>::value>::type>
 {
-    static T apply(std::vector<uint8_t>::const_iterator& it)
+    template <class Iterator>
+    static T apply(Iterator& it)
     {
         int64_t value;
         std::copy(it, it + sizeof(value), reinterpret_cast<uint8_t*>(&value));
@@ -319,9 +348,10 @@ struct deserializeHelper<T, typename std::enable_if<is_specialisation_of<std::ch
 };
 
 template <class T>
-struct deserializeHelper<T, typename std::enable_if<isIterable<T>::value && !std::is_same<T, std::string>::value>::type>
+struct deserializeHelper<T, typename std::enable_if<isIterable<T>::value && !std::is_same<T, std::string>::value && !std::is_same<T, std::string_view>::value>::type>
 {
-    static T apply(std::vector<uint8_t>::const_iterator& it)
+    template <class Iterator>
+    static T apply(Iterator& it)
     {
         auto size = deserializer<uint32_t>(it);
         auto obj = T(static_cast<size_t>(size));
@@ -335,16 +365,16 @@ struct deserializeHelper<T, typename std::enable_if<isIterable<T>::value && !std
     }
 };
 
-template <class T>
-inline void deserializeTuple(T& obj, std::vector<uint8_t>::const_iterator& it, int_<0>)
+template <class T, class Iterator>
+inline void deserializeTuple(T& obj, Iterator& it, int_<0>)
 {
     constexpr size_t idx = std::tuple_size<T>::value - 1;
     typedef typename std::tuple_element<idx, T>::type U;
     std::get<idx>(obj) = std::move(deserializer<U>(it));
 }
 
-template <class T, size_t pos>
-inline void deserializeTuple(T& obj, std::vector<uint8_t>::const_iterator& it, int_<pos>)
+template <class T, size_t pos, class Iterator>
+inline void deserializeTuple(T& obj, Iterator& it, int_<pos>)
 {
     constexpr size_t idx = std::tuple_size<T>::value - pos - 1;
     typedef typename std::tuple_element<idx, T>::type U;
@@ -355,7 +385,8 @@ inline void deserializeTuple(T& obj, std::vector<uint8_t>::const_iterator& it, i
 template <class T>
 struct deserializeHelper<T, typename std::enable_if<is_specialisation_of<std::tuple, T>::value>::type>
 {
-    static T apply(std::vector<uint8_t>::const_iterator& it)
+    template <class Iterator>
+    static T apply(Iterator& it)
     {
         T obj;
         constexpr size_t tupleSize = std::tuple_size<T>::value - 1;
@@ -364,8 +395,8 @@ struct deserializeHelper<T, typename std::enable_if<is_specialisation_of<std::tu
     }
 };
 
-template <class T>
-T deserializer(std::vector<uint8_t>::const_iterator& it)
+template <class T, class Iterator>
+T deserializer(Iterator& it)
 {
     return deserializeHelper<T>::apply(it);
 }
@@ -384,6 +415,19 @@ inline T deserialize(const std::vector<uint8_t>& buffer, size_t offset = 0)
     return detail::deserializer<T>(it);
 }
 
+/**
+ * Deserialize the given view over serialized data, without copying it first
+ * \param buffer View over the data to deserialize, which must outlive any std::string_view deserialized from it
+ * \param offset Offset to start deserializing from
+ * \return Return the deserialized object
+ */
+template <class T>
+inline T deserialize(std::span<const uint8_t> buffer, size_t offset = 0)
+{
+    auto it = buffer.data() + offset;
+    return detail::deserializer<T>(it);
+}
+
 } // namespace Serial
 
 } // namespace Splash
@@ -59,6 +59,7 @@ bool Branch::addBranch(std::unique_ptr<Branch>&& branch)
 
     branch->setParent(this);
     _branches.emplace(branchName, std::move(branch));
+    _branchListVersion = ++_versionCounter;
 
     for (const auto& id : _callbackTargetIds[Task::AddBranch])
         _callbacks[id](*this, branchName);
@@ -118,6 +119,7 @@ std::unique_ptr<Branch> Branch::cutBranch(const std::string& branchName)
     std::unique_ptr<Branch> branch{nullptr};
     swap(branchIt->second, branch);
     _branches.erase(branchIt);
+    _branchListVersion = ++_versionCounter;
     branch->setParent(nullptr);
     return branch;
 }
@@ -211,6 +213,7 @@ bool Branch::removeBranch(const std::string& name)
 
     _branches[name]->setParent(nullptr);
     _branches.erase(name);
+    _branchListVersion = ++_versionCounter;
 
     return true;
 }
@@ -242,6 +245,7 @@ bool Branch::renameBranch(const std::string& name, const std::string& newName)
     branchIt->second->setName(newName);
     _branches.emplace(newName, std::move(branchIt->second));
     _branches.erase(name);
+    _branchListVersion = ++_versionCounter;
     return true;
 }
 
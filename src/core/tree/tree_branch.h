@@ -25,6 +25,7 @@
 #ifndef SPLASH_TREE_BRANCH_H
 #define SPLASH_TREE_BRANCH_H
 
+#include <atomic>
 #include <chrono>
 #include <functional>
 #include <list>
@@ -141,6 +142,13 @@ class Branch
      */
     std::list<std::string> getBranchList() const;
 
+    /**
+     * Get the version of the list of branches connected to this branch
+     * It changes every time a branch is added, removed or renamed, and is unique across all branches
+     * \return Return the version
+     */
+    uint64_t getBranchListVersion() const { return _branchListVersion; }
+
     /**
      * Get the leaf by its name
      * \param name Leaf name
@@ -228,6 +236,8 @@ class Branch
     void setParent(Branch* parent) { _parentBranch = parent; }
 
   private:
+    inline static std::atomic_uint64_t _versionCounter{0};
+
     int _currentCallbackID{0};
     std::mutex _callbackMutex;
     std::map<Task, std::set<int>> _callbackTargetIds{};
@@ -236,6 +246,7 @@ class Branch
     DenseMap<std::string, std::unique_ptr<Branch>> _branches{};
     DenseMap<std::string, std::unique_ptr<Leaf>> _leaves{};
     Branch* _parentBranch{nullptr};
+    uint64_t _branchListVersion{++_versionCounter};
 };
 
 } // namespace Tree
@@ -243,6 +243,14 @@ class Root
      */
     bool getError(std::string& error);
 
+    /**
+     * Get a pointer to the branch at the given path
+     * The pointer is only valid as long as the tree is locked, see getHandle()
+     * \param path Path to the branch
+     * \return Return the branch, or nullptr
+     */
+    Branch* getBranchAt(const std::string& path) const;
+
     /**
      * Get the list of branches connected to the root
      * \param path Optional branch path
@@ -401,13 +409,6 @@ class Root
      */
     std::list<Seed> generateSeedsForLeaf(Leaf* leaf);
 
-    /**
-     * Get a pointer to the branch at the given path
-     * \param path Path to the branch
-     * \return Return the branch, or nullptr
-     */
-    Branch* getBranchAt(const std::string& path) const;
-
     /**
      * Get a pointer to the branch at the given path
      * \param path Path as a list of strings
@@ -25,6 +25,8 @@
 #ifndef SPLASH_VALUE_H
 #define SPLASH_VALUE_H
 
+#include <array>
+#include <bit>
 #include <cassert>
 #include <iostream>
 #include <memory>
@@ -88,7 +90,10 @@ struct Value
         else if constexpr (std::is_same_v<T, Values>)
         {
             _type = Type::values;
-            _data = v;
+            if (Numbers numbers; toNumbers(v, numbers))
+                _data = numbers;
+            else
+                _data = v;
         }
         else if constexpr (std::is_same_v<T, Buffer>)
         {
@@ -101,20 +106,51 @@ struct Value
         }
     }
 
+    // Containers given as rvalues are moved instead of copied
+    Value(Values&& v, const std::string& name = "")
+        : _name(name)
+        , _type(Type::values)
+    {
+        if (Numbers numbers; toNumbers(v, numbers))
+            _data = numbers;
+        else
+            _data = std::move(v);
+    }
+
+    Value(std::string&& v, const std::string& name = "")
+        : _name(name)
+        , _type(Type::string)
+        , _data(std::move(v))
+    {
+    }
+
+    Value(Buffer&& v, const std::string& name = "")
+        : _name(name)
+        , _type(Type::buffer)
+        , _data(std::move(v))
+    {
+    }
+
     template <class InputIt>
     Value(InputIt first, InputIt last)
-        : _type(Type::values)
-        , _data(Values(first, last))
+        : Value(Values(first, last))
     {
     }
 
     Value(const std::initializer_list<Value>& list)
     {
         _type = Type::values;
+        if (Numbers numbers; toNumbers(list, numbers))
+        {
+            _data = numbers;
+            return;
+        }
+
         Values values;
+        values.reserve(list.size());
         for (auto& value : list)
             values.emplace_back(value);
-        _data = values;
+        _data = std::move(values);
     }
 
     bool operator==(const Value& v) const
@@ -142,13 +178,11 @@ struct Value
             return std::get<std::string>(_data) == std::get<std::string>(v._data);
         case Type::values:
         {
-            auto& data = std::get<Values>(_data);
-            auto& other = std::get<Values>(v._data);
-            if (data.size() != other.size())
+            if (size() != v.size())
                 return false;
             bool isEqual = true;
-            for (uint32_t i = 0; i < data.size(); ++i)
-                isEqual &= (data[i] == other[i]);
+            for (uint32_t i = 0; i < size(); ++i)
+                isEqual &= (getElement(i) == v.getElement(i));
             return isEqual;
         }
         case Type::buffer:
@@ -165,17 +199,16 @@ struct Value
         }
     }
 
-    bool operator==(const Values v) const
+    bool operator==(const Values& v) const
     {
         if (_type != Type::values)
             return false;
 
-        auto& data = std::get<Values>(_data);
-        if (data.size() != v.size())
+        if (size() != v.size())
             return false;
         bool isEqual = true;
-        for (uint32_t i = 0; i < data.size(); ++i)
-            isEqual &= (data[i] == v[i]);
+        for (uint32_t i = 0; i < v.size(); ++i)
+            isEqual &= (getElement(i) == v[i]);
         return isEqual;
     }
 
@@ -185,7 +218,7 @@ struct Value
     {
         if (_type == Type::values)
         {
-            auto& data = std::get<Values>(_data);
+            auto& data = getValues();
             return data[index];
         }
         else
@@ -194,17 +227,13 @@ struct Value
         }
     }
 
-    const Value& operator[](int index) const
+    // Elements are returned by value, as inline numbers are not stored as Value
+    Value operator[](int index) const
     {
         if (_type == Type::values)
-        {
-            const auto& data = std::get<Values>(_data);
-            return data[index];
-        }
+            return getElement(index);
         else
-        {
             return *this;
-        }
     }
 
     template <class T>
@@ -342,12 +371,12 @@ struct Value
                 return false;
             else if constexpr (std::is_same_v<T, std::string>)
             {
-                auto& data = std::get<Values>(_data);
+                const auto count = size();
                 std::string out = "[";
-                for (uint32_t i = 0; i < data.size(); ++i)
+                for (uint32_t i = 0; i < count; ++i)
                 {
-                    out += data[i].as<std::string>();
-                    if (data.size() > 1 && i < data.size() - 1)
+                    out += getElement(i).template as<std::string>();
+                    if (count > 1 && i < count - 1)
                         out += ", ";
                 }
                 out += "]";
@@ -356,7 +385,17 @@ struct Value
             else if constexpr (std::is_arithmetic_v<T>)
                 return 0;
             else if constexpr (std::is_same_v<T, Values>)
+            {
+                if (const auto numbers = std::get_if<Numbers>(&_data))
+                {
+                    Values values;
+                    values.reserve(numbers->size);
+                    for (uint32_t i = 0; i < numbers->size; ++i)
+                        values.emplace_back(getNumber(*numbers, i));
+                    return values;
+                }
                 return std::get<Values>(_data);
+            }
             else if constexpr (std::is_same_v<T, Buffer>)
                 return {};
             else
@@ -441,7 +480,7 @@ struct Value
         }
     }
 
-    std::string getName() const { return _name; }
+    const std::string& getName() const { return _name; }
     void setName(const std::string& name) { _name = name; }
     bool isNamed() const { return !_name.empty(); }
 
@@ -541,6 +580,12 @@ struct Value
         case Type::values:
         {
             size_t size = 0;
+            if (const auto numbers = std::get_if<Numbers>(&_data))
+            {
+                for (uint32_t i = 0; i < numbers->size; ++i)
+                    size += getNumber(*numbers, i).byte_size();
+                return size;
+            }
             for (const auto& value : std::get<Values>(_data))
                 size += value.byte_size();
             return size;
@@ -572,6 +617,8 @@ struct Value
         case Type::string:
             return std::get<std::string>(_data).size();
         case Type::values:
+            if (const auto numbers = std::get_if<Numbers>(&_data))
+                return numbers->size;
             return std::get<Values>(_data).size();
         case Type::buffer:
             return std::get<Buffer>(_data).size();
@@ -598,6 +645,8 @@ struct Value
         case Type::string:
             return std::get<std::string>(_data).empty();
         case Type::values:
+            if (const auto numbers = std::get_if<Numbers>(&_data))
+                return numbers->size == 0;
             return std::get<Values>(_data).empty();
         case Type::buffer:
             return std::get<Buffer>(_data).size() > 0;
@@ -605,9 +654,111 @@ struct Value
     }
 
   private:
+    /**
+     * Small tuple of numbers, stored inline to avoid allocating a Values for colors, vectors, etc.
+     * Reals are stored bitwise in the int64_t storage.
+     */
+    struct Numbers
+    {
+        static constexpr uint32_t capacity{4};
+        std::array<int64_t, capacity> data{};
+        std::array<Type, capacity> types{};
+        uint8_t size{0};
+    };
+
+    /**
+     * Convert a list of values to inline numbers, if they are few unnamed numbers
+     * \param values Values to convert
+     * \param numbers Converted numbers
+     * \return Return true if the values could be converted
+     */
+    template <class Container>
+    static bool toNumbers(const Container& values, Numbers& numbers)
+    {
+        if (values.size() == 0 || values.size() > Numbers::capacity)
+            return false;
+
+        for (const auto& value : values)
+        {
+            if (value.isNamed())
+                return false;
+
+            switch (value._type)
+            {
+            default:
+                return false;
+            case Type::boolean:
+                numbers.data[numbers.size] = std::get<bool>(value._data);
+                break;
+            case Type::integer:
+                numbers.data[numbers.size] = std::get<int64_t>(value._data);
+                break;
+            case Type::real:
+                numbers.data[numbers.size] = std::bit_cast<int64_t>(std::get<double>(value._data));
+                break;
+            }
+            numbers.types[numbers.size++] = value._type;
+        }
+
+        return true;
+    }
+
+    /**
+     * Get one of the inline numbers as a Value
+     * \param numbers Inline numbers
+     * \param index Number index
+     * \return Return the number as a Value
+     */
+    static Value getNumber(const Numbers& numbers, uint32_t index)
+    {
+        switch (numbers.types[index])
+        {
+        default:
+            assert(false);
+            return {};
+        case Type::boolean:
+            return Value(numbers.data[index] != 0);
+        case Type::integer:
+            return Value(numbers.data[index]);
+        case Type::real:
+            return Value(std::bit_cast<double>(numbers.data[index]));
+        }
+    }
+
+    /**
+     * Get an element of a Value of type values, whatever its storage
+     * \param index Element index
+     * \return Return the element
+     */
+    Value getElement(uint32_t index) const
+    {
+        if (const auto numbers = std::get_if<Numbers>(&_data))
+            return getNumber(*numbers, index);
+        return std::get<Values>(_data)[index];
+    }
+
+    /**
+     * Get the elements of a Value of type values, moving inline numbers to a Values if needed
+     * This is only needed to give mutable access to the elements by reference, const accesses
+     * go through getElement and never modify the storage.
+     * \return Return the elements
+     */
+    Values& getValues()
+    {
+        if (const auto numbers = std::get_if<Numbers>(&_data))
+        {
+            Values values;
+            values.reserve(numbers->size);
+            for (uint32_t i = 0; i < numbers->size; ++i)
+                values.emplace_back(getNumber(*numbers, i));
+            _data = std::move(values);
+        }
+        return std::get<Values>(_data);
+    }
+
     std::string _name{""};
     mutable Type _type{Type::empty};
-    mutable std::variant<bool, int64_t, double, std::string, Values, Buffer> _data{};
+    mutable std::variant<bool, int64_t, double, std::string, Values, Buffer, Numbers> _data{};
 }; // namespace Splash
 
 } // namespace Splash
@@ -27,7 +27,9 @@
 #include "./utils/jsonutils.h"
 #include "./utils/log.h"
 #include "./utils/osutils.h"
+#include "./utils/scope_guard.h"
 #include "./utils/timer.h"
+#include "./utils/trace_recorder.h"
 
 using namespace glm;
 
@@ -136,19 +138,30 @@ void World::run()
     if (!applyConfig())
         return;
 
+    // Timers used in the main loop, which ids are computed at compile time
+    static constexpr Timer::Scope loopWorldTimer("loop_world");
+    static constexpr Timer::Scope loopWorldInnerTimer("loop_world_inner");
+    static constexpr Timer::Scope treeProcessTimer("tree_process");
+    static constexpr Timer::Scope serializeTimer("serialize");
+    static constexpr Timer::Scope uploadTimer("upload");
+    static constexpr Timer::Scope treePropagateTimer("tree_propagate");
+
+    // Messages sent during a loop are sent together at its end
+    _link->setMessageBatching(true);
+
     while (true)
     {
         FrameMarkStart("World");
 
-        Timer::get() << "loop_world";
-        Timer::get() << "loop_world_inner";
+        Timer::get() << loopWorldTimer;
+        Timer::get() << loopWorldInnerTimer;
 
         {
             // Process tree updates
             ZoneScopedN("Process tree");
-            Timer::get() << "tree_process";
+            Timer::get() << treeProcessTimer;
             _tree.processQueue(true);
-            Timer::get() >> "tree_process";
+            Timer::get() >> treeProcessTimer;
 
             // Execute waiting tasks
             executeTreeCommands();
@@ -160,8 +173,15 @@ void World::run()
             std::lock_guard<std::recursive_mutex> lockObjects(_objectsMutex);
 
             // Read and serialize new buffers
-            Timer::get() << "serialize";
-            std::vector<SerializedObject> serializedObjects;
+            Timer::get() << serializeTimer;
+            struct SerializedBuffer
+            {
+                SerializedObject object;
+                std::shared_ptr<BufferObject> bufferObject;
+                ChannelOutput::BufferPriority priority;
+                ChannelOutput::BufferPriority previousPriority;
+            };
+            std::vector<SerializedBuffer> serializedObjects;
 
             {
                 ZoneScopedN("Serialize buffers");
@@ -174,15 +194,20 @@ void World::run()
                     object->update();
                     if (auto bufferObject = std::dynamic_pointer_cast<BufferObject>(object); bufferObject)
                     {
-                        if (bufferObject->wasUpdated())
+                        // Rate limited objects keep their update flag until they are due
+                        if (bufferObject->wasUpdated() && bufferObject->isTransportDue())
                         {
                             auto serializedObject = bufferObject->serialize();
                             bufferObject->setNotUpdated();
-                            serializedObjects.push_back(std::move(serializedObject));
+                            const auto priority = bufferObject->getTransportPriority();
+                            const auto previousPriority = bufferObject->setTransported(priority);
+                            // Content identical to the one last sent is already known to the scenes
+                            if (bufferObject->hasNewContent(serializedObject))
+                                serializedObjects.push_back({std::move(serializedObject), bufferObject, priority, previousPriority});
                         }
                     }
                 }
-                Timer::get() >> "serialize";
+                Timer::get() >> serializeTimer;
             }
 
             // Wait for previous buffers to be uploaded
@@ -190,15 +215,25 @@ void World::run()
                 ZoneScopedN("Wait for buffers to be sent");
                 _link->waitForBufferSending(std::chrono::milliseconds(50)); // Maximum time to wait for frames to arrive
                 sendMessage(Constants::ALL_PEERS, "syncScenes", {});
-                Timer::get() >> "upload";
+                Timer::get() >> uploadTimer;
             }
 
             // Ask for the upload of the new buffers, during the next world loop
             {
                 ZoneScopedN("Prepare sending next buffers");
-                Timer::get() << "upload";
-                for (auto& serializedObject : serializedObjects)
-                    _link->sendBuffer(std::move(serializedObject));
+                Timer::get() << uploadTimer;
+                for (auto& [serializedObject, bufferObject, priority, previousPriority] : serializedObjects)
+                {
+                    // When the transport policy changed lanes, the buffers still queued in the previous lane
+                    // are sent first, so that they do not overwrite this newer one once received
+                    if (priority != previousPriority && !_link->waitForBufferSending(std::chrono::milliseconds(100), previousPriority))
+                        Log::get() << Log::DEBUGGING << "World::" << __FUNCTION__ << " - Buffers of the previous lane of " << bufferObject->getName() << " are still being sent"
+                                   << Log::endl;
+
+                    // A buffer which could not be sent has to be sent again, even if its content does not change
+                    if (!_link->sendBuffer(std::move(serializedObject), priority))
+                        bufferObject->setDirty();
+                }
             }
         }
 
@@ -206,24 +241,27 @@ void World::run()
         {
             for (auto& s : _scenes)
                 sendMessage(s.first, "quit", {});
+            _link->setMessageBatching(false);
             break;
         }
 
         {
             ZoneScopedN("Propagate tree");
-            Timer::get() << "tree_propagate";
+            Timer::get() << treePropagateTimer;
             updateTreeFromObjects();
             propagateTree();
-            Timer::get() >> "tree_propagate";
+            Timer::get() >> treePropagateTimer;
         }
 
+        _link->flushMessages();
+
         // Sync with buffer object update
-        Timer::get() >> "loop_world_inner";
-        auto elapsed = Timer::get().getDuration("loop_world_inner");
+        Timer::get() >> loopWorldInnerTimer;
+        auto elapsed = Timer::get().getDuration(loopWorldInnerTimer);
         waitSignalBufferObjectUpdated(std::max<uint64_t>(1, 1e6 / (float)_worldFramerate - elapsed));
 
         // Sync to world framerate
-        Timer::get() >> "loop_world";
+        Timer::get() >> loopWorldTimer;
 
         FrameMarkEnd("World");
     }
@@ -252,6 +290,13 @@ bool World::applyConfig()
     _scenes.clear();
     _objects.clear();
     _masterSceneName = "";
+    {
+        std::lock_guard<std::mutex> lockChildProcess(_childProcessMutex);
+        _sceneStartups.clear();
+    }
+
+    const auto configStartDate = Timer::getTime();
+    std::map<std::string, int64_t> sceneConfigurationDates;
 
     try
     {
@@ -262,6 +307,7 @@ bool World::applyConfig()
             return false;
         }
 
+        // All scenes are spawned before waiting for any of them, so that they start concurrently
         const Json::Value& scenes = _config["scenes"];
         const auto& sceneNames = scenes.getMemberNames();
         const auto sceneCount = sceneNames.size();
@@ -277,15 +323,18 @@ bool World::applyConfig()
             const bool spawnSubprocess = spawn && _context.spawnSubprocesses;
             if (!addScene(sceneName, sceneDisplay, sceneAddress, spawnSubprocess, allowEmbbededScene))
                 return false;
-
-            // Set the remaining parameters
-            for (const auto& paramName : scenes[sceneName].getMemberNames())
-            {
-                auto values = Utils::jsonToValues(scenes[sceneName][paramName]);
-                sendMessage(sceneName, paramName, values);
-            }
         }
 
+        // Wait CONNECTION_TIMEOUT seconds maximum for scenes to start. Otherwise we consider
+        // it failed, and we quit
+        if (!waitForSpawnedScenes())
+            return false;
+
+        // The configuration of each Scene is sent as a single batch of messages
+        const auto wasBatching = _link->isMessageBatching();
+        _link->setMessageBatching(true);
+        OnScopeExit { _link->setMessageBatching(wasBatching); };
+
         // Reseeds the world branch into the Scene's trees
         propagatePath("/world");
 
@@ -294,38 +343,52 @@ bool World::applyConfig()
         // First, set the master scene
         sendMessage(_masterSceneName, "setMaster", {_configFilename});
 
-        // Then, we create the objects
         for (const auto& scene : _scenes)
         {
-            const Json::Value& objects = _config["scenes"][scene.first]["objects"];
-            if (!objects)
-                continue;
+            // Set the scene parameters
+            const Json::Value& sceneConfig = scenes[scene.first];
+            for (const auto& paramName : sceneConfig.getMemberNames())
+            {
+                auto values = Utils::jsonToValues(sceneConfig[paramName]);
+                sendMessage(scene.first, paramName, values);
+            }
 
-            // Create the objects
-            auto sceneMembers = objects.getMemberNames();
-            for (const auto& objectName : objects.getMemberNames())
+            // Then, we create the objects. They are synced all at once afterwards
+            const Json::Value& objects = sceneConfig["objects"];
+            if (objects)
             {
-                if (!objects[objectName].isMember("type"))
-                    continue;
+                std::lock_guard<std::recursive_mutex> lockObjects(_objectsMutex);
+                for (const auto& objectName : objects.getMemberNames())
+                {
+                    if (!objects[objectName].isMember("type"))
+                        continue;
 
-                setAttribute("addObject", {objects[objectName]["type"].asString(), objectName, scene.first, false});
+                    addObjectToScene(objects[objectName]["type"].asString(), objectName, scene.first);
+                    set(objectName, "configFilePath", {Utils::getPathFromFilePath(_configFilename)}, false);
+                }
             }
 
-            sendMessage(Constants::ALL_PEERS, "runInBackground", {_context.hide});
+            _link->flushMessages();
         }
 
-        // Wait CONNECTION_TIMEOUT seconds maximum for scenes to start. Otherwise we consider
-        // it failed, and we quit
+        sendMessage(Constants::ALL_PEERS, "runInBackground", {_context.hide});
+
+        // All scenes are synced in parallel
+        std::vector<std::pair<std::string, std::future<Values>>> syncRequests;
         for (const auto& s : _scenes)
+            syncRequests.emplace_back(s.first, sendRequest(s.first, "sync", {}, Constants::CONNECTION_TIMEOUT * 1'000'000));
+
+        for (auto& [sceneName, syncRequest] : syncRequests)
         {
-            auto returnValue = sendMessageWithAnswer(s.first, "sync", {}, Constants::CONNECTION_TIMEOUT * 1'000'000);
-            if (returnValue.empty() || returnValue[1].as<std::string>() != s.first)
+            auto returnValue = syncRequest.get();
+            if (returnValue.empty() || returnValue[1].as<std::string>() != sceneName)
             {
-                Log::get() << Log::ERROR << "World::" << __FUNCTION__ << " - Timeout when trying to sync with scene \"" << s.first << "\" before configuration. Exiting."
+                Log::get() << Log::ERROR << "World::" << __FUNCTION__ << " - Timeout when trying to sync with scene \"" << sceneName << "\" before configuration. Exiting."
                            << Log::endl;
                 _quit = true;
                 return false;
             }
+            sceneConfigurationDates[sceneName] = Timer::getTime();
         }
 
         // Then we link the objects together
@@ -412,15 +475,22 @@ bool World::applyConfig()
 #endif
 
     // Send the start message for all scenes
+    std::vector<std::pair<std::string, std::future<Values>>> startRequests;
     for (auto& s : _scenes)
+        startRequests.emplace_back(s.first, sendRequest(s.first, "start", {}, Constants::CONNECTION_TIMEOUT * 1'000'000));
+
+    for (auto& [sceneName, startRequest] : startRequests)
     {
-        auto answer = sendMessageWithAnswer(s.first, "start", {}, Constants::CONNECTION_TIMEOUT * 1'000'000);
+        auto answer = startRequest.get();
         if (0 == answer.size())
         {
-            Log::get() << Log::ERROR << "World::" << __FUNCTION__ << " - Timeout when trying to start scene \"" << s.first << "\". Exiting." << Log::endl;
+            Log::get() << Log::ERROR << "World::" << __FUNCTION__ << " - Timeout when trying to start scene \"" << sceneName << "\". Exiting." << Log::endl;
             _quit = true;
             break;
         }
+
+        Log::get() << Log::MESSAGE << "World::" << __FUNCTION__ << " - Scene " << sceneName << " configured after " << (sceneConfigurationDates[sceneName] - configStartDate) / 1000
+                   << "ms, started after " << (Timer::getTime() - configStartDate) / 1000 << "ms" << Log::endl;
     }
 
     return true;
@@ -470,7 +540,10 @@ bool World::addScene(const std::string& sceneName, const std::string& /*sceneDis
 
         if (spawn)
         {
-            _sceneLaunched = false;
+            {
+                std::lock_guard<std::mutex> lockChildProcess(_childProcessMutex);
+                _sceneStartups[sceneName] = {Timer::getTime(), 0};
+            }
 
             if (allowEmbedded && _embeddedScene)
                 Log::get() << Log::WARNING << "World::" << __FUNCTION__ << " - Unable to embbed Scene " << sceneName << " as another Scene is already embbeded" << Log::endl;
@@ -549,22 +622,7 @@ bool World::addScene(const std::string& sceneName, const std::string& /*sceneDis
                 return false;
             }
 
-            // We wait for the child process to be launched
-            std::unique_lock<std::mutex> lockChildProcess(_childProcessMutex);
-            for (auto startTime = Timer::get().getTime(); !_sceneLaunched;)
-            {
-                sendMessage(sceneName, "checkSceneRunning");
-                if (std::cv_status::timeout == _childProcessConditionVariable.wait_for(lockChildProcess, std::chrono::milliseconds(100)))
-                {
-                    if (Timer::get().getTime() - startTime < Constants::CONNECTION_TIMEOUT * 1'000'000)
-                        continue;
-
-                    Log::get() << Log::ERROR << "World::" << __FUNCTION__ << " - Timeout when trying to connect to newly spawned scene \"" << sceneName << "\". Exiting."
-                               << Log::endl;
-                    _quit = true;
-                    return false;
-                }
-            }
+            // The Scene is waited for by waitForSpawnedScenes, so that all Scenes start concurrently
         }
         else
         {
@@ -612,6 +670,53 @@ bool World::addScene(const std::string& sceneName, const std::string& /*sceneDis
     }
 }
 
+/*************/
+bool World::waitForSpawnedScenes()
+{
+    std::unique_lock<std::mutex> lockChildProcess(_childProcessMutex);
+    const auto startTime = Timer::getTime();
+    while (true)
+    {
+        std::vector<std::string> pendingScenes;
+        for (const auto& [sceneName, startup] : _sceneStartups)
+            if (startup.launchDate == 0)
+                pendingScenes.push_back(sceneName);
+
+        if (pendingScenes.empty())
+            break;
+
+        if (Timer::getTime() - startTime > Constants::CONNECTION_TIMEOUT * 1'000'000)
+        {
+            for (const auto& sceneName : pendingScenes)
+                Log::get() << Log::ERROR << "World::" << __FUNCTION__ << " - Timeout when trying to connect to newly spawned scene \"" << sceneName << "\". Exiting." << Log::endl;
+            _quit = true;
+            return false;
+        }
+
+        // Messages are flushed as this can be called from the main loop, where they are batched
+        for (const auto& sceneName : pendingScenes)
+            sendMessage(sceneName, "checkSceneRunning");
+        _link->flushMessages();
+
+        _childProcessConditionVariable.wait_for(lockChildProcess, std::chrono::milliseconds(100));
+    }
+
+    for (const auto& [sceneName, startup] : _sceneStartups)
+        Log::get() << Log::MESSAGE << "World::" << __FUNCTION__ << " - Scene " << sceneName << " running " << (startup.launchDate - startup.spawnDate) / 1000 << "ms after being spawned"
+                   << Log::endl;
+
+    return true;
+}
+
+/*************/
+void World::addObjectToScene(const std::string& type, const std::string& name, const std::string& scene)
+{
+    addToWorld(type, name);
+    sendMessage(scene, "addObject", {type, name, scene});
+    if (scene != _masterSceneName)
+        sendMessage(_masterSceneName, "addObject", {type, name, scene});
+}
+
 /*************/
 std::string World::getObjectsAttributesDescriptions()
 {
@@ -798,6 +903,46 @@ void World::saveProject(const std::string& filename)
     }
 }
 
+/*************/
+void World::saveLatencies(const std::string& filename)
+{
+    setlocale(LC_NUMERIC,
+        "C"); // Needed to make sure numbers are written with commas
+
+    // Latencies are stored in the tree as the p50, p95 and p99 percentiles, and the measurement count
+    Json::Value root;
+    for (const auto& rootName : _tree.getBranchList())
+    {
+        const auto latenciesPath = "/" + rootName + "/latencies";
+        if (!_tree.hasBranchAt(latenciesPath))
+            continue;
+
+        for (const auto& source : _tree.getBranchListAt(latenciesPath))
+        {
+            for (const auto& stage : _tree.getLeafListAt(latenciesPath + "/" + source))
+            {
+                Value value;
+                if (!_tree.getValueForLeafAt(latenciesPath + "/" + source + "/" + stage, value) || value.size() != 4)
+                    continue;
+
+                auto& jsonStage = root[rootName][source][stage];
+                jsonStage["p50"] = value[0].as<float>();
+                jsonStage["p95"] = value[1].as<float>();
+                jsonStage["p99"] = value[2].as<float>();
+                jsonStage["count"] = static_cast<Json::Int64>(value[3].as<int64_t>());
+            }
+        }
+    }
+
+    std::ofstream out(filename, std::ios::binary);
+    if (!out.is_open())
+    {
+        Log::get() << Log::WARNING << "World::" << __FUNCTION__ << " - Could not open file " << filename << Log::endl;
+        return;
+    }
+    out << root.toStyledString();
+}
+
 /*************/
 std::vector<std::string> World::getObjectsOfType(const std::string& type) const
 {
@@ -1040,18 +1185,18 @@ void World::registerAttributes()
                 if (scene.empty())
                 {
                     addToWorld(type, name);
+                    std::vector<std::future<Values>> syncRequests;
                     for (auto& s : _scenes)
                     {
                         sendMessage(s.first, "addObject", {type, name, s.first});
-                        sendMessageWithAnswer(s.first, "sync");
+                        syncRequests.push_back(sendRequest(s.first, "sync"));
                     }
+                    for (auto& syncRequest : syncRequests)
+                        syncRequest.wait();
                 }
                 else
                 {
-                    addToWorld(type, name);
-                    sendMessage(scene, "addObject", {type, name, scene});
-                    if (scene != _masterSceneName)
-                        sendMessage(_masterSceneName, "addObject", {type, name, scene});
+                    addObjectToScene(type, name, scene);
                     sendMessageWithAnswer(scene, "sync");
                 }
 
@@ -1064,14 +1209,28 @@ void World::registerAttributes()
     setAttributeDescription("addObject", "Add an object to the scenes");
 
     addAttribute("sceneLaunched",
-        [&](const Values&) {
+        [&](const Values& args) {
             std::lock_guard<std::mutex> lockChildProcess(_childProcessMutex);
-            _sceneLaunched = true;
+            const auto startupIt = _sceneStartups.find(args[0].as<std::string>());
+            const auto isNewConnection = startupIt == _sceneStartups.end() || startupIt->second.launchDate == 0;
+            if (startupIt != _sceneStartups.end() && startupIt->second.launchDate == 0)
+                startupIt->second.launchDate = Timer::getTime();
             _childProcessConditionVariable.notify_all();
+
+            if (!isNewConnection)
+                return true;
+
+            // A (re)connected Scene missed the buffers sent before, which are sent again even if their content did not change
+            addTask([this]() {
+                std::lock_guard<std::recursive_mutex> lockObjects(_objectsMutex);
+                for (auto& [name, object] : _objects)
+                    if (auto bufferObject = std::dynamic_pointer_cast<BufferObject>(object); bufferObject)
+                        bufferObject->setDirty();
+            });
             return true;
         },
-        {});
-    setAttributeDescription("sceneLaunched", "Message sent by Scenes to confirm they are running");
+        {'s'});
+    setAttributeDescription("sceneLaunched", "Message sent by Scenes to confirm they are running, with their name as a parameter");
 
     addAttribute("deleteObject",
         [&](const Values& args) {
@@ -1084,12 +1243,16 @@ void World::registerAttributes()
                 auto objectIt = _objects.find(objectName);
                 if (objectIt != _objects.end())
                     _objects.erase(objectIt);
+                _link->releaseBuffers(objectName);
 
                 // Ask for Scenes to delete the object
                 sendMessage(Constants::ALL_PEERS, "deleteObject", args);
 
+                std::vector<std::future<Values>> syncRequests;
                 for (const auto& s : _scenes)
-                    sendMessageWithAnswer(s.first, "sync");
+                    syncRequests.push_back(sendRequest(s.first, "sync"));
+                for (auto& syncRequest : syncRequests)
+                    syncRequest.wait();
             });
 
             return true;
@@ -1239,6 +1402,33 @@ void World::registerAttributes()
         {'s'});
     setAttributeDescription("loadProject", "Load only the configuration of images, textures and meshes");
 
+    addAttribute("saveLatencies",
+        [&](const Values& args) {
+            auto filename = args[0].as<std::string>();
+            addTask([this, filename]() {
+                Log::get() << "Saving frame latencies to " << filename << Log::endl;
+                saveLatencies(filename);
+            });
+            return true;
+        },
+        {'s'});
+    setAttributeDescription("saveLatencies", "Save the frame latencies from the sources to each stage of the pipeline, as Json. Given as p50, p95 and p99 percentiles, in ms");
+
+    addAttribute("recordTrace",
+        [&](const Values& args) {
+            const auto seconds = args[0].as<float>();
+            const auto filename = args[1].as<std::string>();
+            if (seconds <= 0.f)
+                return false;
+            const auto recording = TraceRecorder::get().record(seconds, filename, "world");
+            setAttribute("sendAllScenes", {"recordTrace", seconds, filename});
+            return recording;
+        },
+        {'r', 's'});
+    setAttributeDescription("recordTrace",
+        "Record the Timer and OpenGL profiling scopes for the given duration in seconds, in every process. Each process writes its trace to the given file, suffixed with "
+        "its name, in the Chrome trace format which can be opened in Perfetto");
+
     addAttribute("logToFile",
         [&](const Values& args) {
             Log::get().logToFile(args[0].as<bool>());
@@ -1255,10 +1445,11 @@ void World::registerAttributes()
                 auto attr = args[1].as<std::string>();
                 auto values = args;
 
-                // Send the updated values to all scenes
+                // Send the updated values to all scenes, only the last value
+                // set during a loop being sent
                 values.erase(values.begin());
                 values.erase(values.begin());
-                sendMessage(name, attr, values);
+                sendMessage(name, attr, values, true);
 
                 // Also update local version
                 if (_objects.find(name) != _objects.end())
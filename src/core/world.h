@@ -120,7 +120,12 @@ class World : public RootObject
     // Scenes handling
     std::shared_ptr<Scene> _embeddedScene; //!< embedded Scene, if any
     std::thread _embeddedSceneThread;      //!< Thread for the embedded Scene, if any
-    bool _sceneLaunched{false};
+    struct SceneStartup
+    {
+        int64_t spawnDate{0};  //!< Date at which the Scene was spawned, in µs
+        int64_t launchDate{0}; //!< Date at which the Scene confirmed it is running, in µs, or 0 if it did not yet
+    };
+    std::map<std::string, SceneStartup> _sceneStartups{}; //!< Startup of the Scenes spawned by this World
     std::mutex _childProcessMutex;
     std::condition_variable _childProcessConditionVariable;
 
@@ -153,9 +158,24 @@ class World : public RootObject
      * \param address Address where to spawn the scene
      * \param spawn If true, the Scene is spawned, otherwise it is considered to be already running
      * \param allowEmbedded If true, try to run an embedded Scene instead of spawning a process
+     * \return Return true if the Scene was added. Spawned Scenes are not waited for, see waitForSpawnedScenes
      */
     bool addScene(const std::string& sceneName, const std::string& sceneDisplay, const std::string& sceneAddress, bool spawn = true, bool allowEmbedded = false);
 
+    /**
+     * Wait for all spawned Scenes to be running, in parallel. Quits if a Scene did not start in time.
+     * \return Return true if all Scenes are running
+     */
+    bool waitForSpawnedScenes();
+
+    /**
+     * Add an object to the given Scene, and as a ghost to the master Scene
+     * \param type Object type
+     * \param name Object name
+     * \param scene Scene name
+     */
+    void addObjectToScene(const std::string& type, const std::string& name, const std::string& scene);
+
     /**
      * Copies the camera calibration from the given file to the current configuration
      * \param filename Source configuration file
@@ -182,6 +202,12 @@ class World : public RootObject
      */
     void saveProject(const std::string& filename);
 
+    /**
+     * Save the frame latencies measured by all processes, as Json
+     * \param filename Path to the output file
+     */
+    void saveLatencies(const std::string& filename);
+
     /**
      * Get all object of given type.
      * \param type Type to look for. If empty, get all objects.
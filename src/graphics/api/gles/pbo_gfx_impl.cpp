@@ -1,5 +1,6 @@
 #include "./graphics/api/gles/pbo_gfx_impl.h"
 
+#include <algorithm>
 #include <cassert>
 
 #include "./graphics/api/renderer.h"
@@ -35,11 +36,13 @@ void PboGfxImpl::deactivatePixelPack()
 }
 
 /*************/
-void PboGfxImpl::packTexture(Texture* texture)
+void PboGfxImpl::packTexture(Texture* texture, int mipmapLevel)
 {
-    const auto spec = texture->getSpec();
+    auto spec = texture->getSpec();
+    spec.width = std::max(1u, spec.width >> mipmapLevel);
+    spec.height = std::max(1u, spec.height >> mipmapLevel);
     texture->bind();
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture->getTexId(), 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture->getTexId(), mipmapLevel);
     if (_image == nullptr || _image->getSpec() != spec)
         _image = std::make_unique<Image>(nullptr, spec);
     glReadPixels(0, 0, spec.width, spec.height, GL_RGBA, GL_UNSIGNED_BYTE, const_cast<GLvoid*>(_image->data()));
@@ -63,9 +63,24 @@ class PboGfxImpl : public gfx::PboGfxImpl
      * Pack the given texture to the underlying PBO active for pixel packing
      * This must be called after activatePixelPack
      * \param texture Texture to pack
-     * \param bpp Pixel size in bits
+     * \param mipmapLevel Mipmap level to pack
      */
-    void packTexture(Texture* texture) override final;
+    void packTexture(Texture* texture, int mipmapLevel = 0) override final;
+
+    /**
+     * Insert a fence after the commands packing into the given PBO index
+     * Packing is synchronous with this implementation, so there is nothing to do
+     * \param index PBO index to fence
+     */
+    void insertFence(std::size_t /*index*/) override final {}
+
+    /**
+     * Check whether the fence for the given PBO index has been signaled
+     * Packing is synchronous with this implementation, so it always is
+     * \param index PBO index to check
+     * \return Return true
+     */
+    bool isFenceSignaled(std::size_t /*index*/) override final { return true; }
 
     /**
      * Map the given PBO index to be read from the CPU
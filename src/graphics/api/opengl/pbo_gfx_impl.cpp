@@ -12,6 +12,7 @@ namespace Splash::gfx::opengl
 PboGfxImpl::PboGfxImpl(std::size_t size)
     : gfx::PboGfxImpl(size)
     , _pbos(size, 0)
+    , _fences(size, nullptr)
 {
 }
 
@@ -21,6 +22,10 @@ PboGfxImpl::~PboGfxImpl()
     if (_mappedPixels)
         glUnmapNamedBuffer(_pbos[_pboMapReadIndex]);
 
+    for (const auto fence : _fences)
+        if (fence != nullptr)
+            glDeleteSync(fence);
+
     glDeleteBuffers(static_cast<GLint>(_pboCount), _pbos.data());
 }
 
@@ -38,7 +43,7 @@ void PboGfxImpl::deactivatePixelPack()
 }
 
 /*************/
-void PboGfxImpl::packTexture(Texture* texture)
+void PboGfxImpl::packTexture(Texture* texture, int mipmapLevel)
 {
     const auto spec = texture->getSpec();
 
@@ -52,36 +57,61 @@ void PboGfxImpl::packTexture(Texture* texture)
     {
         texture->bind();
         if (spec.bpp == 64)
-            glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8_REV, 0);
+            glGetTexImage(GL_TEXTURE_2D, mipmapLevel, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8_REV, 0);
         else if (spec.bpp == 32)
-            glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8_REV, 0);
+            glGetTexImage(GL_TEXTURE_2D, mipmapLevel, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8_REV, 0);
         else if (spec.bpp == 24)
-            glGetTexImage(GL_TEXTURE_2D, 0, GL_RGB, GL_UNSIGNED_BYTE, 0);
+            glGetTexImage(GL_TEXTURE_2D, mipmapLevel, GL_RGB, GL_UNSIGNED_BYTE, 0);
         else if (spec.bpp == 16 && spec.channels != 1)
-            glGetTexImage(GL_TEXTURE_2D, 0, GL_RG, GL_UNSIGNED_SHORT, 0);
+            glGetTexImage(GL_TEXTURE_2D, mipmapLevel, GL_RG, GL_UNSIGNED_SHORT, 0);
         else if (spec.bpp == 16 && spec.channels == 1)
-            glGetTexImage(GL_TEXTURE_2D, 0, GL_RED, GL_UNSIGNED_SHORT, 0);
+            glGetTexImage(GL_TEXTURE_2D, mipmapLevel, GL_RED, GL_UNSIGNED_SHORT, 0);
         else if (spec.bpp == 8)
-            glGetTexImage(GL_TEXTURE_2D, 0, GL_RED, GL_UNSIGNED_BYTE, 0);
+            glGetTexImage(GL_TEXTURE_2D, mipmapLevel, GL_RED, GL_UNSIGNED_BYTE, 0);
         texture->unbind();
     }
     else
     {
         if (spec.bpp == 64)
-            glGetTextureImage(texture->getTexId(), 0, GL_RGBA, GL_UNSIGNED_SHORT, 0, 0);
+            glGetTextureImage(texture->getTexId(), mipmapLevel, GL_RGBA, GL_UNSIGNED_SHORT, static_cast<GLsizei>(_bufferSize), 0);
         else if (spec.bpp == 32)
-            glGetTextureImage(texture->getTexId(), 0, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8_REV, 0, 0);
+            glGetTextureImage(texture->getTexId(), mipmapLevel, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8_REV, static_cast<GLsizei>(_bufferSize), 0);
         else if (spec.bpp == 24)
-            glGetTextureImage(texture->getTexId(), 0, GL_RGB, GL_UNSIGNED_BYTE, 0, 0);
+            glGetTextureImage(texture->getTexId(), mipmapLevel, GL_RGB, GL_UNSIGNED_BYTE, static_cast<GLsizei>(_bufferSize), 0);
         else if (spec.bpp == 16 && spec.channels != 1)
-            glGetTextureImage(texture->getTexId(), 0, GL_RG, GL_UNSIGNED_SHORT, 0, 0);
+            glGetTextureImage(texture->getTexId(), mipmapLevel, GL_RG, GL_UNSIGNED_SHORT, static_cast<GLsizei>(_bufferSize), 0);
         else if (spec.bpp == 16 && spec.channels == 1)
-            glGetTextureImage(texture->getTexId(), 0, GL_RED, GL_UNSIGNED_SHORT, 0, 0);
+            glGetTextureImage(texture->getTexId(), mipmapLevel, GL_RED, GL_UNSIGNED_SHORT, static_cast<GLsizei>(_bufferSize), 0);
         else if (spec.bpp == 8)
-            glGetTextureImage(texture->getTexId(), 0, GL_RED, GL_UNSIGNED_BYTE, 0, 0);
+            glGetTextureImage(texture->getTexId(), mipmapLevel, GL_RED, GL_UNSIGNED_BYTE, static_cast<GLsizei>(_bufferSize), 0);
     }
 }
 
+/*************/
+void PboGfxImpl::insertFence(std::size_t index)
+{
+    assert(index < _pboCount);
+    if (_fences[index] != nullptr)
+        glDeleteSync(_fences[index]);
+    _fences[index] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+/*************/
+bool PboGfxImpl::isFenceSignaled(std::size_t index)
+{
+    assert(index < _pboCount);
+    if (_fences[index] == nullptr)
+        return true;
+
+    const auto status = glClientWaitSync(_fences[index], GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+        return false;
+
+    glDeleteSync(_fences[index]);
+    _fences[index] = nullptr;
+    return true;
+}
+
 /*************/
 uint8_t* PboGfxImpl::mapRead(std::size_t index)
 {
@@ -106,6 +136,13 @@ void PboGfxImpl::updatePBOs(std::size_t size)
     if (size == _bufferSize)
         return;
 
+    for (auto& fence : _fences)
+    {
+        if (fence != nullptr)
+            glDeleteSync(fence);
+        fence = nullptr;
+    }
+
     if (!_pbos.empty())
         glDeleteBuffers(static_cast<GLint>(_pboCount), _pbos.data());
 
@@ -62,9 +62,23 @@ class PboGfxImpl : public gfx::PboGfxImpl
      * Pack the given texture to the underlying PBO active for pixel packing
      * This must be called after activatePixelPack
      * \param texture Texture to pack
-     * \param bpp Pixel size in bits
+     * \param mipmapLevel Mipmap level to pack
      */
-    void packTexture(Texture* texture) override final;
+    void packTexture(Texture* texture, int mipmapLevel = 0) override final;
+
+    /**
+     * Insert a fence after the commands packing into the given PBO index
+     * \param index PBO index to fence
+     */
+    void insertFence(std::size_t index) override final;
+
+    /**
+     * Check whether the fence for the given PBO index has been signaled,
+     * meaning that mapping it will not stall the pipeline
+     * \param index PBO index to check
+     * \return Return true if the PBO can be mapped without waiting
+     */
+    bool isFenceSignaled(std::size_t index) override final;
 
     /**
      * Map the given PBO index to be read from the CPU
@@ -87,6 +101,7 @@ class PboGfxImpl : public gfx::PboGfxImpl
 
   private:
     std::vector<GLuint> _pbos{};
+    std::vector<GLsync> _fences{};
     std::size_t _bufferSize{0};
 
     GLint _pboMapReadIndex{0};
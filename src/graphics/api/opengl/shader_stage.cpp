@@ -1,6 +1,7 @@
 #include "./graphics/api/opengl/shader_stage.h"
 
 #include "./utils/log.h"
+#include "./utils/timer.h"
 
 namespace Splash::gfx::opengl
 {
@@ -42,11 +43,15 @@ bool ShaderStage::setSource(std::string_view source)
 
     _shader = glCreateShader(static_cast<GLenum>(_type));
 
+    // Compilation is timed up to the status query, as drivers may compile asynchronously
+    static constexpr Timer::Scope shaderCompileTimer("shader_compile");
+    Timer::get() << shaderCompileTimer;
     const auto sourcePtr = source.data();
     glShaderSource(_shader, 1, &sourcePtr, nullptr);
     glCompileShader(_shader);
     GLint status;
     glGetShaderiv(_shader, GL_COMPILE_STATUS, &status);
+    Timer::get() >> shaderCompileTimer;
 
     if (status)
     {
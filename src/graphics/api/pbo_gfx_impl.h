@@ -73,8 +73,23 @@ class PboGfxImpl
      * Pack the given texture to the underlying PBO active for pixel packing
      * This must be called after activatePixelPack
      * \param texture Texture to pack
+     * \param mipmapLevel Mipmap level to pack
      */
-    virtual void packTexture(Texture* texture) = 0;
+    virtual void packTexture(Texture* texture, int mipmapLevel = 0) = 0;
+
+    /**
+     * Insert a fence after the commands packing into the given PBO index
+     * \param index PBO index to fence
+     */
+    virtual void insertFence(std::size_t index) = 0;
+
+    /**
+     * Check whether the fence for the given PBO index has been signaled,
+     * meaning that mapping it will not stall the pipeline
+     * \param index PBO index to check
+     * \return Return true if the PBO can be mapped without waiting
+     */
+    virtual bool isFenceSignaled(std::size_t index) = 0;
 
     /**
      * Map the given PBO index to be read from the CPU
@@ -1,7 +1,10 @@
 #include "./graphics/camera.h"
 
 #include <fstream>
+#include <future>
 #include <limits>
+#include <random>
+#include <thread>
 
 #include <glm/ext.hpp>
 #include <glm/glm.hpp>
@@ -22,6 +25,7 @@
 #include "./utils/osutils.h"
 #include "./utils/scope_guard.h"
 #include "./utils/timer.h"
+#include "./utils/worker_pool.h"
 
 #define WORLDMARKER_SCALE 0.0003
 #define SCREENMARKER_SCALE 0.05
@@ -112,15 +116,20 @@ Camera::~Camera()
 }
 
 /*************/
-void Camera::computeBlendingContribution()
+void Camera::computeBlendingContribution(const std::unordered_set<std::string>& objectNames)
 {
+    const auto viewMatrix = computeViewMatrix();
+    const auto projectionMatrix = computeProjectionMatrix();
+
     for (auto& o : _objects)
     {
         if (o.expired())
             continue;
         auto obj = o.lock();
+        if (!objectNames.empty() && !objectNames.contains(obj->getName()))
+            continue;
 
-        obj->computeCameraContribution(computeViewMatrix(), computeProjectionMatrix(), _blendWidth);
+        obj->computeCameraContribution(viewMatrix, projectionMatrix, _blendWidth);
     }
 }
 
@@ -141,8 +150,25 @@ float Camera::getFarthestVisibleVertexDistance()
     return farthestVisibleVertexDistance;
 }
 
+/*************/
+std::vector<std::shared_ptr<Object>> Camera::getLinkedObjects() const
+{
+    std::vector<std::shared_ptr<Object>> objects;
+    for (auto& o : _objects)
+        if (auto obj = o.lock(); obj)
+            objects.push_back(obj);
+    return objects;
+}
+
 /*************/
 void Camera::computeVertexVisibility()
+{
+    renderVertexVisibility();
+    transferVertexVisibility();
+}
+
+/*************/
+void Camera::renderVertexVisibility()
 {
     // We want to render the object with a specific texture, containing the primitive IDs
     std::vector<Values> shaderFill;
@@ -186,6 +212,23 @@ void Camera::computeVertexVisibility()
         obj->setAttribute("fill", shaderFill[fillIndex]);
         fillIndex++;
     }
+}
+
+/*************/
+void Camera::transferVertexVisibility(const std::unordered_set<std::string>& objectNames)
+{
+    // Other cameras may have rendered their own visibility since renderVertexVisibility()
+    // was called, so the primitive IDs and visibility flags are reset to match this camera
+    int primitiveIdShift = 0;
+    for (auto& o : _objects)
+    {
+        if (o.expired())
+            continue;
+        auto obj = o.lock();
+        if (objectNames.empty() || objectNames.contains(obj->getName()))
+            obj->resetVisibility(primitiveIdShift);
+        primitiveIdShift += obj->getVerticesNumber() / 3;
+    }
 
     // Update the vertices visibility based on the result
     _gfxImpl->activateTexture(0);
@@ -197,22 +240,28 @@ void Camera::computeVertexVisibility()
             continue;
         auto obj = o.lock();
 
-        obj->transferVisibilityFromTexToAttr(_width, _height, primitiveIdShift);
+        if (objectNames.empty() || objectNames.contains(obj->getName()))
+            obj->transferVisibilityFromTexToAttr(_width, _height, primitiveIdShift);
         primitiveIdShift += obj->getVerticesNumber() / 3;
     }
     _outFbo->getColorTexture()->unbind();
 }
 
 /*************/
-void Camera::blendingTessellateForCurrentCamera()
+void Camera::blendingTessellateForCurrentCamera(const std::unordered_set<std::string>& objectNames)
 {
+    const auto viewMatrix = computeViewMatrix();
+    const auto projectionMatrix = computeProjectionMatrix();
+
     for (auto& o : _objects)
     {
         if (o.expired())
             continue;
         auto obj = o.lock();
+        if (!objectNames.empty() && !objectNames.contains(obj->getName()))
+            continue;
 
-        obj->tessellateForThisCamera(computeViewMatrix(), computeProjectionMatrix(), glm::radians(_fov * _width / _height), glm::radians(_fov), _blendWidth, _blendPrecision);
+        obj->tessellateForThisCamera(viewMatrix, projectionMatrix, glm::radians(_fov * _width / _height), glm::radians(_fov), _blendWidth, _blendPrecision);
     }
 }
 
@@ -236,118 +285,103 @@ bool Camera::doCalibration()
 
     _calibrationCalledOnce = true;
 
-    gsl_multimin_function calibrationFunc;
-    calibrationFunc.n = 9;
-    calibrationFunc.f = &Camera::calibrationCostFunc;
-    calibrationFunc.params = (void*)this;
-
     Log::get() << "Camera::" << __FUNCTION__ << " - Starting calibration..." << Log::endl;
+    const auto calibrationStart = Timer::getTime();
+
+    // Gather everything the cost function needs, so that it does not access the camera
+    CalibrationProblem problem;
+    problem.width = _width;
+    problem.height = _height;
+    problem.near = _near;
+    problem.far = _far;
+    if (operator[]("fov").isLocked())
+        problem.lockedFov = _fov;
+    if (operator[]("principalPoint").isLocked())
+        problem.lockedPrincipalPoint = dvec2(_cx, _cy);
+    for (const auto& point : _calibrationPoints)
+    {
+        if (!point.isSet)
+            continue;
+        problem.worldX.push_back(point.world.x);
+        problem.worldY.push_back(point.world.y);
+        problem.worldZ.push_back(point.world.z);
+        problem.screenX.push_back((point.screen.x + 1.0) / 2.0 * _width);
+        problem.screenY.push_back((point.screen.y + 1.0) / 2.0 * _height);
+        problem.weights.push_back(_weightedCalibrationPoints ? point.weight : 1.0);
+    }
 
-    const gsl_multimin_fminimizer_type* minimizerType = gsl_multimin_fminimizer_nmsimplex2rand;
     // Variables we do not want to keep between tries
-    dvec3 eyeOriginal = _eye;
+    const dvec3 eyeOriginal = _eye;
+
+    // First step: find a rough estimate, quickly, from a grid of starting points
+    // The starting points are seeded from their index to get reproducible results,
+    // and each row of the grid is run concurrently on a pool of persistent threads.
+    // The search stops after the first row which gives a result good enough to be refined.
+    constexpr double roughEstimateThreshold = 64.0;
+    constexpr uint32_t gridSize = 5;
+    constexpr uint32_t randomSeed = 0x5f3759df;
+    const std::array<double, 9> roughSteps{10.0, 0.1, 0.1, M_PI / 4.0, M_PI / 4.0, M_PI / 4.0, M_PI / 4.0, M_PI / 4.0, M_PI / 4.0};
+    static Utils::WorkerPool calibrationPool(std::min<size_t>(gridSize, std::thread::hardware_concurrency()));
 
     double minValue = std::numeric_limits<double>::max();
-    std::vector<double> selectedValues(9);
+    std::array<double, 9> selectedValues{};
 
-    gsl_multimin_fminimizer* minimizer;
-    minimizer = gsl_multimin_fminimizer_alloc(minimizerType, 9);
-    gsl_vector* x = gsl_vector_alloc(9);
-    gsl_vector* step = gsl_vector_alloc(9);
-    gsl_vector_set(step, 0, 10.0);
-    gsl_vector_set(step, 1, 0.1);
-    gsl_vector_set(step, 2, 0.1);
-    for (int i = 3; i < 6; ++i)
-        gsl_vector_set(step, i, 1.0);
-    for (int i = 3; i < 9; ++i)
-        gsl_vector_set(step, i, M_PI / 4.0);
-
-    // First step: find a rough estimate, quickly
-    for (double s = 0.0; s <= 1.3; s += 0.3)
+    using RoughEstimate = std::pair<double, std::array<double, 9>>;
+    for (uint32_t row = 0; row < gridSize && minValue > roughEstimateThreshold; ++row)
     {
-        for (double t = 0.0; t <= 1.3; t += 0.3)
+        std::vector<std::future<RoughEstimate>> starts;
+        for (uint32_t column = 0; column < gridSize; ++column)
         {
-            gsl_vector_set(x, 0, 50.0 + (static_cast<float>(rand()) / static_cast<float>(RAND_MAX) * 2.0 - 1.0) * 25.0);
-            gsl_vector_set(x, 1, s);
-            gsl_vector_set(x, 2, t);
-            for (int i = 0; i < 3; ++i)
-            {
-                gsl_vector_set(x, i + 3, eyeOriginal[i]);
-                gsl_vector_set(x, i + 6, static_cast<float>(rand()) / static_cast<float>(RAND_MAX) * M_PI * 2.0);
-            }
-
-            gsl_multimin_fminimizer_set(minimizer, &calibrationFunc, x, step);
-
-            size_t iter = 0;
-            int status = GSL_CONTINUE;
-            double localMinimum = std::numeric_limits<double>::max();
-            while (status == GSL_CONTINUE && iter < 1000 && localMinimum > 64.0)
-            {
-                iter++;
-                status = gsl_multimin_fminimizer_iterate(minimizer);
-                if (status)
+            auto start = std::make_shared<std::packaged_task<RoughEstimate()>>([&, row, column]() {
+                std::mt19937 randomGenerator(randomSeed + row * gridSize + column);
+                std::uniform_real_distribution<double> unitDistribution(0.0, 1.0);
+
+                std::array<double, 9> values;
+                values[0] = 50.0 + (unitDistribution(randomGenerator) * 2.0 - 1.0) * 25.0;
+                values[1] = 0.3 * row;
+                values[2] = 0.3 * column;
+                for (int i = 0; i < 3; ++i)
                 {
-                    Log::get() << Log::WARNING << "Camera::" << __FUNCTION__ << " - An error has occured during minimization" << Log::endl;
-                    break;
+                    values[i + 3] = eyeOriginal[i];
+                    values[i + 6] = unitDistribution(randomGenerator) * M_PI * 2.0;
                 }
 
-                status = gsl_multimin_test_size(minimizer->size, 1e-2);
-                localMinimum = gsl_multimin_fminimizer_minimum(minimizer);
-            }
+                const auto localMinimum = minimizeCalibration(problem, values, roughSteps, 1000, 1e-2, roughEstimateThreshold);
+                return std::make_pair(localMinimum, values);
+            });
+            starts.push_back(start->get_future());
+            calibrationPool.enqueue([start]() { (*start)(); });
+        }
 
+        // Results are gathered in order, to keep the selection independent from the scheduling
+        for (auto& start : starts)
+        {
+            const auto [localMinimum, values] = start.get();
             if (localMinimum < minValue)
             {
                 minValue = localMinimum;
-                for (int i = 0; i < 9; ++i)
-                    selectedValues[i] = gsl_vector_get(minimizer->x, i);
+                selectedValues = values;
             }
         }
     }
 
-    // Second step: we improve on the best result from the previous step
-    for (int index = 0; index < 8; ++index)
+    // Second step: we improve on the best result from the previous step, restarting the
+    // minimizer from the last minimum. A restart from the same values being deterministic,
+    // we stop as soon as one does not improve on the previous one.
+    const std::array<double, 9> fineSteps{1.0, 0.05, 0.05, M_PI / 10.0, M_PI / 10.0, M_PI / 10.0, M_PI / 10.0, M_PI / 10.0, M_PI / 10.0};
+    for (int index = 0; index < 8 && minValue > 0.5; ++index)
     {
-        gsl_vector_set(step, 0, 1.0);
-        gsl_vector_set(step, 1, 0.05);
-        gsl_vector_set(step, 2, 0.05);
-        for (int i = 3; i < 6; ++i)
-            gsl_vector_set(step, i, 0.1);
-        for (int i = 3; i < 9; ++i)
-            gsl_vector_set(step, i, M_PI / 10.0);
-
-        for (int i = 0; i < 9; ++i)
-            gsl_vector_set(x, i, selectedValues[i]);
-
-        gsl_multimin_fminimizer_set(minimizer, &calibrationFunc, x, step);
-
-        size_t iter = 0;
-        int status = GSL_CONTINUE;
-        double localMinimum = std::numeric_limits<double>::max();
-        while (status == GSL_CONTINUE && iter < 10000 && localMinimum > 0.5)
-        {
-            iter++;
-            status = gsl_multimin_fminimizer_iterate(minimizer);
-            if (status)
-            {
-                Log::get() << Log::WARNING << "Camera::" << __FUNCTION__ << " - An error has occured during minimization" << Log::endl;
-                break;
-            }
+        auto values = selectedValues;
+        const auto localMinimum = minimizeCalibration(problem, values, fineSteps, 10000, 1e-7, 0.5);
 
-            status = gsl_multimin_test_size(minimizer->size, 1e-7);
-            localMinimum = gsl_multimin_fminimizer_minimum(minimizer);
-        }
+        if (localMinimum >= minValue)
+            break;
 
-        if (localMinimum < minValue)
-        {
-            minValue = localMinimum;
-            for (int i = 0; i < 9; ++i)
-                selectedValues[i] = gsl_vector_get(minimizer->x, i);
-        }
+        minValue = localMinimum;
+        selectedValues = values;
     }
 
-    gsl_vector_free(x);
-    gsl_vector_free(step);
-    gsl_multimin_fminimizer_free(minimizer);
+    Log::get() << "Camera::" << __FUNCTION__ << " - Calibration search done in " << (Timer::getTime() - calibrationStart) / 1000 << "ms" << Log::endl;
 
     // If the result is good enough, apply it. Otherwise, drop!
     if (minValue > 1000.0)
@@ -813,9 +847,18 @@ void Camera::render()
     {
         auto colorTexture = _outFbo->getColorTexture();
         colorTexture->generateMipmap();
-        _mipmapBuffer = colorTexture->grabMipmap(_grabMipmapLevel).getRawBuffer();
-        auto spec = colorTexture->getSpec();
-        _mipmapBufferSpec = {spec.width, spec.height, spec.channels, spec.bpp, spec.format};
+        auto readbackQueue = _scene->getTextureReadbackQueue();
+        readbackQueue->request(colorTexture, _grabMipmapLevel);
+        if (const auto mipmap = readbackQueue->getResult(colorTexture); mipmap)
+        {
+            _mipmapBuffer = mipmap->getRawBuffer();
+            const auto spec = mipmap->getSpec();
+            _mipmapBufferSpec = {spec.width, spec.height, spec.channels, spec.bpp, spec.format};
+        }
+    }
+    else
+    {
+        _scene->getTextureReadbackQueue()->cancel(_outFbo->getColorTexture());
     }
 
     // Set the timestamp for the output texture
@@ -964,19 +1007,15 @@ double Camera::calibrationCostFunc(const gsl_vector* v, void* params)
     if (params == NULL)
         return 0.0;
 
-    Camera& camera = *(Camera*)params;
+    const auto& problem = *static_cast<const CalibrationProblem*>(params);
 
-    double fov = gsl_vector_get(v, 0);
+    double fov = problem.lockedFov.value_or(gsl_vector_get(v, 0));
     double cx = gsl_vector_get(v, 1);
     double cy = gsl_vector_get(v, 2);
-
-    // Check whether the camera parameters are locked
-    if (camera["fov"].isLocked())
-        fov = camera["fov"]()[0].as<float>();
-    if (camera["principalPoint"].isLocked())
+    if (problem.lockedPrincipalPoint)
     {
-        cx = camera["principalPoint"]()[0].as<float>();
-        cy = camera["principalPoint"]()[1].as<float>();
+        cx = problem.lockedPrincipalPoint->x;
+        cy = problem.lockedPrincipalPoint->y;
     }
 
     // Some limits for the calibration parameters
@@ -984,60 +1023,45 @@ double Camera::calibrationCostFunc(const gsl_vector* v, void* params)
         return std::numeric_limits<double>::max();
 
     dvec3 eye;
-    dvec3 target;
-    dvec3 up;
     dvec3 euler;
     for (int i = 0; i < 3; ++i)
     {
         eye[i] = gsl_vector_get(v, i + 3);
         euler[i] = gsl_vector_get(v, i + 6);
     }
-    dmat4 rotateMat = yawPitchRoll(euler[0], euler[1], euler[2]);
-    dvec4 targetTmp = rotateMat * dvec4(1.0, 0.0, 0.0, 0.0);
-    dvec4 upTmp = rotateMat * dvec4(0.0, 0.0, 1.0, 0.0);
-    for (int i = 0; i < 3; ++i)
-    {
-        target[i] = targetTmp[i];
-        up[i] = upTmp[i];
-    }
-    target += eye;
-
-    std::vector<dvec3> objectPoints;
-    std::vector<dvec3> imagePoints;
-    std::vector<float> pointsWeight;
-    for (auto& point : camera._calibrationPoints)
-    {
-        if (!point.isSet)
-            continue;
-
-        objectPoints.emplace_back(dvec3(point.world.x, point.world.y, point.world.z));
-        imagePoints.emplace_back(dvec3((point.screen.x + 1.0) / 2.0 * camera._width, (point.screen.y + 1.0) / 2.0 * camera._height, 0.0));
-        pointsWeight.push_back(point.weight);
-    }
+    const dmat4 rotateMat = yawPitchRoll(euler[0], euler[1], euler[2]);
+    const dvec3 target = eye + dvec3(rotateMat * dvec4(1.0, 0.0, 0.0, 0.0));
+    const dvec3 up = dvec3(rotateMat * dvec4(0.0, 0.0, 1.0, 0.0));
 
 #ifdef DEBUG
-    Log::get() << Log::DEBUGGING << "Camera::" << __FUNCTION__ << " - Values for the current iteration (fov, cx, cy): " << fov << " " << camera._width - cx << " "
-               << camera._height - cy << Log::endl;
+    Log::get() << Log::DEBUGGING << "Camera::" << __FUNCTION__ << " - Values for the current iteration (fov, cx, cy): " << fov << " " << problem.width - cx << " "
+               << problem.height - cy << Log::endl;
 #endif
 
-    dmat4 lookM = lookAt(eye, target, up);
-    dmat4 projM = dmat4(getProjectionMatrix(fov, camera._near, camera._far, camera._width, camera._height, cx, cy));
-    dvec4 viewport(0, 0, camera._width, camera._height);
+    const dmat4 lookM = lookAt(eye, target, up);
+    const dmat4 projM = getProjectionMatrix(fov, problem.near, problem.far, problem.width, problem.height, cx, cy);
+    const dmat4 mvp = projM * lookM;
 
     // Project all the object points, and measure the distance between them and the image points
+    // This is equivalent to glm::project, written over flat arrays to let the compiler vectorize it
+    const size_t pointCount = problem.screenX.size();
     double summedDistance = 0.0;
-    for (uint32_t i = 0; i < imagePoints.size(); ++i)
+    for (size_t i = 0; i < pointCount; ++i)
     {
-        dvec3 projectedPoint;
-        projectedPoint = project(objectPoints[i], lookM, projM, viewport);
-        projectedPoint.z = 0.0;
-
-        if (camera._weightedCalibrationPoints)
-            summedDistance += pointsWeight[i] * pow(imagePoints[i].x - projectedPoint.x, 2.0) + pow(imagePoints[i].y - projectedPoint.y, 2.0);
-        else
-            summedDistance += pow(imagePoints[i].x - projectedPoint.x, 2.0) + pow(imagePoints[i].y - projectedPoint.y, 2.0);
+        const double x = problem.worldX[i];
+        const double y = problem.worldY[i];
+        const double z = problem.worldZ[i];
+        const double clipX = mvp[0][0] * x + mvp[1][0] * y + mvp[2][0] * z + mvp[3][0];
+        const double clipY = mvp[0][1] * x + mvp[1][1] * y + mvp[2][1] * z + mvp[3][1];
+        const double clipW = mvp[0][3] * x + mvp[1][3] * y + mvp[2][3] * z + mvp[3][3];
+
+        const double projectedX = (clipX / clipW * 0.5 + 0.5) * problem.width;
+        const double projectedY = (clipY / clipW * 0.5 + 0.5) * problem.height;
+        const double dx = problem.screenX[i] - projectedX;
+        const double dy = problem.screenY[i] - projectedY;
+        summedDistance += problem.weights[i] * dx * dx + dy * dy;
     }
-    summedDistance /= imagePoints.size();
+    summedDistance /= pointCount;
 
 #ifdef DEBUG
     Log::get() << Log::DEBUGGING << "Camera::" << __FUNCTION__ << " - Actual summed distance: " << summedDistance << Log::endl;
@@ -1046,6 +1070,56 @@ double Camera::calibrationCostFunc(const gsl_vector* v, void* params)
     return summedDistance;
 }
 
+/*************/
+double Camera::minimizeCalibration(
+    CalibrationProblem& problem, std::array<double, 9>& values, const std::array<double, 9>& steps, size_t maxIterations, double sizeThreshold, double targetValue)
+{
+    gsl_multimin_function calibrationFunc;
+    calibrationFunc.n = 9;
+    calibrationFunc.f = &Camera::calibrationCostFunc;
+    calibrationFunc.params = static_cast<void*>(&problem);
+
+    gsl_multimin_fminimizer* minimizer = gsl_multimin_fminimizer_alloc(gsl_multimin_fminimizer_nmsimplex2rand, 9);
+    gsl_vector* x = gsl_vector_alloc(9);
+    gsl_vector* step = gsl_vector_alloc(9);
+    OnScopeExit
+    {
+        gsl_vector_free(x);
+        gsl_vector_free(step);
+        gsl_multimin_fminimizer_free(minimizer);
+    };
+
+    for (size_t i = 0; i < 9; ++i)
+    {
+        gsl_vector_set(x, i, values[i]);
+        gsl_vector_set(step, i, steps[i]);
+    }
+
+    gsl_multimin_fminimizer_set(minimizer, &calibrationFunc, x, step);
+
+    size_t iter = 0;
+    int status = GSL_CONTINUE;
+    double localMinimum = std::numeric_limits<double>::max();
+    while (status == GSL_CONTINUE && iter < maxIterations && localMinimum > targetValue)
+    {
+        iter++;
+        status = gsl_multimin_fminimizer_iterate(minimizer);
+        if (status)
+        {
+            Log::get() << Log::WARNING << "Camera::" << __FUNCTION__ << " - An error has occured during minimization" << Log::endl;
+            break;
+        }
+
+        status = gsl_multimin_test_size(minimizer->size, sizeThreshold);
+        localMinimum = gsl_multimin_fminimizer_minimum(minimizer);
+    }
+
+    for (size_t i = 0; i < 9; ++i)
+        values[i] = gsl_vector_get(minimizer->x, i);
+
+    return localMinimum;
+}
+
 /*************/
 dmat4 Camera::computeProjectionMatrix()
 {
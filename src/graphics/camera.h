@@ -25,11 +25,14 @@
 #ifndef SPLASH_CAMERA_H
 #define SPLASH_CAMERA_H
 
+#include <array>
 #include <functional>
 #include <list>
 #include <memory>
+#include <optional>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -86,19 +89,35 @@ class Camera : public GraphObject
 
     /**
      * Tessellate the objects for this camera
+     * \param objectNames Names of the objects to tessellate. If empty, all linked objects are tessellated
      */
-    void blendingTessellateForCurrentCamera();
+    void blendingTessellateForCurrentCamera(const std::unordered_set<std::string>& objectNames = {});
 
     /**
      * Compute the blending for all objects seen by this camera
+     * \param objectNames Names of the objects to compute the blending for. If empty, all linked objects are processed
      */
-    void computeBlendingContribution();
+    void computeBlendingContribution(const std::unordered_set<std::string>& objectNames = {});
 
     /**
      * Compute the vertex visibility for all objects visible by this camera
+     * This is equivalent to calling renderVertexVisibility() followed by transferVertexVisibility()
      */
     void computeVertexVisibility();
 
+    /**
+     * Render the primitive IDs of all objects seen by this camera into its output texture
+     * The result stays in the output texture until the next call to render()
+     */
+    void renderVertexVisibility();
+
+    /**
+     * Transfer the visibility rendered by the last call to renderVertexVisibility() to the objects vertices
+     * This resets the previous visibility of the objects
+     * \param objectNames Names of the objects to transfer the visibility to. If empty, all linked objects are processed
+     */
+    void transferVertexVisibility(const std::unordered_set<std::string>& objectNames = {});
+
     /**
      * Get the projection matrix
      * \return Return the projection matrix
@@ -124,12 +143,30 @@ class Camera : public GraphObject
      */
     void drawModelOnce(const std::string& modelName, const glm::dmat4& rtMatrix);
 
+    /**
+     * Get the blending width
+     * \return Return the blending width, as a fraction of the width and height
+     */
+    float getBlendWidth() const { return _blendWidth; }
+
+    /**
+     * Get the blending precision
+     * \return Return the blending precision
+     */
+    float getBlendPrecision() const { return _blendPrecision; }
+
     /**
      * Get the farthest visible vertex distance
      * \return Return the distance
      */
     float getFarthestVisibleVertexDistance();
 
+    /**
+     * Get the objects linked to this camera
+     * \return Return a vector of the linked objects
+     */
+    std::vector<std::shared_ptr<Object>> getLinkedObjects() const;
+
     /**
      * Get the output texture for this camera
      * \return Return a pointer to the output textures
@@ -339,9 +376,40 @@ class Camera : public GraphObject
     };
     std::list<Drawable> _drawables;
 
+    // Data needed by the calibration cost function, gathered once before the optimization
+    // so that the cost function does not access the camera and can run concurrently
+    struct CalibrationProblem
+    {
+        std::vector<double> worldX{}, worldY{}, worldZ{}; //!< Calibration points in world space
+        std::vector<double> screenX{}, screenY{};         //!< Calibration points in pixels
+        std::vector<double> weights{};                    //!< Weight of each point along the X axis
+        double width{0.0}, height{0.0};
+        double near{0.0}, far{0.0};
+        std::optional<double> lockedFov{};
+        std::optional<glm::dvec2> lockedPrincipalPoint{};
+    };
+
     // Function used for the calibration (camera parameters optimization)
+    // params must point to a CalibrationProblem
     static double calibrationCostFunc(const gsl_vector* v, void* params);
 
+    /**
+     * Run the Nelder-Mead minimizer on the calibration problem, starting from the given values
+     * \param problem Calibration problem
+     * \param values Starting values, replaced by the values found at the minimum
+     * \param steps Initial step size for each parameter
+     * \param maxIterations Maximum iteration count
+     * \param sizeThreshold Size of the simplex under which the minimizer is considered to have converged
+     * \param targetValue Value under which the minimization is stopped
+     * \return Return the minimum found
+     */
+    static double minimizeCalibration(CalibrationProblem& problem,
+        std::array<double, 9>& values,
+        const std::array<double, 9>& steps,
+        size_t maxIterations,
+        double sizeThreshold,
+        double targetValue);
+
     /**
      * Send calibration points to the model
      */
@@ -244,13 +244,22 @@ void Filter::render()
 
     _fbo->unbindDraw();
 
-    _fbo->getColorTexture()->generateMipmap();
+    auto colorTexture = _fbo->getColorTexture();
+    colorTexture->generateMipmap();
     if (_grabMipmapLevel >= 0)
     {
-        auto colorTexture = _fbo->getColorTexture();
-        _mipmapBuffer = colorTexture->grabMipmap(_grabMipmapLevel).getRawBuffer();
-        auto spec = colorTexture->getSpec();
-        _mipmapBufferSpec = {spec.width, spec.height, spec.channels, spec.bpp, spec.format};
+        auto readbackQueue = _scene->getTextureReadbackQueue();
+        readbackQueue->request(colorTexture, _grabMipmapLevel);
+        if (const auto mipmap = readbackQueue->getResult(colorTexture); mipmap)
+        {
+            _mipmapBuffer = mipmap->getRawBuffer();
+            const auto spec = mipmap->getSpec();
+            _mipmapBufferSpec = {spec.width, spec.height, spec.channels, spec.bpp, spec.format};
+        }
+    }
+    else
+    {
+        _scene->getTextureReadbackQueue()->cancel(colorTexture);
     }
 }
 
@@ -1,6 +1,8 @@
 #include "./graphics/geometry.h"
 
+#include <limits>
 #include <memory>
+#include <utility>
 
 #include "./core/scene.h"
 #include "./core/serialize/serialize_mesh.h"
@@ -81,6 +83,33 @@ void Geometry::draw() const
     _gfxImpl->draw();
 }
 
+/*************/
+std::pair<glm::vec3, glm::vec3> Geometry::getBoundingBox() const
+{
+    if (!_mesh)
+        return {};
+
+    const auto timestamp = _mesh->getTimestamp();
+    if (timestamp == _boundingBoxTimestamp)
+        return _boundingBox;
+
+    const auto vertices = _mesh->getVertCoords();
+    if (vertices.empty())
+        return {};
+
+    glm::vec3 minCorner(std::numeric_limits<float>::max());
+    glm::vec3 maxCorner(std::numeric_limits<float>::lowest());
+    for (const auto& vertex : vertices)
+    {
+        minCorner = glm::min(minCorner, glm::vec3(vertex));
+        maxCorner = glm::max(maxCorner, glm::vec3(vertex));
+    }
+
+    _boundingBox = {minCorner, maxCorner};
+    _boundingBoxTimestamp = timestamp;
+    return _boundingBox;
+}
+
 /*************/
 uint32_t Geometry::getVerticesNumber() const
 {
@@ -108,9 +137,8 @@ SerializedObject Geometry::serialize() const
 /*************/
 bool Geometry::deserialize(SerializedObject&& obj)
 {
-    // After this, obj does not hold any more data
-    const auto serializedMesh = obj.grabData();
-    auto serializedMeshIt = serializedMesh.cbegin();
+    // The mesh is read in place, as the serialized object may be a view over shared memory
+    auto serializedMeshIt = std::as_const(obj).data();
     auto mesh = Serial::detail::deserializer<Mesh::MeshContainer>(serializedMeshIt);
 
     bool doMatch = (mesh.vertices.size() == mesh.uvs.size());
@@ -116,6 +116,13 @@ class Geometry : public BufferObject
      */
     std::vector<char> getGpuBufferAsVector(Geometry::BufferType type, bool forceAlternativeBuffer = false) const;
 
+    /**
+     * Get the axis-aligned bounding box of the mesh, in model space
+     * The result is cached until the mesh is updated
+     * \return Return the minimum and maximum corners of the bounding box
+     */
+    std::pair<glm::vec3, glm::vec3> getBoundingBox() const;
+
     /**
      * Get the number of vertices for this geometry
      * \return Return the vertice count
@@ -196,6 +203,9 @@ class Geometry : public BufferObject
     std::shared_ptr<Mesh> _mesh;
     std::unique_ptr<Mesh::MeshContainer> _deserializedMesh{nullptr};
 
+    mutable std::pair<glm::vec3, glm::vec3> _boundingBox{};
+    mutable int64_t _boundingBoxTimestamp{-1};
+
     bool _buffersDirty{false};
     bool _buffersResized{false}; // Holds whether the alternative buffers have been resized in the previous feedback
 
@@ -532,16 +532,12 @@ void Object::computeCameraContribution(glm::dmat4 viewMatrix, glm::dmat4 project
         {
             size_t annexeBufferSize = annexeBufferAsChar.size() / 4;
             const float* annexePtr = reinterpret_cast<const float*>(annexeBufferAsChar.data());
-            std::vector<float> distanceBuffer((size_t)annexeBufferSize / 4);
-            // Initialize the distanceBuffer using only the w component of the annexeBuffer
+            // Only the w component of the annexeBuffer is of interest. The vertices are farther
+            // away from the camera when the distance goes lower, so the values are inverted
+            float maxDistance = 0.f;
             for (size_t i = 3; i < annexeBufferSize / 4; i += 4)
-            {
-                // The vertices are farther away from the camera when the distance goes lower,
-                // so we need to invert the values from the annexe buffer
-                distanceBuffer[(i - 3) / 4] = -annexePtr[i];
-            }
-            const auto maxDistance = std::max_element(distanceBuffer.cbegin(), distanceBuffer.cend());
-            _farthestVisibleVertexDistance = std::max(_farthestVisibleVertexDistance, *maxDistance);
+                maxDistance = std::max(maxDistance, -annexePtr[i]);
+            _farthestVisibleVertexDistance = std::max(_farthestVisibleVertexDistance, maxDistance);
         }
         }
         else
@@ -129,6 +129,12 @@ class Object : public GraphObject
      */
     inline float getFarthestVisibleVertexDistance() const { return _farthestVisibleVertexDistance; }
 
+    /**
+     * Get the geometry used by this object
+     * \return Return the geometry
+     */
+    inline std::shared_ptr<Geometry> getGeometry() const { return _geometry; }
+
     /**
      * Get the model matrix
      * \return Return the model matrix
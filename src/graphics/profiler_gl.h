@@ -35,6 +35,9 @@
 
 #include <glad/glad.h>
 
+#include "./utils/timer.h"
+#include "./utils/trace_recorder.h"
+
 namespace Splash
 {
 
@@ -104,6 +107,7 @@ class ProfilerGL
             }
             Content _content;
             unsigned int _timeElapsedQueryObj;
+            int64_t _start{0}; // CPU time at which the section started, in us, used as an approximate GPU start time
         };
 
         explicit Section(const std::string& scope)
@@ -111,6 +115,7 @@ class ProfilerGL
         {
             // We generate the two timers for start and end of section
             glGenQueries(1, &_data._timeElapsedQueryObj);
+            _data._start = Timer::getTime();
 
             // We keep the current code scope depth updated.
             ProfilerGL::get().increaseDepth(_data._content);
@@ -276,6 +281,10 @@ class ProfilerGL
             glGetQueryObjectuiv(timing._timeElapsedQueryObj, GL_QUERY_RESULT, &elapsedTime);
             timing._content.setDuration(elapsedTime);
 
+            auto& traceRecorder = TraceRecorder::get();
+            if (traceRecorder.isRecording())
+                traceRecorder.addEvent(timing._content.getScope(), timing._start, elapsedTime / 1000, TraceRecorder::Track::GPU);
+
             // Cleanup
             glDeleteQueries(1, &timing._timeElapsedQueryObj);
 
@@ -3,6 +3,7 @@
 #include <string>
 
 #include "./image/image.h"
+#include "./utils/latency.h"
 #include "./utils/log.h"
 #include "./utils/timer.h"
 #include "graphics/api/texture_image_gfx_impl.h"
@@ -208,6 +209,9 @@ void Texture_Image::update()
         _spec = *updatedSpec;
 
     _spec.timestamp = imgSpec.timestamp;
+    _uploadLatency = Timer::getTime() - imgSpec.timestamp;
+    LatencyTracker::get().record(img->getName(), LatencyTracker::STAGE_UPLOAD, imgSpec.timestamp);
+    LatencyTracker::get().setUploaded(img->getName(), imgSpec.timestamp);
 
     updateShaderUniforms(imgSpec, img);
 
@@ -247,6 +251,9 @@ void Texture_Image::registerAttributes()
         },
         {'i', 'i'});
     setAttributeDescription("size", "Change the texture size");
+
+    addAttribute("uploadLatency", [&]() -> Values { return {static_cast<float>(_uploadLatency) / 1e3f}; });
+    setAttributeDescription("uploadLatency", "Delay between the timestamp of the last image and its upload to the GPU, in ms. For a capture device, this is the capture latency");
 }
 
 } // namespace Splash
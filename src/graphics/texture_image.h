@@ -186,6 +186,7 @@ class Texture_Image : public Texture
     };
 
     int64_t _lastDrawnTimestamp{0};
+    int64_t _uploadLatency{0}; //!< Delay between the timestamp of the last image and its upload, in us
 
     std::string _pixelFormat{"RGBA"};
     int _multisample{0};
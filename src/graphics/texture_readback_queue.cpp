@@ -0,0 +1,158 @@
+#include "./graphics/texture_readback_queue.h"
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+#include "./graphics/api/renderer.h"
+#include "./graphics/api/texture_image_gfx_impl.h"
+#include "./graphics/texture_image.h"
+
+namespace Splash
+{
+
+/*************/
+TextureReadbackQueue::TextureReadbackQueue(gfx::Renderer* renderer)
+    : _renderer(renderer)
+{
+}
+
+/*************/
+void TextureReadbackQueue::request(const std::shared_ptr<Texture_Image>& texture, int mipmapLevel)
+{
+    if (!texture)
+        return;
+
+    auto readbackIt = find(texture.get());
+    if (readbackIt == _readbacks.end())
+    {
+        Readback readback;
+        readback.texture = texture;
+        readback.key = texture.get();
+        readback.pbos = _renderer->createPboGfxImpl(_pboCount);
+        _readbacks.push_back(std::move(readback));
+        readbackIt = std::prev(_readbacks.end());
+    }
+
+    readbackIt->mipmapLevel = std::clamp(mipmapLevel, 0, gfx::Texture_ImageGfxImpl::_texLevels - 1);
+    readbackIt->requested = true;
+}
+
+/*************/
+std::optional<ImageBuffer> TextureReadbackQueue::getResult(const std::shared_ptr<Texture_Image>& texture)
+{
+    auto readbackIt = find(texture.get());
+    if (readbackIt == _readbacks.end())
+        return std::nullopt;
+
+    return std::exchange(readbackIt->result, std::nullopt);
+}
+
+/*************/
+void TextureReadbackQueue::cancel(const std::shared_ptr<Texture_Image>& texture)
+{
+    auto readbackIt = find(texture.get());
+    if (readbackIt == _readbacks.end())
+        return;
+
+    readbackIt->pbos->unmapRead();
+    _readbacks.erase(readbackIt);
+}
+
+/*************/
+void TextureReadbackQueue::process(int maxReadbacks)
+{
+    // Drop the readbacks for textures which do not exist anymore
+    std::erase_if(_readbacks, [](const auto& readback) { return readback.texture.expired(); });
+
+    // Gather whatever the GPU is done with. Readbacks still in flight are left
+    // for the next frame, we never wait on them
+    for (auto& readback : _readbacks)
+        collect(readback);
+
+    // Issue the pending requests, starting from where the last frame stopped so
+    // that no texture starves when there are more requests than allowed per frame
+    const auto readbackCount = _readbacks.size();
+    if (readbackCount == 0)
+        return;
+
+    _nextReadback %= readbackCount;
+    int issued = 0;
+    for (std::size_t i = 0; i < readbackCount && issued < maxReadbacks; ++i)
+    {
+        const auto index = (_nextReadback + i) % readbackCount;
+        auto& readback = _readbacks[index];
+        if (!readback.requested)
+            continue;
+
+        if (!issue(readback))
+            continue;
+
+        readback.requested = false;
+        ++issued;
+        _nextReadback = index + 1;
+    }
+}
+
+/*************/
+std::vector<TextureReadbackQueue::Readback>::iterator TextureReadbackQueue::find(const Texture_Image* texture)
+{
+    return std::find_if(_readbacks.begin(), _readbacks.end(), [&](const auto& readback) { return readback.key == texture && !readback.texture.expired(); });
+}
+
+/*************/
+void TextureReadbackQueue::collect(Readback& readback)
+{
+    // PBOs are written in a round-robin fashion, so the oldest one is the next to be written
+    for (std::size_t i = 0; i < _pboCount; ++i)
+    {
+        const auto index = (readback.pboWriteIndex + i) % _pboCount;
+        if (!readback.inFlight[index])
+            continue;
+
+        if (!readback.pbos->isFenceSignaled(index))
+            return;
+
+        const auto spec = *readback.inFlight[index];
+        auto pixels = readback.pbos->mapRead(index);
+        if (pixels)
+            readback.result = ImageBuffer(spec, pixels);
+        readback.pbos->unmapRead();
+        readback.inFlight[index].reset();
+    }
+}
+
+/*************/
+bool TextureReadbackQueue::issue(Readback& readback)
+{
+    // Both PBOs are still in use by the GPU, skip this frame rather than stall
+    if (readback.inFlight[readback.pboWriteIndex])
+        return false;
+
+    auto texture = readback.texture.lock();
+    if (!texture)
+        return false;
+
+    auto spec = texture->getSpec();
+    spec.width = std::max(1u, spec.width >> readback.mipmapLevel);
+    spec.height = std::max(1u, spec.height >> readback.mipmapLevel);
+    if (spec.rawSize() == 0)
+        return false;
+
+    // Resizing the PBOs discards their content, so any readback still in flight is lost
+    for (auto& inFlight : readback.inFlight)
+        if (inFlight && inFlight->rawSize() != spec.rawSize())
+            inFlight.reset();
+    readback.pbos->updatePBOs(spec.rawSize());
+
+    readback.pbos->activatePixelPack(readback.pboWriteIndex);
+    readback.pbos->packTexture(texture.get(), readback.mipmapLevel);
+    readback.pbos->deactivatePixelPack();
+    readback.pbos->insertFence(readback.pboWriteIndex);
+
+    readback.inFlight[readback.pboWriteIndex] = spec;
+    readback.pboWriteIndex = (readback.pboWriteIndex + 1) % _pboCount;
+    return true;
+}
+
+} // namespace Splash
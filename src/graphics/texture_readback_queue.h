@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2026 Splash authors
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @texture_readback_queue.h
+ * The TextureReadbackQueue class, batching asynchronous texture readbacks
+ */
+
+#ifndef SPLASH_TEXTURE_READBACK_QUEUE_H
+#define SPLASH_TEXTURE_READBACK_QUEUE_H
+
+#include <array>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "./core/imagebuffer.h"
+#include "./graphics/api/pbo_gfx_impl.h"
+
+namespace Splash
+{
+
+class Texture_Image;
+
+namespace gfx
+{
+class Renderer;
+}
+
+/*************/
+class TextureReadbackQueue
+{
+  public:
+    /**
+     * Constructor
+     * \param renderer Renderer used to create the pixel buffer objects
+     */
+    explicit TextureReadbackQueue(gfx::Renderer* renderer);
+    ~TextureReadbackQueue() = default;
+
+    /**
+     * Request a readback of the given texture at the given mipmap level
+     * The readback happens asynchronously, the result being available through getResult
+     * once the GPU is done with it, usually the next frame.
+     * Must be called from the rendering thread.
+     * \param texture Texture to read back
+     * \param mipmapLevel Mipmap level to read
+     */
+    void request(const std::shared_ptr<Texture_Image>& texture, int mipmapLevel);
+
+    /**
+     * Get the latest completed readback for the given texture
+     * \param texture Texture to get the result for
+     * \return Return the image if a readback has completed since the last call, std::nullopt otherwise
+     */
+    std::optional<ImageBuffer> getResult(const std::shared_ptr<Texture_Image>& texture);
+
+    /**
+     * Stop reading back the given texture
+     * \param texture Texture to stop reading back
+     */
+    void cancel(const std::shared_ptr<Texture_Image>& texture);
+
+    /**
+     * Collect the readbacks which are completed, and issue the pending requests
+     * Must be called once per frame from the rendering thread, after all textures have been rendered.
+     * \param maxReadbacks Maximum number of readbacks to issue
+     */
+    void process(int maxReadbacks);
+
+  private:
+    static constexpr std::size_t _pboCount{2};
+
+    struct Readback
+    {
+        std::weak_ptr<Texture_Image> texture{};
+        const Texture_Image* key{nullptr};
+        int mipmapLevel{0};
+        bool requested{false};
+        std::unique_ptr<gfx::PboGfxImpl> pbos{nullptr};
+        std::size_t pboWriteIndex{0};
+        std::array<std::optional<ImageBufferSpec>, _pboCount> inFlight{};
+        std::optional<ImageBuffer> result{};
+    };
+
+    gfx::Renderer* _renderer{nullptr};
+    std::vector<Readback> _readbacks{};
+    std::size_t _nextReadback{0};
+
+    /**
+     * Find the readback for the given texture
+     * \param texture Texture
+     * \return Return an iterator to the readback, or end() if not found
+     */
+    std::vector<Readback>::iterator find(const Texture_Image* texture);
+
+    /**
+     * Copy the completed PBOs of the given readback to its result
+     * \param readback Readback to collect
+     */
+    void collect(Readback& readback);
+
+    /**
+     * Issue the GPU copy of the given readback into its next free PBO
+     * \param readback Readback to issue
+     * \return Return true if a copy has been issued
+     */
+    bool issue(Readback& readback);
+};
+
+} // namespace Splash
+
+#endif // SPLASH_TEXTURE_READBACK_QUEUE_H
@@ -279,9 +279,18 @@ void Warp::render()
     colorTexture->generateMipmap();
     if (_grabMipmapLevel >= 0)
     {
-        _mipmapBuffer = colorTexture->grabMipmap(_grabMipmapLevel).getRawBuffer();
-        auto spec = colorTexture->getSpec();
-        _mipmapBufferSpec = {spec.width, spec.height, spec.channels, spec.bpp, spec.format};
+        auto readbackQueue = _scene->getTextureReadbackQueue();
+        readbackQueue->request(colorTexture, _grabMipmapLevel);
+        if (const auto mipmap = readbackQueue->getResult(colorTexture); mipmap)
+        {
+            _mipmapBuffer = mipmap->getRawBuffer();
+            const auto spec = mipmap->getSpec();
+            _mipmapBufferSpec = {spec.width, spec.height, spec.channels, spec.bpp, spec.format};
+        }
+    }
+    else
+    {
+        _scene->getTextureReadbackQueue()->cancel(colorTexture);
     }
 
     colorTexture->setTimestamp(input->getTimestamp());
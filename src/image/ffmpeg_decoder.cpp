@@ -0,0 +1,1098 @@
+#include "./image/ffmpeg_decoder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#if HAVE_LINUX
+#include <fcntl.h>
+#endif
+#include <hap.h>
+
+#include "./utils/log.h"
+#include "./utils/osutils.h"
+
+namespace chrono = std::chrono;
+
+namespace Splash
+{
+
+/*************/
+std::shared_ptr<FFmpegDecoder> FFmpegDecoder::acquire(const Parameters& parameters, ConsumerId consumer, bool share, float seconds, bool create)
+{
+    std::lock_guard<std::mutex> lock(_decodersMutex);
+    _decoders.erase(std::remove_if(_decoders.begin(), _decoders.end(), [](const auto& decoder) { return decoder.expired(); }), _decoders.end());
+
+    if (share)
+    {
+        for (const auto& weakDecoder : _decoders)
+        {
+            auto decoder = weakDecoder.lock();
+            if (!decoder || !decoder->_shared || decoder->getParameters() != parameters)
+                continue;
+
+            std::lock_guard<std::mutex> lockFrames(decoder->_frameMutex);
+            if (!decoder->isJoinable())
+                continue;
+
+            Log::get() << Log::MESSAGE << "FFmpegDecoder::" << __FUNCTION__ << " - Sharing the decoder for file " << parameters.filepath << Log::endl;
+            auto& cursors = decoder->_cursors;
+            const auto slowestCursor = std::min_element(cursors.begin(), cursors.end(), [](const auto& a, const auto& b) { return a.second < b.second; });
+            cursors.emplace_back(consumer, slowestCursor != cursors.end() ? slowestCursor->second : decoder->_nextSequence - decoder->_frames.size());
+            return decoder;
+        }
+    }
+
+    if (!create)
+        return nullptr;
+
+    auto decoder = std::shared_ptr<FFmpegDecoder>(new FFmpegDecoder(parameters));
+    decoder->_shared = share;
+    decoder->addConsumer(consumer);
+    if (!decoder->open(seconds))
+        return nullptr;
+
+    _decoders.push_back(decoder);
+    return decoder;
+}
+
+/*************/
+FFmpegDecoder::FFmpegDecoder(const Parameters& parameters)
+    : _parameters(parameters)
+{
+}
+
+/*************/
+FFmpegDecoder::~FFmpegDecoder()
+{
+    _continueRead = false;
+    if (_readLoopThread.joinable())
+        _readLoopThread.join();
+    if (_seekIndexThread.joinable())
+        _seekIndexThread.join();
+
+    if (_avContext)
+    {
+        avformat_close_input(&_avContext);
+        _avContext = nullptr;
+    }
+}
+
+/*************/
+bool FFmpegDecoder::open(float seconds)
+{
+    const auto& filepath = _parameters.filepath;
+    if (avformat_open_input(&_avContext, filepath.c_str(), nullptr, nullptr) != 0)
+    {
+        Log::get() << Log::WARNING << "FFmpegDecoder::" << __FUNCTION__ << " - Couldn't read file " << filepath << Log::endl;
+        return false;
+    }
+
+    if (avformat_find_stream_info(_avContext, nullptr) < 0)
+    {
+        Log::get() << Log::WARNING << "FFmpegDecoder::" << __FUNCTION__ << " - Couldn't retrieve information for file " << filepath << Log::endl;
+        avformat_close_input(&_avContext);
+        return false;
+    }
+
+    Log::get() << Log::MESSAGE << "FFmpegDecoder::" << __FUNCTION__ << " - Successfully loaded file " << filepath << Log::endl;
+    av_dump_format(_avContext, 0, filepath.c_str(), 0);
+
+#if HAVE_LINUX
+    // Give the kernel hints about how to read the file
+    auto fd = Utils::getFileDescriptorForOpenedFile(filepath);
+    if (fd)
+    {
+        bool success = true;
+        success &= posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+        success &= posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL) == 0;
+        if (!success)
+            Log::get() << Log::WARNING << "FFmpegDecoder::" << __FUNCTION__ << " - Could not set hints for video file reading access" << Log::endl;
+    }
+#endif
+
+    // Find the first video stream
+    _videoStreamIndex = -1;
+#if HAVE_PORTAUDIO
+    _audioStreamIndex = -1;
+#endif
+    for (uint32_t i = 0; i < _avContext->nb_streams; ++i)
+    {
+        if (_avContext->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_VIDEO && _videoStreamIndex < 0)
+            _videoStreamIndex = i;
+#if HAVE_PORTAUDIO
+        else if (_avContext->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_AUDIO && _audioStreamIndex < 0)
+            _audioStreamIndex = i;
+#endif
+    }
+
+    if (_videoStreamIndex == -1)
+    {
+        Log::get() << Log::WARNING << "FFmpegDecoder::" << __FUNCTION__ << " - No video stream found in file " << filepath << Log::endl;
+        return false;
+    }
+
+    auto videoStream = _avContext->streams[_videoStreamIndex];
+    _videoTimeBase = static_cast<double>(videoStream->time_base.num) / static_cast<double>(videoStream->time_base.den);
+
+    if (seconds > 0.f)
+        seek(seconds);
+
+    _continueRead = true;
+    _readLoopThread = std::thread([&]() { readLoop(); });
+
+    return true;
+}
+
+/*************/
+bool FFmpegDecoder::isJoinable() const
+{
+    if (_jumped)
+        return false;
+
+    if (_cursors.empty())
+        return true;
+
+    // The new consumer starts from the frame the slowest consumer is about to show
+    const auto slowestCursor = std::min_element(_cursors.begin(), _cursors.end(), [](const auto& a, const auto& b) { return a.second < b.second; })->second;
+    const auto firstSequence = _nextSequence - _frames.size();
+    if (slowestCursor < firstSequence)
+        return true;
+
+    const auto index = slowestCursor - firstSequence;
+    const auto timing = index < _frames.size() ? _frames[index].timing : _lastTiming;
+    return isWithinJoinDelay(_parameters, timing);
+}
+
+/*************/
+bool FFmpegDecoder::isWithinJoinDelay(const Parameters& parameters, uint64_t timing)
+{
+    // Playback starts at the trimming start, if the media is trimmed
+    const auto start = parameters.trimEnd > parameters.trimStart ? parameters.trimStart : 0;
+    return timing <= start + _maximumJoinDelay;
+}
+
+/*************/
+void FFmpegDecoder::addConsumer(ConsumerId consumer)
+{
+    std::lock_guard<std::mutex> lock(_frameMutex);
+    _cursors.emplace_back(consumer, _nextSequence - _frames.size());
+}
+
+/*************/
+void FFmpegDecoder::release(ConsumerId consumer)
+{
+    std::lock_guard<std::mutex> lock(_frameMutex);
+    _cursors.erase(std::remove_if(_cursors.begin(), _cursors.end(), [&](const auto& cursor) { return cursor.first == consumer; }), _cursors.end());
+    releaseFrames();
+}
+
+/*************/
+size_t FFmpegDecoder::getConsumerCount() const
+{
+    std::lock_guard<std::mutex> lock(_frameMutex);
+    return _cursors.size();
+}
+
+/*************/
+FFmpegDecoder::Parameters FFmpegDecoder::getParameters() const
+{
+    std::lock_guard<std::mutex> lock(_frameMutex);
+    return _parameters;
+}
+
+/*************/
+void FFmpegDecoder::setParameters(const Parameters& parameters)
+{
+    bool seekToTrimStart = false;
+    {
+        std::lock_guard<std::mutex> lock(_frameMutex);
+        _parameters.loop = parameters.loop;
+        _parameters.trimStart = parameters.trimStart;
+        _parameters.trimEnd = parameters.trimEnd;
+        _parameters.timeShift = parameters.timeShift;
+        _parameters.useClock = parameters.useClock;
+
+        if (_parameters.trimEnd <= _parameters.trimStart)
+            return;
+
+        // Drop the decoded frames which are out of the new trimmed part
+        bool droppedLeadingFrames = false;
+        while (!_frames.empty() && _frames.front().timing < _parameters.trimStart)
+        {
+            _framesSize -= _frames.front().image->getSize();
+            _frames.pop_front();
+            droppedLeadingFrames = true;
+        }
+
+        if (droppedLeadingFrames)
+        {
+            _discontinuity = _frames.empty();
+            if (!_frames.empty())
+                _frames.front().discontinuity = true;
+        }
+
+        bool droppedTrailingFrames = false;
+        while (!_frames.empty() && _frames.back().timing > _parameters.trimEnd)
+        {
+            _framesSize -= _frames.back().image->getSize();
+            _frames.pop_back();
+            --_nextSequence;
+            droppedTrailingFrames = true;
+        }
+
+        if (droppedTrailingFrames || static_cast<uint64_t>(_lastTiming) > _parameters.trimEnd)
+        {
+            for (auto& cursor : _cursors)
+                cursor.second = std::min(cursor.second, _nextSequence);
+            _trimEndReached = true;
+        }
+
+        // Rather than decoding all frames up to the new trimming start, seek to it
+        seekToTrimStart = static_cast<uint64_t>(_lastTiming) < _parameters.trimStart;
+    }
+
+    if (seekToTrimStart)
+        seek(static_cast<float>(parameters.trimStart) / 1e6);
+}
+
+/*************/
+float FFmpegDecoder::getDuration() const
+{
+    if (!_avContext)
+        return 0.f;
+    return static_cast<float>(_avContext->duration) / static_cast<float>(AV_TIME_BASE);
+}
+
+/*************/
+std::string FFmpegDecoder::getVideoFormat() const
+{
+    std::lock_guard<std::mutex> lock(_frameMutex);
+    return _videoFormat;
+}
+
+/*************/
+std::optional<FFmpegDecoder::Frame> FFmpegDecoder::getFrame(ConsumerId consumer) const
+{
+    std::lock_guard<std::mutex> lock(_frameMutex);
+    const auto cursor = std::find_if(_cursors.begin(), _cursors.end(), [&](const auto& cursor) { return cursor.first == consumer; });
+    if (cursor == _cursors.end())
+        return {};
+
+    const auto firstSequence = _nextSequence - _frames.size();
+    const auto index = std::max(cursor->second, firstSequence) - firstSequence;
+    if (index >= _frames.size())
+        return {};
+
+    return _frames[index];
+}
+
+/*************/
+void FFmpegDecoder::nextFrame(ConsumerId consumer)
+{
+    std::lock_guard<std::mutex> lock(_frameMutex);
+    const auto cursor = std::find_if(_cursors.begin(), _cursors.end(), [&](const auto& cursor) { return cursor.first == consumer; });
+    if (cursor == _cursors.end())
+        return;
+
+    const auto firstSequence = _nextSequence - _frames.size();
+    cursor->second = std::min(std::max(cursor->second, firstSequence) + 1, _nextSequence);
+    releaseFrames();
+}
+
+/*************/
+void FFmpegDecoder::releaseFrames()
+{
+    if (_cursors.empty())
+        return;
+
+    const auto slowestCursor = std::min_element(_cursors.begin(), _cursors.end(), [](const auto& a, const auto& b) { return a.second < b.second; })->second;
+    while (!_frames.empty() && _frames.front().sequence < slowestCursor)
+    {
+        _framesSize -= _frames.front().image->getSize();
+        _frames.pop_front();
+    }
+}
+
+/*************/
+bool FFmpegDecoder::skipLaggingConsumers()
+{
+    std::lock_guard<std::mutex> lock(_frameMutex);
+    if (_cursors.size() < 2 || _framesSize <= _maximumBufferSize)
+        return false;
+
+    // If the fastest consumer still has frames to show, the buffer is full because all consumers are behind
+    const auto fastestCursor = std::max_element(_cursors.begin(), _cursors.end(), [](const auto& a, const auto& b) { return a.second < b.second; })->second;
+    if (fastestCursor < _nextSequence)
+        return false;
+
+    // Lagging cursors behind the first frame kept are moved to it when reading the frames
+    bool released = false;
+    while (_frames.size() > 1 && _framesSize > _maximumBufferSize)
+    {
+        _framesSize -= _frames.front().image->getSize();
+        _frames.pop_front();
+        released = true;
+    }
+
+    return released;
+}
+
+/*************/
+int64_t FFmpegDecoder::getFramesSize() const
+{
+    std::lock_guard<std::mutex> lock(_frameMutex);
+    return _framesSize;
+}
+
+/*************/
+void FFmpegDecoder::pushFrame(std::unique_ptr<ImageBuffer>&& image, uint64_t timing)
+{
+    std::lock_guard<std::mutex> lock(_frameMutex);
+    _lastTiming = timing;
+
+    // Frames out of the trimmed part of the media are not shown
+    if (_parameters.trimEnd > _parameters.trimStart)
+    {
+        if (timing < _parameters.trimStart)
+            return;
+        if (timing > _parameters.trimEnd)
+        {
+            _trimEndReached = true;
+            return;
+        }
+    }
+
+    Frame frame;
+    _framesSize += image->getSize();
+    frame.image = std::move(image);
+    frame.timing = timing;
+    frame.sequence = _nextSequence++;
+    frame.discontinuity = std::exchange(_discontinuity, false);
+    _frames.push_back(std::move(frame));
+}
+
+/*************/
+void FFmpegDecoder::seek(float seconds, bool flush, bool precise)
+{
+    if (!_avContext)
+        return;
+
+    std::lock_guard<std::mutex> lock(_videoSeekMutex);
+
+    // Prevent seeking outside of the file
+    float duration = getDuration();
+    if (seconds < 0)
+        seconds = 0;
+    else if (seconds > duration)
+        seconds = duration;
+
+    const auto target = static_cast<int64_t>(seconds * 1e6);
+    const auto timestamp = static_cast<int64_t>(floor(seconds / _videoTimeBase));
+    const auto keyframes = getSurroundingKeyframes(timestamp);
+
+    if (flush)
+    {
+        std::lock_guard<std::mutex> lockFrames(_frameMutex);
+
+        // If the target frame has already been decoded, only the frames before it are dropped
+        const auto alreadyDecoded = !_frames.empty() && static_cast<int64_t>(_frames.front().timing) <= target && static_cast<int64_t>(_frames.back().timing) >= target;
+        // If no keyframe lies between the decoding position and the target, decoding forward is faster than seeking
+        const auto lastTimestamp = static_cast<int64_t>(static_cast<double>(_lastTiming) / 1e6 / _videoTimeBase);
+        const auto decodeForward = keyframes && target > _lastTiming && keyframes->first <= lastTimestamp;
+
+        if (alreadyDecoded || decodeForward)
+        {
+            while (!_frames.empty() && static_cast<int64_t>(_frames.front().timing) < target)
+            {
+                _framesSize -= _frames.front().image->getSize();
+                _frames.pop_front();
+            }
+
+            _seekTarget = target;
+            _discontinuity = _frames.empty();
+            if (!_frames.empty())
+                _frames.front().discontinuity = true;
+            _jumped = true;
+            _trimEndReached = false;
+            for (auto& cursor : _cursors)
+                cursor.second = _nextSequence - _frames.size();
+#if HAVE_PORTAUDIO
+            _audioQueue.clear();
+#endif
+            ++_flushCount;
+            return;
+        }
+    }
+
+    int result = 0;
+    if (keyframes)
+    {
+        // The index gives the exact keyframe to start decoding from
+        result = avformat_seek_file(_avContext, _videoStreamIndex, std::numeric_limits<int64_t>::min(), keyframes->first, keyframes->first, 0);
+    }
+    else
+    {
+        int64_t lastTiming = 0;
+        {
+            std::lock_guard<std::mutex> lockFrames(_frameMutex);
+            lastTiming = _lastTiming;
+        }
+
+        int seekFlag = 0;
+        if (static_cast<float>(lastTiming) / 1e6f > seconds)
+            seekFlag = AVSEEK_FLAG_BACKWARD;
+        result = avformat_seek_file(_avContext, _videoStreamIndex, 0, timestamp, timestamp, seekFlag);
+    }
+
+    if (result < 0)
+    {
+        Log::get() << Log::WARNING << "FFmpegDecoder::" << __FUNCTION__ << " - Could not seek to timestamp " << seconds << Log::endl;
+    }
+    else
+    {
+        std::lock_guard<std::mutex> lockFrames(_frameMutex);
+        // Seeking goes to the closest keyframe before the desired timestamp. Unless the seek is not precise,
+        // the frames between the keyframe and the desired timestamp are decoded but not shown.
+        // Consumers will set their start time at the next frame.
+        _seekTarget = precise ? target : 0;
+        _discontinuity = true;
+        _jumped = true;
+        _trimEndReached = false;
+
+        if (flush)
+        {
+            _flushCodecs = true;
+            _frames.clear();
+            _framesSize = 0;
+            for (auto& cursor : _cursors)
+                cursor.second = _nextSequence;
+#if HAVE_PORTAUDIO
+            _audioQueue.clear();
+#endif
+            ++_flushCount;
+        }
+    }
+}
+
+/*************/
+void FFmpegDecoder::enableSeekIndex()
+{
+    if (!_avContext || _seekIndexRequested.exchange(true))
+        return;
+
+    if (loadSeekIndex())
+    {
+        Log::get() << Log::MESSAGE << "FFmpegDecoder::" << __FUNCTION__ << " - Loaded the keyframe index for file " << _parameters.filepath << Log::endl;
+        return;
+    }
+
+    _seekIndexThread = std::thread([this]() { buildSeekIndex(); });
+}
+
+/*************/
+bool FFmpegDecoder::hasSeekIndex() const
+{
+    std::lock_guard<std::mutex> lock(_seekIndexMutex);
+    return !_keyframes.empty();
+}
+
+/*************/
+std::optional<std::pair<int64_t, int64_t>> FFmpegDecoder::getSurroundingKeyframes(int64_t timestamp) const
+{
+    std::lock_guard<std::mutex> lock(_seekIndexMutex);
+    if (_keyframes.empty())
+        return {};
+
+    const auto next = std::upper_bound(_keyframes.begin(), _keyframes.end(), timestamp);
+    const auto previousKeyframe = next == _keyframes.begin() ? _keyframes.front() : *std::prev(next);
+    const auto nextKeyframe = next == _keyframes.end() ? std::numeric_limits<int64_t>::max() : *next;
+    return std::make_pair(previousKeyframe, nextKeyframe);
+}
+
+/*************/
+void FFmpegDecoder::buildSeekIndex()
+{
+    const auto& filepath = _parameters.filepath;
+
+    // A separate context is used, so as not to disturb the decoding
+    AVFormatContext* context = nullptr;
+    if (avformat_open_input(&context, filepath.c_str(), nullptr, nullptr) != 0)
+    {
+        Log::get() << Log::WARNING << "FFmpegDecoder::" << __FUNCTION__ << " - Couldn't read file " << filepath << Log::endl;
+        return;
+    }
+
+    AVPacket* packet = av_packet_alloc();
+    if (!packet)
+    {
+        avformat_close_input(&context);
+        return;
+    }
+
+    // Only the packets are read, nothing is decoded
+    std::vector<int64_t> keyframes;
+    while (_continueRead && av_read_frame(context, packet) >= 0)
+    {
+        if (packet->stream_index == _videoStreamIndex && (packet->flags & AV_PKT_FLAG_KEY))
+        {
+            const auto timestamp = packet->pts != AV_NOPTS_VALUE ? packet->pts : packet->dts;
+            if (timestamp != AV_NOPTS_VALUE)
+                keyframes.push_back(timestamp);
+        }
+        av_packet_unref(packet);
+    }
+
+    const bool complete = _continueRead;
+    av_packet_free(&packet);
+    avformat_close_input(&context);
+
+    if (!complete || keyframes.empty())
+        return;
+
+    std::sort(keyframes.begin(), keyframes.end());
+    keyframes.erase(std::unique(keyframes.begin(), keyframes.end()), keyframes.end());
+
+    {
+        std::lock_guard<std::mutex> lock(_seekIndexMutex);
+        _keyframes = std::move(keyframes);
+    }
+
+    Log::get() << Log::MESSAGE << "FFmpegDecoder::" << __FUNCTION__ << " - Built the keyframe index for file " << filepath << Log::endl;
+
+    if (!saveSeekIndex())
+        Log::get() << Log::WARNING << "FFmpegDecoder::" << __FUNCTION__ << " - Could not save the keyframe index for file " << filepath << Log::endl;
+}
+
+/*************/
+std::optional<std::pair<uint64_t, int64_t>> FFmpegDecoder::getFileSignature() const
+{
+    std::error_code error;
+    const auto fileSize = std::filesystem::file_size(_parameters.filepath, error);
+    if (error)
+        return {};
+    const auto writeTime = std::filesystem::last_write_time(_parameters.filepath, error);
+    if (error)
+        return {};
+
+    return std::make_pair(static_cast<uint64_t>(fileSize), static_cast<int64_t>(writeTime.time_since_epoch().count()));
+}
+
+/*************/
+bool FFmpegDecoder::loadSeekIndex()
+{
+    const auto signature = getFileSignature();
+    if (!signature)
+        return false;
+
+    std::ifstream file(_parameters.filepath + _seekIndexExtension, std::ios::binary);
+    if (!file.is_open())
+        return false;
+
+    // The index is only valid for the exact same version of the media file
+    char magic[sizeof(_seekIndexMagic)];
+    uint64_t fileSize = 0;
+    int64_t writeTime = 0;
+    int32_t streamIndex = -1;
+    uint64_t count = 0;
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char*>(&fileSize), sizeof(fileSize));
+    file.read(reinterpret_cast<char*>(&writeTime), sizeof(writeTime));
+    file.read(reinterpret_cast<char*>(&streamIndex), sizeof(streamIndex));
+    file.read(reinterpret_cast<char*>(&count), sizeof(count));
+
+    if (!file || !std::equal(magic, magic + sizeof(magic), _seekIndexMagic) || fileSize != signature->first || writeTime != signature->second ||
+        streamIndex != _videoStreamIndex || count == 0 || count > fileSize)
+        return false;
+
+    std::vector<int64_t> keyframes(count);
+    file.read(reinterpret_cast<char*>(keyframes.data()), count * sizeof(int64_t));
+    if (!file || !std::is_sorted(keyframes.begin(), keyframes.end()))
+        return false;
+
+    std::lock_guard<std::mutex> lock(_seekIndexMutex);
+    _keyframes = std::move(keyframes);
+    return true;
+}
+
+/*************/
+bool FFmpegDecoder::saveSeekIndex() const
+{
+    const auto signature = getFileSignature();
+    if (!signature)
+        return false;
+
+    const auto indexPath = _parameters.filepath + _seekIndexExtension;
+    const auto temporaryPath = indexPath + ".tmp";
+
+    {
+        std::lock_guard<std::mutex> lock(_seekIndexMutex);
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+            return false;
+
+        const uint64_t fileSize = signature->first;
+        const int64_t writeTime = signature->second;
+        const int32_t streamIndex = _videoStreamIndex;
+        const uint64_t count = _keyframes.size();
+        file.write(_seekIndexMagic, sizeof(_seekIndexMagic));
+        file.write(reinterpret_cast<const char*>(&fileSize), sizeof(fileSize));
+        file.write(reinterpret_cast<const char*>(&writeTime), sizeof(writeTime));
+        file.write(reinterpret_cast<const char*>(&streamIndex), sizeof(streamIndex));
+        file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+        file.write(reinterpret_cast<const char*>(_keyframes.data()), count * sizeof(int64_t));
+        if (!file)
+            return false;
+    }
+
+    // Renaming makes sure that no partially written index is ever read
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, indexPath, error);
+    if (error)
+    {
+        std::filesystem::remove(temporaryPath, error);
+        return false;
+    }
+
+    return true;
+}
+
+#if HAVE_PORTAUDIO
+/*************/
+bool FFmpegDecoder::isAudioOwner(ConsumerId consumer) const
+{
+    std::lock_guard<std::mutex> lock(_frameMutex);
+    return !_cursors.empty() && _cursors.front().first == consumer;
+}
+
+/*************/
+std::optional<FFmpegDecoder::AudioParameters> FFmpegDecoder::getAudioParameters() const
+{
+    std::lock_guard<std::mutex> lock(_frameMutex);
+    return _audioParameters;
+}
+
+/*************/
+void FFmpegDecoder::getAudioFrames(ConsumerId consumer, std::deque<AudioFrame>& frames)
+{
+    std::lock_guard<std::mutex> lock(_frameMutex);
+    if (_cursors.empty() || _cursors.front().first != consumer)
+        return;
+
+    std::move(_audioQueue.begin(), _audioQueue.end(), std::back_inserter(frames));
+    _audioQueue.clear();
+}
+#endif
+
+/*************/
+std::string FFmpegDecoder::tagToFourCC(unsigned int tag)
+{
+    std::string fourcc;
+    fourcc.resize(4);
+
+    unsigned int sum = 0;
+    fourcc[3] = char(tag >> 24);
+    sum += (fourcc[3]) << 24;
+
+    fourcc[2] = char((tag - sum) >> 16);
+    sum += (fourcc[2]) << 16;
+
+    fourcc[1] = char((tag - sum) >> 8);
+    sum += (fourcc[1]) << 8;
+
+    fourcc[0] = char(tag - sum);
+
+    return fourcc;
+}
+
+/*************/
+void FFmpegDecoder::readLoop()
+{
+    const auto& filepath = _parameters.filepath;
+
+#if HAVE_PORTAUDIO
+    if (_audioStreamIndex == -1)
+    {
+        Log::get() << Log::MESSAGE << "FFmpegDecoder::" << __FUNCTION__ << " - No audio stream found in file " << filepath << Log::endl;
+    }
+#endif
+
+    // Find a video decoder
+    auto videoCodecParameters = _avContext->streams[_videoStreamIndex]->codecpar;
+    auto videoCodecContext = avcodec_alloc_context3(nullptr);
+    if (avcodec_parameters_to_context(videoCodecContext, videoCodecParameters) < 0)
+    {
+        Log::get() << Log::WARNING << "FFmpegDecoder::" << __FUNCTION__ << " - Unable to create a video context from the codec parameters from file " << filepath << Log::endl;
+        return;
+    }
+
+    // Set video format info
+    {
+        auto videoFormat = std::string(1024, '\0');
+        avcodec_string(videoFormat.data(), videoFormat.size(), videoCodecContext, 0);
+        std::lock_guard<std::mutex> lock(_frameMutex);
+        _videoFormat = videoFormat;
+    }
+
+    videoCodecContext->thread_count = std::min(Utils::getCoreCount(), 16);
+    auto videoCodec = avcodec_find_decoder(videoCodecContext->codec_id);
+    auto isHap = false;
+
+    // Check whether the video codec only has intra frames
+    auto desc = avcodec_descriptor_get(videoCodecContext->codec_id);
+    if (desc)
+        _intraOnly = !!(desc->props & AV_CODEC_PROP_INTRA_ONLY);
+    else
+        _intraOnly = false; // We don't know, so we consider it's not
+
+    auto fourcc = tagToFourCC(videoCodecContext->codec_tag);
+    if (fourcc.find("Hap") != std::string::npos)
+    {
+        isHap = true;
+        _intraOnly = true; // Hap is necessarily intra only
+    }
+    else if (videoCodec == nullptr)
+    {
+        Log::get() << Log::WARNING << "FFmpegDecoder::" << __FUNCTION__ << " - Video codec not supported for file " << filepath << Log::endl;
+        return;
+    }
+
+    if (videoCodec)
+    {
+        AVDictionary* optionsDict = nullptr;
+        if (avcodec_open2(videoCodecContext, videoCodec, &optionsDict) < 0)
+        {
+            Log::get() << Log::WARNING << "FFmpegDecoder::" << __FUNCTION__ << " - Could not open video codec for file " << filepath << Log::endl;
+            return;
+        }
+    }
+
+#if HAVE_PORTAUDIO
+    // Find an audio decoder
+    auto audioCodecContext = avcodec_alloc_context3(nullptr);
+    auto planar = false;
+    if (_audioStreamIndex >= 0)
+    {
+        auto audioCodecParameters = _avContext->streams[_audioStreamIndex]->codecpar;
+        if (avcodec_parameters_to_context(audioCodecContext, audioCodecParameters) < 0)
+        {
+            Log::get() << Log::WARNING << "FFmpegDecoder::" << __FUNCTION__ << " - Unable to create an audio context from the codec parameters for file " << filepath << Log::endl;
+            return;
+        }
+
+        const auto audioCodec = avcodec_find_decoder(audioCodecContext->codec_id);
+
+        if (audioCodec == nullptr)
+        {
+            Log::get() << Log::WARNING << "FFmpegDecoder::" << __FUNCTION__ << " - Audio codec not supported for file " << filepath << Log::endl;
+            audioCodecContext = nullptr;
+        }
+        else
+        {
+            AVDictionary* audioOptionsDict = nullptr;
+            if (avcodec_open2(audioCodecContext, audioCodec, &audioOptionsDict) < 0)
+            {
+                Log::get() << Log::WARNING << "FFmpegDecoder::" << __FUNCTION__ << " - Could not open audio codec for file " << filepath << Log::endl;
+                audioCodecContext = nullptr;
+            }
+        }
+
+        if (audioCodecContext)
+        {
+            AudioParameters audioParameters;
+#if LIBAVCODEC_VERSION_INT < AV_VERSION_INT(59, 37, 100)
+            audioParameters.channels = audioCodecContext->channels;
+#else
+            audioParameters.channels = audioCodecContext->ch_layout.nb_channels;
+#endif
+            audioParameters.sampleRate = audioCodecContext->sample_rate;
+
+            planar = av_sample_fmt_is_planar(audioCodecContext->sample_fmt);
+            switch (audioCodecContext->sample_fmt)
+            {
+            default:
+                Log::get() << Log::WARNING << "FFmpegDecoder::" << __FUNCTION__ << " - Unsupported sample format" << Log::endl;
+                break;
+            case AV_SAMPLE_FMT_U8:
+                audioParameters.format = Sound_Engine::SAMPLE_FMT_U8;
+                break;
+            case AV_SAMPLE_FMT_S16:
+                audioParameters.format = Sound_Engine::SAMPLE_FMT_S16;
+                break;
+            case AV_SAMPLE_FMT_S32:
+                audioParameters.format = Sound_Engine::SAMPLE_FMT_S32;
+                break;
+            case AV_SAMPLE_FMT_FLT:
+                audioParameters.format = Sound_Engine::SAMPLE_FMT_FLT;
+                break;
+            case AV_SAMPLE_FMT_U8P:
+                audioParameters.format = Sound_Engine::SAMPLE_FMT_U8P;
+                break;
+            case AV_SAMPLE_FMT_S16P:
+                audioParameters.format = Sound_Engine::SAMPLE_FMT_S16P;
+                break;
+            case AV_SAMPLE_FMT_S32P:
+                audioParameters.format = Sound_Engine::SAMPLE_FMT_S32P;
+                break;
+            case AV_SAMPLE_FMT_FLTP:
+                audioParameters.format = Sound_Engine::SAMPLE_FMT_FLTP;
+                break;
+            }
+
+            if (audioParameters.format != Sound_Engine::SAMPLE_FMT_UNKNOWN)
+            {
+                std::lock_guard<std::mutex> lock(_frameMutex);
+                _audioParameters = audioParameters;
+            }
+            else
+            {
+                audioCodecContext = nullptr;
+            }
+        }
+
+        auto audioStream = _avContext->streams[_audioStreamIndex];
+        _audioTimeBase = (double)audioStream->time_base.num / (double)audioStream->time_base.den;
+    }
+#endif
+
+    // Start reading frames
+    AVFrame *frame, *rgbFrame;
+    frame = av_frame_alloc();
+    rgbFrame = av_frame_alloc();
+
+    if (!frame || !rgbFrame)
+    {
+        Log::get() << Log::WARNING << "FFmpegDecoder::" << __FUNCTION__ << " - Error while allocating frame structures" << Log::endl;
+        return;
+    }
+
+    int numBytes = av_image_get_buffer_size(AV_PIX_FMT_YUYV422, videoCodecContext->width, videoCodecContext->height, 1);
+    std::vector<unsigned char> buffer(numBytes);
+
+    struct SwsContext* swsContext = nullptr;
+    if (!isHap)
+    {
+        swsContext = sws_getContext(videoCodecContext->width,
+            videoCodecContext->height,
+            videoCodecContext->pix_fmt,
+            videoCodecContext->width,
+            videoCodecContext->height,
+            AV_PIX_FMT_YUYV422,
+            SWS_BILINEAR,
+            nullptr,
+            nullptr,
+            nullptr);
+
+        av_image_fill_arrays(rgbFrame->data, rgbFrame->linesize, buffer.data(), AV_PIX_FMT_YUYV422, videoCodecContext->width, videoCodecContext->height, 1);
+    }
+
+    AVPacket* packet = av_packet_alloc();
+    if (!packet)
+    {
+        Log::get() << Log::ERROR << "FFmpegDecoder::" << __FUNCTION__ << " - Unable to allocate packet for decoding frames" << Log::endl;
+        return;
+    }
+
+    // This implements looping
+    while (_continueRead)
+    {
+        auto shouldContinueLoop = [&]() -> bool {
+            std::lock_guard<std::mutex> lock(_videoSeekMutex);
+            return _continueRead && !_trimEndReached && av_read_frame(_avContext, packet) >= 0;
+        };
+
+        while (shouldContinueLoop())
+        {
+            // Frames held by the codecs from before a seek are dropped
+            if (_flushCodecs.exchange(false))
+            {
+                if (!isHap)
+                    avcodec_flush_buffers(videoCodecContext);
+#if HAVE_PORTAUDIO
+                if (audioCodecContext)
+                    avcodec_flush_buffers(audioCodecContext);
+#endif
+            }
+
+            // Reading the video
+            if (packet->stream_index == _videoStreamIndex && _videoSeekMutex.try_lock())
+            {
+                auto img = std::unique_ptr<ImageBuffer>();
+                uint64_t timing = 0;
+                bool hasFrame = false;
+
+                //
+                // If the codec is handled by FFmpeg
+                if (!isHap)
+                {
+                    auto frameFinished = false;
+                    if (avcodec_send_packet(videoCodecContext, packet) < 0)
+                        Log::get() << Log::WARNING << "FFmpegDecoder::" << __FUNCTION__ << " - Error while decoding a frame in file " << filepath << Log::endl;
+                    if (avcodec_receive_frame(videoCodecContext, frame) == 0)
+                        frameFinished = true;
+
+                    if (frameFinished)
+                    {
+                        if (packet->pts != AV_NOPTS_VALUE)
+                            timing = static_cast<uint64_t>((double)frame->best_effort_timestamp * _videoTimeBase * 1e6);
+                        else
+                            timing = 0.0;
+                        // This handles repeated frames
+                        timing += frame->repeat_pict * _videoTimeBase * 0.5;
+                    }
+
+                    // Frames preceding the seek target are not converted
+                    if (frameFinished && static_cast<int64_t>(timing) < _seekTarget)
+                    {
+                        std::lock_guard<std::mutex> lock(_frameMutex);
+                        _lastTiming = timing;
+                    }
+                    else if (frameFinished)
+                    {
+                        sws_scale(swsContext, (const uint8_t* const*)frame->data, frame->linesize, 0, videoCodecContext->height, rgbFrame->data, rgbFrame->linesize);
+
+                        ImageBufferSpec spec(videoCodecContext->width, videoCodecContext->height, 2, 16, ImageBufferSpec::Type::UINT8, "YUYV");
+                        img = std::make_unique<ImageBuffer>(spec);
+
+                        unsigned char* pixels = reinterpret_cast<unsigned char*>(img->data());
+                        std::copy(buffer.begin(), buffer.end(), pixels);
+
+                        hasFrame = true;
+                    }
+
+                    av_frame_unref(frame);
+                }
+                //
+                // If the codec is marked as Hap / Hap alpha / Hap Q
+                else if (isHap && packet->pts != AV_NOPTS_VALUE && static_cast<int64_t>(static_cast<double>(packet->pts) * _videoTimeBase * 1e6) < _seekTarget)
+                {
+                    // Hap frames are all keyframes, so frames preceding the seek target are not even decoded
+                    std::lock_guard<std::mutex> lock(_frameMutex);
+                    _lastTiming = static_cast<int64_t>(static_cast<double>(packet->pts) * _videoTimeBase * 1e6);
+                }
+                else if (isHap)
+                {
+                    // We are using kind of a hack to store a DXT compressed image in an ImageBuffer
+                    // First, we check the texture format type
+                    std::string textureFormat;
+                    if (hapDecodeFrame(packet->data, packet->size, nullptr, 0, textureFormat))
+                    {
+                        // Check if we need to resize the reader buffer
+                        // We set the size so as to have just enough place for the given texture format
+                        ImageBufferSpec spec;
+                        if (textureFormat == "RGB_DXT1")
+                        {
+                            spec = ImageBufferSpec(videoCodecContext->width, (int)(ceil((float)videoCodecContext->height / 2.f)), 1, 8, ImageBufferSpec::Type::UINT8);
+                        }
+                        else if (textureFormat == "RGBA_DXT5")
+                        {
+                            spec = ImageBufferSpec(videoCodecContext->width, videoCodecContext->height, 1, 8, ImageBufferSpec::Type::UINT8);
+                        }
+                        else if (textureFormat == "YCoCg_DXT5")
+                        {
+                            spec = ImageBufferSpec(videoCodecContext->width, videoCodecContext->height, 1, 8, ImageBufferSpec::Type::UINT8);
+                        }
+                        else
+                        {
+                            _videoSeekMutex.unlock();
+                            av_packet_unref(packet);
+                            return;
+                        }
+
+                        spec.format = {textureFormat};
+                        img = std::make_unique<ImageBuffer>(spec);
+
+                        unsigned long outputBufferBytes = spec.width * spec.height * spec.channels;
+
+                        if (hapDecodeFrame(packet->data, packet->size, img->data(), outputBufferBytes, textureFormat))
+                        {
+                            if (packet->pts != AV_NOPTS_VALUE)
+                                timing = static_cast<uint64_t>(static_cast<double>(packet->pts) * _videoTimeBase * 1e6);
+                            else
+                                timing = 0.0;
+
+                            hasFrame = true;
+                        }
+                    }
+                }
+
+                if (hasFrame)
+                {
+                    _seekTarget = 0;
+                    pushFrame(std::move(img), timing);
+                }
+
+                _videoSeekMutex.unlock();
+                av_packet_unref(packet);
+
+                // Do not store more than a few frames in memory
+                while (getFramesSize() > _maximumBufferSize && _continueRead && !skipLaggingConsumers())
+                    std::this_thread::sleep_for(chrono::milliseconds(5));
+            }
+#if HAVE_PORTAUDIO
+            // Reading the audio
+            else if (packet->stream_index == _audioStreamIndex && audioCodecContext)
+            {
+                if (avcodec_send_packet(audioCodecContext, packet) < 0)
+                    Log::get() << Log::WARNING << "FFmpegDecoder::" << __FUNCTION__ << " - Error while decoding an audio frame in file " << filepath << Log::endl;
+                uint64_t timing = static_cast<double>(packet->pts) * _audioTimeBase * 1e6;
+                av_packet_unref(packet);
+
+                while (avcodec_receive_frame(audioCodecContext, frame) == 0)
+                {
+#if LIBAVCODEC_VERSION_INT < AV_VERSION_INT(59, 37, 100)
+                    const auto nb_channels = audioCodecContext->channels;
+#else
+                    const auto nb_channels = audioCodecContext->ch_layout.nb_channels;
+#endif
+                    size_t dataSize = av_samples_get_buffer_size(nullptr, nb_channels, frame->nb_samples, audioCodecContext->sample_fmt, 1);
+                    auto buffer = ResizableArray<uint8_t>(dataSize);
+                    auto linesize = dataSize / nb_channels;
+                    if (planar)
+                        for (int c = 0; c < nb_channels; ++c)
+                            std::copy(frame->extended_data[c], frame->extended_data[c] + linesize, buffer.data() + c * linesize);
+                    else
+                        std::copy(frame->extended_data[0], frame->extended_data[0] + dataSize, buffer.data());
+
+                    AudioFrame timedFrame;
+                    timedFrame.frame = std::move(buffer);
+                    timedFrame.timing = timing;
+                    std::lock_guard<std::mutex> lockAudio(_frameMutex);
+                    // Audio is only played by one consumer, and is dropped if there is none
+                    if (!_cursors.empty())
+                        _audioQueue.push_back(std::move(timedFrame));
+
+                    av_frame_unref(frame);
+                }
+            }
+#endif
+            else
+            {
+                av_packet_unref(packet);
+            }
+        }
+
+        // If we loop, seek to the beginning, or whatever time is set as the trimming start
+        const auto parameters = getParameters();
+        if (parameters.loop && _continueRead)
+            seek(static_cast<float>(parameters.trimStart) / 1e6, false);
+        else
+            std::this_thread::sleep_for(chrono::milliseconds(50));
+    }
+
+    av_packet_free(&packet);
+    av_frame_free(&rgbFrame);
+    av_frame_free(&frame);
+    if (!isHap)
+        sws_freeContext(swsContext);
+    avcodec_free_context(&videoCodecContext);
+
+#if HAVE_PORTAUDIO
+    if (audioCodecContext)
+        avcodec_free_context(&audioCodecContext);
+#endif
+}
+
+} // namespace Splash
@@ -0,0 +1,408 @@
+/*
+ * Copyright (C) 2026 Splash authors
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @ffmpeg_decoder.h
+ * The FFmpegDecoder class, decoding a media file for one or more Image_FFmpeg
+ *
+ * Decoders are kept in a process-wide cache: an Image_FFmpeg reading a file already
+ * decoded with the same parameters, and which playback started recently, shares the
+ * existing decoder. Decoded frames are reference counted, and each consumer reads
+ * them through its own cursor. A frame is released once all consumers went past it,
+ * or when a consumer lagging behind the others, as a paused one, fills the buffer.
+ *
+ * A keyframe index can be built in the background, and is persisted next to the media
+ * as a sidecar file. It allows for frame accurate seeks, and for skipping the demuxer
+ * seek altogether when decoding forward is cheaper.
+ */
+
+#ifndef SPLASH_FFMPEG_DECODER_H
+#define SPLASH_FFMPEG_DECODER_H
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/avutil.h>
+#include <libavutil/imgutils.h>
+#include <libswscale/swscale.h>
+}
+
+#include "./config.h"
+#include "./core/constants.h"
+
+#include "./core/imagebuffer.h"
+#if HAVE_PORTAUDIO
+#include "./sound/sound_engine.h"
+#endif
+
+namespace Splash
+{
+
+class FFmpegDecoder
+{
+  public:
+    using ConsumerId = uint64_t;
+
+    struct Parameters
+    {
+        std::string filepath{};
+        bool loop{true};
+        uint64_t trimStart{0ull}; // in us
+        uint64_t trimEnd{0ull};   // in us
+        // Timeline of the consumers, which do not affect the decoding but have to match for a decoder to be shared
+        float timeShift{0.f}; // in seconds
+        bool useClock{false};
+
+        bool operator==(const Parameters&) const = default;
+    };
+
+    struct Frame
+    {
+        std::shared_ptr<const ImageBuffer> image{nullptr};
+        uint64_t timing{0ull}; // in us
+        uint64_t sequence{0ull};
+        bool discontinuity{false}; //!< True for the first frame after opening the file, a seek or a loop
+    };
+
+#if HAVE_PORTAUDIO
+    struct AudioParameters
+    {
+        uint32_t channels{2};
+        uint32_t sampleRate{44100};
+        Sound_Engine::SampleFormat format{Sound_Engine::SAMPLE_FMT_UNKNOWN};
+    };
+
+    struct AudioFrame
+    {
+        ResizableArray<uint8_t> frame{};
+        int64_t timing{0ull}; // in us
+    };
+#endif
+
+  public:
+    /**
+     * Get a decoder for the given file, and register the consumer to it
+     * An existing decoder is shared if it has the same parameters and its playback started
+     * less than a second ago, so that the consumers stay in sync. Otherwise a new one is created.
+     * \param parameters Decoding parameters
+     * \param consumer Consumer id
+     * \param share If false, always create a new decoder, which will not be shared either
+     * \param seconds Position to start decoding from, for a new decoder
+     * \param create If false, only look for an existing decoder to share
+     * \return Return the decoder, or nullptr if none could be found or created
+     */
+    static std::shared_ptr<FFmpegDecoder> acquire(const Parameters& parameters, ConsumerId consumer, bool share = true, float seconds = 0.f, bool create = true);
+
+    /**
+     * Get a new consumer id
+     * \return Return an id unique in the process
+     */
+    static ConsumerId getNewConsumerId() { return ++_consumerCounter; }
+
+    /**
+     * Destructor
+     */
+    ~FFmpegDecoder();
+
+    /**
+     * Constructors/operators
+     */
+    FFmpegDecoder(const FFmpegDecoder&) = delete;
+    FFmpegDecoder& operator=(const FFmpegDecoder&) = delete;
+    FFmpegDecoder(FFmpegDecoder&&) = delete;
+    FFmpegDecoder& operator=(FFmpegDecoder&&) = delete;
+
+    /**
+     * Unregister a consumer, releasing the frames it held
+     * \param consumer Consumer id
+     */
+    void release(ConsumerId consumer);
+
+    /**
+     * Get the number of consumers sharing this decoder
+     * \return Return the consumer count
+     */
+    size_t getConsumerCount() const;
+
+    /**
+     * Get the decoding parameters
+     * \return Return the parameters
+     */
+    Parameters getParameters() const;
+
+    /**
+     * Set the decoding parameters. The file path can not be changed.
+     * Decoded frames out of the new trimmed part are dropped, and the decoder seeks to
+     * the trimming start if it is past the decoding position.
+     * \param parameters New parameters
+     */
+    void setParameters(const Parameters& parameters);
+
+    /**
+     * Check whether a playback position is close enough to the start of the playback for a new consumer to join it
+     * \param parameters Decoding parameters
+     * \param timing Playback position, in us
+     * \return Return true if a consumer can join at this position
+     */
+    static bool isWithinJoinDelay(const Parameters& parameters, uint64_t timing);
+
+    /**
+     * Get the media duration
+     * \return Return the duration in seconds
+     */
+    float getDuration() const;
+
+    /**
+     * Check whether the video codec only has intra frames
+     * \return Return true if all frames are intra frames
+     */
+    bool isIntraOnly() const { return _intraOnly; }
+
+    /**
+     * Get a description of the video format
+     * \return Return the video format
+     */
+    std::string getVideoFormat() const;
+
+    /**
+     * Set the maximum size of the decoded frames kept in memory
+     * \param size Size in bytes
+     */
+    void setMaximumBufferSize(int64_t size) { _maximumBufferSize = size; }
+
+    /**
+     * Get the number of times the decoded frames have been flushed, to detect seeks
+     * \return Return the flush count
+     */
+    uint64_t getFlushCount() const { return _flushCount; }
+
+    /**
+     * Get the next frame for the given consumer, without moving its cursor
+     * \param consumer Consumer id
+     * \return Return the frame, or nothing if it has not been decoded yet
+     */
+    std::optional<Frame> getFrame(ConsumerId consumer) const;
+
+    /**
+     * Move the cursor of the given consumer to the next frame
+     * \param consumer Consumer id
+     */
+    void nextFrame(ConsumerId consumer);
+
+    /**
+     * Seek in the media
+     * \param seconds Desired position
+     * \param flush If true, drop the frames decoded before seeking
+     * \param precise If true, frames before the desired position are decoded but not shown. Otherwise
+     * the first frame shown is the keyframe preceding the position, which is faster (useful for scrubbing).
+     */
+    void seek(float seconds, bool flush = true, bool precise = true);
+
+    /**
+     * Load the keyframe index from its sidecar file, or build it in the background
+     * Does nothing if the index has already been requested.
+     */
+    void enableSeekIndex();
+
+    /**
+     * Check whether the keyframe index is available
+     * \return Return true if the index has been loaded or built
+     */
+    bool hasSeekIndex() const;
+
+#if HAVE_PORTAUDIO
+    /**
+     * Check whether the given consumer receives the audio. Only one consumer does so at a time.
+     * \param consumer Consumer id
+     * \return Return true if this consumer is in charge of playing the audio
+     */
+    bool isAudioOwner(ConsumerId consumer) const;
+
+    /**
+     * Get the audio parameters
+     * \return Return the parameters, or nothing if there is no audio to play
+     */
+    std::optional<AudioParameters> getAudioParameters() const;
+
+    /**
+     * Get the decoded audio frames, if the consumer owns the audio
+     * \param consumer Consumer id
+     * \param frames Queue to which the frames are appended
+     */
+    void getAudioFrames(ConsumerId consumer, std::deque<AudioFrame>& frames);
+#endif
+
+  private:
+    static constexpr uint64_t _maximumJoinDelay{1000000}; //!< Maximum playback time since the start for a decoder to be shared, in us
+    static constexpr char _seekIndexMagic[8] = {'S', 'P', 'L', 'K', 'E', 'Y', '0', '1'};
+    static constexpr char _seekIndexExtension[] = ".seekindex";
+
+    inline static std::atomic<ConsumerId> _consumerCounter{0};
+    inline static std::mutex _decodersMutex{};
+    inline static std::vector<std::weak_ptr<FFmpegDecoder>> _decoders{};
+
+    Parameters _parameters;
+    bool _shared{true};
+    bool _jumped{false}; //!< True if the decoder seeked or looped since its creation
+
+    std::thread _readLoopThread{};
+    std::atomic_bool _continueRead{false};
+    std::atomic_bool _trimEndReached{false};
+
+    AVFormatContext* _avContext{nullptr};
+    double _videoTimeBase{0.033};
+    int _videoStreamIndex{-1};
+    std::string _videoFormat{""};
+    std::atomic_bool _intraOnly{false};
+    std::atomic_int64_t _maximumBufferSize{(int64_t)1 << 29};
+    int64_t _lastTiming{0}; //!< Timing of the last decoded frame, in us
+
+    std::mutex _videoSeekMutex{};
+    mutable std::mutex _frameMutex{};
+    std::deque<Frame> _frames{};
+    int64_t _framesSize{0};
+    uint64_t _nextSequence{0};
+    bool _discontinuity{true};
+    std::atomic_uint64_t _flushCount{0};
+    std::vector<std::pair<ConsumerId, uint64_t>> _cursors{}; //!< Sequence of the next frame for each consumer, in registration order
+
+    std::atomic_bool _flushCodecs{false}; //!< Set after a seek, so that the codecs drop the frames they hold
+    std::atomic_int64_t _seekTarget{0};   //!< Frames before this timing are decoded but not shown, in us
+
+    std::thread _seekIndexThread{};
+    std::atomic_bool _seekIndexRequested{false};
+    mutable std::mutex _seekIndexMutex{};
+    std::vector<int64_t> _keyframes{}; //!< Sorted timestamps of the video keyframes, in the video stream time base
+
+#if HAVE_PORTAUDIO
+    int _audioStreamIndex{-1};
+    double _audioTimeBase{0.001};
+    std::optional<AudioParameters> _audioParameters{};
+    std::deque<AudioFrame> _audioQueue{};
+#endif
+
+    /**
+     * Constructor
+     * \param parameters Decoding parameters
+     */
+    explicit FFmpegDecoder(const Parameters& parameters);
+
+    /**
+     * Open the media file and start decoding
+     * \param seconds Position to start decoding from
+     * \return Return true if all went well
+     */
+    bool open(float seconds);
+
+    /**
+     * Check whether a new consumer could share this decoder and stay in sync with the others
+     * Must be called with _frameMutex locked
+     * \return Return true if the decoder can be shared
+     */
+    bool isJoinable() const;
+
+    /**
+     * Register a consumer, starting at the position of the slowest consumer
+     * \param consumer Consumer id
+     */
+    void addConsumer(ConsumerId consumer);
+
+    /**
+     * Add a decoded frame
+     * \param image Decoded image
+     * \param timing Frame timing, in us
+     */
+    void pushFrame(std::unique_ptr<ImageBuffer>&& image, uint64_t timing);
+
+    /**
+     * Release the frames which all consumers went past
+     * Must be called with _frameMutex locked
+     */
+    void releaseFrames();
+
+    /**
+     * Release the oldest frames if the buffer is full only because of consumers lagging behind, so
+     * that a paused or hidden consumer does not stall the decoding for the others. Those consumers
+     * skip forward to the first frame kept.
+     * \return Return true if frames were released
+     */
+    bool skipLaggingConsumers();
+
+    /**
+     * Get the size of the decoded frames waiting to be consumed
+     * \return Return the size in bytes
+     */
+    int64_t getFramesSize() const;
+
+    /**
+     * Get the keyframe preceding the given timestamp, and the one following it
+     * \param timestamp Timestamp, in the video stream time base
+     * \return Return the previous and next keyframes, or nothing if the index is not available
+     */
+    std::optional<std::pair<int64_t, int64_t>> getSurroundingKeyframes(int64_t timestamp) const;
+
+    /**
+     * Read all the packets of the file to list the video keyframes, then save the index as a sidecar file
+     */
+    void buildSeekIndex();
+
+    /**
+     * Load the keyframe index from its sidecar file
+     * \return Return true if a valid index was found
+     */
+    bool loadSeekIndex();
+
+    /**
+     * Save the keyframe index as a sidecar file
+     * \return Return true if all went well
+     */
+    bool saveSeekIndex() const;
+
+    /**
+     * Get a value identifying the current version of the media file, to invalidate outdated sidecar files
+     * \return Return the file size and modification time, or nothing if the file could not be read
+     */
+    std::optional<std::pair<uint64_t, int64_t>> getFileSignature() const;
+
+    /**
+     * Convert a codec tag to a fourcc
+     * \param tag Tag to convert
+     * \return Return the tag as a string
+     */
+    static std::string tagToFourCC(unsigned int tag);
+
+    /**
+     * File read loop
+     */
+    void readLoop();
+};
+
+} // namespace Splash
+
+#endif // SPLASH_FFMPEG_DECODER_H
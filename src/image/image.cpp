@@ -11,6 +11,8 @@
 
 #include "./core/serialize/serialize_imagebuffer.h"
 #include "./core/serializer.h"
+#include "./utils/hash.h"
+#include "./utils/latency.h"
 #include "./utils/log.h"
 #include "./utils/osutils.h"
 #include "./utils/timer.h"
@@ -122,6 +124,7 @@ SerializedObject Image::serialize() const
     std::vector<uint8_t> data;
     Serial::serialize(*_image, data);
     SerializedObject obj(ResizableArray(std::move(data)));
+    LatencyTracker::get().record(_name, LatencyTracker::STAGE_SERIALIZE, _image->getSpec().timestamp);
 
     if (Timer::get().isDebug())
         Timer::get() >> ("serialize " + _name);
@@ -129,6 +132,24 @@ SerializedObject Image::serialize() const
     return obj;
 }
 
+/*************/
+uint64_t Image::getContentHash(const SerializedObject& obj) const
+{
+    if (obj.size() == 0)
+        return 0;
+
+    // The serialized image holds its name, its spec and then the pixels. The spec
+    // holds the timestamp, which is updated even when the pixels do not change
+    auto it = obj.data();
+    Serial::detail::deserializer<std::string_view>(it);
+    auto spec = ImageBufferSpec(std::string(Serial::detail::deserializer<std::string_view>(it)));
+    spec.timestamp = -1;
+
+    const auto specString = spec.to_string();
+    const auto seed = Hash::xxh64(std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(specString.data()), specString.size()));
+    return Hash::xxh64(std::span<const uint8_t>(it, obj.data() + obj.size()), seed);
+}
+
 /*************/
 bool Image::deserialize(SerializedObject&& obj)
 {
@@ -160,6 +181,7 @@ bool Image::deserialize(SerializedObject&& obj)
 
     _bufferImageUpdated = true;
     updateTimestamp(_bufferImage->getSpec().timestamp);
+    LatencyTracker::get().record(_name, LatencyTracker::STAGE_DESERIALIZE, spec.timestamp);
 
     if (Timer::get().isDebug())
         Timer::get() >> ("deserialize " + _name);
@@ -179,12 +201,12 @@ bool Image::read(const std::string& filename)
 }
 
 /*************/
-bool Image::readFile(const std::string& filename)
+std::optional<ImageBuffer> Image::loadFile(const std::string& filename)
 {
     if (!std::ifstream(filename).is_open())
     {
         Log::get() << Log::WARNING << "Image::" << __FUNCTION__ << " - Unable to load file " << filename << Log::endl;
-        return false;
+        return std::nullopt;
     }
 
     const bool is16bits = stbi_is_16_bit(filename.c_str());
@@ -198,7 +220,7 @@ bool Image::readFile(const std::string& filename)
     if (!rawImage)
     {
         Log::get() << Log::WARNING << "Image::" << __FUNCTION__ << " - Caught an error while opening image file " << filename << Log::endl;
-        return false;
+        return std::nullopt;
     }
 
     const auto channels = is16bits ? c : 4;
@@ -213,9 +235,19 @@ bool Image::readFile(const std::string& filename)
 
     stbi_image_free(rawImage);
 
+    return img;
+}
+
+/*************/
+bool Image::readFile(const std::string& filename)
+{
+    auto img = loadFile(filename);
+    if (!img)
+        return false;
+
     {
         std::lock_guard<Spinlock> updateLock(_updateMutex);
-        std::swap(*_bufferImage, img);
+        std::swap(*_bufferImage, *img);
         _bufferImageUpdated = true;
     }
 
@@ -27,6 +27,7 @@
 
 #include <chrono>
 #include <mutex>
+#include <optional>
 
 #include "./core/constants.h"
 
@@ -193,6 +194,13 @@ class Image : public BufferObject
      */
     void updateMediaInfo();
 
+    /**
+     * Decode the specified image file. Thread safe, as it does not modify the object
+     * \param filename File path
+     * \return Return the decoded image, or std::nullopt if it could not be read
+     */
+    static std::optional<ImageBuffer> loadFile(const std::string& filename);
+
     /**
      * Read the specified image file
      * \param filename File path
@@ -212,6 +220,13 @@ class Image : public BufferObject
      */
     virtual void updateTimestamp(int64_t timestamp = -1) final;
 
+    /**
+     * Compute the hash of the content of a serialized image, leaving its timestamp out
+     * \param obj Serialized image
+     * \return Return the hash
+     */
+    uint64_t getContentHash(const SerializedObject& obj) const override;
+
   private:
     static const uint32_t _imageCopyThreads = 2;
     static const uint32_t _serializedImageHeaderSize = 4096;
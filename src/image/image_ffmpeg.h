@@ -26,25 +26,17 @@
 #define SPLASH_IMAGE_FFMPEG_H
 
 #include <atomic>
-#include <condition_variable>
-#include <deque>
 #include <future>
+#include <array>
+#include <memory>
 #include <mutex>
 #include <thread>
 
-extern "C"
-{
-#include <libavcodec/avcodec.h>
-#include <libavformat/avformat.h>
-#include <libavutil/avutil.h>
-#include <libavutil/imgutils.h>
-#include <libswscale/swscale.h>
-}
-
 #include "./config.h"
 #include "./core/constants.h"
 
 #include "./core/attribute.h"
+#include "./image/ffmpeg_decoder.h"
 #include "./image/image.h"
 #if HAVE_PORTAUDIO
 #include "./sound/speaker.h"
@@ -83,30 +75,30 @@ class Image_FFmpeg final : public Image
     bool read(const std::string& filename) final;
 
   private:
-    std::thread _readLoopThread;
     std::atomic_bool _continueRead{false};
     std::atomic_bool _loopOnVideo{true};
 
     std::thread _videoDisplayThread;
-    struct TimedFrame
-    {
-        std::unique_ptr<ImageBuffer> frame{};
-        uint64_t timing{0ull}; // in us
-    };
-    std::deque<TimedFrame> _timedFrames;
-
-    // Frame size history, used to keep the frame buffer smaller than _maximumBufferSize
-    std::vector<int64_t> _framesSize{};
+
+    // Decoder, possibly shared with other Image_FFmpeg reading the same file
+    const FFmpegDecoder::ConsumerId _consumerId{FFmpegDecoder::getNewConsumerId()};
+    mutable std::mutex _decoderMutex;
+    std::shared_ptr<FFmpegDecoder> _decoder{nullptr};
+    std::string _mediaPath{""}; //!< Full path to the media file
+    bool _shareDecoder{true};
+    bool _useSeekIndex{false}; //!< Opt-in, as the index is written next to the media file
+
     int64_t _maximumBufferSize{(int64_t)1 << 29};
 
-    std::mutex _videoQueueMutex;
-    std::mutex _videoSeekMutex;
-    std::mutex _videoEndMutex;
     std::future<void> _seekFuture;
-
     std::atomic_bool _timeJump{false};
 
-    bool _intraOnly{false};
+    // Seek latency, from the seek request to the display of the first frame, as a histogram
+    static constexpr std::array<int64_t, 8> _seekLatencyBuckets{5, 10, 20, 50, 100, 200, 500, 1000}; //!< Bucket upper bounds, in ms
+    std::array<std::atomic_uint64_t, _seekLatencyBuckets.size() + 1> _seekLatencyHistogram{};
+    std::atomic_int64_t _seekRequestTime{-1}; //!< Time of the pending seek request, in us
+    std::atomic_int64_t _lastSeekLatency{0};  //!< In us
+
     int64_t _startTime{0};
     int64_t _currentTime{0};
     int64_t _elapsedTime{0};
@@ -116,40 +108,18 @@ class Image_FFmpeg final : public Image
     uint64_t _trimStart{0ull}; //!< Start trimming time
     uint64_t _trimEnd{0ull};   //!< End trimming time
 
-    std::mutex _clockMutex;
     bool _useClock{false};
     int64_t _clockTime{-1};
 
-    AVFormatContext* _avContext{nullptr};
-    double _videoTimeBase{0.033};
-    int _videoStreamIndex{-1};
-    std::string _videoFormat{""}; //!< Holds the current video format information
-
 #if HAVE_PORTAUDIO
     std::unique_ptr<Speaker> _speaker;
-    int _audioStreamIndex{-1};
-    double _audioTimeBase{0.001};
-    bool _planar{false};
     std::string _audioDeviceOutput{""};
     bool _audioDeviceOutputUpdated{false};
+    float _audioSyncTolerance{20.f}; //!< In milliseconds
 
     std::thread _audioThread{};
-    struct TimedAudioFrame
-    {
-        ResizableArray<uint8_t> frame{};
-        int64_t timing{0ull}; // in us
-    };
-    std::deque<TimedAudioFrame> _audioQueue{};
-    std::mutex _audioMutex{};
 #endif
 
-    /**
-     * Convert a codec tag to a fourcc
-     * \param tag Tag to convert
-     * \return Return the tag as a string
-     */
-    std::string tagToFourCC(unsigned int tag);
-
     /**
      * Free everything related to FFmpeg
      */
@@ -161,32 +131,61 @@ class Image_FFmpeg final : public Image
     float getMediaDuration() const;
 
     /**
-     * File read loop
+     * Get the current decoder
+     * \return Return the decoder, or nullptr if no media is opened
+     */
+    std::shared_ptr<FFmpegDecoder> getDecoder() const;
+
+    /**
+     * Get the decoding parameters matching the current attributes
+     * \return Return the parameters
+     */
+    FFmpegDecoder::Parameters getDecoderParameters() const;
+
+    /**
+     * Replace the current decoder, releasing the previous one
+     * \param decoder New decoder, already acquired for this object
+     */
+    void setDecoder(const std::shared_ptr<FFmpegDecoder>& decoder);
+
+    /**
+     * Apply the decoding parameters to the decoder, or switch decoder if it is shared with objects using other parameters
      */
-    void readLoop();
+    void updateDecoderParameters();
 
     /**
-     * Seek in the video
+     * Seek in the video. If the decoder is shared, a new one is created for this object.
      * \param seconds Desired position
+     * \param precise If false, show the keyframe preceding the position instead of the exact frame
      */
-    void seek(float seconds, bool clearQueues = true);
+    void seek(float seconds, bool precise = true);
 
     /**
      * Seek asynchronously
      * \param seconds Desired position
+     * \param precise If false, show the keyframe preceding the position instead of the exact frame
+     */
+    void seek_async(float seconds, bool precise = true);
+
+    /**
+     * Add a seek latency measurement to the histogram
+     * \param latency Latency, in us
      */
-    void seek_async(float seconds, bool clearQueues = true);
+    void addSeekLatency(int64_t latency);
 
+#if HAVE_PORTAUDIO
     /**
      * Set the audio output
+     * \param parameters Audio parameters
      * \return Return true if all went well
      */
-    bool setupAudioOutput(AVCodecContext* audioCodecContext);
+    bool setupAudioOutput(const FFmpegDecoder::AudioParameters& parameters);
 
     /**
      * Audio loop
      */
     void audioLoop();
+#endif
 
     /**
      * Add more media info
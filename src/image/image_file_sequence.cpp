@@ -0,0 +1,444 @@
+#include "./image/image_file_sequence.h"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <regex>
+
+#include "./utils/log.h"
+#include "./utils/osutils.h"
+#include "./utils/timer.h"
+
+namespace chrono = std::chrono;
+
+namespace Splash
+{
+
+/*************/
+Image_FileSequence::Image_FileSequence(RootObject* root)
+    : Image(root)
+{
+    _type = "image_file_sequence";
+    registerAttributes();
+
+    // This is used for getting documentation "offline"
+    if (!_root)
+        return;
+}
+
+/*************/
+Image_FileSequence::~Image_FileSequence()
+{
+    stopThreads();
+}
+
+/*************/
+bool Image_FileSequence::read(const std::string& path)
+{
+    if (!_root)
+        return false;
+
+    const auto fullPath = Utils::getFullPathFromFilePath(path, _root->getConfigurationPath());
+
+    stopThreads();
+
+    _filenames = listFiles(fullPath);
+    if (_filenames.empty())
+    {
+        Log::get() << Log::WARNING << "Image_FileSequence::" << __FUNCTION__ << " - Could not find any image for sequence " << fullPath << Log::endl;
+        return false;
+    }
+
+    Log::get() << Log::MESSAGE << "Image_FileSequence::" << __FUNCTION__ << " - Successfully loaded sequence " << fullPath << " (" << _filenames.size() << " frames)"
+               << Log::endl;
+
+    startThreads();
+    return true;
+}
+
+/*************/
+std::vector<std::string> Image_FileSequence::listFiles(const std::string& path)
+{
+    std::vector<std::string> filenames;
+
+    // A directory: all the images it contains, ordered by name
+    if (std::filesystem::is_directory(path))
+    {
+        for (const auto& entry : std::filesystem::directory_iterator(path))
+        {
+            if (!entry.is_regular_file())
+                continue;
+
+            auto extension = entry.path().extension().string();
+            Utils::toLower(extension);
+            if (extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".bmp" || extension == ".tga")
+                filenames.push_back(std::filesystem::absolute(entry.path()).string());
+        }
+
+        std::sort(filenames.begin(), filenames.end());
+        return filenames;
+    }
+
+    // A pattern or a first frame: frame numbers are incremented until a file is missing
+    const auto filename = std::filesystem::path(path).filename().string();
+    const auto directory = std::filesystem::path(path).parent_path();
+
+    std::smatch match;
+    std::string prefix, suffix;
+    int64_t firstFrame = 0;
+    size_t width = 0;
+    if (std::regex_match(filename, match, std::regex("(.*)%0?([0-9]*)d(.*)")))
+    {
+        prefix = match[1].str();
+        width = match[2].length() > 0 ? std::stoul(match[2].str()) : 0;
+        suffix = match[3].str();
+
+        // Sequences start either at 0 or 1
+        auto zeroPadded = std::to_string(firstFrame);
+        zeroPadded.insert(0, width > zeroPadded.size() ? width - zeroPadded.size() : 0, '0');
+        if (!std::filesystem::exists(directory / (prefix + zeroPadded + suffix)))
+            firstFrame = 1;
+    }
+    else if (std::regex_match(filename, match, std::regex("(.*?)([0-9]+)([^0-9]*)")))
+    {
+        prefix = match[1].str();
+        width = match[2].length();
+        firstFrame = std::stoll(match[2].str());
+        suffix = match[3].str();
+    }
+    else
+    {
+        return filenames;
+    }
+
+    for (auto frame = firstFrame;; ++frame)
+    {
+        auto number = std::to_string(frame);
+        number.insert(0, width > number.size() ? width - number.size() : 0, '0');
+        const auto framePath = directory / (prefix + number + suffix);
+        if (!std::filesystem::is_regular_file(framePath))
+            break;
+        filenames.push_back(framePath.string());
+    }
+
+    return filenames;
+}
+
+/*************/
+void Image_FileSequence::startThreads()
+{
+    _startTime = Timer::getTime();
+    _currentTime = 0;
+    _displayedFrame = -1;
+    _seekRequest = -1;
+    _playhead = 0;
+    _cacheHits = 0;
+    _cacheMisses = 0;
+
+    _continueRead = true;
+    _displayThread = std::thread([&]() { displayLoop(); });
+    for (uint32_t i = 0; i < _decodeThreadCount; ++i)
+        _decodeThreads.emplace_back([&]() { decodeLoop(); });
+}
+
+/*************/
+void Image_FileSequence::stopThreads()
+{
+    if (!_continueRead)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(_cacheMutex);
+        _continueRead = false;
+    }
+    _cacheCondition.notify_all();
+
+    _displayThread.join();
+    for (auto& thread : _decodeThreads)
+        thread.join();
+    _decodeThreads.clear();
+
+    _cache.clear();
+    _decoding.clear();
+}
+
+/*************/
+bool Image_FileSequence::isInCacheWindow(int64_t frame) const
+{
+    const auto frameCount = static_cast<int64_t>(_filenames.size());
+    auto distance = frame - _playhead;
+    if (_loop && distance < 0)
+        distance += frameCount;
+    return distance >= 0 && distance < static_cast<int64_t>(_cacheSize);
+}
+
+/*************/
+void Image_FileSequence::displayLoop()
+{
+    const auto frameCount = static_cast<int64_t>(_filenames.size());
+    int64_t missedFrame = -1;
+
+    while (_continueRead)
+    {
+        //
+        // Get the current time, from the master clock or the local one
+        //
+        const auto seekRequest = _seekRequest.exchange(-1);
+        if (seekRequest >= 0)
+        {
+            _currentTime = seekRequest;
+            _startTime = Timer::getTime() - _currentTime;
+        }
+
+        int64_t clockAsUs = 0;
+        bool clockIsPaused = false;
+        const bool useClock = _useClock && Timer::get().getMasterClock<chrono::microseconds>(clockAsUs, clockIsPaused);
+        if (_paused || (useClock && clockIsPaused))
+        {
+            _startTime = Timer::getTime() - _currentTime;
+            std::this_thread::sleep_for(chrono::milliseconds(2));
+            continue;
+        }
+
+        if (useClock)
+            _currentTime = clockAsUs + static_cast<int64_t>(_shiftTime * 1e6);
+        else
+            _currentTime = Timer::getTime() - _startTime;
+
+        //
+        // Get the frame to show at this time
+        //
+        const auto framerate = static_cast<double>(std::max(0.01f, _framerate));
+        const auto position = std::max(0.0, static_cast<double>(_currentTime) * framerate / 1e6);
+        auto frame = static_cast<int64_t>(position);
+        if (_loop)
+            frame = frame % frameCount;
+        else
+            frame = std::min(frame, frameCount - 1);
+
+        if (frame == _displayedFrame)
+        {
+            const auto waitTime = static_cast<int64_t>((std::floor(position) + 1.0 - position) * 1e6 / framerate);
+            std::this_thread::sleep_for(chrono::microseconds(std::clamp<int64_t>(waitTime, 0, 2000)));
+            continue;
+        }
+
+        std::unique_ptr<ImageBuffer> image;
+        {
+            std::unique_lock<std::mutex> lock(_cacheMutex);
+
+            // Move the playhead, and drop the frames which fell out of the cache window
+            _playhead = frame;
+            for (auto it = _cache.begin(); it != _cache.end();)
+            {
+                if (!isInCacheWindow(it->first))
+                    it = _cache.erase(it);
+                else
+                    ++it;
+            }
+            _cacheCondition.notify_all();
+
+            auto cachedFrame = _cache.find(frame);
+            if (cachedFrame != _cache.end())
+            {
+                _cacheHits++;
+            }
+            else
+            {
+                // Wait at most a frame for the decoding, then check again the time as the playhead may have moved
+                if (missedFrame != frame)
+                    _cacheMisses++;
+                missedFrame = frame;
+                _cacheCondition.wait_for(lock, chrono::microseconds(static_cast<int64_t>(1e6 / framerate)), [&]() {
+                    cachedFrame = _cache.find(frame);
+                    return !_continueRead || cachedFrame != _cache.end();
+                });
+                if (cachedFrame == _cache.end())
+                    continue;
+            }
+
+            image = std::move(cachedFrame->second);
+            _cache.erase(cachedFrame);
+            _cacheCondition.notify_all();
+        }
+
+        _displayedFrame = frame;
+        if (!image)
+            continue;
+
+        {
+            std::lock_guard<Spinlock> updateLock(_updateMutex);
+            std::swap(_bufferImage, image);
+            _bufferImageUpdated = true;
+        }
+        updateTimestamp();
+    }
+}
+
+/*************/
+void Image_FileSequence::decodeLoop()
+{
+    const auto frameCount = static_cast<int64_t>(_filenames.size());
+
+    while (_continueRead)
+    {
+        int64_t frame = -1;
+        {
+            // Look for the first frame after the playhead which is neither decoded nor being decoded
+            std::unique_lock<std::mutex> lock(_cacheMutex);
+            _cacheCondition.wait(lock, [&]() {
+                if (!_continueRead)
+                    return true;
+                for (int64_t i = 0; i < std::min<int64_t>(_cacheSize, frameCount); ++i)
+                {
+                    auto candidate = _playhead + i;
+                    if (candidate >= frameCount)
+                    {
+                        if (!_loop)
+                            break;
+                        candidate -= frameCount;
+                    }
+                    if (_cache.find(candidate) == _cache.end() && _decoding.find(candidate) == _decoding.end())
+                    {
+                        frame = candidate;
+                        return true;
+                    }
+                }
+                return false;
+            });
+
+            if (!_continueRead)
+                break;
+            _decoding.insert(frame);
+        }
+
+        const auto decodeStart = Timer::getTime();
+        auto image = loadFile(_filenames[frame]);
+        const auto decodeDuration = Timer::getTime() - decodeStart;
+        _decodeDuration = (_decodeDuration * 7 + decodeDuration) / 8;
+
+        {
+            std::lock_guard<std::mutex> lock(_cacheMutex);
+            _decoding.erase(frame);
+            if (isInCacheWindow(frame))
+                _cache[frame] = image ? std::make_unique<ImageBuffer>(std::move(*image)) : nullptr;
+        }
+        _cacheCondition.notify_all();
+    }
+}
+
+/*************/
+void Image_FileSequence::updateMoreMediaInfo(Values& mediaInfo)
+{
+    mediaInfo.push_back(Value(static_cast<int64_t>(_filenames.size()), "frames"));
+    mediaInfo.push_back(Value(static_cast<float>(_filenames.size()) / std::max(0.01f, _framerate), "duration"));
+}
+
+/*************/
+void Image_FileSequence::registerAttributes()
+{
+    Image::registerAttributes();
+
+    addAttribute(
+        "framerate",
+        [&](const Values& args) {
+            _framerate = std::max(0.01f, args[0].as<float>());
+            return true;
+        },
+        [&]() -> Values { return {_framerate}; },
+        {'r'});
+    setAttributeDescription("framerate", "Playback framerate of the sequence, in frames per second");
+
+    addAttribute("duration", [&]() -> Values { return {static_cast<float>(_filenames.size()) / _framerate}; });
+    setAttributeDescription("duration", "Duration of the sequence");
+
+    addAttribute(
+        "loop",
+        [&](const Values& args) {
+            std::lock_guard<std::mutex> lock(_cacheMutex);
+            _loop = args[0].as<bool>();
+            return true;
+        },
+        [&]() -> Values { return {_loop}; },
+        {'b'});
+    setAttributeDescription("loop", "Loop over the sequence if true");
+
+    addAttribute(
+        "pause",
+        [&](const Values& args) {
+            _paused = args[0].as<bool>();
+            return true;
+        },
+        [&]() -> Values { return {_paused}; },
+        {'b'});
+    setAttributeDescription("pause", "Pause the playback if true");
+
+    addAttribute(
+        "seek",
+        [&](const Values& args) {
+            _seekTime = std::max(0.f, args[0].as<float>());
+            _seekRequest = static_cast<int64_t>(_seekTime * 1e6);
+            return true;
+        },
+        [&]() -> Values { return {_seekTime}; },
+        {'r'});
+    setAttributeDescription("seek", "Change the read position in the sequence, in seconds");
+
+    addAttribute(
+        "useClock",
+        [&](const Values& args) {
+            _useClock = args[0].as<bool>();
+            return true;
+        },
+        [&]() -> Values { return {_useClock}; },
+        {'b'});
+    setAttributeDescription("useClock", "Follow the master clock if true");
+
+    addAttribute(
+        "timeShift",
+        [&](const Values& args) {
+            _shiftTime = args[0].as<float>();
+            return true;
+        },
+        [&]() -> Values { return {_shiftTime}; },
+        {'r'});
+    setAttributeDescription("timeShift", "Time shift relative to the master clock, in seconds");
+
+    addAttribute(
+        "decodeThreads",
+        [&](const Values& args) {
+            const auto threadCount = static_cast<uint32_t>(std::max(1, args[0].as<int>()));
+            if (threadCount == _decodeThreadCount)
+                return true;
+            stopThreads();
+            _decodeThreadCount = threadCount;
+            if (!_filenames.empty())
+                startThreads();
+            return true;
+        },
+        [&]() -> Values { return {_decodeThreadCount}; },
+        {'i'});
+    setAttributeDescription("decodeThreads", "Number of threads decoding the frames ahead of the playback");
+
+    addAttribute(
+        "cacheSize",
+        [&](const Values& args) {
+            std::lock_guard<std::mutex> lock(_cacheMutex);
+            _cacheSize = static_cast<uint32_t>(std::max(1, args[0].as<int>()));
+            return true;
+        },
+        [&]() -> Values { return {_cacheSize}; },
+        {'i'});
+    setAttributeDescription("cacheSize", "Maximum number of frames decoded ahead of the playback");
+
+    addAttribute("cacheHits", [&]() -> Values { return {static_cast<int64_t>(_cacheHits)}; });
+    setAttributeDescription("cacheHits", "Number of frames which were decoded before having to be displayed");
+
+    addAttribute("cacheMisses", [&]() -> Values { return {static_cast<int64_t>(_cacheMisses)}; });
+    setAttributeDescription("cacheMisses", "Number of frames which were not decoded when they had to be displayed");
+
+    addAttribute("decodeTime", [&]() -> Values { return {static_cast<float>(_decodeDuration) / 1e3f}; });
+    setAttributeDescription("decodeTime", "Average time to decode a frame, in milliseconds");
+}
+
+} // namespace Splash
@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2026 Splash authors
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @image_file_sequence.h
+ * The Image_FileSequence class, playing a sequence of numbered image files
+ */
+
+#ifndef SPLASH_IMAGE_FILE_SEQUENCE_H
+#define SPLASH_IMAGE_FILE_SEQUENCE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "./core/constants.h"
+
+#include "./core/attribute.h"
+#include "./image/image.h"
+
+namespace Splash
+{
+
+class Image_FileSequence final : public Image
+{
+  public:
+    /**
+     * Constructor
+     * \param root Root object
+     */
+    explicit Image_FileSequence(RootObject* root);
+
+    /**
+     * Destructor
+     */
+    ~Image_FileSequence() final;
+
+    /**
+     * Constructors/operators
+     */
+    Image_FileSequence(const Image_FileSequence&) = delete;
+    Image_FileSequence& operator=(const Image_FileSequence&) = delete;
+    Image_FileSequence(Image_FileSequence&&) = delete;
+    Image_FileSequence& operator=(Image_FileSequence&&) = delete;
+
+    /**
+     * Set the sequence to read from. It can be either:
+     * - a directory, in which case all the images it holds are played in alphabetical order
+     * - the path to the first frame, i.e. "frame_0001.png"
+     * - a path pattern, i.e. "frame_%04d.png"
+     * \param path Path to the sequence
+     * \return Return true if all went well
+     */
+    bool read(const std::string& path) final;
+
+    /**
+     * Get the number of frames in the sequence
+     * \return Return the frame count
+     */
+    size_t getFrameCount() const { return _filenames.size(); }
+
+  private:
+    std::vector<std::string> _filenames{};
+
+    // Playback
+    float _framerate{30.f};
+    bool _loop{true};
+    bool _paused{false};
+    bool _useClock{false};
+    float _shiftTime{0.f};
+    float _seekTime{0.f};
+    std::atomic_int64_t _seekRequest{-1}; //!< Seek position waiting to be applied by the display loop, in us
+    int64_t _startTime{0};
+    int64_t _currentTime{0};
+    int64_t _displayedFrame{-1};
+
+    // Decoding
+    std::atomic_bool _continueRead{false};
+    std::thread _displayThread{};
+    std::vector<std::thread> _decodeThreads{};
+    uint32_t _decodeThreadCount{4};
+    uint32_t _cacheSize{16};
+
+    // Frames decoded ahead of the playhead, indexed by frame number. A null frame could not be decoded.
+    std::mutex _cacheMutex{};
+    std::condition_variable _cacheCondition{};
+    std::map<int64_t, std::unique_ptr<ImageBuffer>> _cache{};
+    std::set<int64_t> _decoding{};
+    int64_t _playhead{0};
+
+    // Statistics
+    std::atomic_uint64_t _cacheHits{0};
+    std::atomic_uint64_t _cacheMisses{0};
+    std::atomic_int64_t _decodeDuration{0}; //!< Moving average of the decoding time of one frame, in us
+
+    /**
+     * List the files of the sequence
+     * \param path Path to the sequence, see read()
+     * \return Return the ordered list of files
+     */
+    static std::vector<std::string> listFiles(const std::string& path);
+
+    /**
+     * Start the display and decoding threads
+     */
+    void startThreads();
+
+    /**
+     * Stop the display and decoding threads, and clear the cache
+     */
+    void stopThreads();
+
+    /**
+     * Check whether the given frame is in the window to be decoded ahead of the playhead
+     * Must be called with _cacheMutex locked
+     * \param frame Frame index
+     * \return Return true if the frame should be cached
+     */
+    bool isInCacheWindow(int64_t frame) const;
+
+    /**
+     * Display loop, showing the frames at the right time
+     */
+    void displayLoop();
+
+    /**
+     * Decoding loop, run by each decoding thread
+     */
+    void decodeLoop();
+
+    /**
+     * Add more media info
+     */
+    void updateMoreMediaInfo(Values& mediaInfo) final;
+
+    /**
+     * Register new functors to modify attributes
+     */
+    void registerAttributes();
+};
+
+} // namespace Splash
+
+#endif // SPLASH_IMAGE_FILE_SEQUENCE_H
@@ -9,6 +9,7 @@
 #include "rgb133v4l2.h"
 
 #include "./utils/osutils.h"
+#include "./utils/timer.h"
 
 #define NUMERATOR 1001
 #define DIVISOR 10
@@ -134,6 +135,9 @@ void Image_V4L2::captureThreadFunc()
             fd.events = POLLIN | POLLPRI;
             fd.revents = 0;
 
+            if (_ioMethod == V4L2_MEMORY_MMAP && !requeueReleasedBuffers())
+                return;
+
             if (poll(&fd, 1, 50) > 0)
             {
                 if (fd.revents & (POLLIN | POLLPRI))
@@ -156,36 +160,57 @@ void Image_V4L2::captureThreadFunc()
                         }
                     }
 
-                    assert(buffer.index < _bufferCount);
-
-                    if (!_bufferImage || _bufferImage->getSpec() != _imageBuffers[buffer.index]->getSpec())
-                        _bufferImage = std::make_unique<ImageBuffer>(_spec);
+                    assert(buffer.index < _v4l2RequestBuffers.count);
 
                     if (_ioMethod == V4L2_MEMORY_MMAP)
                     {
-                        auto& imageBuffer = _imageBuffers[buffer.index];
+                        // The mapped buffer is used by the image without any copy. It is queued again
+                        // once the image does not use it anymore, and unmapped after the last use.
+                        const auto mappedBuffer = _mappedBuffers[buffer.index];
+                        const auto releasedBuffers = _releasedBuffers;
+                        const auto index = buffer.index;
+                        auto sharedBuffer = std::shared_ptr<const ImageBuffer>(mappedBuffer.get(), [mappedBuffer, releasedBuffers, index](const ImageBuffer*) {
+                            std::lock_guard<std::mutex> lock(releasedBuffers->mutex);
+                            releasedBuffers->indices.push_back(index);
+                        });
+
                         std::lock_guard<Spinlock> updateLock(_updateMutex);
-                        _bufferImage = std::make_unique<ImageBuffer>(imageBuffer->getSpec(), imageBuffer->data());
+                        _bufferImage = std::make_unique<ImageBuffer>(sharedBuffer);
                         _bufferImageUpdated = true;
                     }
                     else if (_ioMethod == V4L2_MEMORY_USERPTR)
                     {
-                        std::lock_guard<Spinlock> updateLock(_updateMutex);
-                        _bufferImage.swap(_imageBuffers[buffer.index]);
-                        _bufferImageUpdated = true;
-                    }
+                        {
+                            std::lock_guard<Spinlock> updateLock(_updateMutex);
+                            if (!_bufferImage || _bufferImage->getSpec() != _imageBuffers[buffer.index]->getSpec())
+                                _bufferImage = std::make_unique<ImageBuffer>(_spec);
+                            _bufferImage.swap(_imageBuffers[buffer.index]);
+                            _bufferImageUpdated = true;
+                        }
 
-                    buffer.m.userptr = reinterpret_cast<unsigned long>(_imageBuffers[buffer.index]->data());
-                    buffer.length = _spec.rawSize();
+                        buffer.m.userptr = reinterpret_cast<unsigned long>(_imageBuffers[buffer.index]->data());
+                        buffer.length = _spec.rawSize();
 
-                    result = xioctl(_deviceFd, VIDIOC_QBUF, &buffer);
-                    if (result < 0)
-                    {
-                        Log::get() << Log::WARNING << "Image_V4L2::" << __FUNCTION__ << " - Failed to requeue buffer " << buffer.index << Log::endl;
-                        return;
+                        result = xioctl(_deviceFd, VIDIOC_QBUF, &buffer);
+                        if (result < 0)
+                        {
+                            Log::get() << Log::WARNING << "Image_V4L2::" << __FUNCTION__ << " - Failed to requeue buffer " << buffer.index << Log::endl;
+                            return;
+                        }
                     }
 
-                    updateTimestamp();
+                    // If the device timestamps the frames with the monotonic clock, this timestamp is kept
+                    // so that the latency can be measured down to the texture upload
+                    if ((buffer.flags & V4L2_BUF_FLAG_TIMESTAMP_MASK) == V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC)
+                    {
+                        const auto captureTime = static_cast<int64_t>(buffer.timestamp.tv_sec) * 1000000 + static_cast<int64_t>(buffer.timestamp.tv_usec);
+                        _captureLatency = Timer::getTime() - captureTime;
+                        updateTimestamp(captureTime);
+                    }
+                    else
+                    {
+                        updateTimestamp();
+                    }
                 }
             }
 
@@ -225,11 +250,11 @@ void Image_V4L2::captureThreadFunc()
         if (result < 0)
             Log::get() << Log::WARNING << "Image_V4L2::" << __FUNCTION__ << " - VIDIOC_STREAMOFF failed: " << result << Log::endl;
 
-        for (uint32_t i = 0; i < _bufferCount; ++i)
+        for (uint32_t i = 0; i < _v4l2RequestBuffers.count; ++i)
         {
             memset(&buffer, 0, sizeof(buffer));
             buffer.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-            buffer.memory = V4L2_MEMORY_USERPTR;
+            buffer.memory = _ioMethod;
             result = xioctl(_deviceFd, VIDIOC_DQBUF, &buffer);
             if (result < 0)
                 Log::get() << Log::WARNING << "Image_V4L2::" << __FUNCTION__ << " - VIDIOC_DQBUF failed: " << result << Log::endl;
@@ -244,6 +269,33 @@ void Image_V4L2::captureThreadFunc()
     updateTimestamp();
 }
 
+/*************/
+bool Image_V4L2::requeueReleasedBuffers()
+{
+    std::vector<uint32_t> indices;
+    {
+        std::lock_guard<std::mutex> lock(_releasedBuffers->mutex);
+        std::swap(indices, _releasedBuffers->indices);
+    }
+
+    for (const auto index : indices)
+    {
+        struct v4l2_buffer buffer;
+        memset(&buffer, 0, sizeof(buffer));
+        buffer.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buffer.memory = V4L2_MEMORY_MMAP;
+        buffer.index = index;
+
+        if (xioctl(_deviceFd, VIDIOC_QBUF, &buffer) < 0)
+        {
+            Log::get() << Log::WARNING << "Image_V4L2::" << __FUNCTION__ << " - Failed to requeue buffer " << index << Log::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
 /*************/
 bool Image_V4L2::initializeIOMethod()
 {
@@ -357,6 +409,9 @@ bool Image_V4L2::initializeCapture()
 
     // Initialize the buffers
     _imageBuffers.clear();
+    _mappedBuffers.clear();
+    // Buffers released by images from a previous capture must not be queued in this one
+    _releasedBuffers = std::make_shared<ReleasedBuffers>();
 
     switch (_ioMethod)
     {
@@ -368,7 +423,7 @@ bool Image_V4L2::initializeCapture()
         int result;
         struct v4l2_buffer buffer;
 
-        for (uint32_t i = 0; i < _bufferCount; ++i)
+        for (uint32_t i = 0; i < _v4l2RequestBuffers.count; ++i)
         {
             memset(&buffer, 0, sizeof(buffer));
             buffer.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
@@ -389,7 +444,12 @@ bool Image_V4L2::initializeCapture()
                 return false;
             }
 
-            _imageBuffers.push_back(std::make_unique<ImageBuffer>(_spec, static_cast<uint8_t*>(mappedMemory), true));
+            const auto length = buffer.length;
+            _mappedBuffers.push_back(std::shared_ptr<const ImageBuffer>(new ImageBuffer(_spec, static_cast<uint8_t*>(mappedMemory), true), [length](const ImageBuffer* image) {
+                if (munmap(const_cast<ImageBuffer*>(image)->data(), length) == -1)
+                    Log::get() << Log::WARNING << "Image_V4L2::" << __FUNCTION__ << " - Failed to unmap a capture buffer" << Log::endl;
+                delete image;
+            }));
 
             result = xioctl(_deviceFd, VIDIOC_QBUF, &buffer);
             if (result < 0)
@@ -405,7 +465,7 @@ bool Image_V4L2::initializeCapture()
         int result;
         struct v4l2_buffer buffer;
 
-        for (uint32_t i = 0; i < _bufferCount; ++i)
+        for (uint32_t i = 0; i < _v4l2RequestBuffers.count; ++i)
         {
             _imageBuffers.push_back(std::make_unique<ImageBuffer>(_spec));
 
@@ -578,12 +638,8 @@ void Image_V4L2::closeCaptureDevice()
     _v4l2Standards.clear();
     _v4l2Formats.clear();
 
-    if (_ioMethod == V4L2_MEMORY_MMAP)
-    {
-        for (auto& buffer : _imageBuffers)
-            if (munmap(buffer->data(), buffer->getSize()) == -1)
-                Log::get() << Log::WARNING << "Image_V4L2::" << __FUNCTION__ << " - Failed to unmap buffer for device " << _devicePath << Log::endl;
-    }
+    // Mapped buffers are unmapped once the last image using them is released
+    _mappedBuffers.clear();
 
     if (_deviceFd >= 0)
     {
@@ -710,6 +766,7 @@ void Image_V4L2::updateMoreMediaInfo(Values& mediaInfo)
 {
     mediaInfo.push_back(Value(_devicePath, "devicePath"));
     mediaInfo.push_back(Value(_v4l2Index, "v4l2Index"));
+    mediaInfo.push_back(Value(static_cast<float>(_captureLatency) / 1e3f, "captureLatency"));
 }
 
 /*************/
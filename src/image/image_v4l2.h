@@ -28,7 +28,9 @@
 #include <atomic>
 #include <deque>
 #include <future>
+#include <memory>
 #include <mutex>
+#include <vector>
 
 #include <linux/videodev2.h>
 
@@ -98,8 +100,22 @@ class Image_V4L2 final : public Image
 
     // Capture buffers;
     struct v4l2_requestbuffers _v4l2RequestBuffers;
-    static const uint32_t _bufferCount{1};
-    std::deque<std::unique_ptr<ImageBuffer>> _imageBuffers{};
+    static const uint32_t _bufferCount{4};
+    std::deque<std::unique_ptr<ImageBuffer>> _imageBuffers{};          //!< Buffers used with the userptr io method
+    std::vector<std::shared_ptr<const ImageBuffer>> _mappedBuffers{}; //!< Buffers used with the mmap io method, unmapped when not used anymore
+
+    /**
+     * Indices of the mapped buffers which are not used by any image anymore, and can be queued again
+     * Images wrapping mapped buffers can outlive the capture, hence the shared ownership
+     */
+    struct ReleasedBuffers
+    {
+        std::mutex mutex{};
+        std::vector<uint32_t> indices{};
+    };
+    std::shared_ptr<ReleasedBuffers> _releasedBuffers{nullptr};
+
+    std::atomic_int64_t _captureLatency{0}; //!< Delay between the capture by the device and the dequeuing of the frame, in us
 
     bool _shouldCapture{false};    //!< True if the device should start capturing
     bool _capturing{false};        //!< True if currently capturing frames
@@ -116,6 +132,12 @@ class Image_V4L2 final : public Image
      */
     void captureThreadFunc();
 
+    /**
+     * Queue again the mapped buffers released by the images which used them
+     * \return Return true if all went well
+     */
+    bool requeueReleasedBuffers();
+
     /**
      * Initialize V4L2 capture mode
      * Tries first with mmap, then with userptr
@@ -114,44 +114,35 @@ void Queue::update()
         {
             _currentSource = std::dynamic_pointer_cast<BufferObject>(_factory->create("image"));
             _currentSource->setName(_name + DISTANT_NAME_SUFFIX);
+            _switchPending = false;
             _root->sendMessage(_name, "source", {"image"});
         }
-        // Otherwise we create the new source
+        // Otherwise we use the prerolled source if it matches, or create the new source
         else
         {
             const auto& sourceParameters = _playlist[_currentSourceIndex];
-            _currentSource = std::dynamic_pointer_cast<BufferObject>(_factory->create(sourceParameters.type));
 
-            if (_currentSource)
-                _playing = true;
-            else
-                _currentSource = std::dynamic_pointer_cast<BufferObject>(_factory->create("image"));
-
-            std::dynamic_pointer_cast<Image>(_currentSource)->zero();
-            _currentSource->setName(_name + DISTANT_NAME_SUFFIX);
-            _currentSource->setAttribute("file", {sourceParameters.filename});
-
-            if (_useClock && !sourceParameters.freeRun)
+            // The current source is released first, so that the new one can take its name
+            _currentSource.reset();
+            if (_nextSource.object && _nextSource.index == _currentSourceIndex)
             {
-                // If we use the master clock, set a timeshift to be correctly placed in the video
-                // (as the source gets its clock from the same Timer)
-                _currentSource->setAttribute("timeShift", {-static_cast<float>(sourceParameters.start) / 1e6});
-                _currentSource->setAttribute("useClock", {true});
+                _currentSource = _nextSource.object;
+                _currentSourceBlankTimestamp = _nextSource.blankTimestamp;
+                _playing = sourceParameters.type == _currentSource->getType();
             }
             else
             {
-                _currentSource->setAttribute("useClock", {false});
+                _currentSource = createSource(sourceParameters);
+                _currentSourceBlankTimestamp = _currentSource->getTimestamp();
+                _playing = sourceParameters.type == _currentSource->getType();
             }
+            _nextSource = {};
 
-            _root->sendMessage(_name, "source", {sourceParameters.type});
-
-            for (const auto& arg : sourceParameters.args)
-            {
-                if (!arg.isNamed())
-                    continue;
+            _currentSource->setName(_name + DISTANT_NAME_SUFFIX);
+            _currentSource->setAttribute("pause", {false});
+            _switchPending = true;
 
-                _currentSource->setAttribute(arg.getName(), arg.as<Values>());
-            }
+            _root->sendMessage(_name, "source", {sourceParameters.type});
 
             Log::get() << Log::MESSAGE << "Queue::" << __FUNCTION__ << " - Playing source: " << sourceParameters.filename << Log::endl;
         }
@@ -166,6 +157,83 @@ void Queue::update()
 
     if (_currentSource)
         _currentSource->update();
+
+    // Measure the delay between the theoretical start of the source and its first frame
+    if (_switchPending && _currentSource && _currentSource->getTimestamp() != _currentSourceBlankTimestamp)
+    {
+        _switchLatency = std::max<int64_t>(0, _currentTime - _playlist[_currentSourceIndex].start);
+        _switchPending = false;
+    }
+
+    prerollNextSource();
+}
+
+/*************/
+std::shared_ptr<BufferObject> Queue::createSource(const Source& parameters)
+{
+    auto source = std::dynamic_pointer_cast<BufferObject>(_factory->create(parameters.type));
+    if (!source)
+        source = std::dynamic_pointer_cast<BufferObject>(_factory->create("image"));
+
+    std::dynamic_pointer_cast<Image>(source)->zero();
+    source->setAttribute("file", {parameters.filename});
+
+    if (_useClock && !parameters.freeRun)
+    {
+        // If we use the master clock, set a timeshift to be correctly placed in the video
+        // (as the source gets its clock from the same Timer)
+        source->setAttribute("timeShift", {-static_cast<float>(parameters.start) / 1e6});
+        source->setAttribute("useClock", {true});
+    }
+    else
+    {
+        source->setAttribute("useClock", {false});
+    }
+
+    for (const auto& arg : parameters.args)
+    {
+        if (!arg.isNamed())
+            continue;
+
+        source->setAttribute(arg.getName(), arg.as<Values>());
+    }
+
+    return source;
+}
+
+/*************/
+void Queue::prerollNextSource()
+{
+    if (_prerollTime <= 0.f || _currentSourceIndex < 0 || static_cast<uint32_t>(_currentSourceIndex) >= _playlist.size())
+        return;
+
+    const auto& currentParameters = _playlist[_currentSourceIndex];
+    if (currentParameters.stop - _currentTime > static_cast<int64_t>(_prerollTime * 1e6))
+        return;
+
+    auto nextIndex = _currentSourceIndex + 1;
+    if (static_cast<uint32_t>(nextIndex) >= _playlist.size())
+    {
+        // When looping without the master clock, the playlist restarts from its first source
+        if (_useClock || !_loop)
+            return;
+        nextIndex = 0;
+    }
+
+    // A single looping source is never recreated, and is prerolled only once
+    if (nextIndex == _currentSourceIndex || (_nextSource.object && _nextSource.index == nextIndex))
+        return;
+
+    // The source is opened, and paused as soon as its first frame is decoded so that
+    // it is ready to be displayed when its turn comes
+    const auto& nextParameters = _playlist[nextIndex];
+    _nextSource.object = createSource(nextParameters);
+    _nextSource.index = nextIndex;
+    _nextSource.blankTimestamp = _nextSource.object->getTimestamp();
+    _nextSource.object->setName(_name + "_preroll" + DISTANT_NAME_SUFFIX);
+    _nextSource.object->setAttribute("pause", {true});
+
+    Log::get() << Log::DEBUGGING << "Queue::" << __FUNCTION__ << " - Prerolling source: " << nextParameters.filename << Log::endl;
 }
 
 /*************/
@@ -279,6 +347,8 @@ void Queue::runTasks()
     BaseObject::runTasks();
     if (_currentSource != nullptr)
         _currentSource->runTasks();
+    if (_nextSource.object != nullptr)
+        _nextSource.object->runTasks();
 }
 
 /*************/
@@ -336,6 +406,7 @@ void Queue::registerAttributes()
 
             cleanPlaylist(playlist);
             _playlist = playlist;
+            _nextSource = {};
 
             return true;
         },
@@ -376,6 +447,19 @@ void Queue::registerAttributes()
         {'r'});
     setAttributeDescription("seek", "Seek through the playlist");
 
+    addAttribute("prerollTime",
+        [&](const Values& args) {
+            _prerollTime = std::max(0.f, args[0].as<float>());
+            return true;
+        },
+        [&]() -> Values { return {_prerollTime}; },
+        {'r'});
+    setAttributeDescription("prerollTime", "Time before its start at which the next source is opened and its first frames decoded, in seconds. 0 to disable");
+
+    addAttribute(
+        "switchLatency", [&](const Values& /*args*/) { return true; }, [&]() -> Values { return {static_cast<float>(_switchLatency) / 1e3f}; }, {'r'});
+    setAttributeDescription("switchLatency", "Delay between the start of the last source and the display of its first frame, in milliseconds");
+
     addAttribute("useClock",
         [&](const Values& args) {
             _useClock = args[0].as<bool>();
@@ -133,12 +133,38 @@ class Queue : public BufferObject
     int32_t _currentSourceIndex{-1};
     bool _playing{false};
 
+    // The upcoming source is created ahead of its start, so that opening and
+    // decoding its first frames does not delay the transition
+    struct PrerolledSource
+    {
+        std::shared_ptr<BufferObject> object{nullptr};
+        int32_t index{-1};
+        int64_t blankTimestamp{0}; // Timestamp of the source before it outputs its first frame
+    };
+    PrerolledSource _nextSource{};
+    float _prerollTime{1.f};                 // Time before its start to create the next source, in seconds
+    int64_t _currentSourceBlankTimestamp{0}; // Timestamp of the current source before it outputs its first frame
+    bool _switchPending{false};              // True until the current source outputs its first frame
+    int64_t _switchLatency{0};               // Delay between the start of the last source and its first frame, in us
+
     bool _loop{false};
     bool _seeked{false};
     float _seekTime{0};
     int64_t _startTime{-1};   // Beginning of the current loop, in us
     int64_t _currentTime{-1}; // Elapsed time since _startTime
 
+    /**
+     * Create a source given its parameters, zeroed until it outputs its first frame
+     * \param parameters Source parameters
+     * \return Return the source, or nullptr if its type could not be created
+     */
+    std::shared_ptr<BufferObject> createSource(const Source& parameters);
+
+    /**
+     * Create the source following the current one if it starts soon enough
+     */
+    void prerollNextSource();
+
     /**
      * Clean the playlist for holes and overlaps
      * \param playlist Playlist to clean
@@ -153,7 +179,7 @@ class Queue : public BufferObject
     /**
      * Run the tasks waiting in the object's queue.
      * Also runs tasks for objects created by this queue,
-     * namely _currentSource, if it is valid.
+     * namely _currentSource and the prerolled source, if they are valid.
      */
     void runTasks() override;
 };
@@ -1,5 +1,7 @@
 #include "./mesh/mesh.h"
 
+#include <utility>
+
 #include "./core/attribute.h"
 #include "./core/root_object.h"
 #include "./core/serialize/serialize_mesh.h"
@@ -164,9 +166,8 @@ bool Mesh::deserialize(SerializedObject&& obj)
     if (Timer::get().isDebug())
         Timer::get() << "deserialize " + _name;
 
-    // After this, obj does not hold any more data
-    const auto serializedMesh = obj.grabData();
-    auto serializedMeshIt = serializedMesh.cbegin();
+    // The mesh is read in place, as the serialized object may be a view over shared memory
+    auto serializedMeshIt = std::as_const(obj).data();
     auto mesh = Serial::detail::deserializer<MeshContainer>(serializedMeshIt);
 
     _bufferMesh = mesh;
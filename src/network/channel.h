@@ -27,8 +27,11 @@
 #define SPLASH_CHANNEL_H
 
 #include <chrono>
+#include <cstring>
 #include <functional>
+#include <span>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "./core/constants.h"
@@ -51,6 +54,14 @@ class ChannelOutput
         InToOut
     };
 
+    // Buffers of each priority are sent through their own path, so that
+    // large background buffers never delay the real-time ones
+    enum class BufferPriority : uint8_t
+    {
+        realtime,  //!< Only the latest buffer matters, waited for by waitForBufferSending
+        background //!< Every buffer is delivered, only waited for on request
+    };
+
   public:
     /**
      * Constructor
@@ -114,28 +125,54 @@ class ChannelOutput
     /**
      * Send a buffer
      * \param buffer Buffer to be sent
+     * \param priority Buffer priority
      * \return Return true if the buffer was successfully sent
      */
-    virtual bool sendBuffer(SerializedObject&& buffer) = 0;
+    virtual bool sendBuffer(SerializedObject&& buffer, BufferPriority priority = BufferPriority::realtime) = 0;
 
     /**
-     * Check that all buffers were sent to the client
+     * Check that all buffers of the given priority were sent to the client
      * \param maximumWait Maximum waiting time
+     * \param priority Priority of the buffers to wait for
      * \return Return true if all went well
      */
-    virtual bool waitForBufferSending(std::chrono::milliseconds maximumWait) = 0;
+    virtual bool waitForBufferSending(std::chrono::milliseconds maximumWait, BufferPriority priority = BufferPriority::realtime) = 0;
+
+    /**
+     * Release the resources held to send the buffers of an object, once it has been removed
+     * \param name Object name
+     */
+    virtual void releaseBuffers(const std::string& /*name*/) {}
 
   protected:
     const RootObject* _root;
     const std::string _name;
     bool _ready{false};
+
+    /**
+     * Get the name of the object a buffer belongs to, serialized at its beginning
+     * \param buffer Serialized buffer
+     * \return Return a view over the name, or an empty view if the buffer is malformed
+     */
+    static std::string_view getBufferName(const SerializedObject& buffer)
+    {
+        const auto sizeLength = sizeof(uint32_t);
+        if (buffer.size() < sizeLength)
+            return {};
+        uint32_t nameLength;
+        std::memcpy(&nameLength, buffer.data(), sizeLength);
+        if (nameLength > buffer.size() - sizeLength)
+            return {};
+        return std::string_view(reinterpret_cast<const char*>(buffer.data()) + sizeLength, nameLength);
+    }
 };
 
 /*************/
 class ChannelInput
 {
   public:
-    using MessageRecvCallback = std::function<void(const std::vector<uint8_t>&)>;
+    // The message is a view over the received frame, only valid during the callback
+    using MessageRecvCallback = std::function<void(std::span<const uint8_t>)>;
     using BufferRecvCallback = std::function<void(SerializedObject&&)>;
 
   public:
@@ -1,5 +1,6 @@
 #include "./network/channel_shmdata.h"
 
+#include <algorithm>
 #include <cassert>
 #include <chrono>
 #include <thread>
@@ -7,7 +8,9 @@
 #include "./core/constants.h"
 #include "./core/root_object.h"
 #include "./core/serialized_object.h"
+#include "./utils/latency.h"
 #include "./utils/log.h"
+#include "./utils/timer.h"
 
 namespace Splash
 {
@@ -27,15 +30,17 @@ ChannelOutput_Shmdata::ChannelOutput_Shmdata(const RootObject* root, const std::
 
     _ready = true;
 
-    _msgConsumeThread = std::thread([&]() { messageConsume(); });
-    _bufConsumeThread = std::thread([&]() { bufferConsume(); });
-
     _msgWriter = std::make_unique<shmdata::Writer>(_pathPrefix + "msg_" + _name, _shmDefaultSize, "splash/x-msg", &_shmlogger, [&](int /*id*/) {
         std::unique_lock<std::mutex> lock(_worldConnectedMutex);
         _isWorldConnected = true;
         _worldConnectedCondition.notify_one();
     });
-    _bufWriter = std::make_unique<shmdata::Writer>(_pathPrefix + "buf_" + _name, _shmDefaultSize, "splash/x-msg", &_shmlogger);
+    _realtimeBuffers.writer = std::make_unique<shmdata::Writer>(_pathPrefix + "buf_" + _name, _shmDefaultSize, "splash/x-msg", &_shmlogger);
+    _backgroundBuffers.writer = std::make_unique<shmdata::Writer>(_pathPrefix + "bufbg_" + _name, _shmDefaultSize, "splash/x-msg", &_shmlogger);
+
+    _msgConsumeThread = std::thread([&]() { messageConsume(); });
+    _realtimeBuffers.thread = std::thread([&]() { bufferConsume(_realtimeBuffers); });
+    _backgroundBuffers.thread = std::thread([&]() { bufferConsume(_backgroundBuffers); });
 }
 
 /*************/
@@ -44,8 +49,10 @@ ChannelOutput_Shmdata::~ChannelOutput_Shmdata()
     _joinAllThreads = true;
     if (_msgConsumeThread.joinable())
         _msgConsumeThread.join();
-    if (_bufConsumeThread.joinable())
-        _bufConsumeThread.join();
+    if (_realtimeBuffers.thread.joinable())
+        _realtimeBuffers.thread.join();
+    if (_backgroundBuffers.thread.joinable())
+        _backgroundBuffers.thread.join();
 }
 
 /*************/
@@ -75,12 +82,28 @@ bool ChannelOutput_Shmdata::sendMessage(const std::vector<uint8_t>& message)
 }
 
 /*************/
-bool ChannelOutput_Shmdata::sendBuffer(SerializedObject&& buffer)
+bool ChannelOutput_Shmdata::sendBuffer(SerializedObject&& buffer, BufferPriority priority)
 {
-    std::unique_lock<std::mutex> lock(_bufConsumeMutex);
-    _bufQueue.push_back(std::move(buffer));
-    _bufNewInQueue = true;
-    _bufCondition.notify_one();
+    auto& path = priority == BufferPriority::realtime ? _realtimeBuffers : _backgroundBuffers;
+    std::unique_lock<std::mutex> lock(path.mutex);
+
+    // Only the latest real-time buffer of an object matters, a previous one still waiting is replaced
+    if (priority == BufferPriority::realtime)
+    {
+        const auto name = getBufferName(buffer);
+        const auto queuedIt =
+            std::find_if(path.queue.begin(), path.queue.end(), [&](const QueuedBuffer& queued) { return !name.empty() && getBufferName(queued.buffer) == name; });
+        if (queuedIt != path.queue.end())
+        {
+            queuedIt->buffer = std::move(buffer);
+            queuedIt->queueTime = Timer::getTime();
+            return true;
+        }
+    }
+
+    path.queue.push_back({std::move(buffer), Timer::getTime()});
+    path.newInQueue = true;
+    path.condition.notify_one();
     return true;
 }
 
@@ -108,24 +131,32 @@ void ChannelOutput_Shmdata::messageConsume()
 }
 
 /*************/
-void ChannelOutput_Shmdata::bufferConsume()
+void ChannelOutput_Shmdata::bufferConsume(BufferPath& path)
 {
     while (!_joinAllThreads)
     {
-        std::unique_lock<std::mutex> lock(_bufConsumeMutex);
-        _bufCondition.wait_for(lock, std::chrono::milliseconds(50));
-        if (!_bufNewInQueue)
+        std::unique_lock<std::mutex> lock(path.mutex);
+        path.condition.wait_for(lock, std::chrono::milliseconds(50));
+        if (!path.newInQueue)
             continue;
 
-        const auto bufferQueue = std::move(_bufQueue);
-        _bufQueue = decltype(_bufQueue)();
-        _bufNewInQueue = false;
+        const auto bufferQueue = std::move(path.queue);
+        path.queue = decltype(path.queue)();
+        path.newInQueue = false;
         lock.unlock();
 
-        for (const auto& buffer : bufferQueue)
+        for (const auto& queued : bufferQueue)
         {
-            if (!_bufWriter->copy_to_shm(buffer.data(), buffer.size()))
-                Log::get() << Log::WARNING << "ChannelOutput_Shmdata::messageConsume - Error while sending message\n";
+            const auto& buffer = queued.buffer;
+            if (!path.writer->copy_to_shm(buffer.data(), buffer.size()))
+            {
+                Log::get() << Log::WARNING << "ChannelOutput_Shmdata::bufferConsume - Error while sending buffer\n";
+                continue;
+            }
+
+            // The buffer starts with the name of the object it belongs to
+            if (const auto name = getBufferName(buffer); !name.empty())
+                LatencyTracker::get().recordLatency(std::string(name), LatencyTracker::STAGE_SEND, Timer::getTime() - queued.queueTime);
         }
     }
 }
@@ -181,18 +212,21 @@ bool ChannelInput_Shmdata::connectTo(const std::string& target)
             [&]() {},
             &_shmlogger)});
 
+    // Real-time and background buffers are read by their own follower, and handled alike
+    const auto onBuffer = [&](void* data, size_t size) {
+        std::unique_lock<std::mutex> lock(_bufConsumeMutex);
+        _bufQueue.emplace_back(std::vector<uint8_t>(reinterpret_cast<uint8_t*>(data), reinterpret_cast<uint8_t*>(data) + size));
+        _bufNewInQueue = true;
+        _bufCondition.notify_one();
+    };
+
     _bufFollowers.insert({target,
         std::make_unique<shmdata::Follower>(
-            _pathPrefix + "buf_" + target,
-            [&](void* data, size_t size) {
-                std::unique_lock<std::mutex> lock(_bufConsumeMutex);
-                _bufQueue.emplace_back(std::vector<uint8_t>(reinterpret_cast<uint8_t*>(data), reinterpret_cast<uint8_t*>(data) + size));
-                _bufNewInQueue = true;
-                _bufCondition.notify_one();
-            },
-            [&](const std::string& caps) { _bufCaps = caps; },
-            [&]() {},
-            &_shmlogger)});
+            _pathPrefix + "buf_" + target, onBuffer, [&](const std::string& caps) { _bufCaps = caps; }, [&]() {}, &_shmlogger)});
+
+    _backgroundBufFollowers.insert({target,
+        std::make_unique<shmdata::Follower>(
+            _pathPrefix + "bufbg_" + target, onBuffer, [&](const std::string& caps) { _bufCaps = caps; }, [&]() {}, &_shmlogger)});
 
     return true;
 }
@@ -265,6 +299,7 @@ bool ChannelInput_Shmdata::disconnectFrom(const std::string& target)
 
     _msgFollowers.erase(target);
     _bufFollowers.erase(target);
+    _backgroundBufFollowers.erase(target);
 
     return true;
 }
@@ -107,19 +107,21 @@ class ChannelOutput_Shmdata final : public ChannelOutput
     /**
      * Send a buffer
      * \param buffer Buffer to be sent
+     * \param priority Buffer priority, each priority having its own shmdata writer
      * \return Return true if the buffer was successfully sent
      */
-    bool sendBuffer(SerializedObject&& buffer) final;
+    bool sendBuffer(SerializedObject&& buffer, BufferPriority priority = BufferPriority::realtime) final;
 
     /**
-     * Check that all buffers were sent to the client
+     * Check that all real-time buffers were sent to the client
      *
      * Copy to shmdata is (for now) synchronous so there is no need to wait.
      *
      * \param maximumWait Maximum waiting time
+     * \param priority Priority of the buffers to wait for
      * \return Return true if all went well
      */
-    bool waitForBufferSending(std::chrono::milliseconds /*maximumWait*/) final { return true; }
+    bool waitForBufferSending(std::chrono::milliseconds /*maximumWait*/, BufferPriority /*priority*/ = BufferPriority::realtime) final { return true; }
 
   private:
     static const size_t _shmDefaultSize;
@@ -136,17 +138,30 @@ class ChannelOutput_Shmdata final : public ChannelOutput
     bool _msgNewInQueue{false};
     std::thread _msgConsumeThread;
 
-    std::vector<SerializedObject> _bufQueue;
-    std::mutex _bufConsumeMutex;
-    std::condition_variable _bufCondition;
-    bool _bufNewInQueue{false};
-    std::thread _bufConsumeThread;
+    struct QueuedBuffer
+    {
+        SerializedObject buffer;
+        int64_t queueTime{0};
+    };
+
+    // Each buffer priority has its own queue, thread and writer
+    struct BufferPath
+    {
+        std::vector<QueuedBuffer> queue;
+        std::mutex mutex;
+        std::condition_variable condition;
+        bool newInQueue{false};
+        std::thread thread;
+        std::unique_ptr<shmdata::Writer> writer{nullptr};
+    };
+
+    BufferPath _realtimeBuffers;
+    BufferPath _backgroundBuffers;
 
     Utils::ShmdataLogger _shmlogger{};
     std::string _pathPrefix{};
 
     std::unique_ptr<shmdata::Writer> _msgWriter{nullptr};
-    std::unique_ptr<shmdata::Writer> _bufWriter{nullptr};
 
     /**
      * Message consume method, responsible for sending the queued messages
@@ -156,9 +171,10 @@ class ChannelOutput_Shmdata final : public ChannelOutput
 
     /**
      * Buffer consume method, responsible for sending the queued buffers
-     * Used by the buffer consume thread
+     * Used by the buffer consume threads
+     * \param path Buffer path to send the buffers from
      */
-    void bufferConsume();
+    void bufferConsume(BufferPath& path);
 };
 
 /*************/
@@ -227,6 +243,7 @@ class ChannelInput_Shmdata final : public ChannelInput
 
     std::unordered_map<std::string, std::unique_ptr<shmdata::Follower>> _msgFollowers{};
     std::unordered_map<std::string, std::unique_ptr<shmdata::Follower>> _bufFollowers{};
+    std::unordered_map<std::string, std::unique_ptr<shmdata::Follower>> _backgroundBufFollowers{};
 
     /**
      * Message consume method, responsible for handling the input queued messages
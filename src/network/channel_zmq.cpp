@@ -1,9 +1,11 @@
 #include "./network/channel_zmq.h"
 
+#include <algorithm>
 #include <chrono>
 #include <thread>
 
 #include "./core/root_object.h"
+#include "./utils/latency.h"
 #include "./utils/log.h"
 #include "./utils/timer.h"
 
@@ -31,20 +33,38 @@ ChannelOutput_ZMQ::ChannelOutput_ZMQ(const RootObject* root, const std::string&
     try
     {
 #if HAVE_LINUX
-        _context = zmq::context_t(1);
+        // Background buffers get their own I/O thread, so as not to delay the other sockets
+        _context = zmq::context_t(2);
         _socketMessageOut = std::make_unique<zmq::socket_t>(_context, ZMQ_PUB);
         _socketBufferOut = std::make_unique<zmq::socket_t>(_context, ZMQ_PUB);
+        _socketBackgroundBufferOut = std::make_unique<zmq::socket_t>(_context, ZMQ_PUB);
+        _socketMessageOut->set(zmq::sockopt::affinity, 1);
+        _socketBufferOut->set(zmq::sockopt::affinity, 1);
+        _socketBackgroundBufferOut->set(zmq::sockopt::affinity, 2);
+        _socketSharedBufferOut = std::make_unique<zmq::socket_t>(_context, ZMQ_PUB);
+        _socketSharedBufferOut->set(zmq::sockopt::affinity, 1);
 #elif HAVE_WINDOWS
         _socketMessageOut = std::make_unique<zmq::socket_t>(zmqCommonContext, ZMQ_PUB);
         _socketBufferOut = std::make_unique<zmq::socket_t>(zmqCommonContext, ZMQ_PUB);
+        _socketBackgroundBufferOut = std::make_unique<zmq::socket_t>(zmqCommonContext, ZMQ_PUB);
 #endif
 
         const int highWaterMark = 0;
         _socketMessageOut->set(zmq::sockopt::sndhwm, highWaterMark);
         _socketBufferOut->set(zmq::sockopt::sndhwm, highWaterMark);
+        _socketBackgroundBufferOut->set(zmq::sockopt::sndhwm, highWaterMark);
 
         _socketMessageOut->bind(_pathPrefix + "msg_" + _name);
         _socketBufferOut->bind(_pathPrefix + "buf_" + _name);
+        _socketBackgroundBufferOut->bind(_pathPrefix + "bufbg_" + _name);
+
+#if HAVE_LINUX
+        // Inputs are always on the same machine with the ipc transport, so large real-time
+        // buffers can be written once to shared memory, only their descriptor going through the socket
+        _socketSharedBufferOut->set(zmq::sockopt::sndhwm, highWaterMark);
+        _socketSharedBufferOut->bind(_pathPrefix + "bufshm_" + _name);
+        _sharedMemoryWriter = std::make_unique<SharedMemoryWriter>(socketPrefix.empty() ? _name : socketPrefix + "_" + _name);
+#endif
     }
     catch (const zmq::error_t& error)
     {
@@ -69,6 +89,10 @@ ChannelOutput_ZMQ::~ChannelOutput_ZMQ()
         const int lingerValue = 0;
         _socketMessageOut->set(zmq::sockopt::linger, lingerValue);
         _socketBufferOut->set(zmq::sockopt::linger, lingerValue);
+        _socketBackgroundBufferOut->set(zmq::sockopt::linger, lingerValue);
+#if HAVE_LINUX
+        _socketSharedBufferOut->set(zmq::sockopt::linger, lingerValue);
+#endif
     }
     catch (zmq::error_t& error)
     {
@@ -101,7 +125,7 @@ bool ChannelOutput_ZMQ::sendMessage(const std::vector<uint8_t>& message)
 }
 
 /*************/
-bool ChannelOutput_ZMQ::sendBuffer(SerializedObject&& buffer)
+bool ChannelOutput_ZMQ::sendBuffer(SerializedObject&& buffer, BufferPriority priority)
 {
     if (!_ready)
         return false;
@@ -109,15 +133,22 @@ bool ChannelOutput_ZMQ::sendBuffer(SerializedObject&& buffer)
     try
     {
         std::lock_guard<Spinlock> lock(_bufferSendMutex);
+        const auto isRealtime = priority == BufferPriority::realtime;
+
+        if (isRealtime)
+            if (const auto sent = sendSharedBuffer(buffer))
+                return *sent;
 
         _sendQueueMutex.lock();
-        _bufferSendQueue.push_back(std::move(buffer));
-        auto& queuedBuffer = _bufferSendQueue.back();
-        _sendQueueBufferCount++;
+        auto& sendQueue = isRealtime ? _bufferSendQueue : _backgroundBufferSendQueue;
+        sendQueue.push_back({std::move(buffer), Timer::getTime()});
+        auto& queuedBuffer = sendQueue.back().buffer;
+        if (isRealtime)
+            _sendQueueBufferCount++;
         _sendQueueMutex.unlock();
 
         zmq::message_t msg(queuedBuffer.data(), queuedBuffer.size(), ChannelOutput_ZMQ::freeSerializedBuffer, this);
-        _socketBufferOut->send(msg, zmq::send_flags::none);
+        (isRealtime ? _socketBufferOut : _socketBackgroundBufferOut)->send(msg, zmq::send_flags::none);
     }
     catch (const zmq::error_t& error)
     {
@@ -131,6 +162,63 @@ bool ChannelOutput_ZMQ::sendBuffer(SerializedObject&& buffer)
     return true;
 }
 
+/*************/
+std::optional<bool> ChannelOutput_ZMQ::sendSharedBuffer(const SerializedObject& buffer)
+{
+#if HAVE_LINUX
+    if (!_useSharedMemory)
+        return {};
+
+    // Segments are reused per object, unnamed buffers go through the socket
+    const auto name = getBufferName(buffer);
+    if (name.empty())
+        return {};
+
+    auto pathIt = _sharedMemoryObjects.find(std::string(name));
+    if (pathIt == _sharedMemoryObjects.end())
+        pathIt = _sharedMemoryObjects.emplace(std::string(name), buffer.size() >= _sharedMemoryMinimumSize).first;
+    if (!pathIt->second)
+        return {};
+
+    const auto startTime = Timer::getTime();
+    const auto descriptor = _sharedMemoryWriter->write(name, std::span<const uint8_t>(buffer.data(), buffer.size()));
+    if (descriptor.empty())
+    {
+        // Without any segment, no buffer of the object can still be on its way through shared memory,
+        // and the object can switch to the socket
+        if (!_sharedMemoryWriter->hasSegments(name))
+        {
+            pathIt->second = false;
+            return {};
+        }
+
+        // Otherwise the buffer is dropped, the caller being in charge of sending it again
+        Log::get() << Log::DEBUGGING << "ChannelOutput_ZMQ::" << __FUNCTION__ << " - No shared memory segment available for " << name << ", dropping buffer" << Log::endl;
+        return false;
+    }
+
+    zmq::message_t msg(descriptor.data(), descriptor.size());
+    _socketSharedBufferOut->send(msg, zmq::send_flags::none);
+
+    // The buffer is sent as soon as it is written, the inputs read it from shared memory
+    LatencyTracker::get().recordLatency(std::string(name), LatencyTracker::STAGE_SEND, Timer::getTime() - startTime);
+    return true;
+#else
+    return {};
+#endif
+}
+
+/*************/
+void ChannelOutput_ZMQ::releaseBuffers(const std::string& name)
+{
+    std::lock_guard<Spinlock> lock(_bufferSendMutex);
+    _sharedMemoryObjects.erase(name);
+#if HAVE_LINUX
+    if (_sharedMemoryWriter)
+        _sharedMemoryWriter->release(name);
+#endif
+}
+
 /*************/
 void ChannelOutput_ZMQ::freeSerializedBuffer(void* data, void* hint)
 {
@@ -139,44 +227,51 @@ void ChannelOutput_ZMQ::freeSerializedBuffer(void* data, void* hint)
     std::unique_lock<std::mutex> lock(ctx->_bufferTransmittedMutex);
     std::unique_lock<Spinlock> lockBuffer(ctx->_sendQueueMutex);
 
-    uint32_t index = 0;
-    for (; index < ctx->_bufferSendQueue.size(); ++index)
-        if (ctx->_bufferSendQueue[index].data() == data)
-            break;
+    const auto findBuffer = [data](auto& queue) {
+        return std::find_if(queue.begin(), queue.end(), [data](const QueuedBuffer& queued) { return queued.buffer.data() == data; });
+    };
 
-    if (index >= ctx->_bufferSendQueue.size())
+    auto isRealtime = true;
+    auto& realtimeQueue = ctx->_bufferSendQueue;
+    auto bufferIt = findBuffer(realtimeQueue);
+    if (bufferIt == realtimeQueue.end())
     {
-        Log::get() << Log::DEBUGGING << "Link::" << __FUNCTION__ << " - Buffer to free not found in currently sent buffers list" << Log::endl;
-        return;
+        isRealtime = false;
+        bufferIt = findBuffer(ctx->_backgroundBufferSendQueue);
+        if (bufferIt == ctx->_backgroundBufferSendQueue.end())
+        {
+            Log::get() << Log::DEBUGGING << "Link::" << __FUNCTION__ << " - Buffer to free not found in currently sent buffers list" << Log::endl;
+            return;
+        }
+    }
+
+    // The buffer starts with the name of the object it belongs to
+    const auto& buffer = bufferIt->buffer;
+    if (const auto name = getBufferName(buffer); !name.empty())
+        LatencyTracker::get().recordLatency(std::string(name), LatencyTracker::STAGE_SEND, Timer::getTime() - bufferIt->queueTime);
+
+    if (isRealtime)
+    {
+        realtimeQueue.erase(bufferIt);
+        ctx->_sendQueueBufferCount--;
+    }
+    else
+    {
+        ctx->_backgroundBufferSendQueue.erase(bufferIt);
     }
-    ctx->_bufferSendQueue.erase(ctx->_bufferSendQueue.begin() + index);
-    ctx->_sendQueueBufferCount--;
 
     ctx->_bufferTransmittedCondition.notify_all();
 }
 
 /*************/
-bool ChannelOutput_ZMQ::waitForBufferSending(std::chrono::milliseconds maximumWait)
+bool ChannelOutput_ZMQ::waitForBufferSending(std::chrono::milliseconds maximumWait, BufferPriority priority)
 {
     std::unique_lock<std::mutex> lock(_bufferTransmittedMutex);
-
-    // If no buffer is currently being sent, return now
-    if (_sendQueueBufferCount == 0)
-        return true;
-
-    const auto startTime = Timer::getTime() / 1000; // Time in ms
-    auto waitDurationLeft = maximumWait.count();
-    while (true)
-    {
-        const auto status = _bufferTransmittedCondition.wait_for(lock, std::chrono::milliseconds(waitDurationLeft));
-        if (status == std::cv_status::timeout)
-            return false;
-        else if (_sendQueueBufferCount == 0)
-            return true;
-        waitDurationLeft = Timer::getTime() / 1000 - startTime;
-    }
-
-    return false;
+    const auto isQueueEmpty = [&]() {
+        std::lock_guard<Spinlock> lockQueue(_sendQueueMutex);
+        return priority == BufferPriority::realtime ? _sendQueueBufferCount == 0 : _backgroundBufferSendQueue.empty();
+    };
+    return _bufferTransmittedCondition.wait_for(lock, maximumWait, isQueueEmpty);
 }
 
 /*************/
@@ -199,14 +294,23 @@ ChannelInput_ZMQ::ChannelInput_ZMQ(const RootObject* root, const std::string& na
         _context = zmq::context_t(1);
         _socketMessageIn = std::make_unique<zmq::socket_t>(_context, ZMQ_SUB);
         _socketBufferIn = std::make_unique<zmq::socket_t>(_context, ZMQ_SUB);
+        _socketBackgroundBufferIn = std::make_unique<zmq::socket_t>(_context, ZMQ_SUB);
+        _socketSharedBufferIn = std::make_unique<zmq::socket_t>(_context, ZMQ_SUB);
 #elif HAVE_WINDOWS
         _socketMessageIn = std::make_unique<zmq::socket_t>(zmqCommonContext, ZMQ_SUB);
         _socketBufferIn = std::make_unique<zmq::socket_t>(zmqCommonContext, ZMQ_SUB);
+        _socketBackgroundBufferIn = std::make_unique<zmq::socket_t>(zmqCommonContext, ZMQ_SUB);
 #endif
         // We don't want to miss a message: set the high water mark to a high value
         _socketMessageIn->set(zmq::sockopt::rcvhwm, 1000);
-        // We only keep one buffer in memory while processing
+        // We only keep one real-time buffer in memory while processing
         _socketBufferIn->set(zmq::sockopt::rcvhwm, 1);
+        // Background buffers must all be delivered
+        _socketBackgroundBufferIn->set(zmq::sockopt::rcvhwm, 0);
+#if HAVE_LINUX
+        // Descriptors are small, and those of overwritten buffers are dropped when read
+        _socketSharedBufferIn->set(zmq::sockopt::rcvhwm, 1000);
+#endif
     }
     catch (const zmq::error_t& error)
     {
@@ -219,7 +323,11 @@ ChannelInput_ZMQ::ChannelInput_ZMQ(const RootObject* root, const std::string& na
 
     _continueListening = true;
     _messageInThread = std::thread([&]() { handleInputMessages(); });
-    _bufferInThread = std::thread([&]() { handleInputBuffers(); });
+    _bufferInThread = std::thread([&]() { handleInputBuffers(*_socketBufferIn); });
+    _backgroundBufferInThread = std::thread([&]() { handleInputBuffers(*_socketBackgroundBufferIn); });
+#if HAVE_LINUX
+    _sharedBufferInThread = std::thread([&]() { handleInputSharedBuffers(); });
+#endif
 
     _ready = true;
 }
@@ -234,6 +342,12 @@ ChannelInput_ZMQ::~ChannelInput_ZMQ()
 
     if (_bufferInThread.joinable())
         _bufferInThread.join();
+
+    if (_backgroundBufferInThread.joinable())
+        _backgroundBufferInThread.join();
+
+    if (_sharedBufferInThread.joinable())
+        _sharedBufferInThread.join();
 }
 
 /*************/
@@ -251,10 +365,18 @@ ChannelInput_ZMQ::~ChannelInput_ZMQ()
     {
         _socketMessageIn->connect(_pathPrefix + "msg_" + target);
         _socketBufferIn->connect(_pathPrefix + "buf_" + target);
+        _socketBackgroundBufferIn->connect(_pathPrefix + "bufbg_" + target);
+#if HAVE_LINUX
+        _socketSharedBufferIn->connect(_pathPrefix + "bufshm_" + target);
+#endif
 
         // We subscribe to all incoming messages
         _socketMessageIn->set(zmq::sockopt::subscribe, "");
         _socketBufferIn->set(zmq::sockopt::subscribe, "");
+        _socketBackgroundBufferIn->set(zmq::sockopt::subscribe, "");
+#if HAVE_LINUX
+        _socketSharedBufferIn->set(zmq::sockopt::subscribe, "");
+#endif
     }
     catch (const zmq::error_t& error)
     {
@@ -281,6 +403,10 @@ ChannelInput_ZMQ::~ChannelInput_ZMQ()
     {
         _socketMessageIn->disconnect((_pathPrefix + "msg_" + target));
         _socketBufferIn->disconnect((_pathPrefix + "buf_" + target));
+        _socketBackgroundBufferIn->disconnect((_pathPrefix + "bufbg_" + target));
+#if HAVE_LINUX
+        _socketSharedBufferIn->disconnect((_pathPrefix + "bufshm_" + target));
+#endif
     }
     catch (const zmq::error_t& error)
     {
@@ -309,9 +435,7 @@ void ChannelInput_ZMQ::handleInputMessages()
             zmq::message_t msg;
             while (_socketMessageIn->recv(msg, zmq::recv_flags::dontwait))
             {
-                std::vector<uint8_t> message(static_cast<size_t>(msg.size()));
-                std::copy(static_cast<uint8_t*>(msg.data()), static_cast<uint8_t*>(msg.data()) + msg.size(), message.data());
-                _msgRecvCb(message);
+                _msgRecvCb(std::span<const uint8_t>(static_cast<const uint8_t*>(msg.data()), msg.size()));
             }
         }
     }
@@ -323,11 +447,11 @@ void ChannelInput_ZMQ::handleInputMessages()
 }
 
 /*************/
-void ChannelInput_ZMQ::handleInputBuffers()
+void ChannelInput_ZMQ::handleInputBuffers(zmq::socket_t& socket)
 {
     try
     {
-        zmq::pollitem_t items = {_socketBufferIn->handle(), 0, ZMQ_POLLIN, 0};
+        zmq::pollitem_t items = {socket.handle(), 0, ZMQ_POLLIN, 0};
 
         while (_continueListening)
         {
@@ -335,7 +459,7 @@ void ChannelInput_ZMQ::handleInputBuffers()
                 continue;
 
             zmq::message_t msg;
-            while (_socketBufferIn->recv(msg, zmq::recv_flags::dontwait))
+            while (socket.recv(msg, zmq::recv_flags::dontwait))
             {
                 const auto data = static_cast<uint8_t*>(msg.data());
                 auto buffer = SerializedObject(data, data + msg.size());
@@ -350,4 +474,39 @@ void ChannelInput_ZMQ::handleInputBuffers()
     }
 }
 
+/*************/
+void ChannelInput_ZMQ::handleInputSharedBuffers()
+{
+#if HAVE_LINUX
+    try
+    {
+        zmq::pollitem_t items = {_socketSharedBufferIn->handle(), 0, ZMQ_POLLIN, 0};
+
+        while (_continueListening)
+        {
+            if (!zmq::poll(&items, 1, std::chrono::milliseconds(10)))
+                continue;
+
+            zmq::message_t msg;
+            while (_socketSharedBufferIn->recv(msg, zmq::recv_flags::dontwait))
+            {
+                auto buffer = _sharedMemoryReader.read(std::span<const uint8_t>(static_cast<const uint8_t*>(msg.data()), msg.size()));
+                if (!buffer)
+                {
+                    // A segment is only overwritten by a newer buffer of the same object, which is on its way
+                    Log::get() << Log::DEBUGGING << "ChannelInput_ZMQ::" << __FUNCTION__ << " - Shared buffer was replaced before being read, skipping it" << Log::endl;
+                    continue;
+                }
+                _bufferRecvCb(std::move(*buffer));
+            }
+        }
+    }
+    catch (const zmq::error_t& error)
+    {
+        if (errno != ETERM)
+            Log::get() << Log::WARNING << "ChannelInput_ZMQ::" << __FUNCTION__ << " - Exception: " << error.what() << Log::endl;
+    }
+#endif
+}
+
 } // namespace Splash
@@ -30,15 +30,20 @@
 #include <deque>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <set>
 #include <string>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
 #include <zmq.hpp>
 
 #include "./core/spinlock.h"
 #include "./network/channel.h"
+#if HAVE_LINUX
+#include "./network/shared_memory_broadcast.h"
+#endif
 
 namespace Splash
 {
@@ -97,23 +102,49 @@ class ChannelOutput_ZMQ final : public ChannelOutput
     /**
      * Send a buffer
      * \param buffer Buffer to be sent
+     * \param priority Buffer priority, each priority having its own socket
      * \return Return true if the buffer was successfully sent
      */
-    bool sendBuffer(SerializedObject&& buffer) final;
+    bool sendBuffer(SerializedObject&& buffer, BufferPriority priority = BufferPriority::realtime) final;
 
     /**
-     * Check that all buffers were sent to the client
+     * Check that all buffers of the given priority were sent to the client
      * \param maximumWait Maximum waiting time
+     * \param priority Priority of the buffers to wait for
      * \return Return true if all went well
      */
-    bool waitForBufferSending(std::chrono::milliseconds maximumWait) final;
+    bool waitForBufferSending(std::chrono::milliseconds maximumWait, BufferPriority priority = BufferPriority::realtime) final;
+
+    /**
+     * Release the shared memory segments of an object, once it has been removed
+     * \param name Object name
+     */
+    void releaseBuffers(const std::string& name) final;
+
+    /**
+     * Set whether large real-time buffers are written once to shared memory, for all the
+     * inputs to read them, instead of being sent through the socket to each of them.
+     * This is only available on Linux, and is active by default.
+     * \param active Set to true to use shared memory
+     */
+    void setSharedMemory(bool active) { _useSharedMemory = active; }
 
   private:
+    // Objects whose first real-time buffer is smaller than this go through the socket, even with shared memory active
+    static constexpr size_t _sharedMemoryMinimumSize{1 << 16};
+
     Spinlock _msgSendMutex;
     Spinlock _bufferSendMutex;
 
+    struct QueuedBuffer
+    {
+        SerializedObject buffer;
+        int64_t queueTime{0};
+    };
+
     Spinlock _sendQueueMutex;
-    std::deque<SerializedObject> _bufferSendQueue;
+    std::deque<QueuedBuffer> _bufferSendQueue;
+    std::deque<QueuedBuffer> _backgroundBufferSendQueue;
     uint32_t _sendQueueBufferCount{0};
     std::condition_variable _bufferTransmittedCondition{};
     std::mutex _bufferTransmittedMutex{};
@@ -123,6 +154,23 @@ class ChannelOutput_ZMQ final : public ChannelOutput
     zmq::context_t _context;
     std::unique_ptr<zmq::socket_t> _socketMessageOut{nullptr};
     std::unique_ptr<zmq::socket_t> _socketBufferOut{nullptr};
+    std::unique_ptr<zmq::socket_t> _socketBackgroundBufferOut{nullptr};
+
+    std::atomic_bool _useSharedMemory{true};
+#if HAVE_LINUX
+    std::unique_ptr<zmq::socket_t> _socketSharedBufferOut{nullptr};
+    std::unique_ptr<SharedMemoryWriter> _sharedMemoryWriter{nullptr};
+#endif
+    // Path taken by the real-time buffers of each object, true for shared memory. It is set by the first buffer
+    // of the object and never changes, as buffers going through both paths could be received out of order
+    std::unordered_map<std::string, bool> _sharedMemoryObjects{};
+
+    /**
+     * Write a real-time buffer to shared memory, and send its descriptor to the inputs
+     * \param buffer Buffer to send
+     * \return Return nothing if the buffer has to go through the buffer socket, otherwise whether it was sent
+     */
+    std::optional<bool> sendSharedBuffer(const SerializedObject& buffer);
 
     static void freeSerializedBuffer(void* data, void* hint);
 };
@@ -174,14 +222,22 @@ class ChannelInput_ZMQ final : public ChannelInput
     zmq::context_t _context;
     std::unique_ptr<zmq::socket_t> _socketMessageIn{nullptr};
     std::unique_ptr<zmq::socket_t> _socketBufferIn{nullptr};
+    std::unique_ptr<zmq::socket_t> _socketBackgroundBufferIn{nullptr};
+#if HAVE_LINUX
+    std::unique_ptr<zmq::socket_t> _socketSharedBufferIn{nullptr};
+    SharedMemoryReader _sharedMemoryReader{};
+#endif
 
     std::thread _messageInThread;
     std::thread _bufferInThread;
+    std::thread _backgroundBufferInThread;
+    std::thread _sharedBufferInThread;
 
     std::set<std::string> _targets;
 
     void handleInputMessages();
-    void handleInputBuffers();
+    void handleInputBuffers(zmq::socket_t& socket);
+    void handleInputSharedBuffers();
 };
 
 } // namespace Splash
@@ -20,6 +20,12 @@
 namespace Splash
 {
 
+namespace
+{
+// Name of the pseudo-target of a batch, the messages following it in the frame
+constexpr std::string_view batchName{"_batch"};
+} // namespace
+
 /*************/
 Link::Link(RootObject* root, const std::string& name, ChannelType channelType)
     : _rootObject(root)
@@ -33,7 +39,7 @@ Link::Link(RootObject* root, const std::string& name, ChannelType channelType)
         Log::get() << Log::MESSAGE << "Link::" << __FUNCTION__ << " - Setting up interprocess communication to shmdata" << Log::endl;
         _channelOutput = std::make_unique<ChannelOutput_Shmdata>(root, name);
         _channelInput = std::make_unique<ChannelInput_Shmdata>(
-            root, name, [&](const std::vector<uint8_t>& message) { handleInputMessages(message); }, [&](SerializedObject&& buffer) { handleInputBuffers(std::move(buffer)); });
+            root, name, [&](std::span<const uint8_t> message) { handleInputMessages(message); }, [&](SerializedObject&& buffer) { handleInputBuffers(std::move(buffer)); });
         break;
 #else
     default:
@@ -42,7 +48,7 @@ Link::Link(RootObject* root, const std::string& name, ChannelType channelType)
         Log::get() << Log::MESSAGE << "Link::" << __FUNCTION__ << " - Setting up interprocess communication to ZMQ" << Log::endl;
         _channelOutput = std::make_unique<ChannelOutput_ZMQ>(root, name);
         _channelInput = std::make_unique<ChannelInput_ZMQ>(
-            root, name, [&](const std::vector<uint8_t>& message) { handleInputMessages(message); }, [&](SerializedObject&& buffer) { handleInputBuffers(std::move(buffer)); });
+            root, name, [&](std::span<const uint8_t> message) { handleInputMessages(message); }, [&](SerializedObject&& buffer) { handleInputBuffers(std::move(buffer)); });
         break;
     }
 }
@@ -75,36 +81,101 @@ bool Link::isReady() const
 }
 
 /*************/
-bool Link::waitForBufferSending(std::chrono::milliseconds maximumWait)
+bool Link::waitForBufferSending(std::chrono::milliseconds maximumWait, ChannelOutput::BufferPriority priority)
 {
-    return _channelOutput->waitForBufferSending(maximumWait);
+    return _channelOutput->waitForBufferSending(maximumWait, priority);
 }
 
 /*************/
-bool Link::sendBuffer(SerializedObject&& buffer)
+bool Link::sendBuffer(SerializedObject&& buffer, ChannelOutput::BufferPriority priority)
 {
     if (buffer.size() == 0)
         return true;
 
-    return _channelOutput->sendBuffer(std::move(buffer));
+    return _channelOutput->sendBuffer(std::move(buffer), priority);
 }
 
 /*************/
 bool Link::sendBuffer(const std::shared_ptr<BufferObject>& object)
 {
     auto buffer = object->serialize();
-    return sendBuffer(std::move(buffer));
+    return sendBuffer(std::move(buffer), object->getTransportPriority());
 }
 
 /*************/
-bool Link::sendMessage(const std::string& name, const std::string& attribute, const Values& message)
+bool Link::sendMessage(const std::string& name, const std::string& attribute, const Values& message, bool coalesce)
 {
+    ++_messageCount;
+
+    {
+        std::lock_guard<std::mutex> lock(_batchMutex);
+        if (_batching)
+        {
+            if (_batch.empty())
+                Serial::serialize(batchName, _batch);
+
+            // Messages to all peers are never coalesced, as they may interleave with messages to any object
+            if (coalesce && name != Constants::ALL_PEERS)
+            {
+                auto key = name;
+                key.push_back('\0');
+                key += attribute;
+
+                std::vector<uint8_t> serializedMessage;
+                Serial::serialize(name, serializedMessage);
+                Serial::serialize(attribute, serializedMessage);
+                Serial::serialize(message, serializedMessage);
+
+                // The previous message is replaced in place, so that it keeps its order relative to the other messages
+                if (const auto previousIt = _batchCoalescing.find(key); previousIt != _batchCoalescing.end())
+                {
+                    const auto [offset, size] = previousIt->second;
+                    const auto begin = _batch.begin() + offset;
+                    _batch.insert(_batch.erase(begin, begin + size), serializedMessage.begin(), serializedMessage.end());
+
+                    const auto sizeDifference = static_cast<int64_t>(serializedMessage.size()) - static_cast<int64_t>(size);
+                    for (auto& [otherKey, otherMessage] : _batchCoalescing)
+                        if (otherMessage.first > offset)
+                            otherMessage.first += sizeDifference;
+                    previousIt->second.second = serializedMessage.size();
+                    ++_coalescedMessageCount;
+                    return true;
+                }
+
+                _batchCoalescing.emplace(std::move(key), std::make_pair(_batch.size(), serializedMessage.size()));
+                _batch.insert(_batch.end(), serializedMessage.begin(), serializedMessage.end());
+            }
+            else
+            {
+                // Messages to the same object batched before this one can not be replaced anymore,
+                // as the newer one would then be received before this message
+                if (name == Constants::ALL_PEERS)
+                {
+                    _batchCoalescing.clear();
+                }
+                else
+                {
+                    auto prefix = name;
+                    prefix.push_back('\0');
+                    std::erase_if(_batchCoalescing, [&](const auto& entry) { return entry.first.starts_with(prefix); });
+                }
+
+                Serial::serialize(name, _batch);
+                Serial::serialize(attribute, _batch);
+                Serial::serialize(message, _batch);
+            }
+
+            ++_batchMessageCount;
+            return true;
+        }
+    }
+
     std::vector<uint8_t> serializedMessage;
     Serial::serialize(name, serializedMessage);
     Serial::serialize(attribute, serializedMessage);
     Serial::serialize(message, serializedMessage);
 
-    auto result = _channelOutput->sendMessage(serializedMessage);
+    auto result = sendSerializedMessage(serializedMessage);
 
 #ifdef DEBUG
     // We don't display broadcast messages, for visibility
@@ -116,17 +187,77 @@ bool Link::sendMessage(const std::string& name, const std::string& attribute, co
 }
 
 /*************/
-void Link::handleInputMessages(const std::vector<uint8_t>& message)
+void Link::setMessageBatching(bool batching)
+{
+    std::lock_guard<std::mutex> lock(_batchMutex);
+    _batching = batching;
+    if (!_batching)
+        sendBatch();
+}
+
+/*************/
+bool Link::flushMessages()
+{
+    std::lock_guard<std::mutex> lock(_batchMutex);
+    return sendBatch();
+}
+
+/*************/
+bool Link::sendBatch()
+{
+    if (_batchMessageCount == 0)
+        return true;
+
+    // The batch is sent while holding the lock, so that it can not be overtaken
+    // by a message sent once batching is deactivated
+    const auto result = sendSerializedMessage(_batch);
+    _batch.clear();
+    _batchCoalescing.clear();
+    _batchMessageCount = 0;
+    return result;
+}
+
+/*************/
+Link::Statistics Link::getStatistics() const
+{
+    return {_messageCount.load(), _coalescedMessageCount.load(), _sentMessageCount.load(), _sentByteCount.load()};
+}
+
+/*************/
+bool Link::sendSerializedMessage(const std::vector<uint8_t>& message)
+{
+    ++_sentMessageCount;
+    _sentByteCount += message.size();
+    return _channelOutput->sendMessage(message);
+}
+
+/*************/
+void Link::handleInputMessages(std::span<const uint8_t> message)
+{
+    auto messageIt = message.data();
+    const auto messageEnd = message.data() + message.size();
+
+    auto nameIt = messageIt;
+    if (Serial::detail::deserializer<std::string_view>(nameIt) != batchName)
+    {
+        handleInputMessage(messageIt);
+        return;
+    }
+
+    messageIt = nameIt;
+    while (messageIt < messageEnd)
+        handleInputMessage(messageIt);
+}
+
+/*************/
+void Link::handleInputMessage(const uint8_t*& messageIt)
 {
-    size_t offset = 0;
-    auto name = Serial::deserialize<std::string>(message);
-    offset += Serial::getSize(name);
-    auto attribute = Serial::deserialize<std::string>(message, offset);
-    offset += Serial::getSize(attribute);
-    auto value = Serial::deserialize<Values>(message, offset);
+    // Name and attribute are read in place, only the value is copied out of the frame
+    const auto name = Serial::detail::deserializer<std::string_view>(messageIt);
+    const auto attribute = Serial::detail::deserializer<std::string_view>(messageIt);
 
     if (_rootObject)
-        _rootObject->set(name, attribute, value);
+        _rootObject->set(std::string(name), std::string(attribute), Serial::detail::deserializer<Values>(messageIt));
 #ifdef DEBUG
     // We don't display broadcast messages, for visibility
     if (name != Constants::ALL_PEERS)
@@ -141,10 +272,11 @@ void Link::handleInputBuffers(SerializedObject&& buffer)
     if (buffer.size() == 0)
         return;
 
-    auto bufferDataIt = buffer._data.cbegin();
-    const auto name = Serial::detail::deserializer<std::string>(bufferDataIt);
+    // The buffer may be a view over shared memory, which is read without being copied
+    const auto& constBuffer = buffer;
+    const auto name = Serial::deserialize<std::string_view>(std::span<const uint8_t>(constBuffer.data(), constBuffer.size()));
     if (_rootObject)
-        _rootObject->setFromSerializedObject(name, std::move(buffer));
+        _rootObject->setFromSerializedObject(std::string(name), std::move(buffer));
 }
 
 } // namespace Splash
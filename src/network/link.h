@@ -20,6 +20,10 @@
 /*
  * @link.h
  * The Link class, used for communication between World and Scenes
+ *
+ * Messages can be batched: while batching is active, they are accumulated and
+ * sent as a single framed message when flushMessages is called, typically once
+ * per loop iteration.
  */
 
 #ifndef SPLASH_LINK_H
@@ -31,8 +35,11 @@
 #include <deque>
 #include <map>
 #include <mutex>
+#include <span>
 #include <string>
 #include <thread>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 #include <zmq.hpp>
 
@@ -61,6 +68,14 @@ class Link
 #endif
     };
 
+    struct Statistics
+    {
+        uint64_t messages{0};          //!< Messages given to sendMessage
+        uint64_t coalescedMessages{0}; //!< Batched messages replaced by a newer one for the same object and attribute
+        uint64_t sentMessages{0};      //!< Messages sent through the channel, a batch counting as one
+        uint64_t sentBytes{0};         //!< Bytes sent through the channel
+    };
+
   public:
     /**
      * Constructor
@@ -99,13 +114,15 @@ class Link
      * in order to be used to point it to the correct target
      *
      * \param buffer Serialized buffer
+     * \param priority Priority of the buffer, real-time buffers are not delayed by background ones
+     * \return Return true if all went well
      */
-    bool sendBuffer(SerializedObject&& buffer);
+    bool sendBuffer(SerializedObject&& buffer, ChannelOutput::BufferPriority priority = ChannelOutput::BufferPriority::realtime);
 
     /**
-     * Send a buffer to the connected peers
-     * \param name Buffer name
+     * Send a buffer to the connected peers, with the priority set by its transport policy
      * \param object Object to get a serialized version from
+     * \return Return true if all went well
      */
     bool sendBuffer(const std::shared_ptr<BufferObject>& object);
 
@@ -114,9 +131,35 @@ class Link
      * \param name Destination object name
      * \param attribute Attribute
      * \param message Message
+     * \param coalesce If true and batching is active, replaces in place any message to the same object and attribute waiting in the batch,
+     * unless another message to this object has been batched since
+     * \return Return true if all went well
+     */
+    bool sendMessage(const std::string& name, const std::string& attribute, const Values& message, bool coalesce = false);
+
+    /**
+     * Activate or deactivate message batching. Deactivating it flushes the batch.
+     * \param batching If true, messages are kept until flushMessages is called
+     */
+    void setMessageBatching(bool batching);
+
+    /**
+     * Check whether message batching is active
+     * \return Return true if messages are kept until flushMessages is called
+     */
+    bool isMessageBatching() const { return _batching; }
+
+    /**
+     * Send the batched messages, as a single message
      * \return Return true if all went well
      */
-    bool sendMessage(const std::string& name, const std::string& attribute, const Values& message);
+    bool flushMessages();
+
+    /**
+     * Get the message statistics since the creation of the link
+     * \return Return the statistics
+     */
+    Statistics getStatistics() const;
 
     /**
      * Send a message to connected peers. Converts known base types to vector<Value> before sending.
@@ -129,23 +172,58 @@ class Link
     bool sendMessage(const std::string& name, const std::string& attribute, const std::vector<T>& message);
 
     /**
-     * Check that all buffers were sent to the client
+     * Check that all buffers of the given priority were sent to the client
      * \param maximumWait Maximum waiting time
+     * \param priority Priority of the buffers to wait for
      * \return Return true if all went well
      */
-    bool waitForBufferSending(std::chrono::milliseconds maximumWait);
+    bool waitForBufferSending(std::chrono::milliseconds maximumWait, ChannelOutput::BufferPriority priority = ChannelOutput::BufferPriority::realtime);
+
+    /**
+     * Release the resources held to send the buffers of an object, once it has been removed
+     * \param name Object name
+     */
+    void releaseBuffers(const std::string& name) { _channelOutput->releaseBuffers(name); }
 
   private:
     RootObject* _rootObject;
     std::string _name{""};
 
+    std::mutex _batchMutex{};
+    std::atomic_bool _batching{false};
+    std::vector<uint8_t> _batch{};
+    uint32_t _batchMessageCount{0};
+    std::unordered_map<std::string, std::pair<size_t, size_t>> _batchCoalescing{}; //!< Offset and size in the batch of coalescable messages
+
+    std::atomic<uint64_t> _messageCount{0};
+    std::atomic<uint64_t> _coalescedMessageCount{0};
+    std::atomic<uint64_t> _sentMessageCount{0};
+    std::atomic<uint64_t> _sentByteCount{0};
+
+    /**
+     * Send the batch, the batch mutex has to be locked
+     * \return Return true if all went well
+     */
+    bool sendBatch();
+
+    /**
+     * Send a serialized message through the output channel
+     * \param message Serialized message
+     * \return Return true if all went well
+     */
+    bool sendSerializedMessage(const std::vector<uint8_t>& message);
+
     /**
      * Message input thread function
-     * \param name Object name to send message to
-     * \param attribute Object attribute for the message
-     * \param value Object value to update
+     * \param message View over the received message, holding either a single message or a batch
+     */
+    void handleInputMessages(std::span<const uint8_t> message);
+
+    /**
+     * Handle a single message
+     * \param messageIt Iterator to the beginning of the message, moved to its end
      */
-    void handleInputMessages(const std::vector<uint8_t>& message);
+    void handleInputMessage(const uint8_t*& messageIt);
 
     /**
      * Buffer input thread function
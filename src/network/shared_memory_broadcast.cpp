@@ -0,0 +1,293 @@
+#include "./network/shared_memory_broadcast.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <tuple>
+#include <unistd.h>
+
+#include "./core/serializer.h"
+#include "./utils/log.h"
+#include "./utils/scope_guard.h"
+#include "./utils/timer.h"
+
+namespace Splash
+{
+
+namespace
+{
+// Header at the beginning of each segment, shared by the writer and the readers
+struct SegmentHeader
+{
+    std::atomic<int64_t> readers;   //!< Number of readers copying from the segment, -1 while it is being written
+    std::atomic<uint64_t> sequence; //!< Sequence number of the buffer held by the segment
+    uint64_t size;                  //!< Size of the buffer held by the segment
+};
+
+static_assert(std::atomic<int64_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free, "Shared memory synchronization needs lock-free atomics");
+
+// The buffer starts after the header, aligned on a cache line
+constexpr size_t dataOffset = 64;
+static_assert(sizeof(SegmentHeader) <= dataOffset);
+
+// Segments are allocated by steps, so that they can be reused by buffers of slightly different sizes
+constexpr size_t segmentGranularity = 1 << 20;
+
+using Descriptor = std::tuple<std::string, uint64_t, uint64_t>; // Segment name, sequence number, buffer size
+} // namespace
+
+/*************/
+SharedMemoryWriter::SharedMemoryWriter(const std::string& name, size_t maxSegmentsPerOwner, std::chrono::milliseconds reuseDelay, std::chrono::milliseconds releaseDelay)
+    : _name("/splash_" + name + "_" + std::to_string(getpid()))
+    , _maxSegmentsPerOwner(maxSegmentsPerOwner)
+    , _reuseDelay(std::chrono::duration_cast<std::chrono::microseconds>(reuseDelay).count())
+    , _releaseDelay(std::chrono::duration_cast<std::chrono::microseconds>(releaseDelay).count())
+{
+}
+
+/*************/
+SharedMemoryWriter::~SharedMemoryWriter()
+{
+    for (const auto& segment : _segments)
+    {
+        munmap(segment.memory, segment.length);
+        shm_unlink(segment.name.c_str());
+    }
+}
+
+/*************/
+std::vector<uint8_t> SharedMemoryWriter::write(std::string_view owner, std::span<const uint8_t> buffer)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    const auto now = Timer::getTime();
+    const auto length = ((dataOffset + buffer.size()) / segmentGranularity + 1) * segmentGranularity;
+
+    // Segments left unused for a while, and those of this object which do not fit its size anymore, are released.
+    // Readers still using them keep their own mapping, so there is no need to wait for them.
+    releaseSegments([&](const Segment& segment) {
+        if (now - segment.writeTime >= _releaseDelay)
+            return true;
+        return segment.owner == owner && (segment.length < length || segment.length > 2 * length);
+    });
+
+    // Taking the segment of another object could make its last buffer unavailable to late readers
+    Segment* target = nullptr;
+    size_t ownerSegmentCount = 0;
+    for (auto& segment : _segments)
+    {
+        if (segment.owner != owner)
+            continue;
+        ++ownerSegmentCount;
+        if (now - segment.writeTime < _reuseDelay)
+            continue;
+
+        // The segment is only taken if no reader is currently using it
+        auto header = reinterpret_cast<SegmentHeader*>(segment.memory);
+        int64_t expected = 0;
+        if (!header->readers.compare_exchange_strong(expected, -1, std::memory_order_acq_rel))
+            continue;
+
+        target = &segment;
+        break;
+    }
+
+    // A new segment is created when all the segments of the object are in use
+    if (!target)
+    {
+        if (ownerSegmentCount >= _maxSegmentsPerOwner)
+            return {};
+        target = createSegment(owner, length);
+        if (!target)
+            return {};
+    }
+
+    auto header = reinterpret_cast<SegmentHeader*>(target->memory);
+    const auto sequence = ++_sequence;
+    header->sequence.store(sequence, std::memory_order_relaxed);
+    header->size = buffer.size();
+    std::memcpy(target->memory + dataOffset, buffer.data(), buffer.size());
+    header->readers.store(0, std::memory_order_release);
+    target->writeTime = now;
+
+    std::vector<uint8_t> descriptor;
+    Serial::serialize(Descriptor(target->name, sequence, buffer.size()), descriptor);
+    return descriptor;
+}
+
+/*************/
+void SharedMemoryWriter::release(std::string_view owner)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    releaseSegments([&](const Segment& segment) { return segment.owner == owner; });
+}
+
+/*************/
+bool SharedMemoryWriter::hasSegments(std::string_view owner) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return std::any_of(_segments.cbegin(), _segments.cend(), [&](const Segment& segment) { return segment.owner == owner; });
+}
+
+/*************/
+size_t SharedMemoryWriter::getSegmentCount() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _segments.size();
+}
+
+/*************/
+template <typename Predicate>
+void SharedMemoryWriter::releaseSegments(Predicate predicate)
+{
+    std::erase_if(_segments, [&](const Segment& segment) {
+        if (!predicate(segment))
+            return false;
+        munmap(segment.memory, segment.length);
+        shm_unlink(segment.name.c_str());
+        return true;
+    });
+}
+
+/*************/
+SharedMemoryWriter::Segment* SharedMemoryWriter::createSegment(std::string_view owner, size_t length)
+{
+    const auto name = _name + "_" + std::to_string(_segmentIndex++);
+
+    const auto fd = shm_open(name.c_str(), O_CREAT | O_RDWR | O_TRUNC, S_IRUSR | S_IWUSR);
+    if (fd == -1)
+    {
+        Log::get() << Log::WARNING << "SharedMemoryWriter::" << __FUNCTION__ << " - Unable to create shared memory segment " << name << ": " << std::string(strerror(errno)) << Log::endl;
+        return nullptr;
+    }
+    OnScopeExit { close(fd); };
+
+    // Pages are reserved right away, as writing to a segment lacking memory would raise a SIGBUS instead of failing
+    if (const auto error = posix_fallocate(fd, 0, static_cast<off_t>(length)); error != 0)
+    {
+        Log::get() << Log::WARNING << "SharedMemoryWriter::" << __FUNCTION__ << " - Unable to allocate shared memory segment " << name << ": " << std::string(strerror(error)) << Log::endl;
+        shm_unlink(name.c_str());
+        return nullptr;
+    }
+
+    auto memory = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (memory == MAP_FAILED)
+    {
+        Log::get() << Log::WARNING << "SharedMemoryWriter::" << __FUNCTION__ << " - Unable to map shared memory segment " << name << ": " << std::string(strerror(errno)) << Log::endl;
+        shm_unlink(name.c_str());
+        return nullptr;
+    }
+
+    // The segment is created as being written to
+    auto header = new (memory) SegmentHeader;
+    header->readers.store(-1);
+    header->sequence.store(0);
+    header->size = 0;
+
+    _segments.push_back({name, std::string(owner), static_cast<uint8_t*>(memory), length, 0});
+    return &_segments.back();
+}
+
+/*************/
+SharedMemoryReader::Mapping::Mapping(uint8_t* memory, size_t length)
+    : memory(memory)
+    , length(length)
+{
+}
+
+/*************/
+SharedMemoryReader::Mapping::~Mapping()
+{
+    munmap(memory, length);
+}
+
+/*************/
+std::optional<SerializedObject> SharedMemoryReader::read(std::span<const uint8_t> descriptor)
+{
+    expireMappings();
+
+    // Check that the descriptor is large enough to hold the segment name before deserializing it
+    if (descriptor.size() < sizeof(uint32_t) + 2 * sizeof(uint64_t))
+        return {};
+    const auto nameLength = Serial::deserialize<uint32_t>(descriptor);
+    if (descriptor.size() != sizeof(uint32_t) + nameLength + 2 * sizeof(uint64_t))
+        return {};
+
+    const auto [name, sequence, size] = Serial::deserialize<Descriptor>(descriptor);
+    auto mapping = getMapping(name);
+    if (!mapping || mapping->length - dataOffset < size)
+        return {};
+
+    // Register as a reader, unless the segment is being written to
+    auto header = reinterpret_cast<SegmentHeader*>(mapping->memory);
+    auto readers = header->readers.load(std::memory_order_relaxed);
+    do
+    {
+        if (readers < 0)
+            return {};
+    } while (!header->readers.compare_exchange_weak(readers, readers + 1, std::memory_order_acquire, std::memory_order_relaxed));
+
+    // The reader is unregistered once the view is released, the mapping being kept alive until then
+    auto holder = std::shared_ptr<const void>(header, [mapping](const void* data) {
+        reinterpret_cast<SegmentHeader*>(const_cast<void*>(data))->readers.fetch_sub(1, std::memory_order_release);
+    });
+
+    // The segment may have been overwritten since the descriptor was sent
+    if (header->sequence.load(std::memory_order_relaxed) != sequence || header->size != size)
+        return {};
+
+    return SerializedObject(std::span<const uint8_t>(mapping->memory + dataOffset, size), std::move(holder));
+}
+
+/*************/
+std::shared_ptr<SharedMemoryReader::Mapping> SharedMemoryReader::getMapping(const std::string& name)
+{
+    const auto now = Timer::getTime();
+    if (const auto mappingIt = _mappings.find(name); mappingIt != _mappings.end())
+    {
+        mappingIt->second->lastUse = now;
+        return mappingIt->second;
+    }
+
+    const auto fd = shm_open(name.c_str(), O_RDWR, 0);
+    if (fd == -1)
+    {
+        Log::get() << Log::DEBUGGING << "SharedMemoryReader::" << __FUNCTION__ << " - Unable to open shared memory segment " << name << ": " << std::string(strerror(errno)) << Log::endl;
+        return nullptr;
+    }
+    OnScopeExit { close(fd); };
+
+    struct stat status;
+    if (fstat(fd, &status) == -1 || static_cast<size_t>(status.st_size) < dataOffset)
+        return nullptr;
+
+    const auto length = static_cast<size_t>(status.st_size);
+    auto memory = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (memory == MAP_FAILED)
+    {
+        Log::get() << Log::WARNING << "SharedMemoryReader::" << __FUNCTION__ << " - Unable to map shared memory segment " << name << ": " << std::string(strerror(errno)) << Log::endl;
+        return nullptr;
+    }
+
+    auto mapping = std::make_shared<Mapping>(static_cast<uint8_t*>(memory), length);
+    mapping->lastUse = now;
+    _mappings[name] = mapping;
+    return mapping;
+}
+
+/*************/
+void SharedMemoryReader::expireMappings()
+{
+    const auto now = Timer::getTime();
+    if (now - _lastExpirationCheck < _mappingExpiration)
+        return;
+    _lastExpirationCheck = now;
+
+    // Views still using a dropped mapping keep it alive until they are released
+    std::erase_if(_mappings, [&](const auto& entry) { return now - entry.second->lastUse >= _mappingExpiration; });
+}
+
+} // namespace Splash
@@ -0,0 +1,210 @@
+/*
+ * Copyright (C) 2026 Splash authors
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @shared_memory_broadcast.h
+ * SharedMemoryWriter and SharedMemoryReader classes, broadcasting buffers to
+ * multiple processes of the same machine through a single shared memory write
+ *
+ * The writer copies each buffer once into one of its shared memory segments, and
+ * gives back a small descriptor which is sent to the readers through a socket. Each
+ * reader maps the segment and hands a view over it to the deserialization, which
+ * copies out only what it needs to keep. A segment is held as long as a reader uses
+ * it: it holds a count of the readers currently using it, and a sequence number which
+ * lets late readers detect that it has been overwritten by a newer buffer since the
+ * descriptor was sent.
+ *
+ * Segments belong to the object whose buffers they hold, and are only reused for
+ * buffers of that same object, so that a buffer is only ever overwritten by a newer
+ * version of itself. Each object gets as many segments as it has buffers in use at
+ * the same time, up to a limit. Segments are released when their object is released,
+ * when its buffers change size, and when they have not been written to for a while.
+ */
+
+#ifndef SPLASH_SHARED_MEMORY_BROADCAST_H
+#define SPLASH_SHARED_MEMORY_BROADCAST_H
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "./core/serialized_object.h"
+
+namespace Splash
+{
+
+/*************/
+class SharedMemoryWriter
+{
+  public:
+    /**
+     * Constructor
+     * \param name Name used as a prefix for the shared memory segments
+     * \param maxSegmentsPerOwner Maximum number of segments per object
+     * \param reuseDelay Minimum time before a segment can be overwritten, letting readers catch up
+     * \param releaseDelay Time after which a segment which has not been written to is released
+     */
+    explicit SharedMemoryWriter(const std::string& name,
+        size_t maxSegmentsPerOwner = 4,
+        std::chrono::milliseconds reuseDelay = std::chrono::milliseconds(0),
+        std::chrono::milliseconds releaseDelay = std::chrono::seconds(10));
+
+    /**
+     * Destructor, which unlinks all segments
+     */
+    ~SharedMemoryWriter();
+
+    /**
+     * Constructors/operators
+     */
+    SharedMemoryWriter(const SharedMemoryWriter&) = delete;
+    SharedMemoryWriter& operator=(const SharedMemoryWriter&) = delete;
+    SharedMemoryWriter(SharedMemoryWriter&&) = delete;
+    SharedMemoryWriter& operator=(SharedMemoryWriter&&) = delete;
+
+    /**
+     * Write a buffer to shared memory
+     * \param owner Name of the object the buffer belongs to, only its segments are reused
+     * \param buffer Buffer to write
+     * \return Return the descriptor to send to the readers, or an empty vector if no segment was available
+     */
+    std::vector<uint8_t> write(std::string_view owner, std::span<const uint8_t> buffer);
+
+    /**
+     * Release all the segments of an object. Readers still using them keep their own mapping.
+     * \param owner Name of the object
+     */
+    void release(std::string_view owner);
+
+    /**
+     * Check whether an object has any segment
+     * \param owner Name of the object
+     * \return Return true if the object has at least one segment
+     */
+    bool hasSegments(std::string_view owner) const;
+
+    /**
+     * Get the number of segments currently allocated
+     * \return Return the segment count
+     */
+    size_t getSegmentCount() const;
+
+  private:
+    struct Segment
+    {
+        std::string name{};
+        std::string owner{};
+        uint8_t* memory{nullptr};
+        size_t length{0};
+        int64_t writeTime{0};
+    };
+
+    mutable std::mutex _mutex{};
+    const std::string _name;
+    const size_t _maxSegmentsPerOwner;
+    const int64_t _reuseDelay;
+    const int64_t _releaseDelay;
+    std::vector<Segment> _segments{};
+    uint64_t _segmentIndex{0}; //!< Segment names are never reused, as readers cache their mappings by name
+    uint64_t _sequence{0};
+
+    /**
+     * Create a new segment able to hold the given length
+     * \param owner Name of the object the segment belongs to
+     * \param length Segment length, including its header
+     * \return Return a pointer to the segment, or nullptr if it could not be created
+     */
+    Segment* createSegment(std::string_view owner, size_t length);
+
+    /**
+     * Release the segments matching the given predicate
+     * \param predicate Predicate called with each segment
+     */
+    template <typename Predicate>
+    void releaseSegments(Predicate predicate);
+};
+
+/*************/
+class SharedMemoryReader
+{
+  public:
+    /**
+     * Constructor
+     */
+    SharedMemoryReader() = default;
+
+    /**
+     * Constructors/operators
+     */
+    SharedMemoryReader(const SharedMemoryReader&) = delete;
+    SharedMemoryReader& operator=(const SharedMemoryReader&) = delete;
+    SharedMemoryReader(SharedMemoryReader&&) = delete;
+    SharedMemoryReader& operator=(SharedMemoryReader&&) = delete;
+
+    /**
+     * Read the buffer pointed to by a descriptor, without copying it. The segment can not
+     * be overwritten as long as the returned object holds a view over it, so it should not
+     * be kept longer than needed to deserialize it.
+     * \param descriptor Descriptor, as returned by SharedMemoryWriter::write
+     * \return Return a view over the buffer, or nothing if it is not available anymore
+     */
+    std::optional<SerializedObject> read(std::span<const uint8_t> descriptor);
+
+  private:
+    struct Mapping
+    {
+        uint8_t* memory{nullptr};
+        size_t length{0};
+        int64_t lastUse{0};
+
+        Mapping(uint8_t* memory, size_t length);
+        ~Mapping();
+        Mapping(const Mapping&) = delete;
+        Mapping& operator=(const Mapping&) = delete;
+    };
+
+    // Mappings unused for this long are dropped, as their segment has most likely been released
+    static constexpr int64_t _mappingExpiration{10'000'000};
+
+    std::unordered_map<std::string, std::shared_ptr<Mapping>> _mappings{};
+    int64_t _lastExpirationCheck{0};
+
+    /**
+     * Get the mapping of the given segment, mapping it if needed
+     * \param name Segment name
+     * \return Return the mapping, or nullptr if the segment could not be mapped
+     */
+    std::shared_ptr<Mapping> getMapping(const std::string& name);
+
+    /**
+     * Drop the mappings which have not been used for a while
+     */
+    void expireMappings();
+};
+
+} // namespace Splash
+
+#endif // SPLASH_SHARED_MEMORY_BROADCAST_H
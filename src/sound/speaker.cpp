@@ -1,5 +1,10 @@
 #include "./sound/speaker.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <type_traits>
+
 #include "./utils/log.h"
 #include "./utils/timer.h"
 
@@ -23,9 +28,148 @@ Speaker::~Speaker()
 void Speaker::clearQueue()
 {
     std::lock_guard<std::mutex> lock(_ringWriteMutex);
-    _ringReadPosition = 0;
-    _ringWritePosition = 0;
-    _ringUnusedSpace = 0;
+    // The read position belongs to the audio callback, which will catch up with the write position
+    if (_ready)
+        _clearRequested = true;
+    else
+        _ringReadPosition = _ringWritePosition.load();
+
+    _syncOffset = 0.0;
+    _correctingDrift = false;
+    _resampleRatio = 1.0;
+    _resamplePhase = 0.0;
+    _previousFrame.clear();
+}
+
+/*************/
+bool Speaker::writeToRing(const uint8_t* data, size_t size, int64_t timestamp)
+{
+    const size_t frameSize = _channels * _sampleSize;
+    const size_t frameCount = size / frameSize;
+    if (frameCount == 0)
+        return true;
+
+    if (timestamp >= 0)
+        updateResampleRatio(timestamp);
+
+    if (_resampleRatio != 1.0 || _resamplePhase != 0.0)
+    {
+        switch (_sampleFormat)
+        {
+        default:
+            _resampledBuffer.assign(data, data + frameCount * frameSize);
+            break;
+        case Sound_Engine::SAMPLE_FMT_U8:
+        case Sound_Engine::SAMPLE_FMT_U8P:
+            resample<uint8_t>(data, frameCount);
+            break;
+        case Sound_Engine::SAMPLE_FMT_S16:
+        case Sound_Engine::SAMPLE_FMT_S16P:
+            resample<int16_t>(data, frameCount);
+            break;
+        case Sound_Engine::SAMPLE_FMT_S32:
+        case Sound_Engine::SAMPLE_FMT_S32P:
+            resample<int32_t>(data, frameCount);
+            break;
+        case Sound_Engine::SAMPLE_FMT_FLT:
+        case Sound_Engine::SAMPLE_FMT_FLTP:
+            resample<float>(data, frameCount);
+            break;
+        }
+
+        data = _resampledBuffer.data();
+        size = _resampledBuffer.size();
+    }
+    else
+    {
+        size = frameCount * frameSize;
+        _previousFrame.assign(data + size - frameSize, data + size);
+    }
+
+    const auto writePosition = _ringWritePosition.load(std::memory_order_relaxed);
+    const auto readPosition = _ringReadPosition.load(std::memory_order_acquire);
+    if (_ringbufferSize - (writePosition - readPosition) < size)
+    {
+        ++_overrunCount;
+        return false;
+    }
+
+    const auto index = writePosition & (_ringbufferSize - 1);
+    const auto firstPart = std::min<uint64_t>(size, _ringbufferSize - index);
+    std::memcpy(&_ringBuffer[index], data, firstPart);
+    std::memcpy(&_ringBuffer[0], data + firstPart, size - firstPart);
+
+    _ringWritePosition.store(writePosition + size, std::memory_order_release);
+    return true;
+}
+
+/*************/
+void Speaker::updateResampleRatio(int64_t timestamp)
+{
+    // The buffer will be heard once all the queued samples have been played
+    const auto queuedBytes = _ringWritePosition.load(std::memory_order_relaxed) - _ringReadPosition.load(std::memory_order_acquire);
+    const auto bytesPerSecond = static_cast<double>(_sampleRate * _channels * _sampleSize);
+    const auto playbackTime = Timer::getTime() + static_cast<int64_t>(queuedBytes * 1e6 / bytesPerSecond) + _outputLatency.load();
+    const auto offset = static_cast<double>(playbackTime - timestamp);
+
+    _syncOffset += (offset - _syncOffset) * _syncOffsetSmoothing;
+
+    // Correction starts when the offset gets out of the tolerance, and stops once it is mostly compensated
+    if (std::abs(_syncOffset) > _syncTolerance)
+        _correctingDrift = true;
+    else if (std::abs(_syncOffset) < _syncTolerance / 4)
+        _correctingDrift = false;
+
+    if (_correctingDrift)
+    {
+        _resampleRatio = 1.0 - std::clamp(_syncOffset / 1e6 * _resampleGain, -_maxResampleCorrection, _maxResampleCorrection);
+    }
+    else if (_resampleRatio != 1.0)
+    {
+        // Snapping back to the input frames is a sub-sample shift, which is not audible
+        _resampleRatio = 1.0;
+        _resamplePhase = 0.0;
+    }
+}
+
+/*************/
+template <typename S>
+void Speaker::resample(const uint8_t* data, size_t frameCount)
+{
+    const auto frameSize = _channels * _sampleSize;
+    const auto input = reinterpret_cast<const S*>(data);
+    const auto getSample = [&](int64_t frame, uint32_t channel) -> double {
+        if (frame >= 0)
+            return static_cast<double>(input[frame * _channels + channel]);
+        if (_previousFrame.size() == frameSize)
+            return static_cast<double>(reinterpret_cast<const S*>(_previousFrame.data())[channel]);
+        return static_cast<double>(input[channel]);
+    };
+
+    // Output frames are spread every 1 / ratio input frames, starting from the current phase.
+    // A negative phase means that the output frame lies between the previous buffer and this one.
+    const auto inputStep = 1.0 / _resampleRatio;
+    const auto outputCount = static_cast<size_t>(std::max(0.0, std::ceil((static_cast<double>(frameCount) - 1.0 - _resamplePhase) / inputStep)));
+    _resampledBuffer.resize(outputCount * frameSize);
+    auto output = reinterpret_cast<S*>(_resampledBuffer.data());
+
+    auto position = _resamplePhase;
+    for (size_t frame = 0; frame < outputCount; ++frame, position += inputStep)
+    {
+        const auto inputFrame = static_cast<int64_t>(std::floor(position));
+        const auto weight = position - static_cast<double>(inputFrame);
+        for (uint32_t channel = 0; channel < _channels; ++channel)
+        {
+            const auto value = getSample(inputFrame, channel) * (1.0 - weight) + getSample(inputFrame + 1, channel) * weight;
+            if constexpr (std::is_floating_point_v<S>)
+                output[frame * _channels + channel] = static_cast<S>(value);
+            else
+                output[frame * _channels + channel] = static_cast<S>(std::lround(value));
+        }
+    }
+
+    _resamplePhase = position - static_cast<double>(frameCount);
+    _previousFrame.assign(data + (frameCount - 1) * frameSize, data + frameCount * frameSize);
 }
 
 /*************/
@@ -73,7 +217,7 @@ void Speaker::initResources()
 
 /*************/
 int Speaker::portAudioCallback(
-    const void* /*in*/, void* out, unsigned long framesPerBuffer, const PaStreamCallbackTimeInfo* /*timeInfo*/, PaStreamCallbackFlags /*statusFlags*/, void* userData)
+    const void* /*in*/, void* out, unsigned long framesPerBuffer, const PaStreamCallbackTimeInfo* timeInfo, PaStreamCallbackFlags /*statusFlags*/, void* userData)
 {
     auto that = static_cast<Speaker*>(userData);
     uint8_t* output = (uint8_t*)out;
@@ -81,43 +225,42 @@ int Speaker::portAudioCallback(
     if (!output)
         return paContinue;
 
-    int readPosition = that->_ringReadPosition;
-    int writePosition = that->_ringWritePosition;
-
-    // If the ring buffer is not filled enough, fill with zeros instead
-    int delta = 0;
-    if (writePosition >= readPosition)
-        delta = writePosition - readPosition;
-    else
-        delta = _ringbufferSize - readPosition + writePosition;
-    int step = framesPerBuffer * that->_channels * that->_sampleSize;
+    if (timeInfo && timeInfo->outputBufferDacTime > timeInfo->currentTime)
+        that->_outputLatency = static_cast<int64_t>((timeInfo->outputBufferDacTime - timeInfo->currentTime) * 1e6);
 
-    if (delta < step)
+    const auto writePosition = that->_ringWritePosition.load(std::memory_order_acquire);
+    auto readPosition = that->_ringReadPosition.load(std::memory_order_relaxed);
+    if (that->_clearRequested.exchange(false))
     {
-        for (int i = 0; i < step; ++i)
-            *output++ = 0;
+        readPosition = writePosition;
+        that->_playing = false;
     }
-    // Else, we copy the values and move the read position
-    else
-    {
-        int effectiveSpace = _ringbufferSize - that->_ringUnusedSpace;
 
-        int ringBufferEndLength = effectiveSpace - readPosition;
+    const size_t frameSize = that->_channels * that->_sampleSize;
+    const size_t step = framesPerBuffer * frameSize;
+    const size_t available = (writePosition - readPosition) / frameSize * frameSize;
+    const size_t readSize = std::min(available, step);
 
-        if (step <= ringBufferEndLength)
-        {
-            std::copy(&that->_ringBuffer[readPosition], &that->_ringBuffer[readPosition + step], output);
-        }
-        else
-        {
-            std::copy(&that->_ringBuffer[readPosition], &that->_ringBuffer[effectiveSpace], output);
-            output += ringBufferEndLength;
-            std::copy(&that->_ringBuffer[0], &that->_ringBuffer[step - ringBufferEndLength], output);
-        }
+    const auto index = readPosition & (_ringbufferSize - 1);
+    const auto firstPart = std::min<uint64_t>(readSize, _ringbufferSize - index);
+    std::memcpy(output, &that->_ringBuffer[index], firstPart);
+    std::memcpy(output + firstPart, &that->_ringBuffer[0], readSize - firstPart);
 
-        readPosition = (readPosition + step) % effectiveSpace;
-        that->_ringReadPosition = readPosition;
+    // If the ring buffer is not filled enough, fill the remaining with silence
+    if (readSize < step)
+    {
+        const uint8_t silence = that->_sampleFormat == Sound_Engine::SAMPLE_FMT_U8 || that->_sampleFormat == Sound_Engine::SAMPLE_FMT_U8P ? 0x80 : 0x00;
+        std::memset(output + readSize, silence, step - readSize);
+        if (that->_playing)
+            ++that->_underrunCount;
+        that->_playing = false;
     }
+    else
+    {
+        that->_playing = true;
+    }
+
+    that->_ringReadPosition.store(readPosition + readSize, std::memory_order_release);
 
     if (that->_abortCallback)
         return paComplete;
@@ -128,6 +271,48 @@ int Speaker::portAudioCallback(
 void Speaker::registerAttributes()
 {
     GraphObject::registerAttributes();
+
+    addAttribute(
+        "syncTolerance",
+        [&](const Values& args) {
+            std::lock_guard<std::mutex> lock(_ringWriteMutex);
+            _syncTolerance = static_cast<int64_t>(std::max(1.f, args[0].as<float>()) * 1e3f);
+            return true;
+        },
+        [&]() -> Values {
+            std::lock_guard<std::mutex> lock(_ringWriteMutex);
+            return {static_cast<float>(_syncTolerance) / 1e3f};
+        },
+        {'r'});
+    setAttributeDescription("syncTolerance", "Maximum offset between the sound and the reference clock before the playback speed is adapted, in milliseconds");
+
+    addAttribute(
+        "syncOffset",
+        [&](const Values& /*args*/) { return true; },
+        [&]() -> Values {
+            std::lock_guard<std::mutex> lock(_ringWriteMutex);
+            return {static_cast<float>(_syncOffset / 1e3)};
+        },
+        {'r'});
+    setAttributeDescription("syncOffset", "Smoothed offset between the sound and the reference clock, positive if the sound is late, in milliseconds");
+
+    addAttribute(
+        "resampleRatio",
+        [&](const Values& /*args*/) { return true; },
+        [&]() -> Values {
+            std::lock_guard<std::mutex> lock(_ringWriteMutex);
+            return {static_cast<float>(_resampleRatio)};
+        },
+        {'r'});
+    setAttributeDescription("resampleRatio", "Current resampling ratio applied to compensate for the audio clock drift");
+
+    addAttribute(
+        "underruns", [&](const Values& /*args*/) { return true; }, [&]() -> Values { return {static_cast<int64_t>(_underrunCount)}; }, {'i'});
+    setAttributeDescription("underruns", "Number of times the audio output ran out of samples");
+
+    addAttribute(
+        "overruns", [&](const Values& /*args*/) { return true; }, [&]() -> Values { return {static_cast<int64_t>(_overrunCount)}; }, {'i'});
+    setAttributeDescription("overruns", "Number of buffers dropped because the ring buffer was full");
 }
 
 } // namespace Splash
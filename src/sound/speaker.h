@@ -69,14 +69,18 @@ class Speaker final : public GraphObject
 
     /**
      * Add a buffer to the playing queue
+     * If a timestamp is given, the playback speed is slightly adapted to keep the buffer
+     * playing at the given time, compensating for the drift of the audio device clock
      * \param buffer Buffer to add
-     * \return Return false if there was an error
+     * \param timestamp Time at which the first sample should be heard, as given by Timer::getTime(), in us. Negative to disable synchronization
+     * \return Return false if there was an error, or if the ring buffer is full
      */
     template <typename T>
-    bool addToQueue(const ResizableArray<T>& buffer);
+    bool addToQueue(const ResizableArray<T>& buffer, int64_t timestamp = -1);
 
     /**
      * Clear the queue
+     * The ring buffer is emptied by the audio callback, on its next call
      */
     void clearQueue();
 
@@ -89,7 +93,11 @@ class Speaker final : public GraphObject
     void setParameters(uint32_t channels, uint32_t sampleRate, Sound_Engine::SampleFormat format, const std::string& deviceName = "");
 
   private:
-    static constexpr uint32_t _ringbufferSize{4 * 1024 * 1024};
+    static constexpr uint64_t _ringbufferSize{4 * 1024 * 1024};
+    static_assert((_ringbufferSize & (_ringbufferSize - 1)) == 0, "Ring buffer size must be a power of two");
+    static constexpr double _maxResampleCorrection{0.005}; //!< Maximum playback speed correction, about 9 cents of pitch shift
+    static constexpr double _resampleGain{0.1};            //!< Playback speed correction per second of A/V offset
+    static constexpr double _syncOffsetSmoothing{0.05};    //!< Smoothing factor applied to the measured A/V offset, for each buffer
 
     Sound_Engine _engine;
     bool _ready{false};
@@ -100,13 +108,56 @@ class Speaker final : public GraphObject
     size_t _sampleSize{2};
     std::string _deviceName{""};
 
-    bool _abortCallback{false};
+    std::atomic_bool _abortCallback{false};
 
+    // Single producer, single consumer ring buffer. Positions are byte counters which only
+    // increase, the ring buffer index being the position modulo the ring buffer size.
+    // The write position is only modified by the producer, the read position by the audio callback.
     std::array<uint8_t, _ringbufferSize> _ringBuffer;
-    std::atomic_int _ringWritePosition{0};
-    std::atomic_int _ringReadPosition{0};
-    std::atomic_int _ringUnusedSpace{0};
-    std::mutex _ringWriteMutex;
+    std::atomic_uint64_t _ringWritePosition{0};
+    std::atomic_uint64_t _ringReadPosition{0};
+    std::atomic_bool _clearRequested{false};
+    std::mutex _ringWriteMutex; //!< Serializes the producers, never locked by the audio callback
+    bool _playing{false};       //!< Only accessed by the audio callback, true if the last buffer was fully played
+
+    // Statistics
+    std::atomic_uint64_t _underrunCount{0};
+    std::atomic_uint64_t _overrunCount{0};
+    std::atomic_int64_t _outputLatency{0}; //!< Delay between the audio callback and the output of its samples, in us
+
+    // Synchronization against the reference clock, only accessed with _ringWriteMutex locked
+    int64_t _syncTolerance{20000}; //!< Maximum A/V offset before the playback speed is corrected, in us
+    double _syncOffset{0.0};       //!< Smoothed A/V offset, positive if the sound is late, in us
+    bool _correctingDrift{false};
+    double _resampleRatio{1.0}; //!< Output frames count for each input frame
+    double _resamplePhase{0.0}; //!< Position of the next output frame relative to the start of the next input buffer
+    std::vector<uint8_t> _previousFrame{};
+    std::vector<uint8_t> _resampledBuffer{};
+
+    /**
+     * Write a buffer of interleaved samples to the ring buffer, resampling it if needed
+     * Must be called with _ringWriteMutex locked
+     * \param data Pointer to the samples
+     * \param size Size of the data, in bytes
+     * \param timestamp Time at which the first sample should be heard, in us. Negative to disable synchronization
+     * \return Return false if the ring buffer is full
+     */
+    bool writeToRing(const uint8_t* data, size_t size, int64_t timestamp);
+
+    /**
+     * Update the resampling ratio from the A/V offset of the next buffer
+     * Must be called with _ringWriteMutex locked
+     * \param timestamp Time at which the next buffer should be heard, in us
+     */
+    void updateResampleRatio(int64_t timestamp);
+
+    /**
+     * Resample the given interleaved frames into _resampledBuffer, using linear interpolation
+     * \param data Pointer to the samples
+     * \param frameCount Frame count
+     */
+    template <typename S>
+    void resample(const uint8_t* data, size_t frameCount);
 
     /**
      * Free all PortAudio resources
@@ -137,7 +188,7 @@ class Speaker final : public GraphObject
 
 /*************/
 template <typename T>
-bool Speaker::addToQueue(const ResizableArray<T>& buffer)
+bool Speaker::addToQueue(const ResizableArray<T>& buffer, int64_t timestamp)
 {
     std::lock_guard<std::mutex> lock(_ringWriteMutex);
 
@@ -156,38 +207,13 @@ bool Speaker::addToQueue(const ResizableArray<T>& buffer)
             }
     }
 
-    auto bufferSampleSize = sizeof(T);
-    int readPosition = _ringReadPosition;
-    int writePosition = _ringWritePosition;
-
-    int delta = 0;
-    if (readPosition > writePosition)
-        delta = readPosition - writePosition;
-    else
-        delta = _ringbufferSize - writePosition + readPosition;
-
-    if (delta < static_cast<int>(buffer.size() * bufferSampleSize))
-        return false;
-
-    int spaceLeft = _ringbufferSize - writePosition;
-
     const uint8_t* bufferPtr;
     if (_planar)
-        bufferPtr = static_cast<const uint8_t*>(interleavedBuffer.data());
+        bufferPtr = reinterpret_cast<const uint8_t*>(interleavedBuffer.data());
     else
-        bufferPtr = static_cast<const uint8_t*>(buffer.data());
-
-    if (spaceLeft < static_cast<int>(buffer.size() * bufferSampleSize))
-    {
-        _ringUnusedSpace = spaceLeft;
-        writePosition = 0;
-    }
-
-    std::copy(bufferPtr, bufferPtr + buffer.size() * bufferSampleSize, &_ringBuffer[writePosition]);
-    writePosition = (writePosition + buffer.size() * bufferSampleSize);
+        bufferPtr = reinterpret_cast<const uint8_t*>(buffer.data());
 
-    _ringWritePosition = writePosition;
-    return true;
+    return writeToRing(bufferPtr, buffer.size() * sizeof(T), timestamp);
 }
 
 } // namespace Splash
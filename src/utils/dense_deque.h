@@ -27,6 +27,7 @@
 
 #include <cstddef>
 #include <initializer_list>
+#include <utility>
 #include <vector>
 
 namespace Splash
@@ -69,12 +70,15 @@ class DenseDeque
         return *this;
     }
 
-    DenseDeque(const DenseDeque<T>&& value) { operator=(value); }
+    DenseDeque(DenseDeque<T>&& value) noexcept
+        : _data(std::move(value._data))
+    {
+    }
     DenseDeque<T>& operator=(DenseDeque<T>&& other) noexcept
     {
         if (&other == this)
             return *this;
-        _data = other._data;
+        _data = std::move(other._data);
         return *this;
     }
 
@@ -137,6 +141,13 @@ class DenseDeque
     }
     inline void pop_back() { _data.pop_back(); }
 
+    inline void push_front(T&& value)
+    {
+        _data.resize(_data.size() + 1);
+        for (size_t i = _data.size() - 1; i > 0; --i)
+            _data[i] = std::move(_data[i - 1]);
+        _data[0] = std::move(value);
+    }
     inline void push_front(const T& value)
     {
         _data.resize(_data.size() + 1);
@@ -159,7 +170,7 @@ class DenseDeque
         _data.resize(_data.size() + 1);
         for (size_t i = _data.size() - 1; i > 0; --i)
             _data[i] = std::move(_data[i - 1]);
-        _data[0] = value;
+        _data[0] = std::move(value);
         return _data[0];
     }
     inline void pop_front()
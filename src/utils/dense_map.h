@@ -21,6 +21,8 @@
  * @dense_map.h
  * Dense map, a cache friendly unordered map based on std::vector
  * It matches as much as possible std::map, check https://en.cppreference.com/w/cpp/container/map
+ * Keys are stored in a DenseSet, which provides constant time lookup. With std::string keys,
+ * lookups also accept std::string_view and C strings.
  *
  * Known issues:
  * - modifying the DenseMap while iterating over it with a for range may invalide the std::pair references
@@ -31,7 +33,9 @@
 
 #include <initializer_list>
 #include <memory>
+#include <optional>
 #include <stdexcept>
+#include <utility>
 #include <vector>
 
 #include "./utils/dense_set.h"
@@ -121,14 +125,14 @@ class DenseMap
         }
         std::pair<const Key&, T&>* operator->() const
         {
-            _entry.reset(new std::pair<const Key&, T&>(*(_map->_keys.begin() + _index), _map->_values[_index]));
-            return _entry.get();
+            _entry.emplace(*(_map->_keys.begin() + _index), _map->_values[_index]);
+            return &_entry.value();
         }
 
       protected:
         size_t _index;
         DenseMap<Key, T>* _map;
-        mutable std::unique_ptr<std::pair<const Key&, T&>> _entry{nullptr};
+        mutable std::optional<std::pair<const Key&, T&>> _entry{}; // Storage for operator->, to avoid allocating
     };
 
 #if __cplusplus < 201703L
@@ -217,14 +221,14 @@ class DenseMap
         }
         std::pair<const Key&, const T&>* operator->() const
         {
-            _entry.reset(new std::pair<const Key&, const T&>(*(_map->_keys.begin() + _index), _map->_values[_index]));
-            return _entry.get();
+            _entry.emplace(*(_map->_keys.begin() + _index), _map->_values[_index]);
+            return &_entry.value();
         }
 
       protected:
         size_t _index;
         const DenseMap<Key, T>* _map;
-        mutable std::unique_ptr<std::pair<const Key&, const T&>> _entry{nullptr};
+        mutable std::optional<std::pair<const Key&, const T&>> _entry{}; // Storage for operator->, to avoid allocating
     };
 
     class const_reverse_iterator;
@@ -304,14 +308,14 @@ class DenseMap
         }
         std::pair<const Key&, T&>* operator->() const
         {
-            _entry.reset(new std::pair<const Key&, T&>(*(_map->_keys.begin() + _index), _map->_values[_index]));
-            return _entry.get();
+            _entry.emplace(*(_map->_keys.begin() + _index), _map->_values[_index]);
+            return &_entry.value();
         }
 
       protected:
         size_t _index;
         DenseMap<Key, T>* _map;
-        mutable std::unique_ptr<std::pair<const Key&, const T&>> _entry{nullptr};
+        mutable std::optional<std::pair<const Key&, const T&>> _entry{}; // Storage for operator->, to avoid allocating
     };
 
 #if __cplusplus < 201703L
@@ -399,14 +403,14 @@ class DenseMap
         }
         std::pair<const Key&, const T&>* operator->() const
         {
-            _entry.reset(new std::pair<const Key&, const T&>(*(_map->_keys.begin() + _index), _map->_values[_index]));
-            return _entry.get();
+            _entry.emplace(*(_map->_keys.begin() + _index), _map->_values[_index]);
+            return &_entry.value();
         }
 
       protected:
         size_t _index;
         const DenseMap<Key, T>* _map;
-        mutable std::unique_ptr<std::pair<const Key&, const T&>> _entry{nullptr};
+        mutable std::optional<std::pair<const Key&, const T&>> _entry{}; // Storage for operator->, to avoid allocating
     };
 
   public:
@@ -431,14 +435,15 @@ class DenseMap
         return *this;
     }
 
-    DenseMap(const DenseMap<Key, T>&& other)
+    DenseMap(DenseMap<Key, T>&& other) noexcept
     {
-        operator=(other);
+        operator=(std::move(other));
     }
     DenseMap<Key, T>& operator=(DenseMap<Key, T>&& other) noexcept
     {
-        _keys = other._keys;
-        _values = other._values;
+        _keys = std::move(other._keys);
+        _values = std::move(other._values);
+        other._values.clear();
         return *this;
     }
 
@@ -454,7 +459,7 @@ class DenseMap
         {
             if (_keys.find(p->first) == _keys.end())
             {
-                auto keyIt = _keys.insert(p->first);
+                _keys.insert(p->first);
                 _values.push_back(p->second);
             }
         }
@@ -724,7 +729,7 @@ class DenseMap
         if (it == _keys.end())
             return 0;
         auto index = std::distance(_keys.begin(), it);
-        _keys.erase(key);
+        _keys.erase(it);
         _values.erase(_values.begin() + index);
         return 1;
     }
@@ -753,6 +758,34 @@ class DenseMap
         return const_iterator(index, *this);
     }
 
+    // Heterogeneous lookup, available when the key hash function is transparent
+    template <typename K, typename H = DenseHash<Key>, typename = typename H::is_transparent>
+    iterator find(const K& key)
+    {
+        auto it = _keys.find(key);
+        if (it == _keys.cend())
+            return end();
+        return iterator(std::distance(_keys.cbegin(), it), *this);
+    }
+    template <typename K, typename H = DenseHash<Key>, typename = typename H::is_transparent>
+    const_iterator find(const K& key) const
+    {
+        auto it = _keys.find(key);
+        if (it == _keys.cend())
+            return cend();
+        return const_iterator(std::distance(_keys.cbegin(), it), *this);
+    }
+
+    bool contains(const Key& key) const
+    {
+        return _keys.contains(key);
+    }
+    template <typename K, typename H = DenseHash<Key>, typename = typename H::is_transparent>
+    bool contains(const K& key) const
+    {
+        return _keys.contains(key);
+    }
+
   protected:
     DenseSet<Key> _keys;
     std::vector<T> _values;
@@ -19,80 +19,106 @@
 
 /*
  * @dense_set.h
- * Dense set, cache-friendly ordered set based on std::vector
+ * Dense set, cache-friendly set based on std::vector, keeping the insertion order
  * It matches as much as possible std::set, check https://en.cppreference.com/w/cpp/container/set
+ *
+ * Values are stored contiguously for iteration, and indexed by an open-addressing
+ * hash table (linear probing, load factor kept under 0.5) for constant time lookup.
+ * Erasing keeps the insertion order, and as such is linear in the size of the set.
+ * With std::string values, lookups also accept std::string_view and C strings.
  */
 
 #ifndef SPLASH_DENSE_SET_H
 #define SPLASH_DENSE_SET_H
 
 #include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <initializer_list>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 namespace Splash
 {
 
+/**
+ * Hash function used by default by DenseSet and DenseMap
+ * It is transparent for std::string, allowing lookups from std::string_view without allocation
+ */
 template <typename T>
+struct DenseHash : public std::hash<T>
+{
+};
+
+template <>
+struct DenseHash<std::string>
+{
+    using is_transparent = void;
+    size_t operator()(std::string_view value) const noexcept { return std::hash<std::string_view>()(value); }
+};
+
+template <typename T, typename Hash = DenseHash<T>>
 class DenseSet
 {
   public:
-    using iterator = typename std::vector<T>::iterator;
+    // Values are used as keys in the index, so they can not be modified in place
+    using iterator = typename std::vector<T>::const_iterator;
     using const_iterator = typename std::vector<T>::const_iterator;
 
   public:
     DenseSet() = default;
     template <typename InputIt>
     DenseSet(InputIt first, InputIt last)
-        : _data(first, last)
-    {
-        for (auto it = _data.begin(); it != _data.end(); ++it)
-            _data.erase(std::remove(it + 1, _data.end(), *it), _data.end());
-    }
-    DenseSet(std::initializer_list<T> init)
-        : _data(init)
     {
-        for (auto it = _data.begin(); it != _data.end(); ++it)
-            _data.erase(std::remove(it + 1, _data.end(), *it), _data.end());
+        insert(first, last);
     }
+    DenseSet(std::initializer_list<T> init) { insert(init); }
 
-    DenseSet(const DenseSet<T>& other) { operator=(other); }
-    DenseSet<T>& operator=(const DenseSet<T>& other)
+    DenseSet(const DenseSet<T, Hash>& other) { operator=(other); }
+    DenseSet<T, Hash>& operator=(const DenseSet<T, Hash>& other)
     {
         if (&other == this)
             return *this;
         _data = other._data;
+        _slotPositions = other._slotPositions;
+        _slotHashes = other._slotHashes;
         return *this;
     }
 
-    DenseSet(const DenseSet<T>&& other) { operator=(other); }
-    DenseSet<T>& operator=(DenseSet<T>&& other) noexcept
+    DenseSet(DenseSet<T, Hash>&& other) noexcept { operator=(std::move(other)); }
+    DenseSet<T, Hash>& operator=(DenseSet<T, Hash>&& other) noexcept
     {
         if (&other == this)
             return *this;
-        _data = other._data;
+        _data = std::move(other._data);
+        _slotPositions = std::move(other._slotPositions);
+        _slotHashes = std::move(other._slotHashes);
+        other.clear();
         return *this;
     }
 
-    DenseSet<T>& operator=(std::initializer_list<T> init)
+    DenseSet<T, Hash>& operator=(std::initializer_list<T> init)
     {
-        _data = init;
-        for (auto it = _data.begin(); it != _data.end(); ++it)
-            _data.erase(std::remove(it + 1, _data.end(), *it), _data.end());
+        clear();
+        insert(init);
+        return *this;
     }
 
     // Comparison operators
-    bool operator==(const DenseSet<T>& rhs) const
+    bool operator==(const DenseSet<T, Hash>& rhs) const
     {
         if (size() != rhs.size())
             return false;
         for (const auto& value : _data)
-            if (std::find(rhs._data.cbegin(), rhs._data.cend(), value) == rhs._data.cend())
+            if (rhs.find(value) == rhs.cend())
                 return false;
         return true;
     }
-    bool operator!=(const DenseSet<T>& rhs) const { return !operator==(rhs); }
+    bool operator!=(const DenseSet<T, Hash>& rhs) const { return !operator==(rhs); }
 
     // Iterators
     iterator begin() noexcept { return _data.begin(); }
@@ -103,90 +129,247 @@ class DenseSet
     const_iterator end() const noexcept { return _data.end(); }
     const_iterator cend() const noexcept { return _data.cend(); }
 
-    iterator rbegin() noexcept { return _data.rbegin(); }
-    const_iterator rbegin() const noexcept { return _data.rbegin(); }
-    const_iterator rcbegin() const noexcept { return _data.rcbegin(); }
+    auto rbegin() noexcept { return _data.crbegin(); }
+    auto rbegin() const noexcept { return _data.crbegin(); }
+    auto crbegin() const noexcept { return _data.crbegin(); }
 
-    iterator rend() noexcept { return _data.rend(); }
-    const_iterator rend() const noexcept { return _data.rend(); }
-    const_iterator rcend() const noexcept { return _data.rcend(); }
+    auto rend() noexcept { return _data.crend(); }
+    auto rend() const noexcept { return _data.crend(); }
+    auto crend() const noexcept { return _data.crend(); }
 
     // Capacity
     bool empty() const { return _data.empty(); }
     size_t size() const { return _data.size(); }
-    bool max_size() const noexcept { return _data.max_size(); }
-    void reserve(size_t size) { _data.reserve(size); }
+    size_t max_size() const noexcept { return _data.max_size(); }
+    void reserve(size_t size)
+    {
+        _data.reserve(size);
+        reserveIndex(size);
+    }
 
     // Modifiers
-    void clear() noexcept { _data.clear(); }
+    void clear() noexcept
+    {
+        _data.clear();
+        _slotPositions.clear();
+        _slotHashes.clear();
+    }
 
     std::pair<iterator, bool> insert(const T& value)
     {
-        auto it = std::find(_data.begin(), _data.end(), value);
-        if (it != _data.end())
-            return {it, false};
+        const auto hash = _hasher(value);
+        const auto position = findPosition(value, hash);
+        if (position != _npos)
+            return {_data.cbegin() + position, false};
+        reserveIndex(_data.size() + 1);
         _data.push_back(value);
-        return {_data.end() - 1, true};
+        indexPosition(hash, static_cast<uint32_t>(_data.size() - 1));
+        return {_data.cend() - 1, true};
     }
-    std::pair<iterator, bool> insert(const T&& value)
+    std::pair<iterator, bool> insert(T&& value)
     {
-        auto it = std::find(_data.begin(), _data.end(), value);
-        if (it != _data.end())
-            return {it, false};
-        _data.push_back(value);
-        return {_data.end() - 1, true};
+        const auto hash = _hasher(value);
+        const auto position = findPosition(value, hash);
+        if (position != _npos)
+            return {_data.cbegin() + position, false};
+        reserveIndex(_data.size() + 1);
+        _data.push_back(std::move(value));
+        indexPosition(hash, static_cast<uint32_t>(_data.size() - 1));
+        return {_data.cend() - 1, true};
     }
     template <class InputIt>
     void insert(InputIt first, InputIt last)
     {
-        _data.insert(_data.end(), first, last);
-        for (auto it = _data.begin(); it != _data.end(); ++it)
-            _data.erase(std::remove(it + 1, _data.end(), *it), _data.end());
+        for (auto it = first; it != last; ++it)
+            insert(*it);
     }
     void insert(std::initializer_list<T> init)
     {
-        _data.insert(_data.end(), init);
-        for (auto it = _data.begin(); it != _data.end(); ++it)
-            _data.erase(std::remove(it + 1, _data.end(), *it), _data.end());
+        for (const auto& value : init)
+            insert(value);
     }
 
     template <class... Args>
     std::pair<iterator, bool> emplace(Args&&... args)
     {
-        auto value = T(std::forward<Args>(args)...);
-        if (std::find(_data.cbegin(), _data.cend(), value) != _data.cend())
-            return {_data.end(), false};
-        auto it = _data.emplace(_data.end(), std::move(value));
-        return {it, true};
+        return insert(T(std::forward<Args>(args)...));
     }
 
-    iterator erase(const_iterator pos) { return _data.erase(pos); }
-    iterator erase(const_iterator first, const_iterator last) { return _data.erase(first, last); }
+    iterator erase(const_iterator pos)
+    {
+        const auto position = static_cast<uint32_t>(std::distance(_data.cbegin(), pos));
+        unindexPosition(position);
+        return _data.erase(pos);
+    }
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        auto it = _data.erase(first, last);
+        rebuildIndex(_slotPositions.size());
+        return it;
+    }
     size_t erase(const T& key)
     {
-        auto it = std::find(_data.cbegin(), _data.cend(), key);
+        auto it = find(key);
         if (it == _data.cend())
             return 0;
-        _data.erase(it);
+        erase(it);
         return 1;
     }
 
-    void swap(DenseSet<T>& other) noexcept { _data.swap(other._data); }
+    void swap(DenseSet<T, Hash>& other) noexcept
+    {
+        _data.swap(other._data);
+        _slotPositions.swap(other._slotPositions);
+        _slotHashes.swap(other._slotHashes);
+    }
 
     // Lookup
-    size_t count(const T& key)
+    size_t count(const T& key) const { return find(key) == _data.cend() ? 0 : 1; }
+    bool contains(const T& key) const { return find(key) != _data.cend(); }
+
+    iterator find(const T& key) { return std::as_const(*this).find(key); }
+    const_iterator find(const T& key) const
     {
-        if (std::find(_data.cbegin(), _data.cend(), key) == _data.cend())
-            return 0;
-        return 1;
+        const auto position = findPosition(key, _hasher(key));
+        return position == _npos ? _data.cend() : _data.cbegin() + position;
     }
 
-    iterator find(const T& key) { return std::find(_data.begin(), _data.end(), key); }
-
-    const_iterator find(const T& key) const { return std::find(_data.cbegin(), _data.cend(), key); }
+    // Heterogeneous lookup, only available for transparent hash functions
+    template <typename K, typename H = Hash, typename = typename H::is_transparent>
+    size_t count(const K& key) const
+    {
+        return find(key) == _data.cend() ? 0 : 1;
+    }
+    template <typename K, typename H = Hash, typename = typename H::is_transparent>
+    bool contains(const K& key) const
+    {
+        return find(key) != _data.cend();
+    }
+    template <typename K, typename H = Hash, typename = typename H::is_transparent>
+    iterator find(const K& key)
+    {
+        return std::as_const(*this).find(key);
+    }
+    template <typename K, typename H = Hash, typename = typename H::is_transparent>
+    const_iterator find(const K& key) const
+    {
+        const auto position = findPosition(key, _hasher(key));
+        return position == _npos ? _data.cend() : _data.cbegin() + position;
+    }
 
   private:
-    std::vector<T> _data;
+    static constexpr uint32_t _npos{std::numeric_limits<uint32_t>::max()};
+    static constexpr size_t _minIndexSize{16};
+
+    std::vector<T> _data{};
+    // Hash index, stored as structure of arrays so that shifting positions after an erase
+    // only goes through a compact array. Its size is either 0 or a power of two.
+    std::vector<uint32_t> _slotPositions{}; //!< Position of the value in _data, _npos for an empty slot
+    std::vector<size_t> _slotHashes{};
+    Hash _hasher{};
+
+    /**
+     * Find the position of the given key in the data array
+     * \param key Key to look for
+     * \param hash Hash of the key
+     * \return Return the position, or _npos if not found
+     */
+    template <typename K>
+    uint32_t findPosition(const K& key, size_t hash) const
+    {
+        if (_slotPositions.empty())
+            return _npos;
+
+        const auto mask = _slotPositions.size() - 1;
+        for (auto slot = hash & mask;; slot = (slot + 1) & mask)
+        {
+            const auto position = _slotPositions[slot];
+            if (position == _npos)
+                return _npos;
+            if (_slotHashes[slot] == hash && _data[position] == key)
+                return position;
+        }
+    }
+
+    /**
+     * Add the given position to the index, which must be large enough
+     * \param hash Hash of the value at the given position
+     * \param position Position in the data array
+     */
+    void indexPosition(size_t hash, uint32_t position)
+    {
+        const auto mask = _slotPositions.size() - 1;
+        auto slot = hash & mask;
+        while (_slotPositions[slot] != _npos)
+            slot = (slot + 1) & mask;
+        _slotPositions[slot] = position;
+        _slotHashes[slot] = hash;
+    }
+
+    /**
+     * Remove the given position from the index, and shift the following positions
+     * to match the data array once the value has been erased from it
+     * \param position Position in the data array
+     */
+    void unindexPosition(uint32_t position)
+    {
+        const auto mask = _slotPositions.size() - 1;
+        auto hole = _hasher(_data[position]) & mask;
+        while (_slotPositions[hole] != position)
+            hole = (hole + 1) & mask;
+
+        // Backward shift deletion: move back the following entries of the probe sequence
+        // which would not be reachable anymore once the hole is emptied
+        for (auto slot = (hole + 1) & mask; _slotPositions[slot] != _npos; slot = (slot + 1) & mask)
+        {
+            const auto ideal = _slotHashes[slot] & mask;
+            if (((slot - ideal) & mask) >= ((slot - hole) & mask))
+            {
+                _slotPositions[hole] = _slotPositions[slot];
+                _slotHashes[hole] = _slotHashes[slot];
+                hole = slot;
+            }
+        }
+        _slotPositions[hole] = _npos;
+
+        // Written without branches so that it gets vectorized
+        for (auto& slotPosition : _slotPositions)
+            slotPosition -= static_cast<uint32_t>(slotPosition > position && slotPosition != _npos);
+    }
+
+    /**
+     * Grow the index if needed to hold the given number of values
+     * \param count Value count
+     */
+    void reserveIndex(size_t count)
+    {
+        if (count * 2 <= _slotPositions.size())
+            return;
+
+        auto indexSize = std::max(_minIndexSize, _slotPositions.size());
+        while (indexSize < count * 2)
+            indexSize *= 2;
+
+        auto slotPositions = std::vector<uint32_t>(indexSize, _npos);
+        auto slotHashes = std::vector<size_t>(indexSize, 0);
+        std::swap(slotPositions, _slotPositions);
+        std::swap(slotHashes, _slotHashes);
+        for (size_t slot = 0; slot < slotPositions.size(); ++slot)
+            if (slotPositions[slot] != _npos)
+                indexPosition(slotHashes[slot], slotPositions[slot]);
+    }
+
+    /**
+     * Rebuild the index from the data array
+     * \param indexSize Index size, must be a power of two
+     */
+    void rebuildIndex(size_t indexSize)
+    {
+        _slotPositions.assign(std::max(_minIndexSize, indexSize), _npos);
+        _slotHashes.assign(_slotPositions.size(), 0);
+        for (size_t position = 0; position < _data.size(); ++position)
+            indexPosition(_hasher(_data[position]), static_cast<uint32_t>(position));
+    }
 };
 
 } // namespace Splash
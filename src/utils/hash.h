@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2026 Splash authors
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @hash.h
+ * Fast non-cryptographic hash of memory buffers, used to detect identical contents
+ *
+ * This is an implementation of XXH64 (https://github.com/Cyan4973/xxHash), which gives
+ * the same results as the reference one. Large buffers are processed as four independent
+ * lanes, which keeps the pipeline of the CPU full and reaches the memory bandwidth.
+ */
+
+#ifndef SPLASH_HASH_H
+#define SPLASH_HASH_H
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+namespace Splash::Hash
+{
+
+namespace detail
+{
+constexpr uint64_t prime1 = 0x9E3779B185EBCA87ull;
+constexpr uint64_t prime2 = 0xC2B2AE3D27D4EB4Full;
+constexpr uint64_t prime3 = 0x165667B19E3779F9ull;
+constexpr uint64_t prime4 = 0x85EBCA77C2B2AE63ull;
+constexpr uint64_t prime5 = 0x27D4EB2F165667C5ull;
+
+static_assert(std::endian::native == std::endian::little, "XXH64 reads its input as little endian");
+
+template <typename T>
+inline T read(const uint8_t* data)
+{
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+inline uint64_t round(uint64_t accumulator, uint64_t input)
+{
+    accumulator += input * prime2;
+    accumulator = std::rotl(accumulator, 31);
+    return accumulator * prime1;
+}
+
+inline uint64_t mergeRound(uint64_t accumulator, uint64_t value)
+{
+    accumulator ^= round(0, value);
+    return accumulator * prime1 + prime4;
+}
+} // namespace detail
+
+/**
+ * Compute the XXH64 hash of a buffer
+ * \param buffer Buffer to hash
+ * \param seed Hash seed
+ * \return Return the hash
+ */
+inline uint64_t xxh64(std::span<const uint8_t> buffer, uint64_t seed = 0)
+{
+    using namespace detail;
+
+    auto data = buffer.data();
+    const auto end = data + buffer.size();
+    uint64_t hash;
+
+    if (buffer.size() >= 32)
+    {
+        uint64_t v1 = seed + prime1 + prime2;
+        uint64_t v2 = seed + prime2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - prime1;
+
+        const auto limit = end - 32;
+        do
+        {
+            v1 = round(v1, read<uint64_t>(data));
+            v2 = round(v2, read<uint64_t>(data + 8));
+            v3 = round(v3, read<uint64_t>(data + 16));
+            v4 = round(v4, read<uint64_t>(data + 24));
+            data += 32;
+        } while (data <= limit);
+
+        hash = std::rotl(v1, 1) + std::rotl(v2, 7) + std::rotl(v3, 12) + std::rotl(v4, 18);
+        hash = mergeRound(hash, v1);
+        hash = mergeRound(hash, v2);
+        hash = mergeRound(hash, v3);
+        hash = mergeRound(hash, v4);
+    }
+    else
+    {
+        hash = seed + prime5;
+    }
+
+    hash += static_cast<uint64_t>(buffer.size());
+
+    for (; data + 8 <= end; data += 8)
+    {
+        hash ^= round(0, read<uint64_t>(data));
+        hash = std::rotl(hash, 27) * prime1 + prime4;
+    }
+
+    if (data + 4 <= end)
+    {
+        hash ^= static_cast<uint64_t>(read<uint32_t>(data)) * prime1;
+        hash = std::rotl(hash, 23) * prime2 + prime3;
+        data += 4;
+    }
+
+    for (; data < end; ++data)
+    {
+        hash ^= static_cast<uint64_t>(*data) * prime5;
+        hash = std::rotl(hash, 11) * prime1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= prime2;
+    hash ^= hash >> 29;
+    hash *= prime3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+} // namespace Splash::Hash
+
+#endif // SPLASH_HASH_H
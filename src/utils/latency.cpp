@@ -0,0 +1,98 @@
+#include "./utils/latency.h"
+
+#include <algorithm>
+
+#include "./utils/timer.h"
+
+namespace Splash
+{
+
+/*************/
+void LatencyTracker::record(const std::string& source, const std::string& stage, int64_t timestamp)
+{
+    if (timestamp < 0)
+        return;
+    recordLatency(source, stage, Timer::getTime() - timestamp);
+}
+
+/*************/
+void LatencyTracker::recordLatency(const std::string& source, const std::string& stage, int64_t latency)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto& samples = _samples[source][stage];
+    if (samples.values.size() < _sampleCount)
+    {
+        samples.values.push_back(latency);
+    }
+    else
+    {
+        samples.values[samples.next] = latency;
+        samples.next = (samples.next + 1) % _sampleCount;
+    }
+    ++samples.count;
+}
+
+/*************/
+void LatencyTracker::setUploaded(const std::string& source, int64_t timestamp)
+{
+    if (timestamp < 0)
+        return;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _uploaded[source] = timestamp;
+}
+
+/*************/
+void LatencyTracker::setDisplayed()
+{
+    auto uploaded = std::unordered_map<std::string, int64_t>();
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        std::swap(uploaded, _uploaded);
+    }
+
+    const auto now = Timer::getTime();
+    for (const auto& [source, timestamp] : uploaded)
+        recordLatency(source, STAGE_DISPLAY, now - timestamp);
+}
+
+/*************/
+std::map<std::string, std::map<std::string, LatencyTracker::Percentiles>> LatencyTracker::getPercentiles() const
+{
+    auto percentiles = std::map<std::string, std::map<std::string, Percentiles>>();
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (const auto& [source, stages] : _samples)
+    {
+        for (const auto& [stage, samples] : stages)
+        {
+            if (samples.values.empty())
+                continue;
+
+            auto values = samples.values;
+            const auto getPercentile = [&](float percentile) {
+                const auto index = std::min(values.size() - 1, static_cast<size_t>(percentile * static_cast<float>(values.size())));
+                std::nth_element(values.begin(), values.begin() + index, values.end());
+                return static_cast<float>(values[index]) / 1e3f;
+            };
+
+            auto& result = percentiles[source][stage];
+            result.p50 = getPercentile(0.50f);
+            result.p95 = getPercentile(0.95f);
+            result.p99 = getPercentile(0.99f);
+            result.count = samples.count;
+        }
+    }
+
+    return percentiles;
+}
+
+/*************/
+void LatencyTracker::clear()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _samples.clear();
+    _uploaded.clear();
+}
+
+} // namespace Splash
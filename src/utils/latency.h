@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2026 Splash authors
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @latency.h
+ * The LatencyTracker class, measuring the latency of the frames along the pipeline
+ *
+ * Each frame carries the timestamp set by its source, from the monotonic clock used by
+ * Timer::getTime. Each stage of the pipeline records the time elapsed since this timestamp,
+ * so that the latency is known from the source to the stage, and down to the display.
+ * As this clock is shared by all processes of the machine, so are the measurements.
+ */
+
+#ifndef SPLASH_LATENCY_H
+#define SPLASH_LATENCY_H
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Splash
+{
+
+class LatencyTracker
+{
+  public:
+    /**
+     * Pipeline stages, in the order in which frames go through them
+     */
+    static constexpr const char* STAGE_SERIALIZE{"serialize"};
+    static constexpr const char* STAGE_SEND{"send"}; // Measured from the buffer being given to the link, not from the source
+    static constexpr const char* STAGE_DESERIALIZE{"deserialize"};
+    static constexpr const char* STAGE_UPLOAD{"upload"};
+    static constexpr const char* STAGE_DISPLAY{"display"};
+
+    struct Percentiles
+    {
+        float p50{0.f}; // in ms
+        float p95{0.f}; // in ms
+        float p99{0.f}; // in ms
+        uint64_t count{0};
+    };
+
+  public:
+    /**
+     * Get the singleton
+     * \return Return the LatencyTracker singleton
+     */
+    static LatencyTracker& get()
+    {
+        static auto instance = new LatencyTracker;
+        return *instance;
+    }
+
+    /**
+     * Record the latency of a frame at the given stage
+     * \param source Name of the frame source
+     * \param stage Pipeline stage
+     * \param timestamp Timestamp set by the source, in us. Ignored if negative.
+     */
+    void record(const std::string& source, const std::string& stage, int64_t timestamp);
+
+    /**
+     * Record a latency measurement at the given stage
+     * \param source Name of the frame source
+     * \param stage Pipeline stage
+     * \param latency Latency, in us
+     */
+    void recordLatency(const std::string& source, const std::string& stage, int64_t latency);
+
+    /**
+     * Register a frame as uploaded, waiting to be displayed
+     * \param source Name of the frame source
+     * \param timestamp Timestamp set by the source, in us. Ignored if negative.
+     */
+    void setUploaded(const std::string& source, int64_t timestamp);
+
+    /**
+     * Record the display latency of all the frames uploaded since the last call
+     * To be called once the buffers have been swapped
+     */
+    void setDisplayed();
+
+    /**
+     * Get the latency percentiles over the last measurements
+     * \return Return the percentiles, for each source and each stage
+     */
+    std::map<std::string, std::map<std::string, Percentiles>> getPercentiles() const;
+
+    /**
+     * Clear all measurements
+     */
+    void clear();
+
+  private:
+    static constexpr size_t _sampleCount{512}; //!< Number of measurements kept for each source and stage
+
+    struct Samples
+    {
+        std::vector<int64_t> values{};
+        size_t next{0};
+        uint64_t count{0};
+    };
+
+    mutable std::mutex _mutex{};
+    std::unordered_map<std::string, std::unordered_map<std::string, Samples>> _samples{};
+    std::unordered_map<std::string, int64_t> _uploaded{}; //!< Timestamps of the frames uploaded but not yet displayed
+
+    LatencyTracker() = default;
+    ~LatencyTracker() = default;
+    LatencyTracker(const LatencyTracker&) = delete;
+    const LatencyTracker& operator=(const LatencyTracker&) = delete;
+};
+
+} // namespace Splash
+
+#endif // SPLASH_LATENCY_H
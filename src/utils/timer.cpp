@@ -0,0 +1,284 @@
+#include "./utils/timer.h"
+
+#include <algorithm>
+#include <ctime>
+#include <numeric>
+
+#include "./utils/trace_recorder.h"
+
+namespace Splash
+{
+
+/*************/
+Timer::ThreadTimers* Timer::getThreadTimers()
+{
+    // The measurements are kept until merged, even if the thread ends
+    struct ThreadTimersHolder
+    {
+        std::shared_ptr<ThreadTimers> timers{nullptr};
+        ~ThreadTimersHolder()
+        {
+            if (timers)
+                timers->alive = false;
+        }
+    };
+    thread_local ThreadTimersHolder holder;
+
+    if (!holder.timers)
+    {
+        holder.timers = std::make_shared<ThreadTimers>();
+        std::lock_guard<Spinlock> lock(_threadsMutex);
+        _threads.push_back(holder.timers);
+    }
+
+    return holder.timers.get();
+}
+
+/*************/
+void Timer::registerName(ThreadTimers* threadTimers, const Scope& scope)
+{
+    if (!threadTimers->knownIds.insert(scope.getId()).second)
+        return;
+
+    std::lock_guard<std::mutex> lock(_namesMutex);
+    if (_names.find(scope.getId()) == _names.end())
+        _names.emplace(scope.getId(), std::make_unique<std::string>(scope.getName()));
+}
+
+/*************/
+Timer::Scope Timer::registerScope(const std::string& name)
+{
+    const auto id = getId(name);
+    std::lock_guard<std::mutex> lock(_namesMutex);
+    auto nameIt = _names.find(id);
+    if (nameIt == _names.end())
+        nameIt = _names.emplace(id, std::make_unique<std::string>(name)).first;
+    return Scope(*nameIt->second);
+}
+
+/*************/
+void Timer::start(const Scope& scope)
+{
+    if (!_enabled)
+        return;
+
+    auto threadTimers = getThreadTimers();
+    registerName(threadTimers, scope);
+
+    const auto currentTime = getTime();
+    std::lock_guard<Spinlock> lock(threadTimers->mutex);
+    threadTimers->starts[scope.getId()] = currentTime;
+}
+
+/*************/
+std::optional<uint64_t> Timer::stop(const Scope& scope, uint64_t minDuration)
+{
+    if (!_enabled)
+        return {};
+
+    const auto currentTime = getTime();
+    const auto id = scope.getId();
+    auto threadTimers = getThreadTimers();
+
+    // Starts are erased once their scope closes, so that the maps do not grow with every name ever used
+    std::optional<int64_t> startTime;
+    {
+        std::lock_guard<Spinlock> lock(threadTimers->mutex);
+        if (auto startIt = threadTimers->starts.find(id); startIt != threadTimers->starts.end())
+        {
+            startTime = startIt->second;
+            threadTimers->starts.erase(startIt);
+        }
+    }
+
+    // Slow path, for timers started from another thread
+    if (!startTime)
+    {
+        std::lock_guard<Spinlock> lockThreads(_threadsMutex);
+        for (const auto& otherTimers : _threads)
+        {
+            std::lock_guard<Spinlock> lock(otherTimers->mutex);
+            if (auto startIt = otherTimers->starts.find(id); startIt != otherTimers->starts.end())
+            {
+                startTime = startIt->second;
+                otherTimers->starts.erase(startIt);
+                break;
+            }
+        }
+    }
+
+    if (!startTime)
+        return {};
+
+    const auto elapsed = static_cast<uint64_t>(currentTime - startTime.value());
+    const auto duration = std::max(elapsed, minDuration);
+    {
+        std::lock_guard<Spinlock> lock(threadTimers->mutex);
+        threadTimers->samples.emplace_back(id, duration);
+        threadTimers->pending.store(true, std::memory_order_release);
+    }
+
+    auto& traceRecorder = TraceRecorder::get();
+    if (traceRecorder.isRecording())
+        traceRecorder.addEvent(std::string(scope.getName()), startTime.value(), elapsed);
+
+    return elapsed;
+}
+
+/*************/
+bool Timer::waitUntilDuration(const Scope& scope, unsigned long long duration)
+{
+    const auto elapsed = stop(scope, duration);
+    if (!elapsed)
+        return false;
+
+    if (elapsed.value() >= duration)
+        return true;
+
+    timespec nap;
+    nap.tv_sec = 0;
+    nap.tv_nsec = (duration - elapsed.value()) * 1e3;
+    nanosleep(&nap, NULL);
+
+    return false;
+}
+
+/*************/
+void Timer::addMeasurement(Id id, uint64_t duration)
+{
+    auto& measurements = _measurements[id];
+    if (measurements.window.size() < _statisticsWindow)
+    {
+        measurements.window.push_back(duration);
+    }
+    else
+    {
+        measurements.window[measurements.next] = duration;
+        measurements.next = (measurements.next + 1) % _statisticsWindow;
+    }
+    measurements.last = duration;
+    ++measurements.count;
+}
+
+/*************/
+void Timer::merge()
+{
+    std::vector<std::shared_ptr<ThreadTimers>> threads;
+    {
+        std::lock_guard<Spinlock> lock(_threadsMutex);
+        threads = _threads;
+    }
+
+    std::vector<std::pair<Id, uint64_t>> samples;
+    std::lock_guard<std::mutex> lockMeasurements(_measurementsMutex);
+    for (const auto& threadTimers : threads)
+    {
+        {
+            std::lock_guard<Spinlock> lock(threadTimers->mutex);
+            std::swap(samples, threadTimers->samples);
+            threadTimers->pending.store(false, std::memory_order_relaxed);
+        }
+
+        for (const auto& [id, duration] : samples)
+            addMeasurement(id, duration);
+        samples.clear();
+    }
+
+    // Measurements from ended threads have been merged, their buffers can go
+    std::lock_guard<Spinlock> lock(_threadsMutex);
+    _threads.erase(std::remove_if(_threads.begin(), _threads.end(), [](const auto& threadTimers) { return !threadTimers->alive; }), _threads.end());
+}
+
+/*************/
+void Timer::mergeIfPending()
+{
+    {
+        std::lock_guard<Spinlock> lock(_threadsMutex);
+        if (std::none_of(_threads.cbegin(), _threads.cend(), [](const auto& threadTimers) {
+                return threadTimers->pending.load(std::memory_order_acquire) || !threadTimers->alive;
+            }))
+            return;
+    }
+    merge();
+}
+
+/*************/
+unsigned long long Timer::getDuration(const Scope& scope)
+{
+    mergeIfPending();
+    std::lock_guard<std::mutex> lock(_measurementsMutex);
+    const auto measurementsIt = _measurements.find(scope.getId());
+    if (measurementsIt == _measurements.end())
+        return 0;
+    return measurementsIt->second.last;
+}
+
+/*************/
+const DenseMap<std::string, uint64_t> Timer::getDurationMap()
+{
+    mergeIfPending();
+
+    DenseMap<std::string, uint64_t> durationMap;
+    std::lock_guard<std::mutex> lockNames(_namesMutex);
+    std::lock_guard<std::mutex> lock(_measurementsMutex);
+    for (const auto& [id, measurements] : _measurements)
+    {
+        const auto nameIt = _names.find(id);
+        if (nameIt == _names.end())
+            continue;
+        durationMap[*nameIt->second] = measurements.last;
+    }
+
+    return durationMap;
+}
+
+/*************/
+const DenseMap<std::string, Timer::Statistics> Timer::getStatistics()
+{
+    mergeIfPending();
+
+    DenseMap<std::string, Statistics> statistics;
+    std::lock_guard<std::mutex> lockNames(_namesMutex);
+    std::lock_guard<std::mutex> lock(_measurementsMutex);
+    for (const auto& [id, measurements] : _measurements)
+    {
+        const auto nameIt = _names.find(id);
+        if (nameIt == _names.end() || measurements.window.empty())
+            continue;
+
+        auto values = measurements.window;
+        std::sort(values.begin(), values.end());
+        const auto getPercentile = [&](float percentile) { return values[std::min(values.size() - 1, static_cast<size_t>(percentile * static_cast<float>(values.size())))]; };
+
+        Statistics stats;
+        stats.last = measurements.last;
+        stats.min = values.front();
+        stats.max = values.back();
+        stats.average = std::accumulate(values.begin(), values.end(), uint64_t(0)) / values.size();
+        stats.p95 = getPercentile(0.95f);
+        stats.p99 = getPercentile(0.99f);
+        stats.count = measurements.count;
+        statistics[*nameIt->second] = stats;
+    }
+
+    return statistics;
+}
+
+/*************/
+void Timer::setDuration(const std::string& name, unsigned long long value)
+{
+    const auto scope = registerScope(name);
+    std::lock_guard<std::mutex> lock(_measurementsMutex);
+    addMeasurement(scope.getId(), value);
+}
+
+/*************/
+unsigned long long Timer::sinceLastSeen(const std::string& name)
+{
+    const auto scope = Scope(name);
+    const auto duration = stop(scope);
+    start(scope);
+    return duration.value_or(0);
+}
+
+} // namespace Splash
@@ -20,15 +20,25 @@
 /*
  * @timer.h
  * The Timer class
+ *
+ * Durations are identified by the hash of their name, and measured in per-thread
+ * buffers which are merged when the durations are read, usually once per frame.
  */
 
 #ifndef SPLASH_TIMER_H
 #define SPLASH_TIMER_H
 
+#include <atomic>
 #include <chrono>
+#include <memory>
 #include <mutex>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include "./core/constants.h"
 #include "./core/spinlock.h"
@@ -40,6 +50,58 @@ namespace Splash
 class Timer
 {
   public:
+    using Id = uint64_t;
+
+    /**
+     * Compute the id of a timer from its name, at compile time if possible
+     * \param name Timer name
+     * \return Return the timer id
+     */
+    static constexpr Id getId(std::string_view name)
+    {
+        // FNV-1a hash
+        Id hash = 14695981039346656037ull;
+        for (const auto c : name)
+        {
+            hash ^= static_cast<uint8_t>(c);
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    /**
+     * Timer scope, holding the timer name and its id. For names known at compile time, use:
+     * static constexpr Timer::Scope scope("name");
+     * For names known at runtime, use Timer::registerScope to get a Scope which can be kept.
+     */
+    class Scope
+    {
+      public:
+        constexpr explicit Scope(std::string_view name)
+            : _name(name)
+            , _id(Timer::getId(name))
+        {
+        }
+
+        constexpr Id getId() const { return _id; }
+        constexpr std::string_view getName() const { return _name; }
+
+      private:
+        std::string_view _name;
+        Id _id;
+    };
+
+    struct Statistics
+    {
+        uint64_t last{0};    // in us
+        uint64_t min{0};     // in us
+        uint64_t average{0}; // in us
+        uint64_t max{0};     // in us
+        uint64_t p95{0};     // in us
+        uint64_t p99{0};     // in us
+        uint64_t count{0};
+    };
+
     struct Point
     {
         uint32_t years{0};
@@ -114,150 +176,90 @@ class Timer
      * \param duration Desired duration
      * \return Return false if the timer does not exist
      */
-    bool waitUntilDuration(const std::string& name, unsigned long long duration)
-    {
-        std::unique_lock<Spinlock> lock(_timerMutex);
-        if (!_enabled)
-            return false;
-
-        if (_timeMap.find(name) == _timeMap.end())
-            return false;
-
-        auto currentTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
-        auto timeIt = _timeMap.find(name);
-        auto durationIt = _durationMap.find(name);
-        unsigned long long elapsed;
-
-        elapsed = currentTime - timeIt->second;
-
-        timespec nap;
-        nap.tv_sec = 0;
-        bool overtime = false;
-        if (elapsed < duration)
-            nap.tv_nsec = (duration - elapsed) * 1e3;
-        else
-        {
-            nap.tv_nsec = 0;
-            overtime = true;
-        }
-
-        if (durationIt == _durationMap.end())
-            _durationMap[name] = std::max(duration, elapsed);
-        else
-            durationIt->second = std::max(duration, elapsed);
-        lock.unlock();
-
-        nanosleep(&nap, NULL);
-
-        return overtime;
-    }
+    bool waitUntilDuration(const Scope& scope, unsigned long long duration);
+    bool waitUntilDuration(const std::string& name, unsigned long long duration) { return waitUntilDuration(Scope(name), duration); }
 
     /**
      * Get the last occurence of the specified duration
      * \param name Duration name
      * \return Return the duration in us
      */
-    unsigned long long getDuration(const std::string& name) const
-    {
-        std::lock_guard<Spinlock> lock(_timerMutex);
-        auto durationIt = _durationMap.find(name);
-        if (durationIt == _durationMap.end())
-            return 0;
-        return durationIt->second;
-    }
+    unsigned long long getDuration(const Scope& scope);
+    unsigned long long getDuration(const std::string& name) { return getDuration(Scope(name)); }
 
     /**
      * Get the whole duration map
      * \return Return the whole duration map
      */
-    const DenseMap<std::string, uint64_t> getDurationMap() const
-    {
-        std::lock_guard<Spinlock> lock(_timerMutex);
-        return _durationMap;
-    }
+    const DenseMap<std::string, uint64_t> getDurationMap();
+
+    /**
+     * Get the statistics over the last measurements of all durations
+     * \return Return the statistics for each duration name
+     */
+    const DenseMap<std::string, Statistics> getStatistics();
 
     /**
      * Set an element in the duration map. Used for transmitting timings between pairs
      * \param name Duration name
      * \param value Duration in us
      */
-    void setDuration(const std::string& name, unsigned long long value)
-    {
-        std::lock_guard<Spinlock> lock(_timerMutex);
-        auto durationIt = _durationMap.find(name);
-        if (durationIt == _durationMap.end())
-            _durationMap[name] = value;
-        else
-            durationIt->second = value;
-    }
+    void setDuration(const std::string& name, unsigned long long value);
 
     /**
      * Return the duration since the last call with this name, or 0 if it is the first time.
      * \param name Duration name
      * \return Return the duration
      */
-    unsigned long long sinceLastSeen(const std::string& name)
-    {
-        std::lock_guard<Spinlock> lock(_timerMutex);
-        if (_timeMap.find(name) == _timeMap.end())
-        {
-            start(name);
-            return 0;
-        }
+    unsigned long long sinceLastSeen(const std::string& name);
 
-        stop(name);
-        unsigned long long duration = getDuration(name);
-        start(name);
-        return duration;
-    }
+    /**
+     * Register a timer name which is only known at runtime, to get a Scope
+     * for it. The returned Scope stays valid for the lifetime of the program.
+     * \param name Duration name
+     * \return Return a Scope for this name
+     */
+    Scope registerScope(const std::string& name);
+
+    /**
+     * Merge the durations measured by all threads since the last call.
+     * The getters only merge when some thread measured new durations.
+     */
+    void merge();
 
     /**
      * Some facilities
      */
-    Timer& operator<<(const std::string& name)
+    Timer& operator<<(const Scope& scope)
     {
-        std::lock_guard<Spinlock> lock(_timerMutex);
-        start(name);
-        _currentDuration = 0;
+        start(scope);
         return *this;
     }
+    Timer& operator<<(const char* name) { return operator<<(Scope(name)); }
+    Timer& operator<<(const std::string& name) { return operator<<(Scope(name)); }
 
     Timer& operator>>(unsigned long long duration)
     {
-        std::lock_guard<Spinlock> lock(_timerMutex);
-        _setTimerMutex.lock(); // We lock the mutex to prevent this value to be reset by another call to timer
-        _currentDuration = duration;
-        _durationThreadId = std::this_thread::get_id();
-        _isDurationSet = true;
+        getThreadTimers()->waitDuration = duration;
         return *this;
     }
 
-    bool operator>>(const std::string& name)
+    bool operator>>(const Scope& scope)
     {
-        std::unique_lock<Spinlock> lock(_timerMutex);
-        unsigned long long duration = 0;
-        if (_isDurationSet && _durationThreadId == std::this_thread::get_id())
-        {
-            _isDurationSet = false;
-            duration = _currentDuration;
-            _currentDuration = 0;
-            _setTimerMutex.unlock();
-        }
-        lock.unlock();
+        auto threadTimers = getThreadTimers();
+        const auto duration = threadTimers->waitDuration;
+        threadTimers->waitDuration = 0;
 
-        bool overtime = false;
         if (duration > 0)
-            overtime = waitUntilDuration(name, duration);
-        else
-            stop(name);
-        return overtime;
-    }
+            return waitUntilDuration(scope, duration);
 
-    unsigned long long operator[](const std::string& name)
-    {
-        std::lock_guard<Spinlock> lock(_timerMutex);
-        return getDuration(name);
+        stop(scope);
+        return false;
     }
+    bool operator>>(const char* name) { return operator>>(Scope(name)); }
+    bool operator>>(const std::string& name) { return operator>>(Scope(name)); }
+
+    unsigned long long operator[](const std::string& name) { return getDuration(name); }
 
     /**
      * Enable / disable the timers
@@ -358,59 +360,85 @@ class Timer
     const Timer& operator=(const Timer&) = delete;
 
   private:
-    DenseMap<std::string, uint64_t> _timeMap;
-    DenseMap<std::string, uint64_t> _durationMap;
-    uint64_t _currentDuration{0};
-    bool _isDurationSet{false};
-    std::thread::id _durationThreadId;
-    mutable Spinlock _timerMutex;
-    mutable Spinlock _setTimerMutex;
-    mutable Spinlock _clockMutex;
-    bool _enabled{true};
+    static constexpr size_t _statisticsWindow{256}; //!< Number of measurements kept for the statistics
+
+    // Measurements of a single thread, only locked when merging or when a timer is stopped from another thread
+    struct ThreadTimers
+    {
+        Spinlock mutex{};
+        DenseMap<Id, int64_t> starts{};
+        std::vector<std::pair<Id, uint64_t>> samples{}; //!< Durations measured since the last merge
+        std::unordered_set<Id> knownIds{};              //!< Ids which name is already registered, only used by the owning thread
+        uint64_t waitDuration{0};                       //!< Duration set by operator>>(unsigned long long), for the next stop
+        std::atomic_bool pending{false};                //!< True if samples are waiting to be merged, checked without locking
+        std::atomic_bool alive{true};
+    };
+
+    // Merged measurements for a single duration
+    struct Measurements
+    {
+        std::vector<uint64_t> window{};
+        size_t next{0};
+        uint64_t last{0};
+        uint64_t count{0};
+    };
+
+    std::atomic_bool _enabled{true};
     bool _isDebug{false};
     bool _looseClock{false};
+
+    Spinlock _threadsMutex{};
+    std::vector<std::shared_ptr<ThreadTimers>> _threads{};
+
+    std::mutex _namesMutex{};
+    std::unordered_map<Id, std::unique_ptr<std::string>> _names{}; //!< Names are stored behind a pointer for the Scopes to stay valid
+
+    std::mutex _measurementsMutex{};
+    std::unordered_map<Id, Measurements> _measurements{};
+
+    mutable Spinlock _clockMutex;
     std::chrono::microseconds _lastMasterClockUpdate{};
     Timer::Point _clock;
     bool _clockSet{false};
 
     /**
-     * Start a duration measurement
-     * \param name Duration name
+     * Get the measurements for the current thread
+     * \return Return the thread timers
      */
-    void start(const std::string& name)
-    {
-        if (!_enabled)
-            return;
+    ThreadTimers* getThreadTimers();
 
-        auto currentTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
-        auto timeIt = _timeMap.find(name);
-        if (timeIt == _timeMap.end())
-            _timeMap[name] = currentTime;
-        else
-            timeIt->second = currentTime;
-    }
+    /**
+     * Register the name for the given scope, if not already done by this thread
+     * \param threadTimers Current thread timers
+     * \param scope Timer scope
+     */
+    void registerName(ThreadTimers* threadTimers, const Scope& scope);
 
     /**
-     * End a duration measurement
-     * \param name Duration name
+     * Merge the durations if some thread measured new ones, or has ended and its buffer can be released
      */
-    void stop(const std::string& name)
-    {
-        if (!_enabled)
-            return;
+    void mergeIfPending();
 
-        auto timeIt = _timeMap.find(name);
-        if (timeIt != _timeMap.end())
-        {
-            auto currentTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    /**
+     * Add a measurement to the merged ones
+     * \param id Timer id
+     * \param duration Duration in us
+     */
+    void addMeasurement(Id id, uint64_t duration);
 
-            auto durationIt = _durationMap.find(name);
-            if (durationIt == _durationMap.end())
-                _durationMap[name] = currentTime - timeIt->second;
-            else
-                durationIt->second = currentTime - timeIt->second;
-        }
-    }
+    /**
+     * Start a duration measurement
+     * \param scope Timer scope
+     */
+    void start(const Scope& scope);
+
+    /**
+     * End a duration measurement
+     * \param scope Timer scope
+     * \param minDuration Minimum duration to record, in us
+     * \return Return the measured duration, or nothing if the timer was not started
+     */
+    std::optional<uint64_t> stop(const Scope& scope, uint64_t minDuration = 0);
 };
 
 } // namespace Splash
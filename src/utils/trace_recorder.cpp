@@ -0,0 +1,235 @@
+#include "./utils/trace_recorder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <thread>
+#include <unistd.h>
+
+#include <json/json.h>
+
+#include "./utils/log.h"
+#include "./utils/timer.h"
+
+namespace Splash
+{
+
+/*************/
+TraceRecorder::ThreadBuffer* TraceRecorder::getThreadBuffer()
+{
+    // The buffer is given back when the thread ends
+    struct BufferHolder
+    {
+        ThreadBuffer* buffer{nullptr};
+        ~BufferHolder()
+        {
+            if (buffer)
+                buffer->inUse = false;
+        }
+    };
+    thread_local BufferHolder holder;
+
+    if (holder.buffer)
+        return holder.buffer;
+
+    std::lock_guard<std::mutex> lock(_buffersMutex);
+    for (auto& buffer : _buffers)
+    {
+        if (!buffer->inUse)
+        {
+            buffer->inUse = true;
+            holder.buffer = buffer.get();
+            return holder.buffer;
+        }
+    }
+
+    auto buffer = std::make_unique<ThreadBuffer>();
+    buffer->id = static_cast<uint32_t>(_buffers.size()) + 1; // Id 0 is the GPU track
+    buffer->inUse = true;
+    holder.buffer = buffer.get();
+    _buffers.push_back(std::move(buffer));
+    return holder.buffer;
+}
+
+/*************/
+uint32_t TraceRecorder::getNameId(const std::string& name)
+{
+    thread_local std::unordered_map<std::string, uint32_t> nameIds;
+    if (const auto nameIt = nameIds.find(name); nameIt != nameIds.end())
+        return nameIt->second;
+
+    std::lock_guard<std::mutex> lock(_namesMutex);
+    auto nameIt = _nameIds.find(name);
+    if (nameIt == _nameIds.end())
+    {
+        nameIt = _nameIds.emplace(name, static_cast<uint32_t>(_names.size())).first;
+        _names.push_back(name);
+    }
+    nameIds[name] = nameIt->second;
+    return nameIt->second;
+}
+
+/*************/
+void TraceRecorder::addEvent(const std::string& name, int64_t start, int64_t duration, Track track)
+{
+    if (!isRecording())
+        return;
+
+    auto buffer = getThreadBuffer();
+    const auto nameId = getNameId(name);
+    const auto index = buffer->writeIndex.load(std::memory_order_relaxed);
+    auto& event = buffer->events[index % _bufferCapacity];
+    event.start.store(start, std::memory_order_relaxed);
+    event.duration.store(duration, std::memory_order_relaxed);
+    event.name.store(nameId, std::memory_order_relaxed);
+    event.track.store(static_cast<uint32_t>(track), std::memory_order_relaxed);
+    buffer->writeIndex.store(index + 1, std::memory_order_release);
+}
+
+/*************/
+bool TraceRecorder::start()
+{
+    std::lock_guard<std::mutex> lock(_recordingMutex);
+    return startRecording();
+}
+
+/*************/
+bool TraceRecorder::startRecording()
+{
+    // The previous recording must be written before its start and end times are overwritten
+    if (_recordingFuture.valid() && _recordingFuture.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        return false;
+
+    if (_recording.exchange(true))
+        return false;
+
+    _recordingStart = Timer::getTime();
+    _recordingEnd = std::numeric_limits<int64_t>::max();
+    return true;
+}
+
+/*************/
+void TraceRecorder::stop()
+{
+    _recordingEnd = Timer::getTime();
+    _recording = false;
+}
+
+/*************/
+bool TraceRecorder::record(float seconds, const std::string& filename, const std::string& processName)
+{
+    std::lock_guard<std::mutex> lock(_recordingMutex);
+    if (!startRecording())
+    {
+        Log::get() << Log::WARNING << "TraceRecorder::" << __FUNCTION__ << " - A trace is already being recorded or written" << Log::endl;
+        return false;
+    }
+
+    // Each process writes its own file
+    auto path = std::filesystem::path(filename);
+    path.replace_filename(path.stem().string() + "_" + processName + path.extension().string());
+
+    _recordingFuture = std::async(std::launch::async, [=, this]() {
+        std::this_thread::sleep_for(std::chrono::microseconds(static_cast<int64_t>(seconds * 1e6)));
+        stop();
+
+        std::ofstream out(path, std::ios::binary);
+        if (!out.is_open())
+        {
+            Log::get() << Log::WARNING << "TraceRecorder::" << __FUNCTION__ << " - Could not open file " << path.string() << Log::endl;
+            return;
+        }
+        out << getChromeTrace(processName);
+        Log::get() << Log::MESSAGE << "TraceRecorder::" << __FUNCTION__ << " - Trace written to " << path.string() << Log::endl;
+    });
+
+    return true;
+}
+
+/*************/
+std::string TraceRecorder::getChromeTrace(const std::string& processName) const
+{
+    const auto pid = static_cast<Json::Int>(getpid());
+    const auto recordingStart = _recordingStart.load();
+    const auto recordingEnd = _recordingEnd.load();
+
+    Json::Value root;
+    auto& traceEvents = root["traceEvents"];
+    traceEvents = Json::Value(Json::arrayValue);
+
+    const auto addMetadata = [&](const std::string& type, Json::UInt tid, const std::string& name) {
+        Json::Value metadata;
+        metadata["name"] = type;
+        metadata["ph"] = "M";
+        metadata["pid"] = pid;
+        metadata["tid"] = tid;
+        metadata["args"]["name"] = name;
+        traceEvents.append(metadata);
+    };
+    addMetadata("process_name", 0, processName);
+    addMetadata("thread_name", 0, "GPU");
+
+    std::vector<std::string> names;
+    {
+        std::lock_guard<std::mutex> lock(_namesMutex);
+        names = _names;
+    }
+
+    std::lock_guard<std::mutex> lock(_buffersMutex);
+    for (const auto& buffer : _buffers)
+    {
+        addMetadata("thread_name", buffer->id, "Thread " + std::to_string(buffer->id));
+
+        // Events may be overwritten while being read, if the recording is still ongoing.
+        // The ones which could have been are discarded.
+        const auto end = buffer->writeIndex.load(std::memory_order_acquire);
+        const auto begin = end > _bufferCapacity ? end - _bufferCapacity : 0;
+
+        struct EventCopy
+        {
+            int64_t start, duration;
+            uint32_t name, track;
+        };
+        std::vector<EventCopy> events;
+        events.reserve(end - begin);
+        for (auto index = begin; index < end; ++index)
+        {
+            const auto& event = buffer->events[index % _bufferCapacity];
+            events.push_back({event.start.load(std::memory_order_relaxed),
+                event.duration.load(std::memory_order_relaxed),
+                event.name.load(std::memory_order_relaxed),
+                event.track.load(std::memory_order_relaxed)});
+        }
+
+        const auto newEnd = buffer->writeIndex.load(std::memory_order_acquire);
+        const auto validBegin = newEnd >= _bufferCapacity ? newEnd - _bufferCapacity + 1 : 0;
+
+        for (auto index = std::max(begin, validBegin); index < end; ++index)
+        {
+            const auto& event = events[index - begin];
+            if (event.start < recordingStart || event.start > recordingEnd || event.name >= names.size())
+                continue;
+
+            const auto isGpu = event.track == static_cast<uint32_t>(Track::GPU);
+            Json::Value jsonEvent;
+            jsonEvent["name"] = names[event.name];
+            jsonEvent["cat"] = isGpu ? "gpu" : "cpu";
+            jsonEvent["ph"] = "X";
+            jsonEvent["ts"] = static_cast<Json::Int64>(event.start);
+            jsonEvent["dur"] = static_cast<Json::Int64>(event.duration);
+            jsonEvent["pid"] = pid;
+            jsonEvent["tid"] = isGpu ? 0 : buffer->id;
+            traceEvents.append(jsonEvent);
+        }
+    }
+
+    root["displayTimeUnit"] = "ms";
+
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = "";
+    return Json::writeString(builder, root);
+}
+
+} // namespace Splash
@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 2026 Splash authors
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @trace_recorder.h
+ * The TraceRecorder class, recording the Timer and ProfilerGL scopes as a Chrome trace
+ *
+ * Each thread writes its events to its own ring buffer, without any lock, and only
+ * while a recording is ongoing. Once the recording duration is elapsed, the events are
+ * written as a Chrome trace Json file, which can be opened in chrome://tracing or Perfetto.
+ */
+
+#ifndef SPLASH_TRACE_RECORDER_H
+#define SPLASH_TRACE_RECORDER_H
+
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Splash
+{
+
+class TraceRecorder
+{
+  public:
+    enum class Track : uint32_t
+    {
+        CPU = 0, //!< Event on the thread which added it
+        GPU = 1  //!< Event on the GPU timeline
+    };
+
+  public:
+    /**
+     * Get the singleton
+     * \return Return the TraceRecorder singleton
+     */
+    static TraceRecorder& get()
+    {
+        static auto instance = new TraceRecorder;
+        return *instance;
+    }
+
+    /**
+     * Check whether a recording is ongoing
+     * \return Return true if events are being recorded
+     */
+    bool isRecording() const { return _recording.load(std::memory_order_relaxed); }
+
+    /**
+     * Add an event to the current thread buffer. Does nothing if not recording.
+     * \param name Event name
+     * \param start Start time, in us, from the Timer::getTime clock
+     * \param duration Duration, in us
+     * \param track Track to show the event on
+     */
+    void addEvent(const std::string& name, int64_t start, int64_t duration, Track track = Track::CPU);
+
+    /**
+     * Record the events for the given duration, then write them to a file
+     * \param seconds Recording duration
+     * \param filename Output file, in the Chrome trace Json format
+     * \param processName Name given to the process in the trace
+     * \return Return false if a recording is already ongoing, or if the previous one is still being written
+     */
+    bool record(float seconds, const std::string& filename, const std::string& processName);
+
+    /**
+     * Start recording, until stop is called
+     * \return Return false if a recording is already ongoing, or if the previous one is still being written
+     */
+    bool start();
+
+    /**
+     * Stop recording
+     */
+    void stop();
+
+    /**
+     * Get the events recorded during the last recording, as a Chrome trace
+     * \param processName Name given to the process in the trace
+     * \return Return the trace as a Json string
+     */
+    std::string getChromeTrace(const std::string& processName) const;
+
+  private:
+    static constexpr size_t _bufferCapacity{1 << 15}; //!< Maximum number of events kept per thread
+
+    // Events are made of atomics, so that they can be read while the ring buffer is written
+    struct Event
+    {
+        std::atomic<int64_t> start{0};
+        std::atomic<int64_t> duration{0};
+        std::atomic<uint32_t> name{0};
+        std::atomic<uint32_t> track{0};
+    };
+
+    // Each buffer has a single writer. A buffer is given back when its thread ends, to be reused by another one.
+    struct ThreadBuffer
+    {
+        uint32_t id{0};
+        std::unique_ptr<Event[]> events{std::make_unique<Event[]>(_bufferCapacity)};
+        std::atomic<uint64_t> writeIndex{0};
+        std::atomic_bool inUse{false};
+    };
+
+    std::atomic_bool _recording{false};
+    std::atomic<int64_t> _recordingStart{0};
+    std::atomic<int64_t> _recordingEnd{0};
+    std::mutex _recordingMutex{};
+    std::future<void> _recordingFuture{}; //!< Becomes ready once the recording is written to its file
+
+    mutable std::mutex _buffersMutex{};
+    std::vector<std::unique_ptr<ThreadBuffer>> _buffers{};
+
+    mutable std::mutex _namesMutex{};
+    std::unordered_map<std::string, uint32_t> _nameIds{};
+    std::vector<std::string> _names{};
+
+    TraceRecorder() = default;
+    ~TraceRecorder() = default;
+    TraceRecorder(const TraceRecorder&) = delete;
+    const TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+    /**
+     * Get the buffer for the current thread
+     * \return Return the buffer
+     */
+    ThreadBuffer* getThreadBuffer();
+
+    /**
+     * Get the id for an event name, to avoid storing strings in the buffers
+     * \param name Event name
+     * \return Return the id
+     */
+    uint32_t getNameId(const std::string& name);
+
+    /**
+     * Start recording, to be called with _recordingMutex locked
+     * \return Return false if a recording is already ongoing, or if the previous one is still being written
+     */
+    bool startRecording();
+};
+
+} // namespace Splash
+
+#endif // SPLASH_TRACE_RECORDER_H
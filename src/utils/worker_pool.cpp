@@ -0,0 +1,63 @@
+#include "./utils/worker_pool.h"
+
+#include <algorithm>
+
+namespace Splash
+{
+namespace Utils
+{
+
+/*************/
+WorkerPool::WorkerPool(size_t threadCount)
+{
+    threadCount = std::max<size_t>(threadCount, 1);
+    for (size_t i = 0; i < threadCount; ++i)
+        _threads.emplace_back([this]() { run(); });
+}
+
+/*************/
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+        _tasks.clear();
+    }
+    _condition.notify_all();
+
+    for (auto& thread : _threads)
+        thread.join();
+}
+
+/*************/
+void WorkerPool::enqueue(std::function<void()>&& task)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_stop)
+            return;
+        _tasks.push_back(std::move(task));
+    }
+    _condition.notify_one();
+}
+
+/*************/
+void WorkerPool::run()
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _condition.wait(lock, [this]() { return _stop || !_tasks.empty(); });
+            if (_stop)
+                return;
+            task = std::move(_tasks.front());
+            _tasks.pop_front();
+        }
+        task();
+    }
+}
+
+} // namespace Utils
+} // namespace Splash
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2026 Splash authors
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @worker_pool.h
+ * WorkerPool class, running tasks on a fixed set of persistent threads
+ */
+
+#ifndef SPLASH_WORKER_POOL_H
+#define SPLASH_WORKER_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Splash
+{
+namespace Utils
+{
+
+class WorkerPool
+{
+  public:
+    /**
+     * Constructor
+     * \param threadCount Number of worker threads, at least one is created
+     */
+    explicit WorkerPool(size_t threadCount);
+
+    /**
+     * Destructor. Tasks not started yet are discarded, running ones are waited for.
+     */
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    /**
+     * Add a task to be run by the first available worker
+     * \param task Task to run
+     */
+    void enqueue(std::function<void()>&& task);
+
+    /**
+     * Get the number of worker threads
+     * \return Return the thread count
+     */
+    size_t getThreadCount() const { return _threads.size(); }
+
+  private:
+    std::mutex _mutex{};
+    std::condition_variable _condition{};
+    std::deque<std::function<void()>> _tasks{};
+    bool _stop{false};
+    std::vector<std::thread> _threads{};
+
+    /**
+     * Worker thread loop
+     */
+    void run();
+};
+
+} // namespace Utils
+} // namespace Splash
+
+#endif // SPLASH_WORKER_POOL_H
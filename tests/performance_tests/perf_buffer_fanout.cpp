@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2026 Splash authors
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "./core/root_object.h"
+#include "./core/serializer.h"
+#include "./network/channel_zmq.h"
+
+using namespace Splash;
+
+/*************/
+void benchmark(size_t sceneCount, bool sharedMemory)
+{
+    const size_t frameCount = 1 << 6;
+    const size_t frameSize = 1920 * 1080 * 4;
+    const auto maximumWait = std::chrono::seconds(1);
+
+    RootObject root;
+    ChannelOutput_ZMQ output(&root, "perf_fanout_output");
+    output.setSharedMemory(sharedMemory);
+
+    // Each input stands for a Scene, all of them receiving the same image
+    std::atomic<uint64_t> received{0};
+    std::vector<std::unique_ptr<ChannelInput_ZMQ>> inputs;
+    for (size_t scene = 0; scene < sceneCount; ++scene)
+    {
+        inputs.push_back(std::make_unique<ChannelInput_ZMQ>(
+            &root, "perf_fanout_input_" + std::to_string(scene), [](std::span<const uint8_t>) {}, [&](SerializedObject&& /*buffer*/) { ++received; }));
+        if (!inputs.back()->connectTo("perf_fanout_output"))
+        {
+            std::cout << "Could not connect input " << scene << "\n";
+            return;
+        }
+    }
+
+    // Buffers start with the name of their target object, as with Link
+    std::vector<uint8_t> frame;
+    Serial::serialize(std::string("image"), frame);
+    frame.resize(frameSize);
+    std::iota(frame.begin() + 64, frame.end(), 0);
+    const auto sendFrame = [&]() {
+        output.sendBuffer(SerializedObject(frame.data(), frame.data() + frame.size()));
+        output.waitForBufferSending(std::chrono::milliseconds(50));
+    };
+
+    // Connection through ZMQ takes some time to establish, and there is no way
+    // to know for sure that it is active without sending something
+    while (received < sceneCount)
+    {
+        received = 0;
+        sendFrame();
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    // Each frame is sent once all scenes received the previous one
+    size_t receivedFrames = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t frameId = 0; frameId < frameCount; ++frameId)
+    {
+        received = 0;
+        sendFrame();
+
+        const auto frameStart = std::chrono::steady_clock::now();
+        while (received < sceneCount && std::chrono::steady_clock::now() - frameStart < maximumWait)
+            std::this_thread::yield();
+        receivedFrames += received;
+    }
+    const auto end = std::chrono::steady_clock::now();
+    const auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+
+    std::cout << sceneCount << " scene(s), " << (sharedMemory ? "shared memory" : "socket       ") << " -> " << static_cast<double>(duration) / static_cast<double>(frameCount) / 1000.0
+              << " ms per frame, " << receivedFrames << " / " << frameCount * sceneCount << " frames received, "
+              << static_cast<double>(receivedFrames * frameSize) / static_cast<double>(1 << 20) / (static_cast<double>(duration) / 1e6) << " MB/sec delivered\n";
+}
+
+/*************/
+int main()
+{
+    std::cout << "----> Buffer fan-out performance test\n";
+
+    for (const size_t sceneCount : {1, 4, 8})
+    {
+        benchmark(sceneCount, false);
+        benchmark(sceneCount, true);
+    }
+
+    return 0;
+}
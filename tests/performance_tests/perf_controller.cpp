@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2026 Splash authors
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "./controller/controller.h"
+#include "./core/root_object.h"
+#include "./utils/log.h"
+
+using namespace Splash;
+
+/*************/
+// Walks the tree the way the controller queries did before the object snapshot, as a reference
+std::unordered_map<std::string, std::vector<std::string>> getObjectLinksFromTree(RootObject& root)
+{
+    auto links = std::unordered_map<std::string, std::vector<std::string>>();
+    const auto tree = root.getTree();
+
+    for (const auto& rootName : tree->getBranchList())
+    {
+        const auto objectPath = "/" + rootName + "/objects";
+        for (const auto& objectName : tree->getBranchListAt(objectPath))
+        {
+            auto& childList = links[objectName];
+            Value value;
+            tree->getValueForLeafAt(objectPath + "/" + objectName + "/links/children", value);
+            for (const auto& child : value.as<Values>())
+                if (std::find(childList.begin(), childList.end(), child.as<std::string>()) == childList.end())
+                    childList.push_back(child.as<std::string>());
+        }
+    }
+
+    return links;
+}
+
+/*************/
+Values getObjectAttributeFromTree(RootObject& root, const std::string& name, const std::string& attr)
+{
+    const auto tree = root.getTree();
+    for (const auto& rootName : tree->getBranchList())
+    {
+        Value value;
+        const auto attrPath = "/" + rootName + "/objects/" + name + "/attributes/" + attr;
+        if (!tree->hasLeafAt(attrPath))
+            continue;
+        tree->getValueForLeafAt(attrPath, value);
+        return value.as<Values>();
+    }
+
+    return {};
+}
+
+/*************/
+void benchmark(const std::string& name, size_t loopCount, const std::function<void()>& func)
+{
+    std::cout << name << " -> " << std::flush;
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t loop = 0; loop < loopCount; ++loop)
+        func();
+    const auto end = std::chrono::steady_clock::now();
+    const auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    std::cout << duration / loopCount / 1000 << "us per call\n";
+}
+
+/*************/
+int main()
+{
+    Log::get().setVerbosity(Log::ERROR);
+
+    const size_t objectCount = 500;
+    const size_t attributeCount = 16;
+    const std::vector<std::string> roots{"world", "scene_a", "scene_b"};
+
+    std::cout << "----> Controller queries performance test (" << objectCount << " objects, " << roots.size() << " roots)\n";
+
+    // Fill the tree as if the configuration held the given number of objects, replicated in the World and the Scenes
+    auto root = RootObject();
+    {
+        auto tree = root.getTree();
+        for (const auto& rootName : roots)
+        {
+            for (size_t i = 0; i < objectCount; ++i)
+            {
+                const auto objectPath = "/" + rootName + "/objects/object_" + std::to_string(i);
+                tree->createLeafAt(objectPath + "/type", {i % 10 == 0 ? "camera" : "object"});
+                tree->createLeafAt(objectPath + "/links/children", {"object_" + std::to_string((i + 1) % objectCount)});
+                tree->createLeafAt(objectPath + "/links/parents", {"object_" + std::to_string((i + objectCount - 1) % objectCount)});
+                for (size_t attr = 0; attr < attributeCount; ++attr)
+                    tree->createLeafAt(objectPath + "/attributes/attribute_" + std::to_string(attr), {static_cast<int>(attr)});
+            }
+        }
+    }
+
+    auto controller = ControllerObject(&root, GraphObject::TreeRegisterStatus::NotRegistered);
+    const size_t loopCount = 1 << 8;
+    volatile size_t result;
+
+    benchmark("Tree walk getObjectLinks", loopCount, [&]() { result = getObjectLinksFromTree(root).size(); });
+    benchmark("ControllerObject::getObjectLinks", loopCount, [&]() { result = controller.getObjectLinks().size(); });
+    benchmark("ControllerObject::getObjectReversedLinks", loopCount, [&]() { result = controller.getObjectReversedLinks().size(); });
+    benchmark("ControllerObject::getObjectTypes", loopCount, [&]() { result = controller.getObjectTypes().size(); });
+    benchmark("ControllerObject::getObjectsOfType", loopCount, [&]() { result = controller.getObjectsOfType("camera").size(); });
+
+    size_t index = 0;
+    benchmark("Tree walk getObjectAttribute", loopCount * objectCount, [&]() {
+        result = getObjectAttributeFromTree(root, "object_" + std::to_string(index++ % objectCount), "attribute_3").size();
+    });
+    benchmark("ControllerObject::getObjectAttribute", loopCount * objectCount, [&]() {
+        result = controller.getObjectAttribute("object_" + std::to_string(index++ % objectCount), "attribute_3").size();
+    });
+
+    // Adding an object forces the snapshot to be rebuilt on the next query
+    benchmark("ControllerObject::getObjectAttribute after an object creation", loopCount, [&]() {
+        root.getTree()->createBranchAt("/world/objects/new_object_" + std::to_string(index++));
+        result = controller.getObjectAttribute("object_0", "attribute_3").size();
+    });
+
+    return 0;
+}
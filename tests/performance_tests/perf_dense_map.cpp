@@ -22,11 +22,44 @@
 #include <chrono>
 #include <iostream>
 #include <map>
+#include <string>
 #include <unordered_map>
 #include <vector>
 
 using namespace Splash;
 
+/*************/
+template <typename Map>
+void benchmarkLookupAndErase(const std::string& mapName, size_t count)
+{
+    const size_t lookupCount = 1 << 16;
+
+    std::vector<std::string> keys;
+    for (size_t i = 0; i < count; ++i)
+        keys.push_back("object_" + std::to_string(i));
+
+    Map map{};
+    for (size_t i = 0; i < count; ++i)
+        map.insert({keys[i], static_cast<float>(i)});
+
+    volatile float value;
+    std::cout << mapName << "::find (" << count << " entries) -> " << std::flush;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < lookupCount; ++i)
+        value = map.find(keys[(i * 7919) % count])->second;
+    auto end = std::chrono::steady_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    std::cout << duration / lookupCount << "ns per lookup\n";
+
+    std::cout << mapName << "::erase (" << count << " entries) -> " << std::flush;
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i)
+        map.erase(keys[(i * 7919) % count]);
+    end = std::chrono::steady_clock::now();
+    duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    std::cout << duration / count << "ns per erase\n";
+}
+
 int main()
 {
     const size_t count = 1 << 8;
@@ -119,4 +152,15 @@ int main()
     end = std::chrono::steady_clock::now();
     duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
     std::cout << duration << "µs\n";
+
+    /**
+     * Lookup and erase, with string keys
+     * Note that 7919 is prime, so the keys are visited in a scattered order
+     */
+    for (const size_t entryCount : {10, 100, 1000, 10000})
+    {
+        benchmarkLookupAndErase<DenseMap<std::string, float>>("DenseMap", entryCount);
+        benchmarkLookupAndErase<std::map<std::string, float>>("std::map", entryCount);
+        benchmarkLookupAndErase<std::unordered_map<std::string, float>>("std::unordered_map", entryCount);
+    }
 }
@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2026 Splash authors
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "./core/constants.h"
+#include "./core/root_object.h"
+#include "./network/link.h"
+
+using namespace Splash;
+
+/*************/
+class LinkSink : public RootObject
+{
+  public:
+    LinkSink()
+    {
+        setName("sink");
+        addAttribute(
+            "ping",
+            [&](const Values& /*args*/) {
+                ++_received;
+                return true;
+            },
+            {});
+    }
+
+    uint64_t getReceived() const { return _received.load(); }
+
+  private:
+    std::atomic<uint64_t> _received{0};
+};
+
+/*************/
+void benchmark(const std::string& name, Link::ChannelType channelType)
+{
+    const size_t messageCount = 1 << 16;
+    const auto maximumWait = std::chrono::seconds(10);
+
+    RootObject sourceRoot;
+    LinkSink sinkRoot;
+    Link source(&sourceRoot, "perf_link_source", channelType);
+    Link sink(&sinkRoot, "perf_link_sink", channelType);
+
+    // Depending on the channel, either the input or the output connects to its peer
+    const auto sourceConnected = source.connectTo("perf_link_sink");
+    const auto sinkConnected = sink.connectTo("perf_link_source");
+    if (!sourceConnected && !sinkConnected)
+    {
+        std::cout << name << " -> could not connect the links\n";
+        return;
+    }
+
+    // Typical attribute message: a color, plus a string to exercise the string path
+    const Values message{0.1f, 0.2f, 0.3f, 1.f, "a value long enough not to be inlined"};
+
+    // Connection takes some time to establish, and there is no way to know
+    // for sure that it is active without sending a message
+    while (sinkRoot.getReceived() == 0)
+    {
+        source.sendMessage("sink", "ping", message);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    const auto receivedBefore = sinkRoot.getReceived();
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < messageCount; ++i)
+        source.sendMessage("sink", "ping", message);
+
+    // Messages may be dropped by the channel if they are sent faster than they are handled
+    while (sinkRoot.getReceived() - receivedBefore < messageCount && std::chrono::steady_clock::now() - start < maximumWait)
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+
+    const auto end = std::chrono::steady_clock::now();
+    const auto received = sinkRoot.getReceived() - receivedBefore;
+    const auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+
+    std::cout << name << " -> received " << received << " / " << messageCount << " messages in " << duration << " us, "
+              << static_cast<double>(received) / (static_cast<double>(duration) / 1e6) << " messages/sec\n";
+}
+
+/*************/
+void benchmarkFrames(const std::string& name, bool batching)
+{
+    const size_t frameCount = 1 << 10;
+    const size_t cameraCount = 16;
+    const size_t updatesPerFrame = 4;
+
+    RootObject sourceRoot;
+    Link source(&sourceRoot, "perf_link_frames", Link::ChannelType::zmq);
+    source.setMessageBatching(batching);
+
+    // Typical World frame while a slider bound to all cameras is dragged: the scenes
+    // are synchronized, and each camera gets a few updates of the same attribute
+    const auto statisticsBefore = source.getStatistics();
+    for (size_t frame = 0; frame < frameCount; ++frame)
+    {
+        source.sendMessage(Constants::ALL_PEERS, "syncScenes", {});
+        for (size_t update = 0; update < updatesPerFrame; ++update)
+            for (size_t camera = 0; camera < cameraCount; ++camera)
+                source.sendMessage("camera_" + std::to_string(camera), "fov", {35.f + static_cast<float>(update)}, true);
+        source.flushMessages();
+    }
+    const auto statistics = source.getStatistics();
+
+    const auto perFrame = [&](uint64_t after, uint64_t before) { return static_cast<double>(after - before) / static_cast<double>(frameCount); };
+    std::cout << name << " -> " << perFrame(statistics.messages, statisticsBefore.messages) << " messages, " << perFrame(statistics.sentMessages, statisticsBefore.sentMessages)
+              << " sent messages, " << perFrame(statistics.sentBytes, statisticsBefore.sentBytes) << " bytes per frame\n";
+}
+
+/*************/
+int main()
+{
+    std::cout << "----> Link performance test\n";
+
+    benchmark("Link over zmq", Link::ChannelType::zmq);
+#if HAVE_SHMDATA
+    benchmark("Link over shmdata", Link::ChannelType::shmdata);
+#endif
+
+    benchmarkFrames("Frame messages, unbatched", false);
+    benchmarkFrames("Frame messages, batched and coalesced", true);
+
+    return 0;
+}
@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2026 Splash authors
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <string>
+
+#include "./core/base_object.h"
+#include "./core/value.h"
+
+using namespace Splash;
+
+/*************/
+// Count all heap allocations made by the process
+static std::atomic<uint64_t> allocationCount{0};
+
+void* operator new(size_t size)
+{
+    ++allocationCount;
+    if (auto ptr = std::malloc(size))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+
+/*************/
+class AttributeTarget : public BaseObject
+{
+  public:
+    AttributeTarget()
+    {
+        addAttribute(
+            "color",
+            [&](const Values& args) {
+                _color = {args[0].as<float>(), args[1].as<float>(), args[2].as<float>(), args[3].as<float>()};
+                return true;
+            },
+            [&]() -> Values { return {_color[0], _color[1], _color[2], _color[3]}; },
+            {'r', 'r', 'r', 'r'});
+    }
+
+  private:
+    std::array<float, 4> _color{};
+};
+
+/*************/
+void benchmark(const std::string& name, const std::function<void()>& func)
+{
+    const size_t loopCount = 1 << 16;
+
+    // Warm up, to leave aside the allocations done once
+    func();
+
+    const auto allocationsBefore = allocationCount.load();
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < loopCount; ++i)
+        func();
+    const auto end = std::chrono::steady_clock::now();
+    const auto allocations = allocationCount.load() - allocationsBefore;
+    const auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+
+    std::cout << name << " -> " << static_cast<float>(allocations) / static_cast<float>(loopCount) << " allocations, " << duration / loopCount << "ns per iteration\n";
+}
+
+/*************/
+int main()
+{
+    std::cout << "----> Value performance test\n";
+
+    // Typical attribute message, as received from the link: object name, attribute name, arguments
+    benchmark("Build a color message", []() {
+        Values message{"object", "color", Values{0.1f, 0.2f, 0.3f, 1.f}};
+        (void)message;
+    });
+
+    const Values message{"object", "color", Values{0.1f, 0.2f, 0.3f, 1.f}};
+    benchmark("Copy a color message", [&]() {
+        Values copy = message;
+        (void)copy;
+    });
+
+    benchmark("Move a color message through three hops", [&]() {
+        Values first = message;
+        Values second = std::move(first);
+        Values third(std::move(second));
+        Value wrapped(std::move(third));
+        (void)wrapped;
+    });
+
+    benchmark("Build named values", []() {
+        Values values{Value(1.0, "gamma"), Value(0.5, "brightness"), Value(std::string("a long enough string value"), "description_of_the_value")};
+        (void)values;
+    });
+
+    AttributeTarget target;
+    const Values color{0.1f, 0.2f, 0.3f, 1.f};
+    benchmark("BaseObject::setAttribute with a color", [&]() { target.setAttribute("color", color); });
+
+    benchmark("BaseObject::getAttribute of a color", [&]() {
+        Values values;
+        target.getAttribute("color", values);
+    });
+
+    return 0;
+}
@@ -1,5 +1,7 @@
 #include <chrono>
+#include <future>
 #include <thread>
+#include <vector>
 
 #include <doctest.h>
 
@@ -33,6 +35,36 @@ class BufferObjectMock : public BufferObject
 
     SerializedObject serialize() const final { return {}; }
 };
+
+/*************/
+class BufferObjectMailboxMock : public BufferObject
+{
+  public:
+    std::vector<uint8_t> _applied{};
+    std::promise<void> _firstStarted{};
+    std::shared_future<void> _firstReleased{};
+
+  public:
+    BufferObjectMailboxMock(std::shared_future<void> firstReleased)
+        : BufferObject(nullptr)
+        , _firstReleased(firstReleased)
+    {
+    }
+
+    bool deserialize(SerializedObject&& obj) final
+    {
+        // The first deserialization blocks until released, so that the next objects pile up
+        if (_applied.empty())
+        {
+            _firstStarted.set_value();
+            _firstReleased.wait();
+        }
+        _applied.push_back(obj.data()[0]);
+        return true;
+    }
+
+    SerializedObject serialize() const final { return {}; }
+};
 } // namespace BufferObjectTests
 
 /*************/
@@ -74,3 +106,70 @@ TEST_CASE("Testing serialization")
     CHECK_EQ(result, false);
     CHECK_EQ(timestamp, buffer.getTimestamp());
 }
+
+/*************/
+TEST_CASE("Testing content deduplication")
+{
+    auto buffer = BufferObjectTests::BufferObjectMock();
+    const auto makeObject = [](uint8_t value) { return SerializedObject(ResizableArray<uint8_t>(std::vector<uint8_t>(1024, value))); };
+
+    CHECK(buffer.hasNewContent(makeObject(1)));
+    CHECK_FALSE(buffer.hasNewContent(makeObject(1)));
+    CHECK_EQ(buffer.getSkippedTransportCount(), 1);
+    CHECK_EQ(buffer.getSkippedTransportBytes(), 1024);
+
+    // Setting the object dirty forces its transport
+    buffer.setDirty();
+    CHECK(buffer.hasNewContent(makeObject(1)));
+    CHECK_FALSE(buffer.hasNewContent(makeObject(1)));
+
+    // Content changing at each update is considered as streamed, and is not checked anymore
+    for (uint8_t value = 2; value < 8; ++value)
+        CHECK(buffer.hasNewContent(makeObject(value)));
+    CHECK(buffer.hasNewContent(makeObject(7)));
+    CHECK_EQ(buffer.getSkippedTransportCount(), 2);
+}
+
+/*************/
+TEST_CASE("Testing serialized objects coalescing")
+{
+    std::promise<void> release;
+    auto buffer = BufferObjectTests::BufferObjectMailboxMock(release.get_future().share());
+    auto started = buffer._firstStarted.get_future();
+    const auto makeObject = [](uint8_t value) { return SerializedObject(ResizableArray<uint8_t>(std::vector<uint8_t>(16, value))); };
+
+    // Without a root object, the deserialization runs in the thread setting the object
+    auto first = std::thread([&]() { buffer.setSerializedObject(makeObject(1)); });
+    started.wait();
+
+    // Objects set during the deserialization wait in the mailbox, only the last one is kept
+    for (uint8_t value = 2; value <= 5; ++value)
+        CHECK(buffer.setSerializedObject(makeObject(value)));
+    CHECK(buffer.hasSerializedObjectWaiting());
+
+    release.set_value();
+    first.join();
+
+    CHECK_EQ(buffer._applied, std::vector<uint8_t>({1, 5}));
+    CHECK_EQ(buffer.getCoalescedBufferCount(), 3);
+    CHECK_EQ(buffer.getDroppedBufferCount(), 0);
+    CHECK_FALSE(buffer.hasSerializedObjectWaiting());
+
+    // Empty objects are dropped
+    CHECK_FALSE(buffer.setSerializedObject({}));
+    CHECK_EQ(buffer.getDroppedBufferCount(), 1);
+}
+
+/*************/
+TEST_CASE("Testing transport policy lane switch")
+{
+    auto buffer = BufferObjectTests::BufferObjectMock();
+    CHECK_EQ(buffer.getTransportPriority(), ChannelOutput::BufferPriority::realtime);
+    CHECK_EQ(buffer.setTransported(buffer.getTransportPriority()), ChannelOutput::BufferPriority::realtime);
+
+    // The first transport after a lane switch reports the previous lane, so that it can be flushed
+    CHECK(buffer.setAttribute("transportPolicy", {"reliable"}) == BaseObject::SetAttrStatus::success);
+    CHECK_EQ(buffer.getTransportPriority(), ChannelOutput::BufferPriority::background);
+    CHECK_EQ(buffer.setTransported(buffer.getTransportPriority()), ChannelOutput::BufferPriority::realtime);
+    CHECK_EQ(buffer.setTransported(buffer.getTransportPriority()), ChannelOutput::BufferPriority::background);
+}
@@ -80,3 +80,25 @@ TEST_CASE("Testing ImageBuffer")
         CHECK_EQ(imageBuffer.data(), previousBufferPtr);
     }
 }
+
+/*************/
+TEST_CASE("Testing ImageBuffer sharing")
+{
+    auto spec = ImageBufferSpec(64, 64, 4, 32, ImageBufferSpec::Type::UINT8);
+    auto sourceBuffer = std::make_shared<ImageBuffer>(spec);
+    sourceBuffer->data()[0] = 42;
+    const auto sourceData = sourceBuffer->data();
+
+    auto sharedBuffer = ImageBuffer(std::shared_ptr<const ImageBuffer>(sourceBuffer));
+    CHECK_EQ(sharedBuffer.data(), sourceData);
+    CHECK_EQ(sharedBuffer.getSize(), sourceBuffer->getSize());
+    CHECK_EQ(sharedBuffer.getSpec(), spec);
+
+    // The shared buffer keeps the data alive
+    sourceBuffer.reset();
+    CHECK_EQ(sharedBuffer.data()[0], 42);
+
+    // A copy shares the same data
+    auto copiedBuffer = sharedBuffer;
+    CHECK_EQ(copiedBuffer.data(), sourceData);
+}
@@ -3,6 +3,8 @@
 #include <chrono>
 #include <deque>
 #include <iostream>
+#include <span>
+#include <string_view>
 #include <tuple>
 #include <vector>
 
@@ -193,3 +195,28 @@ TEST_CASE("Testing deserialization")
         CHECK(std::get<2>(data) == std::get<2>(outData));
     }
 }
+
+/*************/
+TEST_CASE("Testing deserialization from a view")
+{
+    std::vector<uint8_t> buffer;
+    Serial::serialize(std::string("object"), buffer);
+    Serial::serialize(std::string_view("attribute"), buffer);
+    Serial::serialize(std::vector<int>({1, 2, 3}), buffer);
+
+    const auto frame = std::span<const uint8_t>(buffer.data(), buffer.size());
+    auto it = frame.data();
+    const auto name = Serial::detail::deserializer<std::string_view>(it);
+    const auto attribute = Serial::detail::deserializer<std::string_view>(it);
+    const auto values = Serial::detail::deserializer<std::vector<int>>(it);
+
+    CHECK_EQ(name, "object");
+    CHECK_EQ(attribute, "attribute");
+    CHECK(values == std::vector<int>({1, 2, 3}));
+    CHECK_EQ(it, frame.data() + frame.size());
+
+    // The view points into the serialized data
+    CHECK(reinterpret_cast<const uint8_t*>(name.data()) == frame.data() + sizeof(uint32_t));
+    CHECK_EQ(Serial::getSize(name), Serial::getSize(std::string("object")));
+    CHECK_EQ(Serial::deserialize<std::string_view>(frame, Serial::getSize(name)), "attribute");
+}
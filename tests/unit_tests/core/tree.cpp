@@ -243,6 +243,37 @@ TEST_CASE("Testing the Branch's callbacks")
     CHECK(lastName == "some_leaf");
 }
 
+/*************/
+TEST_CASE("Testing the Branch's list version")
+{
+    Tree::Root maple;
+    maple.createBranchAt("/some_branch");
+    const auto branch = maple.getBranchAt("/some_branch");
+    const auto rootBranch = maple.getBranchAt("/");
+
+    auto version = branch->getBranchListVersion();
+    const auto rootVersion = rootBranch->getBranchListVersion();
+    maple.createLeafAt("/some_branch/some_leaf");
+    CHECK(branch->getBranchListVersion() == version);
+
+    maple.createBranchAt("/some_branch/a_child");
+    CHECK(branch->getBranchListVersion() != version);
+    CHECK(rootBranch->getBranchListVersion() == rootVersion);
+    version = branch->getBranchListVersion();
+
+    maple.renameBranchAt("/some_branch/a_child", "another_child");
+    CHECK(branch->getBranchListVersion() != version);
+    version = branch->getBranchListVersion();
+
+    maple.removeBranchAt("/some_branch/another_child");
+    CHECK(branch->getBranchListVersion() != version);
+
+    // Versions are unique, even across branches
+    maple.createBranchAt("/another_branch");
+    CHECK(maple.getBranchAt("/another_branch")->getBranchListVersion() != branch->getBranchListVersion());
+    CHECK(rootBranch->getBranchListVersion() != rootVersion);
+}
+
 /*************/
 TEST_CASE("Testing the Leaf's callbacks")
 {
@@ -1,6 +1,8 @@
+#include <atomic>
 #include <doctest.h>
 #include <iostream>
 #include <random>
+#include <thread>
 #include <vector>
 
 #include "./core/serialize/serialize_value.h"
@@ -97,6 +99,85 @@ TEST_CASE("Testing Values comparison")
     CHECK(valueString != valueFloat);
 }
 
+/*************/
+TEST_CASE("Testing small numeric tuples in Value")
+{
+    // Small tuples of numbers are stored inline, but behave as any other values
+    auto color = Value({0.5, 1, true});
+    CHECK_EQ(color.getType(), Value::Type::values);
+    CHECK_EQ(color.size(), 3);
+    CHECK_EQ(color.byte_size(), 2 * sizeof(double) + sizeof(bool));
+    CHECK_EQ(color.as<std::string>(), "[0.500000, 1, true]");
+    CHECK(color == Value(Values({0.5, 1, true})));
+    CHECK(color == Values({0.5, 1, true}));
+    CHECK(color != Value(Values({0.5, 1, false})));
+
+    const auto values = color.as<Values>();
+    CHECK_EQ(values.size(), 3);
+    CHECK_EQ(values[0].as<double>(), 0.5);
+    CHECK_EQ(values[1].as<int>(), 1);
+    CHECK_EQ(values[2].as<bool>(), true);
+
+    // Elements can be modified through references
+    const auto copy = color;
+    color[0] = 0.25;
+    CHECK_EQ(color[0].as<double>(), 0.25);
+    CHECK_EQ(copy[0].as<double>(), 0.5);
+    CHECK(color != copy);
+
+    // Larger tuples, and tuples holding other types, keep the same behavior
+    CHECK_EQ(Value({1, 2, 3, 4, 5}).size(), 5);
+    CHECK_EQ(Value({1, "two"})[1].as<std::string>(), "two");
+    CHECK_EQ(Value({Value(1, "one"), 2})[0].getName(), "one");
+}
+
+/*************/
+TEST_CASE("Testing concurrent reads of a const Value")
+{
+    // Reading a const Value from multiple threads must not modify it, whatever its storage
+    const auto color = Value({0.5, 1, true});
+    const auto list = Value({1, "two", 3.0});
+    std::atomic_int mismatches{0};
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+        threads.emplace_back([&]() {
+            for (int i = 0; i < 10000; ++i)
+            {
+                if (color[0].as<double>() != 0.5 || color[1].as<int>() != 1 || !color[2].as<bool>())
+                    ++mismatches;
+                if (list[1].as<std::string>() != "two" || list.size() != 3)
+                    ++mismatches;
+            }
+        });
+    for (auto& thread : threads)
+        thread.join();
+
+    CHECK_EQ(mismatches, 0);
+    CHECK_EQ(color.byte_size(), 2 * sizeof(double) + sizeof(bool));
+}
+
+/*************/
+TEST_CASE("Testing named Value")
+{
+    auto value = Value(42, "answer");
+    CHECK(value.isNamed());
+    CHECK_EQ(value.getName(), "answer");
+
+    const auto copy = value;
+    CHECK_EQ(copy.getName(), "answer");
+    CHECK(copy == value);
+
+    value.setName("question");
+    CHECK_EQ(copy.getName(), "answer");
+    CHECK(copy != value);
+    CHECK(value == Value(42, "question"));
+
+    value.setName("");
+    CHECK_FALSE(value.isNamed());
+    CHECK(value == Value(42));
+}
+
 /*************/
 TEST_CASE("Testing buffer in Value")
 {
@@ -223,6 +304,14 @@ TEST_CASE("Testing Value serialization")
         CHECK(data == outData);
     }
 
+    {
+        std::vector<uint8_t> buffer;
+        auto data = Value({0.1, 0.2, 0.3, 1.0});
+        Serial::serialize(data, buffer);
+        auto outData = Serial::deserialize<Value>(buffer);
+        CHECK(data == outData);
+    }
+
     {
         Value::Buffer inputBuffer(256);
         std::random_device rd;
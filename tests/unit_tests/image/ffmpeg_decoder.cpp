@@ -0,0 +1,62 @@
+/*
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "./image/ffmpeg_decoder.h"
+
+#include <doctest.h>
+
+using namespace Splash;
+
+/*************/
+TEST_CASE("Testing joining a shared FFmpegDecoder")
+{
+    FFmpegDecoder::Parameters parameters;
+    parameters.filepath = "video.mov";
+
+    // Without trimming, the playback starts at the beginning of the media
+    CHECK(FFmpegDecoder::isWithinJoinDelay(parameters, 0));
+    CHECK(FFmpegDecoder::isWithinJoinDelay(parameters, 500000));
+    CHECK_FALSE(FFmpegDecoder::isWithinJoinDelay(parameters, 2000000));
+
+    // With a trimmed media, the playback starts at the trimming start
+    parameters.trimStart = 60000000;
+    parameters.trimEnd = 120000000;
+    CHECK(FFmpegDecoder::isWithinJoinDelay(parameters, 60000000));
+    CHECK(FFmpegDecoder::isWithinJoinDelay(parameters, 60500000));
+    CHECK_FALSE(FFmpegDecoder::isWithinJoinDelay(parameters, 62000000));
+
+    // A trimming end before the trimming start disables trimming
+    parameters.trimEnd = 0;
+    CHECK(FFmpegDecoder::isWithinJoinDelay(parameters, 500000));
+    CHECK_FALSE(FFmpegDecoder::isWithinJoinDelay(parameters, 60500000));
+}
+
+/*************/
+TEST_CASE("Testing FFmpegDecoder sharing parameters")
+{
+    FFmpegDecoder::Parameters parameters;
+    parameters.filepath = "video.mov";
+    auto other = parameters;
+    CHECK(parameters == other);
+
+    // Consumers on different timelines can not share a decoder
+    other.timeShift = 1.f;
+    CHECK(parameters != other);
+    other = parameters;
+    other.useClock = true;
+    CHECK(parameters != other);
+}
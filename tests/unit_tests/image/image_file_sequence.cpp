@@ -0,0 +1,86 @@
+/*
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "./image/image_file_sequence.h"
+
+#include <chrono>
+#include <doctest.h>
+#include <thread>
+
+#include "./utils/osutils.h"
+
+using namespace Splash;
+
+/*************/
+TEST_CASE("Testing Image_FileSequence initialization")
+{
+    auto root = RootObject();
+    auto image = Image_FileSequence(&root);
+    CHECK_EQ(image.getType(), "image_file_sequence");
+}
+
+/*************/
+TEST_CASE("Testing Image_FileSequence file listing")
+{
+    const auto dataPath = Utils::getCurrentWorkingDirectory() + "/unit_tests/assets/color_calibration/";
+    auto root = RootObject();
+
+    {
+        auto image = Image_FileSequence(&root);
+        CHECK(image.read(dataPath));
+        CHECK_EQ(image.getFrameCount(), 36);
+    }
+
+    {
+        auto image = Image_FileSequence(&root);
+        CHECK(image.read(dataPath + "capt%04d.jpg"));
+        CHECK_EQ(image.getFrameCount(), 36);
+    }
+
+    {
+        auto image = Image_FileSequence(&root);
+        CHECK(image.read(dataPath + "capt0030.jpg"));
+        CHECK_EQ(image.getFrameCount(), 6);
+    }
+
+    {
+        auto image = Image_FileSequence(&root);
+        CHECK_FALSE(image.read(dataPath + "missing%04d.jpg"));
+        CHECK_EQ(image.getFrameCount(), 0);
+    }
+}
+
+/*************/
+TEST_CASE("Testing Image_FileSequence playback")
+{
+    const auto dataPath = Utils::getCurrentWorkingDirectory() + "/unit_tests/assets/color_calibration/";
+    auto root = RootObject();
+    auto image = Image_FileSequence(&root);
+    image.setAttribute("framerate", {10.f});
+    CHECK(image.read(dataPath));
+
+    const auto initialTimestamp = image.getTimestamp();
+    for (int i = 0; i < 100 && image.getTimestamp() == initialTimestamp; ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        image.update();
+    }
+
+    CHECK_NE(image.getTimestamp(), initialTimestamp);
+    CHECK_EQ(image.getSpec().width, 496);
+    CHECK_EQ(image.getSpec().height, 744);
+}
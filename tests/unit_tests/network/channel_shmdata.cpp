@@ -21,6 +21,7 @@
 #include <chrono>
 #include <iostream>
 #include <mutex>
+#include <span>
 #include <thread>
 #include <vector>
 
@@ -47,10 +48,10 @@ TEST_CASE("Test sending a message and a buffer through a shmdata channel")
     auto channelInput = ChannelInput_Shmdata(
         &root,
         "input",
-        [&](const std::vector<uint8_t> msg) {
+        [&](std::span<const uint8_t> msg) {
             std::unique_lock<std::mutex> lock(receivedMutex);
             isMsgReceived = true;
-            receivedMsg = msg;
+            receivedMsg.assign(msg.begin(), msg.end());
         },
         [&](SerializedObject&& obj) {
             std::unique_lock<std::mutex> lock(receivedMutex);
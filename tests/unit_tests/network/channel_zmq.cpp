@@ -20,6 +20,7 @@
 #include <atomic>
 #include <chrono>
 #include <iostream>
+#include <span>
 #include <thread>
 #include <vector>
 
@@ -46,10 +47,10 @@ TEST_CASE("Test sending a message and a buffer through a zmq channel")
     auto channelInput = ChannelInput_ZMQ(
         &root,
         "input",
-        [&](const std::vector<uint8_t> msg) {
+        [&](std::span<const uint8_t> msg) {
             isMsgReceived = true;
             std::unique_lock<std::mutex> lock(receivedMutex);
-            receivedMsg = msg;
+            receivedMsg.assign(msg.begin(), msg.end());
         },
         [&](SerializedObject&& obj) {
             isBufferReceived = true;
@@ -93,4 +94,19 @@ TEST_CASE("Test sending a message and a buffer through a zmq channel")
         CHECK_EQ(receivedObj.data()[1], 2);
         CHECK_EQ(receivedObj.data()[2], 3);
     }
+
+    // Background buffers go through their own socket
+    isBufferReceived = false;
+    array = ResizableArray<uint8_t>({4, 5, 6});
+    object = SerializedObject(std::move(array));
+    CHECK(channelOutput.sendBuffer(std::move(object), ChannelOutput::BufferPriority::background));
+    while (!isBufferReceived)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    {
+        std::unique_lock<std::mutex> lock(receivedMutex);
+        CHECK_EQ(receivedObj.data()[0], 4);
+        CHECK_EQ(receivedObj.data()[1], 5);
+        CHECK_EQ(receivedObj.data()[2], 6);
+    }
 }
@@ -0,0 +1,128 @@
+/*
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "./network/link.h"
+
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <doctest.h>
+
+#include "./core/root_object.h"
+
+using namespace Splash;
+
+/*************/
+class LinkTarget : public RootObject
+{
+  public:
+    LinkTarget()
+    {
+        setName("target");
+        addAttribute(
+            "value",
+            [&](const Values& args) {
+                std::lock_guard<std::mutex> lock(_receivedMutex);
+                _received.push_back(args[0].as<int64_t>());
+                return true;
+            },
+            {'i'});
+
+        // Markers are stored along the values, offset to tell them apart
+        addAttribute(
+            "marker",
+            [&](const Values& args) {
+                std::lock_guard<std::mutex> lock(_receivedMutex);
+                _received.push_back(markerOffset + args[0].as<int64_t>());
+                return true;
+            },
+            {'i'});
+    }
+
+    static constexpr int64_t markerOffset{100};
+
+    std::vector<int64_t> getReceived()
+    {
+        std::lock_guard<std::mutex> lock(_receivedMutex);
+        return _received;
+    }
+
+  private:
+    std::mutex _receivedMutex{};
+    std::vector<int64_t> _received{};
+};
+
+/*************/
+TEST_CASE("Test batching messages through a link")
+{
+    RootObject sourceRoot;
+    LinkTarget targetRoot;
+    Link source(&sourceRoot, "link_test_source", Link::ChannelType::zmq);
+    Link target(&targetRoot, "link_test_target", Link::ChannelType::zmq);
+    CHECK(target.connectTo("link_test_source"));
+
+    // Connection through ZMQ takes some time to establish, and there is no
+    // way to know for sure that it is active without sending a message
+    while (targetRoot.getReceived().empty())
+    {
+        source.sendMessage("target", "value", {0});
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    const auto receivedBefore = targetRoot.getReceived().size();
+    const auto statisticsBefore = source.getStatistics();
+
+    CHECK_FALSE(source.isMessageBatching());
+    source.setMessageBatching(true);
+    CHECK(source.isMessageBatching());
+    CHECK(source.sendMessage("target", "value", {1}, true));
+    CHECK(source.sendMessage("target", "value", {2}, true));
+    CHECK(source.sendMessage("target", "marker", {1}));
+    CHECK(source.sendMessage("target", "value", {3}, true));
+    CHECK(source.sendMessage("other", "value", {0}));
+    CHECK(source.sendMessage("target", "value", {4}, true));
+
+    // Nothing is sent until the batch is flushed
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    CHECK_EQ(targetRoot.getReceived().size(), receivedBefore);
+
+    CHECK(source.flushMessages());
+    while (targetRoot.getReceived().size() < receivedBefore + 3)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    // Coalesced messages are replaced in place, but not across a message to the same object
+    const auto received = targetRoot.getReceived();
+    CHECK_EQ(received.size(), receivedBefore + 3);
+    CHECK_EQ(received[receivedBefore], 2);
+    CHECK_EQ(received[receivedBefore + 1], LinkTarget::markerOffset + 1);
+    CHECK_EQ(received[receivedBefore + 2], 4);
+
+    const auto statistics = source.getStatistics();
+    CHECK_EQ(statistics.messages - statisticsBefore.messages, 6);
+    CHECK_EQ(statistics.coalescedMessages - statisticsBefore.coalescedMessages, 2);
+    CHECK_EQ(statistics.sentMessages - statisticsBefore.sentMessages, 1);
+
+    // Deactivating batching sends messages right away
+    source.setMessageBatching(false);
+    CHECK_FALSE(source.isMessageBatching());
+    CHECK(source.sendMessage("target", "value", {5}));
+    while (targetRoot.getReceived().size() < receivedBefore + 4)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    CHECK_EQ(targetRoot.getReceived().back(), 5);
+}
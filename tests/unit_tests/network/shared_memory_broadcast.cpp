@@ -0,0 +1,159 @@
+/*
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "./network/shared_memory_broadcast.h"
+
+#include <chrono>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#include <doctest.h>
+
+using namespace Splash;
+
+/*************/
+TEST_CASE("Testing broadcasting a buffer through shared memory")
+{
+    SharedMemoryWriter writer("unit_test_broadcast");
+    SharedMemoryReader firstReader;
+    SharedMemoryReader secondReader;
+
+    std::vector<uint8_t> buffer(1 << 20);
+    std::iota(buffer.begin(), buffer.end(), 0);
+    const auto descriptor = writer.write("object", buffer);
+    CHECK(!descriptor.empty());
+
+    // All readers get the same buffer from the single write
+    for (auto* reader : {&firstReader, &secondReader})
+    {
+        const auto received = reader->read(descriptor);
+        REQUIRE(received);
+        CHECK_EQ(received->size(), buffer.size());
+        CHECK(std::equal(buffer.begin(), buffer.end(), received->data()));
+    }
+
+    // A descriptor can be read as long as the segment has not been overwritten
+    CHECK(firstReader.read(descriptor));
+
+    // Modifying a buffer read from shared memory copies it first, leaving the segment untouched
+    {
+        auto received = firstReader.read(descriptor);
+        REQUIRE(received);
+        received->data()[0] = 42;
+        CHECK_EQ(received->size(), buffer.size());
+    }
+    const auto untouched = secondReader.read(descriptor);
+    REQUIRE(untouched);
+    CHECK_EQ(untouched->data()[0], buffer[0]);
+
+    // Malformed descriptors are rejected
+    CHECK_FALSE(firstReader.read(std::vector<uint8_t>{1, 2, 3}));
+    auto truncatedDescriptor = descriptor;
+    truncatedDescriptor.pop_back();
+    CHECK_FALSE(firstReader.read(truncatedDescriptor));
+}
+
+/*************/
+TEST_CASE("Testing overwriting shared memory segments")
+{
+    // A single segment, which can be overwritten right away
+    SharedMemoryWriter writer("unit_test_overwrite", 1, std::chrono::milliseconds(0));
+    SharedMemoryReader reader;
+
+    const std::vector<uint8_t> firstBuffer(1024, 1);
+    const std::vector<uint8_t> secondBuffer(1024, 2);
+    const auto firstDescriptor = writer.write("object", firstBuffer);
+    const auto secondDescriptor = writer.write("object", secondBuffer);
+    CHECK(!firstDescriptor.empty());
+    CHECK(!secondDescriptor.empty());
+
+    // The first buffer has been overwritten, and is not available anymore
+    CHECK_FALSE(reader.read(firstDescriptor));
+    const auto received = reader.read(secondDescriptor);
+    REQUIRE(received);
+    CHECK_EQ(received->data()[0], 2);
+
+    // With the only segment recently written, there is no room left for another buffer
+    SharedMemoryWriter delayedWriter("unit_test_delayed", 1, std::chrono::seconds(10));
+    CHECK(!delayedWriter.write("object", firstBuffer).empty());
+    CHECK(delayedWriter.write("object", secondBuffer).empty());
+}
+
+/*************/
+TEST_CASE("Testing shared memory segments of multiple objects")
+{
+    SharedMemoryWriter writer("unit_test_objects", 1, std::chrono::milliseconds(0));
+    SharedMemoryReader reader;
+
+    const std::vector<uint8_t> firstBuffer(1024, 1);
+    const std::vector<uint8_t> secondBuffer(1024, 2);
+    const std::vector<uint8_t> thirdBuffer(1024, 3);
+    const auto firstDescriptor = writer.write("first", firstBuffer);
+    const auto secondDescriptor = writer.write("second", secondBuffer);
+    CHECK(!firstDescriptor.empty());
+    CHECK(!secondDescriptor.empty());
+    CHECK_EQ(writer.getSegmentCount(), 2);
+
+    // A segment is only overwritten by a buffer of the same object
+    const auto thirdDescriptor = writer.write("first", thirdBuffer);
+    CHECK(!thirdDescriptor.empty());
+    CHECK_FALSE(reader.read(firstDescriptor));
+    {
+        const auto received = reader.read(secondDescriptor);
+        REQUIRE(received);
+        CHECK_EQ(received->data()[0], 2);
+
+        // A segment can not be overwritten while a view over it is held
+        CHECK(writer.write("second", firstBuffer).empty());
+    }
+    CHECK(!writer.write("second", firstBuffer).empty());
+
+    // Segments are released along with their object
+    writer.release("first");
+    CHECK_EQ(writer.getSegmentCount(), 1);
+    SharedMemoryReader otherReader;
+    CHECK_FALSE(otherReader.read(thirdDescriptor));
+}
+
+/*************/
+TEST_CASE("Testing releasing shared memory segments")
+{
+    SharedMemoryWriter writer("unit_test_release", 1, std::chrono::milliseconds(0), std::chrono::milliseconds(50));
+    SharedMemoryReader reader;
+
+    // A segment which does not fit the size of the buffers anymore is replaced
+    const std::vector<uint8_t> largeBuffer(4 << 20, 1);
+    const std::vector<uint8_t> smallBuffer(1024, 2);
+    CHECK(!writer.write("object", largeBuffer).empty());
+    const auto descriptor = writer.write("object", smallBuffer);
+    CHECK(!descriptor.empty());
+    CHECK_EQ(writer.getSegmentCount(), 1);
+
+    // The view over the buffer stays valid, even after its segment has been released
+    const auto received = reader.read(descriptor);
+    REQUIRE(received);
+    writer.release("object");
+    CHECK_EQ(writer.getSegmentCount(), 0);
+    CHECK_EQ(received->data()[0], 2);
+
+    // Segments which have not been written to for a while are released
+    CHECK(!writer.write("object", smallBuffer).empty());
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    CHECK(!writer.write("other", smallBuffer).empty());
+    CHECK_EQ(writer.getSegmentCount(), 1);
+}
@@ -20,6 +20,8 @@
 #include <doctest.h>
 
 #include <iostream>
+#include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
@@ -101,3 +103,19 @@ TEST_CASE("Testing Splash::DenseMap")
     otherMap = DenseMap<int, float>({{4, 4.f}, {8, 8.f}});
     CHECK(dmap == otherMap);
 }
+
+/*************/
+TEST_CASE("Testing Splash::DenseMap heterogeneous lookup")
+{
+    auto dmap = DenseMap<std::string, int>({{"a", 1}, {"b", 2}, {"c", 3}});
+    CHECK(dmap.find(std::string_view("b"))->second == 2);
+    CHECK(dmap.find("c")->second == 3);
+    CHECK(dmap.find("d") == dmap.end());
+    CHECK(dmap.contains("a"));
+    CHECK(!dmap.contains(std::string_view("d")));
+
+    dmap.erase("a");
+    CHECK(!dmap.contains("a"));
+    CHECK(dmap.find("b")->second == 2);
+    CHECK(dmap.find("c")->second == 3);
+}
@@ -19,6 +19,9 @@
 
 #include <doctest.h>
 
+#include <string>
+#include <string_view>
+
 #include "./utils/dense_set.h"
 
 using namespace Splash;
@@ -51,3 +54,30 @@ TEST_CASE("Testing Splash::DenseSet")
     CHECK(DenseSet({1, 2, 3, 4}) != DenseSet({5, 3, 2, 1}));
     CHECK(DenseSet({1, 2, 3, 4}) != DenseSet({1, 2, 3}));
 }
+
+/*************/
+TEST_CASE("Testing Splash::DenseSet lookup after erase")
+{
+    auto dset = DenseSet<std::string>();
+    for (int i = 0; i < 100; ++i)
+        dset.insert("value_" + std::to_string(i));
+    CHECK(dset.size() == 100);
+
+    for (int i = 0; i < 100; i += 3)
+        CHECK(dset.erase("value_" + std::to_string(i)) == 1);
+    CHECK(dset.size() == 66);
+
+    // Insertion order is preserved, and the index matches the remaining values
+    int expected = 1;
+    for (const auto& value : dset)
+    {
+        CHECK(value == "value_" + std::to_string(expected));
+        CHECK(*dset.find(value) == value);
+        expected += expected % 3 == 1 ? 1 : 2;
+    }
+
+    CHECK(dset.contains(std::string_view("value_1")));
+    CHECK(!dset.contains(std::string_view("value_0")));
+    CHECK(dset.find("value_2") != dset.end());
+    CHECK(dset.find("value_3") == dset.end());
+}
@@ -0,0 +1,30 @@
+#include <doctest.h>
+
+#include <numeric>
+#include <string_view>
+#include <vector>
+
+#include "./utils/hash.h"
+
+using namespace Splash;
+
+/*************/
+TEST_CASE("Testing XXH64 hash")
+{
+    const auto asBytes = [](std::string_view text) { return std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(text.data()), text.size()); };
+
+    // Reference values from the xxHash library
+    CHECK_EQ(Hash::xxh64(asBytes("")), 0xEF46DB3751D8E999ull);
+    CHECK_EQ(Hash::xxh64(asBytes("abc")), 0x44BC2CF5AD770999ull);
+    CHECK_EQ(Hash::xxh64(asBytes("Nobody inspects the spammish repetition"), 42), 0x44582824CA1018B5ull);
+
+    std::vector<uint8_t> buffer(1024);
+    for (size_t i = 0; i < buffer.size(); ++i)
+        buffer[i] = static_cast<uint8_t>(i % 256);
+    CHECK_EQ(Hash::xxh64(buffer), 0x6F3914F18FE4DF57ull);
+
+    // Any change to the content changes the hash
+    const auto hash = Hash::xxh64(buffer);
+    buffer[512] ^= 1;
+    CHECK_NE(Hash::xxh64(buffer), hash);
+}
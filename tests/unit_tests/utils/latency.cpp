@@ -0,0 +1,59 @@
+#include <doctest.h>
+
+#include "./utils/latency.h"
+#include "./utils/timer.h"
+
+using namespace Splash;
+
+/*************/
+TEST_CASE("Testing LatencyTracker percentiles")
+{
+    auto& tracker = LatencyTracker::get();
+    tracker.clear();
+
+    for (int64_t latency = 1; latency <= 100; ++latency)
+        tracker.recordLatency("source", LatencyTracker::STAGE_UPLOAD, latency * 1000);
+
+    const auto percentiles = tracker.getPercentiles();
+    REQUIRE_EQ(percentiles.count("source"), 1);
+    REQUIRE_EQ(percentiles.at("source").count(LatencyTracker::STAGE_UPLOAD), 1);
+
+    const auto& upload = percentiles.at("source").at(LatencyTracker::STAGE_UPLOAD);
+    CHECK_EQ(upload.count, 100);
+    CHECK_EQ(upload.p50, 51.f);
+    CHECK_EQ(upload.p95, 96.f);
+    CHECK_EQ(upload.p99, 100.f);
+
+    // Only the last measurements are kept
+    for (int i = 0; i < 1024; ++i)
+        tracker.recordLatency("source", LatencyTracker::STAGE_UPLOAD, 2000);
+    const auto recent = tracker.getPercentiles().at("source").at(LatencyTracker::STAGE_UPLOAD);
+    CHECK_EQ(recent.count, 1124);
+    CHECK_EQ(recent.p99, 2.f);
+
+    tracker.clear();
+}
+
+/*************/
+TEST_CASE("Testing LatencyTracker display stage")
+{
+    auto& tracker = LatencyTracker::get();
+    tracker.clear();
+
+    // Frames without a valid timestamp are ignored
+    tracker.setUploaded("invalid", -1);
+    tracker.setUploaded("source", Timer::getTime() - 5000);
+    tracker.setDisplayed();
+
+    auto percentiles = tracker.getPercentiles();
+    CHECK_EQ(percentiles.count("invalid"), 0);
+    REQUIRE_EQ(percentiles.count("source"), 1);
+    CHECK_EQ(percentiles["source"][LatencyTracker::STAGE_DISPLAY].count, 1);
+    CHECK_GE(percentiles["source"][LatencyTracker::STAGE_DISPLAY].p50, 5.f);
+
+    // A frame is only displayed once
+    tracker.setDisplayed();
+    CHECK_EQ(tracker.getPercentiles()["source"][LatencyTracker::STAGE_DISPLAY].count, 1);
+
+    tracker.clear();
+}
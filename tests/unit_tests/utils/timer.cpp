@@ -0,0 +1,74 @@
+#include <chrono>
+#include <thread>
+
+#include <doctest.h>
+
+#include "./utils/timer.h"
+
+using namespace Splash;
+
+/*************/
+TEST_CASE("Testing Timer durations")
+{
+    auto& timer = Timer::get();
+
+    static constexpr Timer::Scope scope("timer_test_scope");
+    static_assert(scope.getId() == Timer::getId("timer_test_scope"));
+
+    timer << scope;
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    timer >> scope;
+    CHECK_GE(timer.getDuration(scope), 2000);
+    CHECK_EQ(timer.getDuration("timer_test_scope"), timer.getDuration(scope));
+
+    // Timers stopped from another thread
+    timer << "timer_test_thread";
+    std::thread([&]() { timer >> "timer_test_thread"; }).join();
+    const auto durationMap = timer.getDurationMap();
+    CHECK(durationMap.find("timer_test_thread") != durationMap.end());
+
+    // Waiting for a duration
+    timer << "timer_test_wait";
+    timer >> 5000 >> "timer_test_wait";
+    CHECK_GE(timer.getDuration("timer_test_wait"), 5000);
+
+    // Unknown timers
+    CHECK_EQ(timer.getDuration("timer_test_unknown"), 0);
+    CHECK_FALSE(timer >> "timer_test_unknown");
+
+    // A timer is closed once stopped
+    timer << "timer_test_closed";
+    CHECK(timer.waitUntilDuration("timer_test_closed", 0));
+    CHECK_FALSE(timer.waitUntilDuration("timer_test_closed", 0));
+
+    // Durations measured by ended threads are merged when read
+    std::thread([&]() {
+        timer << "timer_test_ended_thread";
+        timer >> "timer_test_ended_thread";
+    }).join();
+    CHECK(timer.getDurationMap().contains("timer_test_ended_thread"));
+}
+
+/*************/
+TEST_CASE("Testing Timer statistics")
+{
+    auto& timer = Timer::get();
+    for (uint64_t i = 1; i <= 100; ++i)
+        timer.setDuration("timer_test_stats", i);
+
+    const auto statistics = timer.getStatistics();
+    const auto statsIt = statistics.find("timer_test_stats");
+    REQUIRE(statsIt != statistics.end());
+    const auto& stats = statsIt->second;
+    CHECK_EQ(stats.last, 100);
+    CHECK_EQ(stats.min, 1);
+    CHECK_EQ(stats.max, 100);
+    CHECK_EQ(stats.average, 50);
+    CHECK_EQ(stats.p95, 96);
+    CHECK_EQ(stats.p99, 100);
+    CHECK_EQ(stats.count, 100);
+
+    const auto scope = timer.registerScope(std::string("timer_test_") + "registered");
+    CHECK_EQ(scope.getName(), "timer_test_registered");
+    CHECK_EQ(scope.getId(), Timer::getId("timer_test_registered"));
+}
@@ -0,0 +1,112 @@
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <thread>
+
+#include <doctest.h>
+#include <json/json.h>
+
+#include "./utils/timer.h"
+#include "./utils/trace_recorder.h"
+
+using namespace Splash;
+
+/*************/
+TEST_CASE("Testing TraceRecorder")
+{
+    auto& recorder = TraceRecorder::get();
+    CHECK_FALSE(recorder.isRecording());
+
+    // Events are ignored when not recording
+    recorder.addEvent("ignored", Timer::getTime(), 10);
+
+    REQUIRE(recorder.start());
+    CHECK(recorder.isRecording());
+    CHECK_FALSE(recorder.start());
+
+    const auto now = Timer::getTime();
+    recorder.addEvent("cpu_event", now, 100);
+    recorder.addEvent("gpu_event", now, 50, TraceRecorder::Track::GPU);
+    std::thread([&]() { recorder.addEvent("thread_event", now, 20); }).join();
+    recorder.stop();
+    CHECK_FALSE(recorder.isRecording());
+
+    // Events outside of the recording are not exported
+    recorder.addEvent("after_stop", Timer::getTime(), 10);
+
+    const auto contents = recorder.getChromeTrace("test");
+    Json::Value trace;
+    Json::CharReaderBuilder builder;
+    std::unique_ptr<Json::CharReader> const reader(builder.newCharReader());
+    std::string errs;
+    REQUIRE(reader->parse(contents.c_str(), contents.c_str() + contents.size(), &trace, &errs));
+    REQUIRE(trace["traceEvents"].isArray());
+
+    int cpuEvents = 0;
+    int gpuEvents = 0;
+    Json::UInt cpuThread = 0;
+    Json::UInt otherThread = 0;
+    bool hasProcessName = false;
+    for (const auto& event : trace["traceEvents"])
+    {
+        const auto name = event["name"].asString();
+        CHECK_NE(name, "ignored");
+        CHECK_NE(name, "after_stop");
+
+        if (name == "process_name")
+        {
+            hasProcessName = event["args"]["name"].asString() == "test";
+        }
+        else if (name == "cpu_event")
+        {
+            ++cpuEvents;
+            CHECK_EQ(event["ph"].asString(), "X");
+            CHECK_EQ(event["ts"].asInt64(), now);
+            CHECK_EQ(event["dur"].asInt64(), 100);
+            cpuThread = event["tid"].asUInt();
+        }
+        else if (name == "gpu_event")
+        {
+            ++gpuEvents;
+            CHECK_EQ(event["tid"].asUInt(), 0);
+        }
+        else if (name == "thread_event")
+        {
+            otherThread = event["tid"].asUInt();
+        }
+    }
+
+    CHECK(hasProcessName);
+    CHECK_EQ(cpuEvents, 1);
+    CHECK_EQ(gpuEvents, 1);
+    CHECK_NE(cpuThread, 0);
+    CHECK_NE(otherThread, 0);
+    CHECK_NE(cpuThread, otherThread);
+}
+
+/*************/
+TEST_CASE("Testing TraceRecorder record")
+{
+    auto& recorder = TraceRecorder::get();
+    const auto filename = std::filesystem::temp_directory_path() / "splash_unit_test_trace.json";
+    const auto tracePath = std::filesystem::temp_directory_path() / "splash_unit_test_trace_test.json";
+    std::filesystem::remove(tracePath);
+
+    REQUIRE(recorder.record(0.05f, filename.string(), "test"));
+    CHECK_FALSE(recorder.record(0.05f, filename.string(), "test"));
+    recorder.addEvent("recorded_event", Timer::getTime(), 10);
+
+    // No new recording can start before the previous one is written
+    const auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!recorder.start() && std::chrono::steady_clock::now() < timeout)
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    REQUIRE(recorder.isRecording());
+    recorder.stop();
+
+    std::ifstream in(tracePath);
+    REQUIRE(in.is_open());
+    const std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    CHECK_NE(contents.find("recorded_event"), std::string::npos);
+    std::filesystem::remove(tracePath);
+}
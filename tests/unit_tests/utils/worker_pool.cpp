@@ -0,0 +1,46 @@
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <thread>
+
+#include <doctest.h>
+
+#include "./utils/worker_pool.h"
+
+using namespace Splash;
+
+/*************/
+TEST_CASE("Testing WorkerPool")
+{
+    std::atomic_int count{0};
+    std::mutex threadIdsMutex;
+    std::set<std::thread::id> threadIds;
+
+    {
+        Utils::WorkerPool pool(2);
+        CHECK_EQ(pool.getThreadCount(), 2);
+
+        for (int i = 0; i < 64; ++i)
+        {
+            pool.enqueue([&]() {
+                {
+                    std::lock_guard<std::mutex> lock(threadIdsMutex);
+                    threadIds.insert(std::this_thread::get_id());
+                }
+                ++count;
+            });
+        }
+
+        while (count < 64)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    CHECK_EQ(count, 64);
+    CHECK_LE(threadIds.size(), 2);
+    CHECK_EQ(threadIds.count(std::this_thread::get_id()), 0);
+
+    // At least one thread is always created
+    Utils::WorkerPool pool(0);
+    CHECK_EQ(pool.getThreadCount(), 1);
+}